@@ -128,6 +128,7 @@ pushd build
 popd
 
 cp build/src/dredd/dredd third_party/clang+llvm/bin/
+cp build/src/dredd_merge/dredd-merge third_party/clang+llvm/bin/
 DREDD_REPO_ROOT=$(pwd)
 export DREDD_REPO_ROOT
 export PATH=${PATH}:${DREDD_REPO_ROOT}/scripts
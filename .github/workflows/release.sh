@@ -117,6 +117,7 @@ popd
 # Get the files actually needed for the release: the dredd executable, and the header files that ship with Clang
 mkdir -p dredd/bin
 cp "${BUILD_DIR}/src/dredd/dredd" dredd/bin/dredd
+cp "${BUILD_DIR}/src/dredd_merge/dredd-merge" dredd/bin/dredd-merge
 mkdir -p "dredd/lib/clang/${DREDD_LLVM_TAG}"
 cp -r "third_party/clang+llvm/lib/clang/${DREDD_LLVM_TAG}/include" "dredd/lib/clang/${DREDD_LLVM_TAG}"
 DREDD_ZIP_NAME="dredd-${DREDD_RELEASE_OS}-${CONFIG}.zip"
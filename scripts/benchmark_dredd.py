@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+
+# Copyright 2024 The Dredd Project Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Times one or more Dredd executables on (a) the single-file test corpus, (b) a
+# large, synthetically-generated translation unit and (c) a much larger one,
+# whose mutation involves hundreds of thousands of edits, and checks that all of
+# the executables produce identical mutated files and mutation info. This is
+# useful for measuring the effect of a performance change, by comparing a build
+# of Dredd with the change against a build without it:
+#
+#   benchmark_dredd.py baseline/dredd new/dredd
+
+import argparse
+import filecmp
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+from pathlib import Path
+from typing import List
+
+DREDD_REPO_ROOT = Path(__file__).resolve().parent.parent
+
+
+def generate_synthetic_translation_unit(num_functions: int) -> str:
+    lines = ['#include <vector>', '']
+    for i in range(num_functions):
+        lines += [
+            f'int function_{i}(int a, int b, std::vector<int>& v) {{',
+            '  int result = 0;',
+            '  for (int i = 0; i < a; i++) {',
+            '    if (i % 3 == 0 && b > 2) {',
+            f'      result += a * b - i + {i};',
+            '    } else {',
+            '      result -= v[static_cast<unsigned>(i) % v.size()] + 1;',
+            '    }',
+            '  }',
+            '  int values[] = {a, b, a + b, a - b};',
+            '  return result + values[(a ^ b) & 3];',
+            '}',
+            '',
+        ]
+    return '\n'.join(lines)
+
+
+def time_dredd(dredd: Path, source_files: List[Path], work_dir: Path, output_dir: Path, repetitions: int) -> float:
+    best = float('inf')
+    for _ in range(repetitions):
+        if work_dir.exists():
+            shutil.rmtree(work_dir)
+        work_dir.mkdir(parents=True)
+        copies = []
+        for source_file in source_files:
+            copy = work_dir / source_file.name
+            shutil.copyfile(src=source_file, dst=copy)
+            copies.append(str(copy))
+        start = time.perf_counter()
+        subprocess.run([str(dredd), '--mutation-info-file', str(work_dir / 'info.json')] + copies + ['--'],
+                       stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        best = min(best, time.perf_counter() - start)
+    if output_dir.exists():
+        shutil.rmtree(output_dir)
+    shutil.copytree(src=work_dir, dst=output_dir)
+    return best
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description='Benchmark Dredd executables.')
+    parser.add_argument('dredd', nargs='+', type=Path, help='Dredd executables to compare.')
+    parser.add_argument('--repetitions', type=int, default=3,
+                        help='Number of times to run each benchmark; the fastest time is reported.')
+    parser.add_argument('--synthetic-functions', type=int, default=2000,
+                        help='Number of functions in the synthetic translation unit.')
+    parser.add_argument('--large-synthetic-functions', type=int, default=20000,
+                        help='Number of functions in the large synthetic translation unit; 0 to skip it.')
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as temp:
+        temp_dir = Path(temp)
+        synthetic_file = temp_dir / 'synthetic.cc'
+        synthetic_file.write_text(generate_synthetic_translation_unit(args.synthetic_functions))
+        corpora = {
+            'single_file': sorted(list((DREDD_REPO_ROOT / 'test' / 'single_file').glob('*.c'))
+                                  + list((DREDD_REPO_ROOT / 'test' / 'single_file').glob('*.cc'))),
+            'synthetic': [synthetic_file],
+        }
+        if args.large_synthetic_functions > 0:
+            large_synthetic_file = temp_dir / 'large_synthetic.cc'
+            large_synthetic_file.write_text(generate_synthetic_translation_unit(args.large_synthetic_functions))
+            corpora['large_synthetic'] = [large_synthetic_file]
+
+        outputs_match = True
+        for corpus_name, source_files in corpora.items():
+            print(f'{corpus_name} ({len(source_files)} file(s)):')
+            first_output_dir = None
+            for index, dredd in enumerate(args.dredd):
+                output_dir = temp_dir / 'output' / corpus_name / str(index)
+                elapsed = time_dredd(dredd, source_files, temp_dir / 'work', output_dir, args.repetitions)
+                print(f'  {dredd}: {elapsed:.2f}s')
+                if first_output_dir is None:
+                    first_output_dir = output_dir
+                    continue
+                comparison = filecmp.dircmp(first_output_dir, output_dir)
+                _, mismatch, errors = filecmp.cmpfiles(first_output_dir, output_dir, comparison.common_files,
+                                                       shallow=False)
+                if mismatch or errors or comparison.left_only or comparison.right_only:
+                    print(f'  Output of {dredd} differs from that of {args.dredd[0]}: {mismatch + errors}')
+                    outputs_match = False
+    return 0 if outputs_match else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+
+# Copyright 2024 The Dredd Project Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Measures the cost of the code that Dredd generates, rather than of Dredd
+# itself: for each of one or more Dredd executables, mutates (a) the programs of
+# the execute tests and (b) the math example, compiles the mutated code with
+# optimisations and times how long the compiler takes and how long the mutated
+# programs take to run with no mutant enabled. The unmutated programs are timed
+# too, as a baseline. The outputs of all programs are checked to be identical.
+# This is useful for measuring the effect of a change to the generated code, by
+# comparing a build of Dredd with the change against a build without it:
+#
+#   benchmark_mutated_code.py baseline/dredd new/dredd
+#
+# The math example is built with CMake, and its tests use googletest, so the
+# googletest submodule must be checked out.
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+from pathlib import Path
+from typing import List, Optional, Tuple
+
+DREDD_REPO_ROOT = Path(__file__).resolve().parent.parent
+
+
+def run_successfully(cmd: List[str], cwd: Optional[Path] = None) -> str:
+    result = subprocess.run([str(c) for c in cmd], cwd=cwd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if result.returncode != 0:
+        print(f"Command exited with error code {result.returncode}: {' '.join([str(c) for c in cmd])}")
+        print(result.stdout.decode('utf-8'))
+        print(result.stderr.decode('utf-8'))
+        sys.exit(1)
+    return result.stdout.decode('utf-8')
+
+
+def time_runs(cmd: List[str], runs: int, repetitions: int) -> Tuple[float, str]:
+    # Yields the fastest time, over |repetitions|, taken to run |cmd| |runs| times, and the output of |cmd|.
+    output = run_successfully(cmd)
+    best = float('inf')
+    for _ in range(repetitions):
+        start = time.perf_counter()
+        for _ in range(runs):
+            subprocess.run([str(c) for c in cmd], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        best = min(best, time.perf_counter() - start)
+    return best, output
+
+
+def benchmark_execute_test(test_dir: Path, dredd: Optional[Path], work_dir: Path, args) -> Tuple[float, float, str]:
+    # Yields the time taken to compile the program of the execute test in |test_dir|, mutated by |dredd| unless it
+    # is None, the time taken to run it and its output.
+    is_cpp = (test_dir / 'harness.cc').exists()
+    extension = 'cc' if is_cpp else 'c'
+    if work_dir.exists():
+        shutil.rmtree(work_dir)
+    work_dir.mkdir(parents=True)
+    for name in ['harness', 'tomutate']:
+        shutil.copyfile(src=test_dir / f'{name}.{extension}', dst=work_dir / f'{name}.{extension}')
+    if dredd is not None:
+        # As in the execute tests, C++ 20 is used for C++ programs.
+        run_successfully([dredd, work_dir / f'tomutate.{extension}', '--'] + (['--std=c++20'] if is_cpp else []))
+    compiler = args.cxx if is_cpp else args.cc
+    start = time.perf_counter()
+    run_successfully([compiler, args.optimisation_level] + (['-std=c++20'] if is_cpp else [])
+                     + [work_dir / f'harness.{extension}', work_dir / f'tomutate.{extension}', '-o',
+                        work_dir / 'test_executable'])
+    compile_time = time.perf_counter() - start
+    run_time, output = time_runs([work_dir / 'test_executable'], args.runs, args.repetitions)
+    return compile_time, run_time, output
+
+
+def benchmark_math(dredd: Optional[Path], args) -> Tuple[float, float, str]:
+    # Yields the time taken to build the math example and its tests, mutated by |dredd| unless it is None, the time
+    # taken to run the tests and their output. The build of the math example refers to googletest via a path relative
+    # to the example, so the copy that is mutated is made alongside it.
+    math_dir = DREDD_REPO_ROOT / 'examples' / 'math-benchmark'
+    if math_dir.exists():
+        shutil.rmtree(math_dir)
+    shutil.copytree(src=DREDD_REPO_ROOT / 'examples' / 'math', dst=math_dir)
+    try:
+        build_dir = math_dir / 'build'
+        run_successfully(['cmake', '-S', math_dir, '-B', build_dir, '-DCMAKE_BUILD_TYPE=Release',
+                          f'-DCMAKE_C_COMPILER={args.cc}', f'-DCMAKE_CXX_COMPILER={args.cxx}',
+                          f'-DCMAKE_CXX_FLAGS_RELEASE={args.optimisation_level}',
+                          '-DCMAKE_EXPORT_COMPILE_COMMANDS=ON'])
+        if dredd is not None:
+            run_successfully([dredd, '-p', build_dir] + sorted((math_dir / 'math' / 'src').glob('*.cc')))
+        # googletest is built first, so that only the math library and its tests are timed.
+        run_successfully(['cmake', '--build', build_dir, '--target', 'gtest_main'])
+        start = time.perf_counter()
+        run_successfully(['cmake', '--build', build_dir, '--target', 'mathtest'])
+        compile_time = time.perf_counter() - start
+        run_time, output = time_runs([build_dir / 'mathtest' / 'mathtest', f'--gtest_repeat={args.gtest_repeat}',
+                                      '--gtest_brief=1'], 1, args.repetitions)
+        # The output of the tests includes timings, so only whether they passed is compared.
+        return compile_time, run_time, 'PASSED' if 'FAILED' not in output else 'FAILED'
+    finally:
+        shutil.rmtree(math_dir)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description='Benchmark the code generated by Dredd executables.')
+    parser.add_argument('dredd', nargs='+', type=Path, help='Dredd executables to compare.')
+    parser.add_argument('--cc', default=os.environ.get('CC', 'clang'), help='C compiler for mutated code.')
+    parser.add_argument('--cxx', default=os.environ.get('CXX', 'clang++'), help='C++ compiler for mutated code.')
+    parser.add_argument('--optimisation-level', default='-O2', help='Optimisation flag for mutated code.')
+    parser.add_argument('--repetitions', type=int, default=3,
+                        help='Number of times to run each benchmark; the fastest time is reported.')
+    parser.add_argument('--runs', type=int, default=100,
+                        help='Number of times each execute test program is run per repetition.')
+    parser.add_argument('--gtest-repeat', type=int, default=200,
+                        help='Number of times the tests of the math example are run per repetition.')
+    parser.add_argument('--skip-math', action='store_true', help='Do not benchmark the math example.')
+    args = parser.parse_args()
+
+    # None stands for the unmutated code.
+    variants = [None] + args.dredd
+    outputs_match = True
+    with tempfile.TemporaryDirectory() as temp:
+        work_dir = Path(temp) / 'work'
+        benchmarks = [(f'execute/{test_dir.name}',
+                       lambda dredd, test_dir=test_dir: benchmark_execute_test(test_dir, dredd, work_dir, args))
+                      for test_dir in sorted((DREDD_REPO_ROOT / 'test' / 'execute').iterdir()) if test_dir.is_dir()]
+        if not args.skip_math:
+            benchmarks.append(('examples/math', lambda dredd: benchmark_math(dredd, args)))
+        totals = [[0.0, 0.0] for _ in variants]
+        for benchmark_name, benchmark in benchmarks:
+            print(f'{benchmark_name}:')
+            first_output = None
+            for index, dredd in enumerate(variants):
+                compile_time, run_time, output = benchmark(dredd)
+                totals[index][0] += compile_time
+                totals[index][1] += run_time
+                print(f'  {dredd or "unmutated"}: compile {compile_time:.2f}s, run {run_time:.2f}s')
+                if first_output is None:
+                    first_output = output
+                elif output != first_output:
+                    print(f'  Output of code mutated by {dredd} differs from that of the unmutated code')
+                    outputs_match = False
+        print('total:')
+        for index, dredd in enumerate(variants):
+            print(f'  {dredd or "unmutated"}: compile {totals[index][0]:.2f}s, run {totals[index][1]:.2f}s')
+    return 0 if outputs_match else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
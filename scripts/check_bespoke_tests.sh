@@ -29,6 +29,7 @@ then
     # Ensure that Dredd is in its installed location. This depends on a
     # debug build being available
     cp temp/build-Debug/src/dredd/dredd "${DREDD_INSTALLED_EXECUTABLE}"
+    cp temp/build-Debug/src/dredd_merge/dredd-merge "${DREDD_REPO_ROOT}/third_party/clang+llvm/bin/dredd-merge"
   fi
 
   # Avoid copying Dredd to its installed location when invoking the script that
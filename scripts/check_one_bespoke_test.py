@@ -42,6 +42,8 @@ if 'DREDD_SKIP_COPY_EXECUTABLE' not in os.environ or os.environ['DREDD_SKIP_COPY
     # debug build being available
     shutil.copy(src=Path('../build-Debug', 'src', 'dredd', 'dredd'),
                 dst=DREDD_INSTALLED_EXECUTABLE)
+    shutil.copy(src=Path('../build-Debug', 'src', 'dredd_merge', 'dredd-merge'),
+                dst=Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd-merge'))
 
 if not os.path.exists(test_directory / 'test.py'):
     print(f"No 'test.py' file found for bespoke test {test_directory}")
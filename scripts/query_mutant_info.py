@@ -16,13 +16,15 @@
 
 import argparse
 import json
+import mmap
 import os
 import re
+import struct
 import sys
 
 from dataclasses import dataclass
 from pathlib import Path
-from typing import Dict, Optional
+from typing import Dict, List, Optional, Tuple
 
 
 @dataclass
@@ -33,6 +35,215 @@ class MutantInfo:
     instance: Optional[Dict]
 
 
+# The following mirror the enums in dredd.proto, indexed by enum value.
+REPLACE_EXPR_ACTIONS: List[str] = [
+    "InsertPreInc", "InsertPreDec", "InsertLNot", "InsertNot", "InsertMinus", "ReplaceWithZeroFloat",
+    "ReplaceWithOneFloat", "ReplaceWithMinusOneFloat", "ReplaceWithZeroInt", "ReplaceWithOneInt",
+    "ReplaceWithMinusOneInt", "ReplaceWithTrue", "ReplaceWithFalse",
+]
+REPLACE_BINARY_OPERATOR_ACTIONS: List[str] = [
+    "ReplaceWithLHS", "ReplaceWithRHS", "ReplaceWithAdd", "ReplaceWithDiv", "ReplaceWithMul", "ReplaceWithRem",
+    "ReplaceWithSub", "ReplaceWithAddAssign", "ReplaceWithAndAssign", "ReplaceWithAssign", "ReplaceWithDivAssign",
+    "ReplaceWithMulAssign", "ReplaceWithOrAssign", "ReplaceWithRemAssign", "ReplaceWithShlAssign",
+    "ReplaceWithShrAssign", "ReplaceWithSubAssign", "ReplaceWithXorAssign", "ReplaceWithAnd", "ReplaceWithOr",
+    "ReplaceWithXor", "ReplaceWithLAnd", "ReplaceWithLOr", "ReplaceWithEQ", "ReplaceWithGE", "ReplaceWithGT",
+    "ReplaceWithLE", "ReplaceWithLT", "ReplaceWithNE", "ReplaceWithShl", "ReplaceWithShr",
+]
+BINARY_OPERATORS: List[str] = [
+    "Mul", "Div", "Rem", "Add", "Sub", "Shl", "Shr", "LT", "GT", "LE", "GE", "EQ", "NE", "And", "Xor", "Or", "LAnd",
+    "LOr", "Assign", "MulAssign", "DivAssign", "RemAssign", "AddAssign", "SubAssign", "ShlAssign", "ShrAssign",
+    "AndAssign", "XorAssign", "OrAssign",
+]
+REPLACE_UNARY_OPERATOR_ACTIONS: List[str] = [
+    "ReplaceWithOperand", "ReplaceWithMinus", "ReplaceWithNot", "ReplaceWithPreDec", "ReplaceWithPostDec",
+    "ReplaceWithPreInc", "ReplaceWithPostInc", "ReplaceWithLNot",
+]
+UNARY_OPERATORS: List[str] = ["PostInc", "PostDec", "PreInc", "PreDec", "Minus", "Not", "LNot"]
+
+
+@dataclass
+class BinaryGroupLayout:
+    kind: str
+    locations: List[str]
+    snippets: List[str]
+    operators: Optional[List[str]]
+    actions: Optional[List[str]]
+
+
+# Indexed by the kind byte of a mutation group record, which is the field number of the group in the MutationGroup
+# message. Locations and snippets are listed in proto field order, which is the order in which they are encoded.
+BINARY_GROUP_LAYOUTS: Dict[int, BinaryGroupLayout] = {
+    1: BinaryGroupLayout("removeStmt", ["start", "end"], ["snippet"], None, None),
+    2: BinaryGroupLayout("replaceExpr", ["start", "end"], ["snippet"], None, REPLACE_EXPR_ACTIONS),
+    3: BinaryGroupLayout("replaceBinaryOperator",
+                         ["exprStart", "exprEnd", "lhsStart", "lhsEnd", "rhsStart", "rhsEnd"],
+                         ["exprSnippet", "lhsSnippet", "rhsSnippet"],
+                         BINARY_OPERATORS,
+                         REPLACE_BINARY_OPERATOR_ACTIONS),
+    4: BinaryGroupLayout("replaceUnaryOperator",
+                         ["exprStart", "exprEnd", "operandStart", "operandEnd"],
+                         ["exprSnippet", "operandSnippet"],
+                         UNARY_OPERATORS,
+                         REPLACE_UNARY_OPERATOR_ACTIONS),
+}
+
+
+class BinaryMutationInfo:
+    # Reads mutation info written with --mutation-info-format=binary; see mutation_info_binary_format.h in libdredd
+    # for a description of the format. The file is memory-mapped, and only the parts of it that are needed are decoded,
+    # so that looking up a mutant takes constant time.
+    MAGIC: bytes = b'DREDDBIN'
+    FOOTER_MAGIC: bytes = b'DREDDEND'
+    VERSION: int = 1
+    FOOTER_SIZE: int = 56
+    FILE_ENTRY_SIZE: int = 24
+    MUTANT_ENTRY_SIZE: int = 16
+
+    def __init__(self, mutation_info_file: Path):
+        with open(mutation_info_file, 'rb') as binary_input:
+            self.data = mmap.mmap(binary_input.fileno(), 0, access=mmap.ACCESS_READ)
+        if (len(self.data) < 16 + self.FOOTER_SIZE or self.data[0:8] != self.MAGIC
+                or self.data[-8:] != self.FOOTER_MAGIC):
+            raise ValueError(f"{mutation_info_file} is not a valid binary mutation info file")
+        version: int = struct.unpack_from('<I', self.data, 8)[0]
+        if version != self.VERSION:
+            raise ValueError(f"{mutation_info_file} has unsupported version {version}")
+        (self.strings_offset, self.num_strings, self.files_offset, self.num_files, self.mutants_offset,
+         self.num_mutants) = struct.unpack_from('<6Q', self.data, len(self.data) - self.FOOTER_SIZE)
+
+    @staticmethod
+    def is_binary(mutation_info_file: Path) -> bool:
+        with open(mutation_info_file, 'rb') as binary_input:
+            return binary_input.read(len(BinaryMutationInfo.MAGIC)) == BinaryMutationInfo.MAGIC
+
+    def get_string(self, string_id: int) -> str:
+        start, end = struct.unpack_from('<2Q', self.data, self.strings_offset + 8 * string_id)
+        string_data: int = self.strings_offset + 8 * (self.num_strings + 1)
+        return self.data[string_data + start:string_data + end].decode('utf-8')
+
+    def read_varint(self, offset: int) -> Tuple[int, int]:
+        result: int = 0
+        shift: int = 0
+        while True:
+            byte: int = self.data[offset]
+            offset += 1
+            result |= (byte & 0x7f) << shift
+            shift += 7
+            if byte < 0x80:
+                return result, offset
+
+    def read_signed_varint(self, offset: int) -> Tuple[int, int]:
+        value, offset = self.read_varint(offset)
+        return (value >> 1) ^ -(value & 1), offset
+
+    def get_filename(self, file_index: int) -> str:
+        filename_id: int = struct.unpack_from('<I', self.data, self.files_offset + self.FILE_ENTRY_SIZE * file_index
+                                              + 16)[0]
+        return self.get_string(filename_id)
+
+    # Decodes the mutation group record at the given offset into the form used by the JSON mutation info, returning
+    # the group and the offset of the following record.
+    def read_mutation_group(self, offset: int) -> Tuple[Dict, int]:
+        layout: BinaryGroupLayout = BINARY_GROUP_LAYOUTS[self.data[offset]]
+        offset += 1
+        group: Dict = {}
+        first_line: int = 0
+        for index, location in enumerate(layout.locations):
+            if index == 0:
+                first_line, offset = self.read_varint(offset)
+                line = first_line
+            else:
+                line_delta, offset = self.read_signed_varint(offset)
+                line = first_line + line_delta
+            column, offset = self.read_varint(offset)
+            group[location] = {"line": line, "column": column}
+        for snippet in layout.snippets:
+            string_id, offset = self.read_varint(offset)
+            group[snippet] = self.get_string(string_id)
+        if layout.operators is not None:
+            operator, offset = self.read_varint(offset)
+            group["operator"] = layout.operators[operator]
+        num_instances, offset = self.read_varint(offset)
+        instances: List[Dict] = []
+        mutation_id: int = 0
+        for _ in range(num_instances):
+            action, offset = self.read_varint(offset)
+            mutation_id_delta, offset = self.read_signed_varint(offset)
+            mutation_id += mutation_id_delta
+            instances.append({"action": action, "mutationId": mutation_id})
+        if layout.actions is None:
+            assert len(instances) == 1
+            group["mutationId"] = instances[0]["mutationId"]
+        else:
+            for instance in instances:
+                instance["action"] = layout.actions[instance["action"]]
+            group["instances"] = instances
+        return {layout.kind: group}, offset
+
+    def largest_mutant_id(self) -> int:
+        for mutant_id in range(self.num_mutants - 1, -1, -1):
+            if self.get_mutant_entry(mutant_id)[0] != 0:
+                return mutant_id
+        return -1
+
+    # Returns the offset of the mutant's mutation group record (0 if there is no such mutant) and the index of its
+    # source file.
+    def get_mutant_entry(self, mutant_id: int) -> Tuple[int, int]:
+        return struct.unpack_from('<QI', self.data, self.mutants_offset + self.MUTANT_ENTRY_SIZE * mutant_id)
+
+    def get_mutant_info(self, mutant_id: int) -> Optional[MutantInfo]:
+        if mutant_id < 0 or mutant_id >= self.num_mutants:
+            return None
+        group_offset, file_index = self.get_mutant_entry(mutant_id)
+        if group_offset == 0:
+            return None
+        mutation_group, _ = self.read_mutation_group(group_offset)
+        kind: str = next(iter(mutation_group))
+        instance: Optional[Dict] = None
+        if "instances" in mutation_group[kind]:
+            instance = next(i for i in mutation_group[kind]["instances"] if i["mutationId"] == mutant_id)
+        return MutantInfo(kind, {"filename": self.get_filename(file_index)}, mutation_group, instance)
+
+    def to_json(self) -> Dict:
+        info_for_files: List[Dict] = []
+        for file_index in range(self.num_files):
+            groups_offset, tree_offset = struct.unpack_from('<2Q', self.data,
+                                                            self.files_offset + self.FILE_ENTRY_SIZE * file_index)
+            num_nodes, tree_offset = self.read_varint(tree_offset)
+            mutation_tree: List[Dict] = []
+            for _ in range(num_nodes):
+                num_groups, tree_offset = self.read_varint(tree_offset)
+                num_children, tree_offset = self.read_varint(tree_offset)
+                children: List[int] = []
+                for _ in range(num_children):
+                    child, tree_offset = self.read_varint(tree_offset)
+                    children.append(child)
+                mutation_groups: List[Dict] = []
+                for _ in range(num_groups):
+                    mutation_group, groups_offset = self.read_mutation_group(groups_offset)
+                    mutation_groups.append(mutation_group)
+                mutation_tree.append({"mutationGroups": mutation_groups, "children": children})
+            info_for_files.append({"filename": self.get_filename(file_index), "mutationTree": mutation_tree})
+        return {"infoForFiles": info_for_files}
+
+
+def load_mutation_info(mutation_info_file: Path) -> Dict:
+    # Dredd writes mutation info as a single JSON object, as JSON Lines with one object per source file
+    # (--mutation-info-format=jsonl), or in a binary format (--mutation-info-format=binary). The latter two are
+    # converted to the former.
+    if BinaryMutationInfo.is_binary(mutation_info_file):
+        return BinaryMutationInfo(mutation_info_file).to_json()
+    with open(mutation_info_file, 'r') as json_input:
+        text: str = json_input.read()
+    try:
+        json_info = json.loads(text)
+        if isinstance(json_info, dict) and "infoForFiles" in json_info:
+            return json_info
+    except json.JSONDecodeError:
+        pass
+    return {"infoForFiles": [json.loads(line) for line in text.splitlines() if line.strip()]}
+
+
 def build_mutant_to_node_mapping(json_info: Dict) -> Dict[int, MutantInfo]:
     result: Dict[int, MutantInfo] = {}
     for file_info in json_info["infoForFiles"]:
@@ -253,17 +464,15 @@ def show_info_for_remove_stmt(mutant_info: MutantInfo,
     return 0
 
 
-def show_info_for_mutant(args, mapping: Dict[int, MutantInfo]) -> int:
+def show_info_for_mutant(args, mutant_info: Optional[MutantInfo]) -> int:
     if args.path_prefix_replacement is None:
         print("Missing: path to the root of the mutated code, and path to the root of the non-mutated code. From "
               "these prefixes onwards, the source trees should have the same content.")
         return 1
 
-    mutant_id: int = args.show_info_for_mutant
-    if mutant_id not in mapping:
-        print(f"Unknown mutant id: {mutant_id}")
+    if mutant_info is None:
+        print(f"Unknown mutant id: {args.show_info_for_mutant}")
         return 1
-    mutant_info: MutantInfo = mapping[mutant_id]
     mutated_source_code_filename = mutant_info.file_info['filename']
     filename_without_prefix = mutated_source_code_filename[len(str(args.path_prefix_replacement[0])):]
     if filename_without_prefix.startswith(os.sep):
@@ -312,19 +521,34 @@ def main() -> int:
     parser.add_argument("--show-info-for-mutant",
                         help="Show information about a given mutant",
                         type=int)
+    parser.add_argument("--export-json",
+                        help="Write the mutation info, in whichever format it was generated, to the given file as a "
+                             "single JSON object, as produced by --mutation-info-format=json.",
+                        type=Path)
 
     args = parser.parse_args()
-    with open(args.mutation_info_file, 'r') as json_input:
-        json_info = json.load(json_input)
-    mapping: Dict[int, MutantInfo] = build_mutant_to_node_mapping(json_info)
+
+    if args.export_json is not None:
+        with open(args.export_json, 'w') as json_output:
+            json.dump(load_mutation_info(args.mutation_info_file), json_output, indent=1)
+        return 0
+
+    if BinaryMutationInfo.is_binary(args.mutation_info_file):
+        # The binary format allows mutants to be looked up without decoding the whole file.
+        binary_info: BinaryMutationInfo = BinaryMutationInfo(args.mutation_info_file)
+        largest_mutant_id = binary_info.largest_mutant_id
+        get_mutant_info = binary_info.get_mutant_info
+    else:
+        mapping: Dict[int, MutantInfo] = build_mutant_to_node_mapping(load_mutation_info(args.mutation_info_file))
+        largest_mutant_id = lambda: -1 if not mapping else max(mapping.keys())
+        get_mutant_info = mapping.get
 
     if args.largest_mutant_id:
-        mutant_ids: List[int] = list(mapping.keys())
-        print(-1 if not mutant_ids else max(mutant_ids))
+        print(largest_mutant_id())
         return 0
 
     if args.show_info_for_mutant is not None:
-        return show_info_for_mutant(args, mapping)
+        return show_info_for_mutant(args, get_mutant_info(args.show_info_for_mutant))
 
     print("No action specified.")
     return 1
@@ -13,30 +13,55 @@
 // limitations under the License.
 
 #include <cassert>
-#include <fstream>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <memory>
 #include <optional>
 #include <set>
 #include <string>
+#include <system_error>
 #include <utility>
+#include <vector>
 
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/DiagnosticOptions.h"
 #include "clang/Frontend/ChainedDiagnosticConsumer.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "clang/Serialization/PCHContainerOperations.h"
 #include "clang/Tooling/CommonOptionsParser.h"
+#include "clang/Tooling/CompilationDatabase.h"
 #include "clang/Tooling/Tooling.h"
 #include "dredd/log_failed_files_diagnostic_consumer.h"
-#include "dredd/protobufs/protobuf_serialization.h"
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/function_filter.h"
+#include "libdredd/line_ranges.h"
+#include "libdredd/mutation_cache.h"
+#include "libdredd/mutation_counts.h"
+#include "libdredd/mutation_info_writer.h"
+#include "libdredd/mutation_sampler.h"
+#include "libdredd/mutation_selection.h"
+#include "libdredd/mutation_server.h"
 #include "libdredd/new_mutate_frontend_action_factory.h"
 #include "libdredd/options.h"
 #include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/run_statistics.h"
+#include "libdredd/shard_file.h"
+#include "libdredd/shared_runtime.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/VirtualFileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 
 #if defined(__clang__)
@@ -77,12 +102,236 @@ static llvm::cl::opt<std::string> mutation_info_file(
         ".json file into which mutation information should be written"),
     llvm::cl::cat(mutate_category));
 // NOLINTNEXTLINE
+static llvm::cl::opt<dredd::MutationInfoWriter::Format> mutation_info_format(
+    "mutation-info-format",
+    llvm::cl::desc("Format in which mutation information is written; in "
+                   "every case, the information for each source file is "
+                   "written as soon as the file has been mutated"),
+    llvm::cl::values(
+        clEnumValN(dredd::MutationInfoWriter::Format::kJson, "json",
+                   "a single JSON object (the default)"),
+        clEnumValN(dredd::MutationInfoWriter::Format::kJsonLines, "jsonl",
+                   "JSON Lines, with one line per source file; usable even "
+                   "if Dredd is interrupted"),
+        clEnumValN(dredd::MutationInfoWriter::Format::kBinary, "binary",
+                   "a compact binary format, indexed by mutant id, that can "
+                   "be memory-mapped")),
+    llvm::cl::init(dredd::MutationInfoWriter::Format::kJson),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
 static llvm::cl::opt<bool> show_ast_node_types(
     "show-ast-node-types",
     llvm::cl::desc(
         "In the mutated code, show (via comments) the type of each AST node to "
         "which mutation has been applied; useful for debugging"),
     llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<unsigned> jobs(
+    "jobs",
+    llvm::cl::desc(
+        "Number of source files to mutate in parallel; 0 means one per "
+        "hardware thread. Mutant ids, mutated files and mutation information "
+        "are identical to those obtained by mutating files one at a time"),
+    llvm::cl::init(1), llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<std::string> shard(
+    "shard",
+    llvm::cl::desc(
+        "Of the given source files, only mutate those belonging to shard i of "
+        "N, specified as i/N where 0 <= i < N. Rather than being written out, "
+        "the mutated files are recorded in the file specified via "
+        "--shard-output-file. The shard files for all N shards should then be "
+        "passed to dredd-merge, which assigns mutant ids and writes out the "
+        "mutated files and mutation information"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<std::string> shard_output_file(
+    "shard-output-file",
+    llvm::cl::desc("File into which the results of mutating a shard should be "
+                   "written; required when --shard is used"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<bool> print_phase_timings(
+    "print-phase-timings",
+    llvm::cl::desc("After mutating all source files, print the time spent "
+                   "parsing, traversing ASTs, applying mutations, rewriting, "
+                   "writing out mutated files and serialising mutation "
+                   "information, summed over all source files"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<std::string> stats_file(
+    "stats-file",
+    llvm::cl::desc(
+        "File to which a JSON report of the run should be written, giving the "
+        "time spent in each phase of mutating each source file, the number of "
+        "AST nodes traversed and mutants applied per source file, mutant "
+        "counts by kind and action, and peak memory use. The report is also "
+        "in Chrome trace-event format, so can be opened in a trace viewer"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<bool> skip_header_function_bodies(
+    "skip-header-function-bodies",
+    llvm::cl::desc(
+        "Do not parse the bodies of functions that are declared outside the "
+        "source file being mutated, e.g. in headers, other than those that "
+        "are needed to analyse the source file, such as constexpr functions. "
+        "Only the source file is mutated, so this saves parsing time without "
+        "changing the result"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<std::string> cache_dir(
+    "cache-dir",
+    llvm::cl::desc(
+        "Directory in which to cache the results of mutating each source file. "
+        "A source file is not parsed again if neither it, nor any file it "
+        "includes, nor its compile command has changed since it was cached by "
+        "the same build of Dredd with the same options. Results are cached as "
+        "soon as each source file has been mutated, so an interrupted run can "
+        "be resumed by running Dredd again on the original source files"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<std::string> coverage_tracking_output_dir(
+    "coverage-tracking-output-dir",
+    llvm::cl::desc(
+        "In addition to mutating each source file in place, write a version of "
+        "it that only tracks mutant coverage (as with "
+        "--only-track-mutant-coverage) to this directory, at the path of the "
+        "source file relative to --source-root. Both versions are produced "
+        "from a single parse of each source file and have identical mutant "
+        "ids, so the source code does not need to be processed twice"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<std::string> source_root(
+    "source-root",
+    llvm::cl::desc("The root of the source tree being mutated, used with "
+                   "--coverage-tracking-output-dir; defaults to the current "
+                   "directory"),
+    llvm::cl::init("."), llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<std::string> runtime_dir(
+    "runtime-dir",
+    llvm::cl::desc(
+        "Rather than defining the functions that implement mutants in every "
+        "mutated file, define each of them once, in a runtime that is shared "
+        "by all mutated files and is written to this directory. The runtime "
+        "consists of dredd_runtime.h, which each mutated file includes, so "
+        "this directory must be on the include path when mutated files are "
+        "compiled, and dredd_runtime.cc and/or dredd_runtime.c, which must be "
+        "compiled and linked with the mutated files"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<bool> global_mutant_registry(
+    "global-mutant-registry",
+    llvm::cl::desc(
+        "Rather than each mutated file working out which of its mutants are "
+        "enabled, look up enabled mutants in a single registry, indexed by "
+        "mutant id, that is shared by all mutated files of a program and that "
+        "processes DREDD_ENABLED_MUTATION once. The registry is defined "
+        "weakly in every mutated file, so mutated files must be compiled with "
+        "GCC or Clang"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<std::string> serve(
+    "serve",
+    llvm::cl::desc(
+        "Rather than mutating the given source files, keep running and mutate "
+        "source files on request, receiving requests on the Unix domain "
+        "socket at this path. Mutated files are returned to the client rather "
+        "than written out, and a client can ask for its source files to be "
+        "watched and mutated again whenever they change. The given source "
+        "files are mutated for requests that do not specify any"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<bool> count_only(
+    "count-only",
+    llvm::cl::desc(
+        "Rather than mutating the given source files, count the mutants that "
+        "would be applied to them, per source file, per function and per "
+        "action, and print the counts to standard output as JSON. Source "
+        "files are left unchanged, and no code is generated, so this is much "
+        "faster than mutating the source files"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::list<std::string> line_ranges(
+    "line-ranges",
+    llvm::cl::desc(
+        "Only mutate code that spans the given lines of the given source file, "
+        "specified as file:ranges, where ranges is a comma-separated list of "
+        "line numbers and inclusive ranges of line numbers, e.g. "
+        "src/foo.cc:3,10-20. May be given more than once. Source files of "
+        "which no lines are given are not mutated"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<std::string> line_ranges_from_diff(
+    "line-ranges-from-diff",
+    llvm::cl::desc(
+        "Only mutate code that spans lines added or changed by the unified "
+        "diff in this file ('-' for standard input). Relative paths in the "
+        "diff are resolved against the current directory, so a suitable diff "
+        "is produced by running \"git diff --relative main\" in the directory "
+        "in which Dredd is run. "
+        "Where lines are only removed, the lines either side of them are "
+        "considered changed. Can be combined with --line-ranges"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::list<std::string> mutate_functions(
+    "mutate-functions",
+    llvm::cl::desc(
+        "Only mutate functions whose qualified names, e.g. ns::Class::Method, "
+        "match this regular expression in full. May be given more than once, "
+        "in which case a function is mutated if it matches any of the "
+        "regular expressions. Lambdas are mutated if and only if their "
+        "enclosing function is"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::list<std::string> skip_functions(
+    "skip-functions",
+    llvm::cl::desc(
+        "Do not mutate functions whose qualified names match this regular "
+        "expression in full, e.g. \"logging::.*\" to skip every function in "
+        "namespace logging. May be given more than once, and takes precedence "
+        "over --mutate-functions. Functions, classes and namespaces can also "
+        "be excluded from mutation in the source code, by annotating them "
+        "with [[clang::annotate(\"dredd_skip\")]]"),
+    llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::list<std::string> enable_mutations(
+    "enable-mutations",
+    llvm::cl::desc(
+        "Only apply the given mutations, specified as a comma-separated list "
+        "of kinds of mutation (remove_stmt, replace_expr, "
+        "replace_binary_operator, replace_unary_operator) and individual "
+        "actions of the form kind:Action, using the action names that appear "
+        "in mutation info files, e.g. "
+        "remove_stmt,replace_binary_operator:ReplaceWithLHS. By default, "
+        "all mutations are applied"),
+    llvm::cl::CommaSeparated, llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::list<std::string> disable_mutations(
+    "disable-mutations",
+    llvm::cl::desc(
+        "Do not apply the given mutations, specified in the same way as for "
+        "--enable-mutations, e.g. replace_expr:InsertMinus. Takes precedence "
+        "over --enable-mutations. A set of such options can be kept in a "
+        "file and passed to Dredd as @file"),
+    llvm::cl::CommaSeparated, llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<double> sample_rate(
+    "sample-rate",
+    llvm::cl::desc(
+        "Only apply this proportion, greater than 0 and at most 1, of the "
+        "mutants that would otherwise be applied. Mutants are sampled "
+        "separately for each kind of mutation in each source file, and at "
+        "least one mutant of each kind that occurs in a file is kept. "
+        "Sampled-out mutants are not given mutation ids"),
+    llvm::cl::init(1.0), llvm::cl::cat(mutate_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<uint64_t> sample_seed(
+    "sample-seed",
+    llvm::cl::desc("The seed used to choose which mutants are kept when "
+                   "--sample-rate is given; the same seed yields the same "
+                   "mutants for the same source code"),
+    llvm::cl::init(0), llvm::cl::cat(mutate_category));
 
 #if defined(__clang__)
 #pragma clang diagnostic pop
@@ -92,31 +341,48 @@ static llvm::cl::opt<bool> show_ast_node_types(
 #pragma warning(pop)
 #endif
 
-int main(int argc, const char** argv) {
-  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+namespace {
 
-  llvm::Expected<clang::tooling::CommonOptionsParser> command_line_options =
-      clang::tooling::CommonOptionsParser::create(argc, argv, mutate_category,
-                                                  llvm::cl::OneOrMore);
-  if (!command_line_options) {
-    const std::string error_message =
-        toString(command_line_options.takeError());
-    llvm::errs() << error_message;
-    return 1;
-  }
+// The outcome of mutating a single source file when files are mutated in
+// parallel.
+struct MutateSourceFileResult {
+  // The mutated files, which have not yet been written out.
+  std::vector<dredd::DeferredMutatedFile> deferred_files;
+
+  // Diagnostics are buffered so that they can be reported in the order in which
+  // source files were provided, rather than being interleaved.
+  std::string diagnostics;
+
+  std::set<std::string> files_with_errors;
+
+  int return_code = 0;
 
+  // Only used when mutants are counted rather than applied.
+  std::vector<dredd::protobufs::FileMutationCounts> mutation_counts;
+};
+
+// Runs the actions created by |factory| on a single source file, appending any
+// diagnostics to |diagnostics| and recording the files that had errors in
+// |files_with_errors|. Returns the result of running the tool.
+int RunToolOnSourceFile(const clang::tooling::CompilationDatabase& compilations,
+                        const std::string& source_path,
+                        clang::tooling::FrontendActionFactory& factory,
+                        std::string& diagnostics,
+                        std::set<std::string>& files_with_errors) {
+  // ClangTool changes the working directory to that of each compile command.
+  // By default this changes the working directory of the whole process, so a
+  // physical file system that tracks its own working directory is used instead.
   clang::tooling::ClangTool tool(
-      command_line_options.get().getCompilations(),
-      command_line_options.get().getSourcePathList());
+      compilations, {source_path},
+      std::make_shared<clang::PCHContainerOperations>(),
+      llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(
+          llvm::vfs::createPhysicalFileSystem().release()));
 
+  llvm::raw_string_ostream diagnostics_stream(diagnostics);
+  diagnostics_stream.enable_colors(llvm::errs().has_colors());
   const llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> diagnostic_options =
       new clang::DiagnosticOptions();
   diagnostic_options->ShowColors = 1;
-  std::unique_ptr<clang::TextDiagnosticPrinter> text_diagnostic_printer =
-      std::make_unique<clang::TextDiagnosticPrinter>(llvm::errs(),
-                                                     &*diagnostic_options);
-  const clang::TextDiagnosticPrinter* text_diagnostic_printer_ptr =
-      text_diagnostic_printer.get();
   std::unique_ptr<LogFailedFilesDiagnosticConsumer>
       log_failed_files_diagnostic_consumer =
           std::make_unique<LogFailedFilesDiagnosticConsumer>();
@@ -124,68 +390,707 @@ int main(int argc, const char** argv) {
       log_failed_files_diagnostic_consumer_ptr =
           log_failed_files_diagnostic_consumer.get();
   clang::ChainedDiagnosticConsumer chained_diagnostic_consumer(
-      std::move(text_diagnostic_printer),
+      std::make_unique<clang::TextDiagnosticPrinter>(diagnostics_stream,
+                                                     &*diagnostic_options),
       std::move(log_failed_files_diagnostic_consumer));
   tool.setDiagnosticConsumer(&chained_diagnostic_consumer);
 
-  // Used to give each mutation a unique identifier.
-  int mutation_id = 0;
+  const int result = tool.run(&factory);
+  files_with_errors =
+      log_failed_files_diagnostic_consumer_ptr->GetFilesWithErrors();
+  diagnostics_stream.flush();
+  return result;
+}
+
+// Mutates a single source file using file-local mutation ids, recording the
+// outcome in |result|. This is invoked concurrently for distinct source files,
+// so it must not touch any state shared with other invocations, other than
+// |run_statistics| and |mutation_cache|, each of which may be null. If
+// |mutation_cache| is non-null, a cached result is used if available, and
+// otherwise the result of successfully mutating the file is cached; mutation
+// info is always built in this case, so that cached results can be used
+// whether or not mutation info is required.
+void MutateSourceFile(
+    const clang::tooling::CompilationDatabase& compilations,
+    const std::string& source_path, const dredd::Options& dredd_options,
+    bool build_mutation_info, dredd::RunStatistics* run_statistics,
+    dredd::MutationCache* mutation_cache, MutateSourceFileResult& result) {
+  std::optional<std::string> cache_key;
+  std::vector<clang::tooling::CompileCommand> compile_commands;
+  if (mutation_cache != nullptr) {
+    // ClangTool looks up compile commands using absolute paths.
+    llvm::SmallString<128> absolute_source_path(source_path);
+    llvm::sys::fs::make_absolute(absolute_source_path);
+    compile_commands = compilations.getCompileCommands(absolute_source_path);
+    cache_key = mutation_cache->ComputeKey(absolute_source_path.str().str(),
+                                           compile_commands);
+    // A cached result is not used when ASTs are to be dumped, as that requires
+    // the source file to be parsed.
+    if (cache_key.has_value() && !dredd_options.GetDumpAsts() &&
+        mutation_cache->Lookup(cache_key.value(), result.deferred_files)) {
+      return;
+    }
+    build_mutation_info = true;
+  }
+
+  std::vector<std::string> dependencies;
+  const std::unique_ptr<clang::tooling::FrontendActionFactory> factory =
+      dredd::NewDeferredMutateFrontendActionFactory(
+          dredd_options, build_mutation_info, result.deferred_files,
+          run_statistics, cache_key.has_value() ? &dependencies : nullptr);
+  result.return_code =
+      RunToolOnSourceFile(compilations, source_path, *factory,
+                          result.diagnostics, result.files_with_errors);
+
+  // Files that could not be mutated successfully are not cached, so that their
+  // diagnostics are reported on every run.
+  if (cache_key.has_value() && result.return_code == 0 &&
+      !compile_commands.empty()) {
+    const dredd::ScopedPhaseTimer timer(
+        run_statistics, dredd::RunStatistics::Phase::kSerialise, source_path);
+    if (!mutation_cache->Store(cache_key.value(),
+                               compile_commands.front().Directory,
+                               dependencies, result.deferred_files)) {
+      result.diagnostics += "Warning: unable to cache the result of mutating " +
+                            source_path + "\n";
+    }
+  }
+}
+
+// Counts the mutants that would be applied to a single source file, recording
+// the outcome in |result|. As with MutateSourceFile, this is invoked
+// concurrently for distinct source files.
+void CountMutationsInSourceFile(
+    const clang::tooling::CompilationDatabase& compilations,
+    const std::string& source_path, const dredd::Options& dredd_options,
+    dredd::RunStatistics* run_statistics, MutateSourceFileResult& result) {
+  const std::unique_ptr<clang::tooling::FrontendActionFactory> factory =
+      dredd::NewCountMutationsFrontendActionFactory(
+          dredd_options, result.mutation_counts, run_statistics);
+  result.return_code =
+      RunToolOnSourceFile(compilations, source_path, *factory,
+                          result.diagnostics, result.files_with_errors);
+}
+
+// A file that is listed multiple times is skipped on repeat occurrences when
+// files are mutated one at a time. When files are mutated in parallel or in
+// shards, repeat occurrences are removed up front, so that the same file is
+// never mutated more than once.
+std::vector<std::string> RemoveRepeatedSourcePaths(
+    const std::vector<std::string>& source_paths) {
+  std::vector<std::string> result;
+  std::set<std::string> absolute_source_paths;
+  for (const auto& source_path : source_paths) {
+    llvm::SmallString<128> absolute_source_path(source_path);
+    llvm::sys::fs::make_absolute(absolute_source_path);
+    if (absolute_source_paths.insert(absolute_source_path.str().str())
+            .second) {
+      result.push_back(source_path);
+    } else {
+      llvm::errs() << "Warning: already processed " << source_path
+                   << "; skipping repeat occurrence.\n";
+    }
+  }
+  return result;
+}
+
+// Invokes |process| for each index from 0 to |num_items| - 1, using the given
+// number of threads, and invokes |consume| for each index in increasing order,
+// as soon as |process| has completed for that index.
+void ProcessInParallel(size_t num_items, unsigned num_threads,
+                       const std::function<void(size_t)>& process,
+                       const std::function<void(size_t)>& consume) {
+  std::vector<std::shared_future<void>> futures;
+  llvm::ThreadPool thread_pool(llvm::hardware_concurrency(num_threads));
+  for (size_t i = 0; i < num_items; i++) {
+    futures.push_back(
+        thread_pool.async([&process, i]() -> void { process(i); }));
+  }
+  for (size_t i = 0; i < num_items; i++) {
+    futures[i].wait();
+    consume(i);
+  }
+  thread_pool.wait();
+}
+
+// Mutates the given source files in parallel, using the given number of
+// threads. Each file is mutated using file-local mutation ids. The mutated
+// files are then passed to |consume_deferred_file|, together with the index of
+// the corresponding source file in |source_paths|, in the order in which the
+// source files are listed. This allows the caller to assign global mutation ids
+// deterministically. |consume_deferred_file| should return false if and only
+// if it fails.
+int MutateSourceFilesInParallel(
+    const clang::tooling::CompilationDatabase& compilations,
+    const std::vector<std::string>& source_paths,
+    const dredd::Options& dredd_options, unsigned num_threads,
+    bool build_mutation_info, dredd::RunStatistics* run_statistics,
+    dredd::MutationCache* mutation_cache,
+    const std::function<bool(size_t, const dredd::DeferredMutatedFile&)>&
+        consume_deferred_file,
+    std::set<std::string>& files_with_errors) {
+  std::vector<MutateSourceFileResult> results(source_paths.size());
+  // Results are consumed in order as they become available, and released once
+  // consumed, so that mutated files do not all need to be held in memory at
+  // once.
+  int return_code = 0;
+  ProcessInParallel(
+      source_paths.size(), num_threads,
+      [&compilations, &source_paths, &dredd_options, build_mutation_info,
+       run_statistics, mutation_cache, &results](size_t i) -> void {
+        MutateSourceFile(compilations, source_paths[i], dredd_options,
+                         build_mutation_info, run_statistics, mutation_cache,
+                         results[i]);
+      },
+      [&consume_deferred_file, &files_with_errors, &results,
+       &return_code](size_t i) -> void {
+        MutateSourceFileResult& result = results[i];
+        llvm::errs() << result.diagnostics;
+        for (const auto& deferred_file : result.deferred_files) {
+          if (!consume_deferred_file(i, deferred_file)) {
+            return_code = 1;
+          }
+        }
+        files_with_errors.insert(result.files_with_errors.begin(),
+                                 result.files_with_errors.end());
+        if (result.return_code != 0) {
+          return_code = result.return_code;
+        }
+        result = MutateSourceFileResult();
+      });
+  return return_code;
+}
+
+// Counts the mutants that would be applied to the given source files, in
+// parallel, using the given number of threads. The counts for each file are
+// added to |mutation_counts| in the order in which the source files are listed.
+int CountMutationsInSourceFilesInParallel(
+    const clang::tooling::CompilationDatabase& compilations,
+    const std::vector<std::string>& source_paths,
+    const dredd::Options& dredd_options, unsigned num_threads,
+    dredd::RunStatistics* run_statistics,
+    dredd::protobufs::MutationCounts& mutation_counts,
+    std::set<std::string>& files_with_errors) {
+  std::vector<MutateSourceFileResult> results(source_paths.size());
+  int return_code = 0;
+  ProcessInParallel(
+      source_paths.size(), num_threads,
+      [&compilations, &source_paths, &dredd_options, run_statistics,
+       &results](size_t i) -> void {
+        CountMutationsInSourceFile(compilations, source_paths[i],
+                                   dredd_options, run_statistics, results[i]);
+      },
+      [&mutation_counts, &files_with_errors, &results,
+       &return_code](size_t i) -> void {
+        MutateSourceFileResult& result = results[i];
+        llvm::errs() << result.diagnostics;
+        for (const auto& file_mutation_counts : result.mutation_counts) {
+          dredd::AddFileMutationCounts(file_mutation_counts, mutation_counts);
+        }
+        files_with_errors.insert(result.files_with_errors.begin(),
+                                 result.files_with_errors.end());
+        if (result.return_code != 0) {
+          return_code = result.return_code;
+        }
+        result = MutateSourceFileResult();
+      });
+  return return_code;
+}
+
+// Parses a shard specification of the form i/N, where 0 <= i < N. Returns true
+// if and only if parsing succeeds.
+bool ParseShard(const std::string& shard_specification, unsigned& shard_index,
+                unsigned& num_shards) {
+  const auto [shard_index_string, num_shards_string] =
+      llvm::StringRef(shard_specification).split('/');
+  // Note that getAsInteger returns true if an error occurs.
+  if (shard_index_string.getAsInteger(10, shard_index) ||
+      num_shards_string.getAsInteger(10, num_shards)) {
+    return false;
+  }
+  return shard_index < num_shards;
+}
+
+// Captures everything other than a source file and its compile commands that
+// affects the result of mutating the source file: the build of Dredd, which is
+// identified by the size and modification time of the Dredd executable, and the
+// options in use. Dumping ASTs does not affect the result of mutation.
+std::string GetMutationCacheFingerprint(const char* argv0,
+                                        const dredd::Options& dredd_options) {
+  // The address of any object in the executable can be used to locate it.
+  static int executable_anchor = 0;
+  std::string result =
+      llvm::sys::fs::getMainExecutable(argv0, &executable_anchor);
+  llvm::sys::fs::file_status executable_status;
+  if (!llvm::sys::fs::status(result, executable_status)) {
+    result += ";" + std::to_string(executable_status.getSize()) + ";" +
+              std::to_string(executable_status.getLastModificationTime()
+                                 .time_since_epoch()
+                                 .count());
+  }
+  result += ";" + std::to_string(static_cast<int>(
+                      dredd_options.GetOptimiseMutations()));
+  result += ";" + std::to_string(static_cast<int>(
+                      dredd_options.GetOnlyTrackMutantCoverage()));
+  result += ";" + std::to_string(static_cast<int>(
+                      dredd_options.GetShowAstNodeTypes()));
+  result += ";" + std::to_string(static_cast<int>(
+                      dredd_options.GetSkipHeaderFunctionBodies()));
+  result += ";" + std::to_string(static_cast<int>(
+                      dredd_options.GetAlsoTrackMutantCoverage()));
+  result += ";" + std::to_string(static_cast<int>(
+                      dredd_options.GetUseSharedRuntime()));
+  result += ";" + std::to_string(static_cast<int>(
+                      dredd_options.GetUseGlobalMutantRegistry()));
+  if (const auto* line_range_filter = dredd_options.GetLineRangeFilter()) {
+    result += ";" + line_range_filter->ToString();
+  }
+  if (const auto* function_filter = dredd_options.GetFunctionFilter()) {
+    result += ";" + function_filter->ToString();
+  }
+  result += ";" + dredd_options.GetMutationSelection().ToString();
+  if (const auto* mutation_sampler = dredd_options.GetMutationSampler()) {
+    result += ";" + mutation_sampler->ToString();
+  }
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+
+  llvm::Expected<clang::tooling::CommonOptionsParser> command_line_options =
+      clang::tooling::CommonOptionsParser::create(argc, argv, mutate_category,
+                                                  llvm::cl::OneOrMore);
+  if (!command_line_options) {
+    const std::string error_message =
+        toString(command_line_options.takeError());
+    llvm::errs() << error_message;
+    return 1;
+  }
+
+  unsigned shard_index = 0;
+  unsigned num_shards = 1;
+  if (!shard.empty()) {
+    if (!ParseShard(shard, shard_index, num_shards)) {
+      llvm::errs() << "Invalid shard '" << shard
+                   << "'; expected i/N, where 0 <= i < N.\n";
+      return 1;
+    }
+    if (shard_output_file.empty()) {
+      llvm::errs() << "--shard-output-file must be specified when --shard is "
+                      "used.\n";
+      return 1;
+    }
+    if (!mutation_info_file.empty()) {
+      llvm::errs() << "--mutation-info-file cannot be used with --shard; pass "
+                      "it to dredd-merge instead.\n";
+      return 1;
+    }
+  } else if (!shard_output_file.empty()) {
+    llvm::errs() << "--shard-output-file can only be used with --shard.\n";
+    return 1;
+  }
+
+  if (!coverage_tracking_output_dir.empty() && only_track_mutant_coverage) {
+    llvm::errs() << "--coverage-tracking-output-dir cannot be used with "
+                    "--only-track-mutant-coverage.\n";
+    return 1;
+  }
+
+  if (!serve.empty() &&
+      (!shard.empty() || !mutation_info_file.empty() ||
+       !coverage_tracking_output_dir.empty() || !runtime_dir.empty())) {
+    llvm::errs() << "--serve cannot be used with --shard, "
+                    "--mutation-info-file, --coverage-tracking-output-dir or "
+                    "--runtime-dir.\n";
+    return 1;
+  }
+
+  if (count_only &&
+      (!serve.empty() || !shard.empty() || !mutation_info_file.empty() ||
+       !coverage_tracking_output_dir.empty() || !runtime_dir.empty() ||
+       !cache_dir.empty())) {
+    llvm::errs() << "--count-only cannot be used with --serve, --shard, "
+                    "--mutation-info-file, --coverage-tracking-output-dir, "
+                    "--runtime-dir or --cache-dir.\n";
+    return 1;
+  }
+
+  if (!runtime_dir.empty() && !coverage_tracking_output_dir.empty()) {
+    llvm::errs() << "--runtime-dir cannot be used with "
+                    "--coverage-tracking-output-dir.\n";
+    return 1;
+  }
+
+  if (global_mutant_registry &&
+      (!runtime_dir.empty() || only_track_mutant_coverage)) {
+    llvm::errs() << "--global-mutant-registry cannot be used with "
+                    "--runtime-dir or --only-track-mutant-coverage.\n";
+    return 1;
+  }
+
+  dredd::Options dredd_options;
+  dredd_options.SetOptimiseMutations(!no_mutation_opts)
+      .SetDumpAsts(dump_asts)
+      .SetOnlyTrackMutantCoverage(only_track_mutant_coverage)
+      .SetShowAstNodeTypes(show_ast_node_types)
+      .SetSkipHeaderFunctionBodies(skip_header_function_bodies)
+      .SetAlsoTrackMutantCoverage(!coverage_tracking_output_dir.empty())
+      .SetUseSharedRuntime(!runtime_dir.empty())
+      .SetUseGlobalMutantRegistry(global_mutant_registry);
+
+  if (!line_ranges.empty() || !line_ranges_from_diff.empty()) {
+    auto line_range_filter = std::make_shared<dredd::LineRangeFilter>();
+    std::string error_message;
+    for (const auto& specification : line_ranges) {
+      if (!dredd::ParseLineRangesSpecification(
+              specification, *line_range_filter, error_message)) {
+        llvm::errs() << "Invalid line ranges '" << specification
+                     << "': " << error_message << ".\n";
+        return 1;
+      }
+    }
+    if (!line_ranges_from_diff.empty()) {
+      const llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> diff =
+          llvm::MemoryBuffer::getFileOrSTDIN(line_ranges_from_diff);
+      if (!diff) {
+        llvm::errs() << "Unable to read " << line_ranges_from_diff << ": "
+                     << diff.getError().message() << "\n";
+        return 1;
+      }
+      if (!dredd::ParseUnifiedDiff(diff.get()->getBuffer(), *line_range_filter,
+                                   error_message)) {
+        llvm::errs() << "Invalid diff " << line_ranges_from_diff << ": "
+                     << error_message << ".\n";
+        return 1;
+      }
+    }
+    dredd_options.SetLineRangeFilter(std::move(line_range_filter));
+  }
+
+  if (!mutate_functions.empty() || !skip_functions.empty()) {
+    auto function_filter = std::make_shared<dredd::FunctionFilter>();
+    std::string error_message;
+    for (const auto& pattern : mutate_functions) {
+      if (!function_filter->AddMutatePattern(pattern, error_message)) {
+        llvm::errs() << "Invalid --mutate-functions pattern '" << pattern
+                     << "': " << error_message << ".\n";
+        return 1;
+      }
+    }
+    for (const auto& pattern : skip_functions) {
+      if (!function_filter->AddSkipPattern(pattern, error_message)) {
+        llvm::errs() << "Invalid --skip-functions pattern '" << pattern
+                     << "': " << error_message << ".\n";
+        return 1;
+      }
+    }
+    dredd_options.SetFunctionFilter(std::move(function_filter));
+  }
+
+  if (!enable_mutations.empty() || !disable_mutations.empty()) {
+    dredd::MutationSelection mutation_selection;
+    std::string error_message;
+    if (!enable_mutations.empty()) {
+      mutation_selection.DisableAll();
+    }
+    for (const auto& specification : enable_mutations) {
+      if (!mutation_selection.Enable(specification, error_message)) {
+        llvm::errs() << "Invalid --enable-mutations entry '" << specification
+                     << "': " << error_message << ".\n";
+        return 1;
+      }
+    }
+    for (const auto& specification : disable_mutations) {
+      if (!mutation_selection.Disable(specification, error_message)) {
+        llvm::errs() << "Invalid --disable-mutations entry '" << specification
+                     << "': " << error_message << ".\n";
+        return 1;
+      }
+    }
+    dredd_options.SetMutationSelection(mutation_selection);
+  }
+
+  if (!(sample_rate > 0.0 && sample_rate <= 1.0)) {
+    llvm::errs() << "--sample-rate must be greater than 0 and at most 1.\n";
+    return 1;
+  }
+  if (sample_rate < 1.0) {
+    dredd_options.SetMutationSampler(
+        std::make_shared<dredd::MutationSampler>(sample_rate, sample_seed));
+  } else if (sample_seed.getNumOccurrences() > 0) {
+    llvm::errs() << "--sample-seed requires --sample-rate to be less than 1.\n";
+    return 1;
+  }
+
+  int return_code = 0;
+  std::set<std::string> files_with_errors;
+
+  // Details are only recorded if a report is to be written.
+  dredd::RunStatistics run_statistics(!stats_file.empty());
+  dredd::RunStatistics* const run_statistics_or_null =
+      (print_phase_timings || !stats_file.empty()) ? &run_statistics : nullptr;
+
+  std::unique_ptr<dredd::MutationCache> mutation_cache;
+  if (!cache_dir.empty()) {
+    if (const std::error_code error_code =
+            llvm::sys::fs::create_directories(cache_dir)) {
+      llvm::errs() << "Unable to create cache directory " << cache_dir << ": "
+                   << error_code.message() << "\n";
+      return 1;
+    }
+    mutation_cache = std::make_unique<dredd::MutationCache>(
+        cache_dir, GetMutationCacheFingerprint(argv[0], dredd_options));
+  }
+
+  // Records the mutations that are applied to each source file, including
+  // their hierarchical structure, as each source file is mutated.
+  std::unique_ptr<dredd::MutationInfoWriter> mutation_info_writer;
+  if (!mutation_info_file.empty()) {
+    mutation_info_writer = std::make_unique<dredd::MutationInfoWriter>(
+        mutation_info_file, mutation_info_format);
+    if (!mutation_info_writer->IsOpen()) {
+      llvm::errs() << "Error opening " << mutation_info_file
+                   << " for writing.\n";
+      return 1;
+    }
+  }
+
+  if (count_only) {
+    dredd::protobufs::MutationCounts mutation_counts;
+    return_code = CountMutationsInSourceFilesInParallel(
+        command_line_options.get().getCompilations(),
+        RemoveRepeatedSourcePaths(
+            command_line_options.get().getSourcePathList()),
+        dredd_options, jobs, run_statistics_or_null, mutation_counts,
+        files_with_errors);
+    for (const auto& file : files_with_errors) {
+      mutation_counts.add_files_with_errors(file);
+    }
+    if (!dredd::WriteMutationCounts(mutation_counts, llvm::outs())) {
+      llvm::errs() << "Error writing mutation counts.\n";
+      return_code = 1;
+    }
+  } else if (!serve.empty()) {
+    // The server mutates files exactly as they are mutated in parallel, with
+    // mutation info always built so that it can be returned to clients.
+    dredd::MutationServer server(
+        serve, dredd_options,
+        RemoveRepeatedSourcePaths(
+            command_line_options.get().getSourcePathList()),
+        [&command_line_options, &dredd_options, run_statistics_or_null,
+         &mutation_cache](
+            const std::vector<std::string>& source_paths,
+            const std::function<void(
+                size_t, const dredd::DeferredMutatedFile&)>&
+                consume_deferred_file,
+            std::set<std::string>& server_files_with_errors) -> int {
+          return MutateSourceFilesInParallel(
+              command_line_options.get().getCompilations(), source_paths,
+              dredd_options, jobs, true, run_statistics_or_null,
+              mutation_cache.get(),
+              [&consume_deferred_file](
+                  size_t index,
+                  const dredd::DeferredMutatedFile& deferred_file) -> bool {
+                consume_deferred_file(index, deferred_file);
+                return true;
+              },
+              server_files_with_errors);
+        });
+    return_code = server.Run() ? 0 : 1;
+  } else if (!shard.empty()) {
+    dredd::ShardFileWriter shard_file_writer(shard_output_file);
+    dredd::protobufs::ShardHeader shard_header;
+    shard_header.set_shard_index(shard_index);
+    shard_header.set_num_shards(num_shards);
+    shard_header.set_only_track_mutant_coverage(only_track_mutant_coverage);
+    if (!coverage_tracking_output_dir.empty()) {
+      // The shard may be merged from a different working directory.
+      llvm::SmallString<128> absolute_coverage_tracking_output_dir(
+          coverage_tracking_output_dir);
+      llvm::sys::fs::make_absolute(absolute_coverage_tracking_output_dir);
+      llvm::SmallString<128> absolute_source_root(source_root);
+      llvm::sys::fs::make_absolute(absolute_source_root);
+      shard_header.set_coverage_tracking_output_dir(
+          absolute_coverage_tracking_output_dir.str().str());
+      shard_header.set_source_root(absolute_source_root.str().str());
+    }
+    if (!runtime_dir.empty()) {
+      llvm::SmallString<128> absolute_runtime_dir(runtime_dir);
+      llvm::sys::fs::make_absolute(absolute_runtime_dir);
+      shard_header.set_runtime_dir(absolute_runtime_dir.str().str());
+    }
+    shard_header.set_use_global_mutant_registry(global_mutant_registry);
+    if (!shard_file_writer.IsOpen() ||
+        !shard_file_writer.WriteHeader(shard_header)) {
+      llvm::errs() << "Error writing shard file " << shard_output_file << "\n";
+      return 1;
+    }
 
-  // Keeps track of the mutations that are applied to each source file,
-  // including their hierarchical structure.
-  std::optional<dredd::protobufs::MutationInfo> mutation_info;
+    // Source files are assigned to shards in a round-robin fashion, according
+    // to their position in the list of source files.
+    const std::vector<std::string> unique_source_paths =
+        RemoveRepeatedSourcePaths(
+            command_line_options.get().getSourcePathList());
+    std::vector<std::string> shard_source_paths;
+    std::vector<uint32_t> shard_source_indices;
+    for (size_t i = shard_index; i < unique_source_paths.size();
+         i += num_shards) {
+      shard_source_paths.push_back(unique_source_paths[i]);
+      shard_source_indices.push_back(static_cast<uint32_t>(i));
+    }
 
-  if (mutation_info_file.empty()) {
-    mutation_info = std::nullopt;
+    // Mutation info is always recorded in shard files, so that dredd-merge can
+    // produce it if requested.
+    return_code = MutateSourceFilesInParallel(
+        command_line_options.get().getCompilations(), shard_source_paths,
+        dredd_options, jobs, true, run_statistics_or_null, mutation_cache.get(),
+        [&shard_file_writer, &shard_source_indices, run_statistics_or_null](
+            size_t index,
+            const dredd::DeferredMutatedFile& deferred_file) -> bool {
+          const dredd::ScopedPhaseTimer timer(
+              run_statistics_or_null, dredd::RunStatistics::Phase::kSerialise,
+              deferred_file.GetFilename());
+          dredd::protobufs::ShardFileEntry entry;
+          entry.set_source_index(shard_source_indices[index]);
+          *entry.mutable_deferred_mutated_file() = deferred_file.ToProtobuf();
+          return shard_file_writer.WriteEntry(entry);
+        },
+        files_with_errors);
+  } else if (jobs == 1 && mutation_cache == nullptr &&
+             coverage_tracking_output_dir.empty() && runtime_dir.empty()) {
+    clang::tooling::ClangTool tool(
+        command_line_options.get().getCompilations(),
+        command_line_options.get().getSourcePathList());
+
+    const llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions>
+        diagnostic_options = new clang::DiagnosticOptions();
+    diagnostic_options->ShowColors = 1;
+    std::unique_ptr<clang::TextDiagnosticPrinter> text_diagnostic_printer =
+        std::make_unique<clang::TextDiagnosticPrinter>(llvm::errs(),
+                                                       &*diagnostic_options);
+    const clang::TextDiagnosticPrinter* text_diagnostic_printer_ptr =
+        text_diagnostic_printer.get();
+    std::unique_ptr<LogFailedFilesDiagnosticConsumer>
+        log_failed_files_diagnostic_consumer =
+            std::make_unique<LogFailedFilesDiagnosticConsumer>();
+    const LogFailedFilesDiagnosticConsumer*
+        log_failed_files_diagnostic_consumer_ptr =
+            log_failed_files_diagnostic_consumer.get();
+    clang::ChainedDiagnosticConsumer chained_diagnostic_consumer(
+        std::move(text_diagnostic_printer),
+        std::move(log_failed_files_diagnostic_consumer));
+    tool.setDiagnosticConsumer(&chained_diagnostic_consumer);
+
+    // Used to give each mutation a unique identifier.
+    int mutation_id = 0;
+
+    const std::unique_ptr<clang::tooling::FrontendActionFactory> factory =
+        dredd::NewMutateFrontendActionFactory(dredd_options, mutation_id,
+                                              mutation_info_writer.get(),
+                                              run_statistics_or_null);
+
+    return_code = tool.run(factory.get());
+
+    if (return_code == 0) {
+      // Keep release mode compilers happy.
+      (void)text_diagnostic_printer_ptr;
+      assert(text_diagnostic_printer_ptr->getNumErrors() == 0);
+    } else {
+      assert(text_diagnostic_printer_ptr->getNumErrors() > 0);
+    }
+    files_with_errors =
+        log_failed_files_diagnostic_consumer_ptr->GetFilesWithErrors();
   } else {
-    mutation_info = dredd::protobufs::MutationInfo();
+    // Global mutation ids are assigned as mutated files are consumed, in the
+    // order in which source files are listed. Caching relies on files being
+    // mutated using file-local mutation ids, and producing a mutant coverage
+    // tracking version of each file or a shared runtime relies on the results
+    // of mutating each file being recorded, so this is also used in those
+    // cases, even if files are mutated one at a time.
+    int mutation_id = 0;
+    std::unique_ptr<dredd::SharedRuntime> shared_runtime;
+    if (!runtime_dir.empty()) {
+      shared_runtime = std::make_unique<dredd::SharedRuntime>(dredd_options);
+    }
+    return_code = MutateSourceFilesInParallel(
+        command_line_options.get().getCompilations(),
+        RemoveRepeatedSourcePaths(
+            command_line_options.get().getSourcePathList()),
+        dredd_options, jobs, mutation_info_writer != nullptr,
+        run_statistics_or_null, mutation_cache.get(),
+        [&dredd_options, &mutation_info_writer, &shared_runtime, &mutation_id,
+         run_statistics_or_null](
+            size_t index,
+            const dredd::DeferredMutatedFile& deferred_file) -> bool {
+          (void)index;  // Unused.
+          if (shared_runtime != nullptr) {
+            shared_runtime->AddFile(deferred_file);
+          }
+          bool result = true;
+          {
+            const dredd::ScopedPhaseTimer timer(
+                run_statistics_or_null, dredd::RunStatistics::Phase::kOutput,
+                deferred_file.GetFilename());
+            result = deferred_file.WriteMutatedText(dredd_options, mutation_id);
+            if (deferred_file.HasCoverageTrackingText() &&
+                !deferred_file.WriteCoverageTrackingText(
+                    dredd_options, mutation_id, source_root,
+                    coverage_tracking_output_dir)) {
+              result = false;
+            }
+          }
+          if (mutation_info_writer != nullptr) {
+            const dredd::ScopedPhaseTimer timer(
+                run_statistics_or_null,
+                dredd::RunStatistics::Phase::kSerialise,
+                deferred_file.GetFilename());
+            mutation_info_writer->Write(
+                deferred_file.GetMutationInfoForFile(mutation_id));
+          }
+          mutation_id += deferred_file.GetNumMutations();
+          return result;
+        },
+        files_with_errors);
+    // The runtime is written even if some files could not be mutated, as the
+    // files that were mutated depend on it.
+    if (shared_runtime != nullptr && !shared_runtime->Write(runtime_dir)) {
+      return_code = 1;
+    }
   }
 
-  const dredd::Options dredd_options(!no_mutation_opts, dump_asts,
-                                     only_track_mutant_coverage,
-                                     show_ast_node_types);
+  if (print_phase_timings) {
+    run_statistics.Print(llvm::errs());
+  }
 
-  const std::unique_ptr<clang::tooling::FrontendActionFactory> factory =
-      dredd::NewMutateFrontendActionFactory(dredd_options, mutation_id,
-                                            mutation_info);
+  if (!stats_file.empty() && !run_statistics.WriteReport(stats_file)) {
+    return_code = 1;
+  }
 
-  const int return_code = tool.run(factory.get());
+  if (mutation_cache != nullptr) {
+    llvm::errs() << "Mutation cache: " << mutation_cache->GetNumHits()
+                 << " hit(s), " << mutation_cache->GetNumMisses()
+                 << " miss(es)\n";
+  }
 
   if (return_code == 0) {
-    // Keep release mode compilers happy.
-    (void)text_diagnostic_printer_ptr;
-    assert(text_diagnostic_printer_ptr->getNumErrors() == 0);
-    assert(
-        log_failed_files_diagnostic_consumer_ptr->GetFilesWithErrors().empty());
-  } else {
-    assert(text_diagnostic_printer_ptr->getNumErrors() > 0);
-    assert(!log_failed_files_diagnostic_consumer_ptr->GetFilesWithErrors()
-                .empty());
+    assert(files_with_errors.empty());
+  } else if (!files_with_errors.empty()) {
     llvm::errs() << "The following files were not mutated due to compile-time "
                     "errors; see above for details:\n";
-    for (const auto& file :
-         log_failed_files_diagnostic_consumer_ptr->GetFilesWithErrors()) {
+    for (const auto& file : files_with_errors) {
       llvm::errs() << "  " << file << "\n";
     }
   }
 
-  if (mutation_info.has_value()) {
-    // Write out the mutation info in JSON format for those files that were
-    // successfully mutated.
-    std::string json_string;
-    auto json_options = google::protobuf::util::JsonOptions();
-    json_options.add_whitespace = true;
-    json_options.always_print_primitive_fields = true;
-    auto json_generation_status = google::protobuf::util::MessageToJsonString(
-        mutation_info.value(), &json_string, json_options);
-    if (json_generation_status.ok()) {
-      std::ofstream transformations_json_file(mutation_info_file);
-      transformations_json_file << json_string;
-    } else {
-      llvm::errs() << "Error writing JSON data to " << mutation_info_file
-                   << "\n";
-      return 1;
-    }
+  // The mutation info for those files that were successfully mutated has
+  // already been written out; it only remains to complete it.
+  if (mutation_info_writer != nullptr && !mutation_info_writer->Finish()) {
+    llvm::errs() << "Error writing mutation info to " << mutation_info_file
+                 << "\n";
+    return 1;
   }
   return return_code;
 }
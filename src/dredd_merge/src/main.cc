@@ -0,0 +1,251 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/mutation_info_writer.h"
+#include "libdredd/options.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/shard_file.h"
+#include "libdredd/shared_runtime.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#elif defined(__GNUC__)
+#pragma GCC diagnostic push
+#elif defined(_MSC_VER)
+#pragma warning(push)
+#endif
+
+// Set up the command line options
+// NOLINTNEXTLINE
+static llvm::cl::OptionCategory merge_category("merge options");
+// NOLINTNEXTLINE
+static llvm::cl::list<std::string> shard_files(
+    llvm::cl::Positional,
+    llvm::cl::desc("<shard files produced by dredd --shard i/N, one per "
+                   "shard>"),
+    llvm::cl::OneOrMore, llvm::cl::cat(merge_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<std::string> mutation_info_file(
+    "mutation-info-file",
+    llvm::cl::desc(".json file into which merged mutation information should "
+                   "be written"),
+    llvm::cl::cat(merge_category));
+// NOLINTNEXTLINE
+static llvm::cl::opt<dredd::MutationInfoWriter::Format> mutation_info_format(
+    "mutation-info-format",
+    llvm::cl::desc("Format in which merged mutation information is written"),
+    llvm::cl::values(
+        clEnumValN(dredd::MutationInfoWriter::Format::kJson, "json",
+                   "a single JSON object (the default)"),
+        clEnumValN(dredd::MutationInfoWriter::Format::kJsonLines, "jsonl",
+                   "JSON Lines, with one line per source file"),
+        clEnumValN(dredd::MutationInfoWriter::Format::kBinary, "binary",
+                   "a compact binary format, indexed by mutant id, that can "
+                   "be memory-mapped")),
+    llvm::cl::init(dredd::MutationInfoWriter::Format::kJson),
+    llvm::cl::cat(merge_category));
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#elif defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+int main(int argc, const char** argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+  llvm::cl::HideUnrelatedOptions(merge_category);
+  llvm::cl::ParseCommandLineOptions(
+      argc, argv,
+      "Merges the shard files produced by running dredd with --shard, "
+      "assigning mutant ids and writing out the mutated source files. The "
+      "result is the same as if dredd had been run on all source files at "
+      "once.\n");
+
+  // Open all shard files and check that their headers are consistent.
+  std::vector<std::unique_ptr<dredd::ShardFileReader>> shard_file_readers;
+  std::set<uint32_t> shard_indices;
+  std::optional<dredd::protobufs::ShardHeader> first_shard_header;
+  for (const auto& shard_file : shard_files) {
+    shard_file_readers.push_back(
+        std::make_unique<dredd::ShardFileReader>(shard_file));
+    dredd::protobufs::ShardHeader shard_header;
+    if (!shard_file_readers.back()->IsOpen() ||
+        !shard_file_readers.back()->ReadHeader(shard_header)) {
+      llvm::errs() << "Error reading shard file " << shard_file << "\n";
+      return 1;
+    }
+    if (!first_shard_header.has_value()) {
+      first_shard_header = shard_header;
+    } else if (shard_header.num_shards() != first_shard_header->num_shards() ||
+               shard_header.only_track_mutant_coverage() !=
+                   first_shard_header->only_track_mutant_coverage() ||
+               shard_header.coverage_tracking_output_dir() !=
+                   first_shard_header->coverage_tracking_output_dir() ||
+               shard_header.source_root() !=
+                   first_shard_header->source_root() ||
+               shard_header.runtime_dir() !=
+                   first_shard_header->runtime_dir() ||
+               shard_header.use_global_mutant_registry() !=
+                   first_shard_header->use_global_mutant_registry()) {
+      llvm::errs() << "Shard file " << shard_file
+                   << " is inconsistent with the other shard files.\n";
+      return 1;
+    }
+    if (shard_header.shard_index() >= shard_header.num_shards() ||
+        !shard_indices.insert(shard_header.shard_index()).second) {
+      llvm::errs() << "Shard file " << shard_file << " has unexpected shard "
+                   << shard_header.shard_index() << ".\n";
+      return 1;
+    }
+  }
+  if (shard_indices.size() != first_shard_header->num_shards()) {
+    llvm::errs() << "Expected " << first_shard_header->num_shards()
+                 << " shard files, one per shard, but got "
+                 << shard_indices.size() << ".\n";
+    return 1;
+  }
+
+  // The prelude that is added to each mutated file only depends on whether
+  // mutant coverage is being tracked, on whether a shared runtime is used and
+  // on whether the global mutant registry is used.
+  const std::string& coverage_tracking_output_dir =
+      first_shard_header->coverage_tracking_output_dir();
+  const std::string& runtime_dir = first_shard_header->runtime_dir();
+  const dredd::Options dredd_options(
+      true, false, first_shard_header->only_track_mutant_coverage(), false,
+      false, !coverage_tracking_output_dir.empty(), !runtime_dir.empty(),
+      first_shard_header->use_global_mutant_registry());
+  std::unique_ptr<dredd::SharedRuntime> shared_runtime;
+  if (!runtime_dir.empty()) {
+    shared_runtime = std::make_unique<dredd::SharedRuntime>(dredd_options);
+  }
+
+  // Each shard file lists its entries in increasing order of source index. The
+  // entries of all shards are merged in order of source index, so that mutant
+  // ids are assigned exactly as they would be had all source files been
+  // mutated at once. Only one entry per shard is held in memory at a time.
+  std::vector<std::optional<dredd::protobufs::ShardFileEntry>> next_entries(
+      shard_file_readers.size());
+  auto read_next_entry = [&shard_file_readers, &next_entries](
+                             size_t shard_file_index) -> bool {
+    dredd::protobufs::ShardFileEntry entry;
+    if (shard_file_readers[shard_file_index]->ReadEntry(entry)) {
+      next_entries[shard_file_index] = std::move(entry);
+      return true;
+    }
+    next_entries[shard_file_index] = std::nullopt;
+    if (shard_file_readers[shard_file_index]->HadError()) {
+      llvm::errs() << "Error reading shard file "
+                   << shard_files[shard_file_index] << "\n";
+      return false;
+    }
+    return true;
+  };
+  for (size_t i = 0; i < shard_file_readers.size(); i++) {
+    if (!read_next_entry(i)) {
+      return 1;
+    }
+  }
+
+  std::unique_ptr<dredd::MutationInfoWriter> mutation_info_writer;
+  if (!mutation_info_file.empty()) {
+    mutation_info_writer = std::make_unique<dredd::MutationInfoWriter>(
+        mutation_info_file, mutation_info_format);
+    if (!mutation_info_writer->IsOpen()) {
+      llvm::errs() << "Error opening " << mutation_info_file
+                   << " for writing.\n";
+      return 1;
+    }
+  }
+
+  int return_code = 0;
+  int mutation_id = 0;
+  std::optional<uint32_t> previous_source_index;
+  while (true) {
+    std::optional<size_t> next_shard_file_index;
+    for (size_t i = 0; i < next_entries.size(); i++) {
+      if (next_entries[i].has_value() &&
+          (!next_shard_file_index.has_value() ||
+           next_entries[i]->source_index() <
+               next_entries[next_shard_file_index.value()]->source_index())) {
+        next_shard_file_index = i;
+      }
+    }
+    if (!next_shard_file_index.has_value()) {
+      break;
+    }
+    const dredd::protobufs::ShardFileEntry entry =
+        std::move(next_entries[next_shard_file_index.value()].value());
+    if (previous_source_index.has_value() &&
+        entry.source_index() <= previous_source_index.value()) {
+      llvm::errs() << "Shard files are inconsistent: source file "
+                   << entry.source_index()
+                   << " appears out of order or in multiple shards.\n";
+      return 1;
+    }
+    previous_source_index = entry.source_index();
+
+    const dredd::DeferredMutatedFile deferred_file =
+        dredd::DeferredMutatedFile::FromProtobuf(entry.deferred_mutated_file());
+    if (shared_runtime != nullptr) {
+      shared_runtime->AddFile(deferred_file);
+    }
+    if (!deferred_file.WriteMutatedText(dredd_options, mutation_id)) {
+      return_code = 1;
+    }
+    if (deferred_file.HasCoverageTrackingText() &&
+        !deferred_file.WriteCoverageTrackingText(
+            dredd_options, mutation_id, first_shard_header->source_root(),
+            coverage_tracking_output_dir)) {
+      return_code = 1;
+    }
+    if (mutation_info_writer != nullptr) {
+      mutation_info_writer->Write(
+          deferred_file.GetMutationInfoForFile(mutation_id));
+    }
+    mutation_id += deferred_file.GetNumMutations();
+
+    if (!read_next_entry(next_shard_file_index.value())) {
+      return 1;
+    }
+  }
+
+  if (shared_runtime != nullptr && !shared_runtime->Write(runtime_dir)) {
+    return_code = 1;
+  }
+
+  if (mutation_info_writer != nullptr && !mutation_info_writer->Finish()) {
+    llvm::errs() << "Error writing mutation info to " << mutation_info_file
+                 << "\n";
+    return 1;
+  }
+  return return_code;
+}
@@ -0,0 +1,154 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_DEFERRED_MUTATED_FILE_H
+#define LIBDREDD_DEFERRED_MUTATED_FILE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libdredd/options.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+
+namespace dredd {
+
+// Captures the result of mutating a source file using file-local mutation ids,
+// i.e. ids that start from zero, without writing the mutated file out. The
+// prelude is the only part of a mutated file that depends on global mutation
+// ids, so the rewritten text either side of the point where the prelude should
+// be inserted is recorded. This allows files to be mutated independently (e.g.
+// in parallel) and then emitted in a deterministic order, yielding exactly the
+// same result as mutating the files one after another.
+class DeferredMutatedFile {
+ public:
+  DeferredMutatedFile(std::string filename, std::string output_path,
+                      bool is_cpp, int num_mutations,
+                      std::string text_before_prelude,
+                      std::string text_after_prelude,
+                      protobufs::MutationInfoForFile mutation_info_for_file,
+                      bool has_coverage_tracking_text,
+                      std::string coverage_tracking_text_before_prelude,
+                      std::string coverage_tracking_text_after_prelude,
+                      std::vector<std::string> dredd_declarations)
+      : filename_(std::move(filename)),
+        output_path_(std::move(output_path)),
+        is_cpp_(is_cpp),
+        num_mutations_(num_mutations),
+        text_before_prelude_(std::move(text_before_prelude)),
+        text_after_prelude_(std::move(text_after_prelude)),
+        mutation_info_for_file_(std::move(mutation_info_for_file)),
+        has_coverage_tracking_text_(has_coverage_tracking_text),
+        coverage_tracking_text_before_prelude_(
+            std::move(coverage_tracking_text_before_prelude)),
+        coverage_tracking_text_after_prelude_(
+            std::move(coverage_tracking_text_after_prelude)),
+        dredd_declarations_(std::move(dredd_declarations)) {}
+
+  // Reconstructs a deferred mutated file from its protobuf representation.
+  [[nodiscard]] static DeferredMutatedFile FromProtobuf(
+      const protobufs::DeferredMutatedFile& deferred_mutated_file);
+
+  // Yields a protobuf representation of this deferred mutated file, so that it
+  // can be saved and later written out by a separate process.
+  [[nodiscard]] protobufs::DeferredMutatedFile ToProtobuf() const;
+
+  [[nodiscard]] const std::string& GetFilename() const { return filename_; }
+
+  [[nodiscard]] int GetNumMutations() const { return num_mutations_; }
+
+  [[nodiscard]] bool IsCpp() const { return is_cpp_; }
+
+  [[nodiscard]] const std::vector<std::string>& GetDreddDeclarations() const {
+    return dredd_declarations_;
+  }
+
+  // Yields the mutated source file, with a prelude suitable for the first
+  // mutation in the file having global id |initial_mutation_id|.
+  [[nodiscard]] std::string GetMutatedText(const Options& options,
+                                           int initial_mutation_id) const;
+
+  // Overwrites the original source file with the result of GetMutatedText.
+  // Returns true if and only if writing succeeded.
+  [[nodiscard]] bool WriteMutatedText(const Options& options,
+                                      int initial_mutation_id) const;
+
+  // Yields the mutation info for the file, with mutation ids made global by
+  // adding |initial_mutation_id|.
+  [[nodiscard]] protobufs::MutationInfoForFile GetMutationInfoForFile(
+      int initial_mutation_id) const;
+
+  [[nodiscard]] bool HasCoverageTrackingText() const {
+    return has_coverage_tracking_text_;
+  }
+
+  // Yields the version of the file that only tracks mutant coverage, with a
+  // prelude suitable for the first mutation in the file having global id
+  // |initial_mutation_id|. Requires HasCoverageTrackingText().
+  [[nodiscard]] std::string GetCoverageTrackingText(
+      const Options& options, int initial_mutation_id) const;
+
+  // Yields the path to which the version of the file that only tracks mutant
+  // coverage should be written: the output path, made relative to
+  // |source_root|, under |coverage_tracking_output_dir|. Yields an empty string
+  // if the output path is not under |source_root|.
+  [[nodiscard]] std::string GetCoverageTrackingOutputPath(
+      const std::string& source_root,
+      const std::string& coverage_tracking_output_dir) const;
+
+  // Writes the result of GetCoverageTrackingText to the path given by
+  // GetCoverageTrackingOutputPath, creating directories as needed. Returns true
+  // if and only if writing succeeded.
+  [[nodiscard]] bool WriteCoverageTrackingText(
+      const Options& options, int initial_mutation_id,
+      const std::string& source_root,
+      const std::string& coverage_tracking_output_dir) const;
+
+ private:
+  // The name of the file, as recorded in mutation info.
+  std::string filename_;
+
+  // The absolute path to which the mutated file should be written.
+  std::string output_path_;
+
+  // True if and only if the file was processed as C++, rather than C.
+  bool is_cpp_;
+
+  int num_mutations_;
+
+  std::string text_before_prelude_;
+
+  std::string text_after_prelude_;
+
+  // Mutation info for the file, using file-local mutation ids.
+  protobufs::MutationInfoForFile mutation_info_for_file_;
+
+  // True if and only if a version of the file that only tracks mutant coverage
+  // was produced alongside the mutated version, in which case the following
+  // hold its text either side of the prelude.
+  bool has_coverage_tracking_text_;
+
+  std::string coverage_tracking_text_before_prelude_;
+
+  std::string coverage_tracking_text_after_prelude_;
+
+  // When a shared runtime is used, the mutator functions that the file calls
+  // are not part of its text, but are instead recorded here, in sorted order,
+  // so that they can be added to the shared runtime. Empty otherwise.
+  std::vector<std::string> dredd_declarations_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_DEFERRED_MUTATED_FILE_H
@@ -0,0 +1,137 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_EDIT_LIST_H
+#define LIBDREDD_EDIT_LIST_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace dredd {
+
+// Collects the edits that are made to the main file of a translation unit, and
+// materialises the edited file in a single pass once all edits have been made.
+// This is used in place of clang::Rewriter, which applies each edit to its edit
+// buffer as the edit is made.
+//
+// The location-based methods mirror those of clang::Rewriter, so that edits
+// compose in the same way:
+// - text inserted via InsertTextBefore at an offset precedes all text
+//   previously inserted at that offset;
+// - text inserted via InsertTextAfterToken follows all text previously
+//   inserted at the resulting offset;
+// - replacement text follows all text inserted at the offset at which the
+//   replaced range starts.
+// Replaced ranges must not overlap one another, and no text may be inserted
+// strictly inside a replaced range; these invariants are checked when the
+// edits are materialised.
+class EditList {
+ public:
+  EditList(const clang::SourceManager& source_manager,
+           const clang::LangOptions& lang_options);
+
+  EditList(const EditList&) = delete;
+
+  EditList& operator=(const EditList&) = delete;
+
+  EditList(EditList&&) = delete;
+
+  EditList& operator=(EditList&&) = delete;
+
+  ~EditList() = default;
+
+  // As with clang::Rewriter, each of the following returns true if the edit
+  // could not be made, which happens if the given location is not in the main
+  // file.
+  bool InsertTextBefore(clang::SourceLocation location, llvm::StringRef text);
+
+  bool InsertTextAfterToken(clang::SourceLocation location,
+                            llvm::StringRef text);
+
+  bool ReplaceText(clang::SourceLocation start, unsigned int length,
+                   llvm::StringRef text);
+
+  // Replaces the text of the token range |range|.
+  bool ReplaceText(clang::SourceRange range, llvm::StringRef text);
+
+  // Offset-based counterparts of the above, where offsets are with respect to
+  // the original text of the main file.
+  void InsertBefore(unsigned int offset, llvm::StringRef text);
+
+  void InsertAfter(unsigned int offset, llvm::StringRef text);
+
+  void Replace(unsigned int offset, unsigned int length, llvm::StringRef text);
+
+  [[nodiscard]] bool IsEmpty() const { return edits_.empty(); }
+
+  [[nodiscard]] size_t GetNumEdits() const { return edits_.size(); }
+
+  // Yields the offset of |location| in the main file.
+  [[nodiscard]] unsigned int GetOffset(clang::SourceLocation location) const;
+
+  // Yields the edited text of the main file.
+  [[nodiscard]] std::string GetRewrittenText() const;
+
+  // Yields the edited text of the main file either side of |offset|. The text
+  // after |offset| starts with any text that was inserted at |offset|, so that
+  // text inserted between the two parts is placed as if by InsertTextBefore.
+  [[nodiscard]] std::pair<std::string, std::string> GetRewrittenTextSplitAt(
+      unsigned int offset) const;
+
+ private:
+  enum class Kind { kInsertBefore, kInsertAfter, kReplace };
+
+  struct Edit {
+    unsigned int offset;
+    Kind kind;
+    unsigned int length;
+    // The order in which the edit was made, used to order edits of the same
+    // kind at the same offset.
+    size_t sequence_number;
+    std::string text;
+  };
+
+  // Checks that |location| is in the main file, yielding its offset via
+  // |offset| if so.
+  [[nodiscard]] bool IsRewritable(clang::SourceLocation location,
+                                  unsigned int& offset) const;
+
+  // Sorts the edits into the order in which they are to be applied, and
+  // applies them to the original text of the main file. The length of the
+  // result prior to the first edit at |split_offset| is recorded in
+  // |split_position|.
+  [[nodiscard]] std::string Materialise(unsigned int split_offset,
+                                        size_t& split_position) const;
+
+  const clang::SourceManager* source_manager_;
+
+  const clang::LangOptions* lang_options_;
+
+  clang::FileID main_file_id_;
+
+  llvm::StringRef original_text_;
+
+  std::vector<Edit> edits_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_EDIT_LIST_H
@@ -0,0 +1,80 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_EXPR_ANALYSIS_CACHE_H
+#define LIBDREDD_EXPR_ANALYSIS_CACHE_H
+
+#include <optional>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Expr.h"
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/DenseMap.h"
+
+namespace dredd {
+
+// Memoises the results of (potentially expensive) queries about expressions,
+// such as attempts to evaluate them as constants, so that each query is
+// performed at most once per expression. Whether an expression is considered
+// for mutation, and how it is mutated, depends on such queries, which are made
+// repeatedly for the same expression by the visitor and by the mutations that
+// it creates. A cache should be used for a single translation unit.
+class ExprAnalysisCache {
+ public:
+  explicit ExprAnalysisCache(const clang::ASTContext& ast_context);
+
+  ExprAnalysisCache(const ExprAnalysisCache&) = delete;
+
+  ExprAnalysisCache& operator=(const ExprAnalysisCache&) = delete;
+
+  ExprAnalysisCache(ExprAnalysisCache&&) = delete;
+
+  ExprAnalysisCache& operator=(ExprAnalysisCache&&) = delete;
+
+  ~ExprAnalysisCache() = default;
+
+  // Yields the value of the expression according to EvaluateAsInt, or an empty
+  // optional if it does not evaluate to an integer.
+  [[nodiscard]] std::optional<llvm::APSInt> GetIntValue(
+      const clang::Expr& expr);
+
+  // Yields the value of the expression according to EvaluateAsFloat, or an
+  // empty optional if it does not evaluate to a float.
+  [[nodiscard]] std::optional<llvm::APFloat> GetFloatValue(
+      const clang::Expr& expr);
+
+  // Yields the value of the expression according to
+  // EvaluateAsBooleanCondition, or an empty optional if it cannot be evaluated
+  // as a boolean condition.
+  [[nodiscard]] std::optional<bool> GetBoolValue(const clang::Expr& expr);
+
+  [[nodiscard]] bool HasSideEffects(const clang::Expr& expr);
+
+  [[nodiscard]] bool IsCxx11ConstantExpr(const clang::Expr& expr);
+
+ private:
+  const clang::ASTContext* ast_context_;
+
+  llvm::DenseMap<const clang::Expr*, std::optional<llvm::APSInt>> int_values_;
+  llvm::DenseMap<const clang::Expr*, std::optional<llvm::APFloat>>
+      float_values_;
+  llvm::DenseMap<const clang::Expr*, std::optional<bool>> bool_values_;
+  llvm::DenseMap<const clang::Expr*, bool> has_side_effects_;
+  llvm::DenseMap<const clang::Expr*, bool> is_cxx11_constant_expr_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_EXPR_ANALYSIS_CACHE_H
@@ -0,0 +1,66 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_FUNCTION_FILTER_H
+#define LIBDREDD_FUNCTION_FILTER_H
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Regex.h"
+
+namespace dredd {
+
+// Determines which functions may be mutated, based on regular expressions that
+// are matched against the qualified names of functions, such as
+// "logging::Logger::Write". A pattern must match the whole of a name.
+class FunctionFilter {
+ public:
+  // Adds a pattern that a function must match to be mutated. If no such
+  // patterns are added, every function that is not skipped is mutated.
+  // Returns true if and only if |pattern| is a valid regular expression;
+  // otherwise |error_message| describes the problem.
+  [[nodiscard]] bool AddMutatePattern(const std::string& pattern,
+                                      std::string& error_message);
+
+  // Adds a pattern that causes matching functions not to be mutated. Skip
+  // patterns take precedence over mutate patterns.
+  [[nodiscard]] bool AddSkipPattern(const std::string& pattern,
+                                    std::string& error_message);
+
+  [[nodiscard]] bool ShouldMutate(llvm::StringRef qualified_name) const;
+
+  // Yields a description of the filter that changes if and only if the
+  // filter changes.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  static bool AddPattern(const std::string& pattern,
+                         std::vector<std::string>& patterns,
+                         std::vector<llvm::Regex>& regexes,
+                         std::string& error_message);
+
+  static bool MatchesAny(const std::vector<llvm::Regex>& regexes,
+                         llvm::StringRef qualified_name);
+
+  std::vector<std::string> mutate_patterns_;
+  std::vector<llvm::Regex> mutate_regexes_;
+  std::vector<std::string> skip_patterns_;
+  std::vector<llvm::Regex> skip_regexes_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_FUNCTION_FILTER_H
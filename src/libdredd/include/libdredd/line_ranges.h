@@ -0,0 +1,94 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_LINE_RANGES_H
+#define LIBDREDD_LINE_RANGES_H
+
+#include <map>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace dredd {
+
+// A set of lines of a single source file, stored as disjoint, non-adjacent
+// ranges of 1-based line numbers.
+class LineRanges {
+ public:
+  // Adds lines |first_line| to |last_line| inclusive.
+  void Add(unsigned int first_line, unsigned int last_line);
+
+  // Returns true if and only if at least one of lines |first_line| to
+  // |last_line| inclusive is in the set.
+  [[nodiscard]] bool Overlaps(unsigned int first_line,
+                              unsigned int last_line) const;
+
+  [[nodiscard]] bool IsEmpty() const { return ranges_.empty(); }
+
+  // Yields the ranges in the form "a-b,c,d-e", as accepted by
+  // ParseLineRangesSpecification.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  // Maps the first line of each range to its last line.
+  std::map<unsigned int, unsigned int> ranges_;
+};
+
+// Restricts mutation to the given lines of the given source files; no
+// mutations are applied to a source file of which no lines are given.
+class LineRangeFilter {
+ public:
+  void Add(const std::string& filename, unsigned int first_line,
+           unsigned int last_line);
+
+  // Yields the lines of |filename| that may be mutated, which are empty if no
+  // lines of the file have been added.
+  [[nodiscard]] LineRanges GetLineRangesForFile(
+      const std::string& filename) const;
+
+  // Yields a description of the filter that changes if and only if the
+  // filter changes.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  // Relative paths are made absolute with respect to the current directory,
+  // and symbolic links are resolved where possible, so that the same file is
+  // identified in the same way whichever path is used to refer to it.
+  static std::string NormalisePath(llvm::StringRef filename);
+
+  std::map<std::string, LineRanges> line_ranges_;
+};
+
+// Adds the lines given by |specification| to |filter|. The specification has
+// the form "file:ranges", where ranges is a comma-separated list of line
+// numbers and inclusive ranges of line numbers, e.g. "src/foo.cc:3,10-20".
+// Returns true if and only if the specification is valid; otherwise
+// |error_message| describes the problem.
+[[nodiscard]] bool ParseLineRangesSpecification(llvm::StringRef specification,
+                                                LineRangeFilter& filter,
+                                                std::string& error_message);
+
+// Adds the lines that a unified diff, such as that produced by "git diff",
+// adds or changes in the new version of each file to |filter|. Where lines are
+// only removed, the lines either side of them are considered changed. File
+// names have their "b/" prefix removed, if present, and relative file names are
+// resolved against the current directory. Returns true if and only if the diff
+// can be parsed; otherwise |error_message| describes the problem.
+[[nodiscard]] bool ParseUnifiedDiff(llvm::StringRef diff,
+                                    LineRangeFilter& filter,
+                                    std::string& error_message);
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_LINE_RANGES_H
@@ -20,7 +20,7 @@
 
 #include "clang/AST/ASTContext.h"
 #include "clang/Lex/Preprocessor.h"
-#include "clang/Rewrite/Core/Rewriter.h"
+#include "libdredd/edit_list.h"
 #include "libdredd/options.h"
 #include "libdredd/protobufs/dredd_protobufs.h"
 
@@ -52,8 +52,16 @@ class Mutation {
   virtual protobufs::MutationGroup Apply(
       clang::ASTContext& ast_context, const clang::Preprocessor& preprocessor,
       const Options& options, int first_mutation_id_in_file, int& mutation_id,
-      clang::Rewriter& rewriter,
+      EditList& edit_list,
       std::unordered_set<std::string>& dredd_declarations) const = 0;
+
+  // Yields the mutants that Apply would produce with the given options,
+  // advancing |mutation_id| as Apply would, but without making any edits or
+  // generating any code. Only the mutation ids and actions of the mutants are
+  // recorded in the result; source locations and snippets are not.
+  virtual protobufs::MutationGroup CountInstances(
+      clang::ASTContext& ast_context, const Options& options,
+      int& mutation_id) const = 0;
 };
 
 }  // namespace dredd
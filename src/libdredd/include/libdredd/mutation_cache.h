@@ -0,0 +1,98 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_MUTATION_CACHE_H
+#define LIBDREDD_MUTATION_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "libdredd/deferred_mutated_file.h"
+
+namespace dredd {
+
+// An on-disk cache of the results of mutating source files, so that source
+// files that have not changed since a previous run of Dredd need not be parsed
+// again.
+//
+// An entry is keyed by a hash of the contents of the source file, the compile
+// commands for the source file, and a fingerprint capturing everything else
+// that affects mutation (such as the build of Dredd and the options in use).
+// The entry records every file that was read while mutating the source file,
+// together with a hash of its contents, and is only used if none of these files
+// has changed. Because the prelude is the only part of a mutated file that
+// depends on global mutation ids, entries hold deferred mutated files, which
+// use file-local mutation ids.
+//
+// Each entry is written to its own file as soon as the corresponding source
+// file has been mutated, and entries are written atomically. A run that is
+// interrupted can therefore be resumed, by running Dredd again on the original
+// source files with the same cache directory.
+//
+// Lookups and stores may be performed concurrently from multiple threads.
+class MutationCache {
+ public:
+  MutationCache(std::string cache_directory, std::string fingerprint);
+
+  MutationCache(const MutationCache&) = delete;
+
+  MutationCache& operator=(const MutationCache&) = delete;
+
+  MutationCache(MutationCache&&) = delete;
+
+  MutationCache& operator=(MutationCache&&) = delete;
+
+  // Yields the key for the result of mutating |source_path| using
+  // |compile_commands|, or std::nullopt if |source_path| cannot be read.
+  [[nodiscard]] std::optional<std::string> ComputeKey(
+      const std::string& source_path,
+      const std::vector<clang::tooling::CompileCommand>& compile_commands)
+      const;
+
+  // If a valid entry exists for |key|, appends the deferred mutated files that
+  // it holds to |deferred_files| and returns true. Otherwise, returns false.
+  [[nodiscard]] bool Lookup(const std::string& key,
+                            std::vector<DeferredMutatedFile>& deferred_files);
+
+  // Records the result of mutating a source file. |dependencies| are the files
+  // that were read in the process; relative paths are resolved against
+  // |working_directory|. Returns true if and only if the entry was written.
+  [[nodiscard]] bool Store(
+      const std::string& key, const std::string& working_directory,
+      const std::vector<std::string>& dependencies,
+      const std::vector<DeferredMutatedFile>& deferred_files) const;
+
+  [[nodiscard]] uint64_t GetNumHits() const { return num_hits_; }
+
+  [[nodiscard]] uint64_t GetNumMisses() const { return num_misses_; }
+
+ private:
+  [[nodiscard]] std::string GetEntryPath(const std::string& key) const;
+
+  std::string cache_directory_;
+
+  std::string fingerprint_;
+
+  std::atomic<uint64_t> num_hits_ = 0;
+
+  std::atomic<uint64_t> num_misses_ = 0;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_MUTATION_CACHE_H
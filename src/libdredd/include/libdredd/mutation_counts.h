@@ -0,0 +1,79 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_MUTATION_COUNTS_H
+#define LIBDREDD_MUTATION_COUNTS_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace dredd {
+
+// Yields the kind and the name of the action of each mutant in
+// |mutation_group|, e.g. ("replace_binary_operator", "ReplaceWithAdd"). The
+// action of a statement removal mutant is "RemoveStmt".
+std::vector<std::pair<std::string, std::string>> GetMutantKindsAndActions(
+    const protobufs::MutationGroup& mutation_group);
+
+// Accumulates the number of mutants of each kind and action found in a single
+// source file, both overall and per function.
+class MutationCounter {
+ public:
+  MutationCounter() = default;
+
+  MutationCounter(const MutationCounter&) = delete;
+
+  MutationCounter& operator=(const MutationCounter&) = delete;
+
+  MutationCounter(MutationCounter&&) = delete;
+
+  MutationCounter& operator=(MutationCounter&&) = delete;
+
+  ~MutationCounter() = default;
+
+  // Records the mutants in |mutation_group|, which were found in the function
+  // named |function_name|; this is empty if they were not found in a function.
+  void Add(const std::string& function_name,
+           const protobufs::MutationGroup& mutation_group);
+
+  [[nodiscard]] protobufs::FileMutationCounts GetCountsForFile(
+      const std::string& filename) const;
+
+ private:
+  // Maps each function name to the number of mutants of each kind and action
+  // in that function. Ordered maps are used so that counts are reported in a
+  // deterministic order.
+  std::map<std::string, std::map<std::pair<std::string, std::string>, int32_t>>
+      counts_;
+};
+
+// Adds |file_counts| to the end of the files in |counts|, and adds its
+// mutants to the totals of |counts|.
+void AddFileMutationCounts(const protobufs::FileMutationCounts& file_counts,
+                           protobufs::MutationCounts& counts);
+
+// Writes |counts| to |stream| as JSON. Returns true if and only if the counts
+// could be converted to JSON.
+[[nodiscard]] bool WriteMutationCounts(const protobufs::MutationCounts& counts,
+                                       llvm::raw_ostream& stream);
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_MUTATION_COUNTS_H
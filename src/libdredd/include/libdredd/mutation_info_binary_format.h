@@ -0,0 +1,87 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_MUTATION_INFO_BINARY_FORMAT_H
+#define LIBDREDD_MUTATION_INFO_BINARY_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Describes the compact binary format in which Dredd can write mutation info
+// (--mutation-info-format=binary). The format is designed to be memory-mapped:
+// a tool can look up any mutant in constant time, without decoding the
+// information about all other mutants. scripts/query_mutant_info.py contains a
+// reader for the format, and can export it as JSON.
+//
+// All fixed-width integers are little-endian. A "varint" is an unsigned LEB128
+// integer, and a "signed varint" is a zigzag-encoded varint. A file consists
+// of:
+//
+// - A header: the magic bytes kMutationInfoBinaryMagic, followed by the format
+//   version as a 4-byte integer and 4 reserved bytes.
+//
+// - For each source file, in the order in which the files were mutated: a
+//   record for each mutation group in the file's mutation tree, in node order,
+//   followed by the shape of the tree. A mutation group record is:
+//     - 1 byte: the kind of the group, a protobufs::MutationGroup::GroupCase.
+//     - The source locations of the group, in proto field order. The first is
+//       a varint line and varint column; each later location is a signed
+//       varint line delta, relative to the first line, and a varint column.
+//     - The ids of the group's snippets in the string table, in proto field
+//       order, as varints.
+//     - For binary and unary operator groups, the operator as a varint.
+//     - The number of instances as a varint; for each instance, its action
+//       as a varint and its mutation id as a signed varint delta, relative to
+//       the mutation id of the previous instance (or to 0). A statement
+//       removal group has one instance, whose action is 0.
+//   The tree shape is the number of nodes as a varint, and, for each node,
+//   its number of mutation groups, its number of children and the indices of
+//   its children, all as varints.
+//
+// - Padding to a multiple of 8 bytes, followed by the string table: 8-byte
+//   offsets of each string, plus an end offset, relative to the start of the
+//   string data, followed by the string data. File names and snippets are
+//   interned in this table.
+//
+// - The file table: for each source file, a kMutationInfoBinaryFileEntrySize
+//   byte entry holding the 8-byte offset of its first mutation group record,
+//   the 8-byte offset of its tree shape, the 4-byte string id of its filename
+//   and 4 reserved bytes.
+//
+// - The mutant index: for each mutation id from 0 up to the largest mutation
+//   id, a kMutationInfoBinaryMutantEntrySize byte entry holding the 8-byte
+//   offset of the record of the mutation group to which the mutant belongs
+//   (0 if there is no such mutant), the 4-byte index of its source file in the
+//   file table, its 1-byte group kind, 1 reserved byte and its 2-byte action.
+//
+// - A kMutationInfoBinaryFooterSize byte footer: the 8-byte offset of the
+//   string table, the number of strings, the offset of the file table, the
+//   number of files, the offset of the mutant index and the number of mutant
+//   index entries, each as 8-byte integers, followed by the magic bytes
+//   kMutationInfoBinaryFooterMagic.
+
+namespace dredd {
+
+constexpr const char* kMutationInfoBinaryMagic = "DREDDBIN";
+constexpr const char* kMutationInfoBinaryFooterMagic = "DREDDEND";
+constexpr size_t kMutationInfoBinaryMagicSize = 8;
+constexpr uint32_t kMutationInfoBinaryVersion = 1;
+constexpr size_t kMutationInfoBinaryHeaderSize = 16;
+constexpr size_t kMutationInfoBinaryFileEntrySize = 24;
+constexpr size_t kMutationInfoBinaryMutantEntrySize = 16;
+constexpr size_t kMutationInfoBinaryFooterSize = 56;
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_MUTATION_INFO_BINARY_FORMAT_H
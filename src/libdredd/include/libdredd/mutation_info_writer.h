@@ -0,0 +1,136 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_MUTATION_INFO_WRITER_H
+#define LIBDREDD_MUTATION_INFO_WRITER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace dredd {
+
+// Writes mutation info to a file incrementally, one source file at a time, so
+// that the mutation info for all source files never needs to be held in memory
+// at once, and so that the mutation info for the source files processed so far
+// is on disk if Dredd is interrupted.
+class MutationInfoWriter {
+ public:
+  enum class Format {
+    // A single JSON object, whose "infoForFiles" array holds the mutation info
+    // for each source file. This is the JSON representation of a
+    // protobufs::MutationInfo message.
+    kJson,
+    // JSON Lines: one line per source file, holding the JSON representation of
+    // a protobufs::MutationInfoForFile message. Unlike kJson, a file in this
+    // format is still usable if Dredd is interrupted.
+    kJsonLines,
+    // A compact binary format that can be memory-mapped, allowing any mutant
+    // to be looked up in constant time; see mutation_info_binary_format.h.
+    kBinary
+  };
+
+  MutationInfoWriter(const std::string& filename, Format format);
+
+  MutationInfoWriter(const MutationInfoWriter&) = delete;
+
+  MutationInfoWriter& operator=(const MutationInfoWriter&) = delete;
+
+  MutationInfoWriter(MutationInfoWriter&&) = delete;
+
+  MutationInfoWriter& operator=(MutationInfoWriter&&) = delete;
+
+  [[nodiscard]] bool IsOpen() const { return output_stream_.is_open(); }
+
+  // Appends the mutation info for a source file, and flushes the output. Any
+  // error is reported by Finish.
+  void Write(const protobufs::MutationInfoForFile& mutation_info_for_file);
+
+  // Completes the output. Must be invoked exactly once, after the mutation info
+  // for all source files has been written. Returns true if and only if all
+  // writing succeeded.
+  [[nodiscard]] bool Finish();
+
+ private:
+  // An entry in the file table of the binary format.
+  struct BinaryFileEntry {
+    uint64_t groups_offset;
+    uint64_t tree_offset;
+    uint32_t filename_id;
+  };
+
+  // An entry in the mutant index of the binary format. An entry whose
+  // group_offset is 0 does not correspond to a mutant.
+  struct BinaryMutantEntry {
+    uint64_t group_offset;
+    uint32_t file_index;
+    uint8_t kind;
+    uint16_t action;
+  };
+
+  void WriteJson(const protobufs::MutationInfoForFile& mutation_info_for_file);
+
+  void WriteBinary(
+      const protobufs::MutationInfoForFile& mutation_info_for_file);
+
+  // Appends the binary record for a mutation group to |buffer|, which will be
+  // written at |buffer_offset| in the output, and adds the mutants of the
+  // group to the mutant index.
+  void EncodeBinaryMutationGroup(
+      const protobufs::MutationGroup& mutation_group, uint32_t file_index,
+      uint64_t buffer_offset, std::string* buffer);
+
+  // Returns the id of |string| in the string table of the binary format,
+  // adding it if necessary.
+  uint32_t InternString(const std::string& string);
+
+  // Writes the tables and footer of the binary format.
+  void FinishBinary();
+
+  void WriteBuffer(const std::string& buffer);
+
+  std::ofstream output_stream_;
+
+  Format format_;
+
+  bool is_first_entry_ = true;
+
+  bool had_error_ = false;
+
+  // The remaining fields are only used by the binary format, which needs to
+  // know the offset at which each record is written, and which writes its
+  // tables once all source files have been processed. The tables grow with
+  // the number of distinct strings, files and mutants, rather than with the
+  // size of the mutation info.
+  uint64_t bytes_written_ = 0;
+
+  llvm::StringMap<uint32_t> string_ids_;
+
+  // Ordered by id; refers to the keys of string_ids_.
+  std::vector<llvm::StringRef> strings_;
+
+  std::vector<BinaryFileEntry> binary_files_;
+
+  // Indexed by mutation id.
+  std::vector<BinaryMutantEntry> binary_mutants_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_MUTATION_INFO_WRITER_H
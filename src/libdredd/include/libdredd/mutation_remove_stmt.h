@@ -22,10 +22,11 @@
 #include "clang/AST/Stmt.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Lex/Preprocessor.h"
-#include "clang/Rewrite/Core/Rewriter.h"
+#include "libdredd/edit_list.h"
 #include "libdredd/mutation.h"
 #include "libdredd/options.h"
 #include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/source_range_cache.h"
 #include "libdredd/util.h"
 
 namespace dredd {
@@ -33,15 +34,18 @@ namespace dredd {
 class MutationRemoveStmt : public Mutation {
  public:
   MutationRemoveStmt(const clang::Stmt& stmt,
-                     const clang::Preprocessor& preprocessor,
-                     const clang::ASTContext& ast_context);
+                     SourceRangeCache& source_range_cache);
 
   protobufs::MutationGroup Apply(
       clang::ASTContext& ast_context, const clang::Preprocessor& preprocessor,
       const Options& options, int first_mutation_id_in_file, int& mutation_id,
-      clang::Rewriter& rewriter,
+      EditList& edit_list,
       std::unordered_set<std::string>& dredd_declarations) const override;
 
+  protobufs::MutationGroup CountInstances(clang::ASTContext& ast_context,
+                                          const Options& options,
+                                          int& mutation_id) const override;
+
  private:
   // Helper method to determine whether the token immediately following the
   // given source range is the '#' token. This is useful for working around
@@ -24,10 +24,13 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/OperationKinds.h"
 #include "clang/Lex/Preprocessor.h"
-#include "clang/Rewrite/Core/Rewriter.h"
+#include "libdredd/edit_list.h"
+#include "libdredd/expr_analysis_cache.h"
 #include "libdredd/mutation.h"
+#include "libdredd/mutation_selection.h"
 #include "libdredd/options.h"
 #include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/source_range_cache.h"
 #include "libdredd/util.h"
 
 namespace dredd {
@@ -35,44 +38,46 @@ namespace dredd {
 class MutationReplaceBinaryOperator : public Mutation {
  public:
   MutationReplaceBinaryOperator(const clang::BinaryOperator& binary_operator,
-                                const clang::Preprocessor& preprocessor,
-                                const clang::ASTContext& ast_context);
+                                SourceRangeCache& source_range_cache,
+                                ExprAnalysisCache& analysis_cache);
 
   protobufs::MutationGroup Apply(
       clang::ASTContext& ast_context, const clang::Preprocessor& preprocessor,
       const Options& options, int first_mutation_id_in_file, int& mutation_id,
-      clang::Rewriter& rewriter,
+      EditList& edit_list,
       std::unordered_set<std::string>& dredd_declarations) const override;
 
+  protobufs::MutationGroup CountInstances(clang::ASTContext& ast_context,
+                                          const Options& options,
+                                          int& mutation_id) const override;
+
  private:
   std::string GenerateMutatorFunction(
       clang::ASTContext& ast_context, const std::string& function_name,
       const std::string& result_type, const std::string& lhs_type,
       const std::string& rhs_type, bool optimise_mutations,
-      bool only_track_mutant_coverage, int& mutation_id,
+      const MutationSelection& mutation_selection,
+      bool only_track_mutant_coverage, bool use_shared_runtime,
+      int& mutation_id,
       protobufs::MutationReplaceBinaryOperator& protobuf_message) const;
 
   void ReplaceOperator(const std::string& lhs_type, const std::string& rhs_type,
                        const std::string& new_function_name,
                        clang::ASTContext& ast_context,
-                       const clang::Preprocessor& preprocessor,
                        int first_mutation_id_in_file, int mutation_id,
-                       bool show_ast_node_types,
-                       clang::Rewriter& rewriter) const;
+                       const Options& options, EditList& edit_list) const;
 
   std::string GetFunctionName(bool optimise_mutations,
                               clang::ASTContext& ast_context) const;
 
   [[nodiscard]] bool IsRedundantReplacementOperator(
-      clang::BinaryOperatorKind operator_kind,
-      const clang::ASTContext& ast_context) const;
+      clang::BinaryOperatorKind operator_kind) const;
 
   [[nodiscard]] bool IsRedundantReplacementForBooleanValuedOperator(
       clang::BinaryOperatorKind operator_kind) const;
 
   [[nodiscard]] bool IsRedundantReplacementForArithmeticOperator(
-      clang::BinaryOperatorKind operator_kind,
-      const clang::ASTContext& ast_context) const;
+      clang::BinaryOperatorKind operator_kind) const;
 
   [[nodiscard]] bool IsValidReplacementOperator(
       clang::BinaryOperatorKind operator_kind) const;
@@ -80,21 +85,26 @@ class MutationReplaceBinaryOperator : public Mutation {
   // Replaces binary expressions with either the left or right operand.
   void GenerateArgumentReplacement(
       const std::string& arg1_evaluated, const std::string& arg2_evaluated,
-      const clang::ASTContext& ast_context, bool optimise_mutations,
+      bool optimise_mutations, const MutationSelection& mutation_selection,
       bool only_track_mutant_coverage, int mutation_id_base,
-      std::stringstream& new_function, int& mutation_id_offset,
+      std::stringstream& new_function,
+      int& mutation_id_offset,
       protobufs::MutationReplaceBinaryOperator& protobuf_message) const;
 
   // Replaces binary operators with other valid binary operators.
   void GenerateBinaryOperatorReplacement(
       const std::string& arg1_evaluated, const std::string& arg2_evaluated,
-      const clang::ASTContext& ast_context, bool optimise_mutations,
+      bool optimise_mutations, const MutationSelection& mutation_selection,
       bool only_track_mutant_coverage, int mutation_id_base,
-      std::stringstream& new_function, int& mutation_id_offset,
+      std::stringstream& new_function,
+      int& mutation_id_offset,
       protobufs::MutationReplaceBinaryOperator& protobuf_message) const;
 
+  // Yields the operators, enabled by |mutation_selection|, with which the
+  // operator may be replaced.
   [[nodiscard]] std::vector<clang::BinaryOperatorKind> GetReplacementOperators(
-      bool optimise_mutations, const clang::ASTContext& ast_context) const;
+      bool optimise_mutations,
+      const MutationSelection& mutation_selection) const;
 
   // The && and || operators in C require special treatment: due to
   // short-circuit evaluation their arguments must not be prematurely evaluated.
@@ -110,13 +120,18 @@ class MutationReplaceBinaryOperator : public Mutation {
   // Using these rewritings avoid the need to change when the operator arguments
   // are evaluated when no mutations are enabled.
   void HandleCLogicalOperator(
-      const clang::Preprocessor& preprocessor,
       const std::string& new_function_prefix, const std::string& result_type,
       const std::string& lhs_type, const std::string& rhs_type,
-      bool only_track_mutant_coverage, int first_mutation_id_in_file,
-      int& mutation_id, clang::Rewriter& rewriter,
+      const Options& options, int first_mutation_id_in_file,
+      int& mutation_id, EditList& edit_list,
       std::unordered_set<std::string>& dredd_declarations) const;
 
+  // Yields the actions, out of swapping the operator and replacing the
+  // expression with its LHS or RHS, that are enabled for a C logical operator,
+  // in the order in which HandleCLogicalOperator assigns them mutation ids.
+  [[nodiscard]] std::vector<protobufs::MutationReplaceBinaryOperatorAction>
+  GetCLogicalOperatorActions(const Options& options) const;
+
   static void AddMutationInstance(
       int mutation_id_base,
       protobufs::MutationReplaceBinaryOperatorAction action,
@@ -134,6 +149,9 @@ class MutationReplaceBinaryOperator : public Mutation {
   InfoForSourceRange info_for_overall_expr_;
   InfoForSourceRange info_for_lhs_;
   InfoForSourceRange info_for_rhs_;
+  // Shared by all mutations for the translation unit; owned by the visitor that
+  // created this mutation.
+  ExprAnalysisCache* analysis_cache_;
 };
 
 }  // namespace dredd
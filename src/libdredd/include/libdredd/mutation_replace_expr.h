@@ -23,10 +23,14 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/OperationKinds.h"
 #include "clang/Lex/Preprocessor.h"
-#include "clang/Rewrite/Core/Rewriter.h"
+#include "libdredd/edit_list.h"
+#include "libdredd/expr_analysis_cache.h"
 #include "libdredd/mutation.h"
+#include "libdredd/mutation_selection.h"
 #include "libdredd/options.h"
 #include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/source_range_cache.h"
+#include "libdredd/stmt_parent_map.h"
 #include "libdredd/util.h"
 
 namespace dredd {
@@ -34,26 +38,31 @@ namespace dredd {
 class MutationReplaceExpr : public Mutation {
  public:
   MutationReplaceExpr(const clang::Expr& expr,
-                      const clang::Preprocessor& preprocessor,
-                      const clang::ASTContext& ast_context);
+                      SourceRangeCache& source_range_cache,
+                      const StmtParentMap& parent_map,
+                      ExprAnalysisCache& analysis_cache);
 
   protobufs::MutationGroup Apply(
       clang::ASTContext& ast_context, const clang::Preprocessor& preprocessor,
       const Options& options, int first_mutation_id_in_file, int& mutation_id,
-      clang::Rewriter& rewriter,
+      EditList& edit_list,
       std::unordered_set<std::string>& dredd_declarations) const override;
 
+  protobufs::MutationGroup CountInstances(clang::ASTContext& ast_context,
+                                          const Options& options,
+                                          int& mutation_id) const override;
+
   static void ApplyCppTypeModifiers(const clang::Expr& expr, std::string& type);
 
   static void ApplyCTypeModifiers(const clang::Expr& expr, std::string& type);
 
   // Check if an expression is equivalent to a constant.
   static bool ExprIsEquivalentToInt(const clang::Expr& expr, int constant,
-                                    const clang::ASTContext& ast_context);
+                                    ExprAnalysisCache& analysis_cache);
   static bool ExprIsEquivalentToFloat(const clang::Expr& expr, double constant,
-                                      const clang::ASTContext& ast_context);
+                                      ExprAnalysisCache& analysis_cache);
   static bool ExprIsEquivalentToBool(const clang::Expr& expr, bool constant,
-                                     const clang::ASTContext& ast_context);
+                                     ExprAnalysisCache& analysis_cache);
 
   // L-value expressions can be mutated via insertion of the ++ and -- prefix
   // operators. This is only done when an l-value is about to be implicitly
@@ -63,7 +72,7 @@ class MutationReplaceExpr : public Mutation {
   //
   // This helper function determines when an l-value expression is suitable for
   // such a mutation.
-  static bool CanMutateLValue(clang::ASTContext& ast_context,
+  static bool CanMutateLValue(const StmtParentMap& parent_map,
                               const clang::Expr& expr);
 
  private:
@@ -80,14 +89,11 @@ class MutationReplaceExpr : public Mutation {
   [[nodiscard]] bool IsRedundantOperatorInsertionBeforeLogicalOperatorArgument(
       clang::ASTContext& ast_context) const;
 
-  [[nodiscard]] bool IsRedundantUnaryLogicalNotInsertion(
-      const clang::ASTContext& ast_context) const;
+  [[nodiscard]] bool IsRedundantUnaryLogicalNotInsertion() const;
 
-  [[nodiscard]] bool IsRedundantUnaryNotInsertion(
-      const clang::ASTContext& ast_context) const;
+  [[nodiscard]] bool IsRedundantUnaryNotInsertion() const;
 
-  [[nodiscard]] bool IsRedundantUnaryMinusInsertion(
-      const clang::ASTContext& ast_context) const;
+  [[nodiscard]] bool IsRedundantUnaryMinusInsertion() const;
 
   void AddOptimisationSpecifier(clang::ASTContext& ast_context,
                                 std::string& function_name) const;
@@ -95,24 +101,26 @@ class MutationReplaceExpr : public Mutation {
   // Replace expressions with constants.
   void GenerateConstantReplacement(
       clang::ASTContext& ast_context, bool optimise_mutations,
+      const MutationSelection& mutation_selection,
       bool only_track_mutant_coverage, int mutation_id_base,
       std::stringstream& new_function, int& mutation_id_offset,
       protobufs::MutationReplaceExpr& protobuf_message) const;
 
   void GenerateBooleanConstantReplacement(
       clang::ASTContext& ast_context, bool optimise_mutations,
+      const MutationSelection& mutation_selection,
       bool only_track_mutant_coverage, int mutation_id_base,
       std::stringstream& new_function, int& mutation_id_offset,
       protobufs::MutationReplaceExpr& protobuf_message) const;
 
   void GenerateIntegerConstantReplacement(
-      const clang::ASTContext& ast_context, bool optimise_mutations,
+      bool optimise_mutations, const MutationSelection& mutation_selection,
       bool only_track_mutant_coverage, int mutation_id_base,
       std::stringstream& new_function, int& mutation_id_offset,
       protobufs::MutationReplaceExpr& protobuf_message) const;
 
   void GenerateFloatConstantReplacement(
-      const clang::ASTContext& ast_context, bool optimise_mutations,
+      bool optimise_mutations, const MutationSelection& mutation_selection,
       bool only_track_mutant_coverage, int mutation_id_base,
       std::stringstream& new_function, int& mutation_id_offset,
       protobufs::MutationReplaceExpr& protobuf_message) const;
@@ -120,20 +128,21 @@ class MutationReplaceExpr : public Mutation {
   // Insert valid unary operators such as !, ~, ++ and --.
   void GenerateUnaryOperatorInsertion(
       const std::string& arg_evaluated, clang::ASTContext& ast_context,
-      bool optimise_mutations, bool only_track_mutant_coverage,
-      int mutation_id_base, std::stringstream& new_function,
-      int& mutation_id_offset,
+      bool optimise_mutations, const MutationSelection& mutation_selection,
+      bool only_track_mutant_coverage, int mutation_id_base,
+      std::stringstream& new_function, int& mutation_id_offset,
       protobufs::MutationReplaceExpr& protobuf_message) const;
 
   void GenerateUnaryOperatorInsertionBeforeNonLValue(
       const std::string& arg_evaluated, clang::ASTContext& ast_context,
-      bool optimise_mutations, bool only_track_mutant_coverage,
-      int mutation_id_base, std::stringstream& new_function,
-      int& mutation_id_offset,
+      bool optimise_mutations, const MutationSelection& mutation_selection,
+      bool only_track_mutant_coverage, int mutation_id_base,
+      std::stringstream& new_function, int& mutation_id_offset,
       protobufs::MutationReplaceExpr& protobuf_message) const;
 
   void GenerateUnaryOperatorInsertionBeforeLValue(
-      const std::string& arg_evaluated, clang::ASTContext& ast_context,
+      const std::string& arg_evaluated,
+      const MutationSelection& mutation_selection,
       bool only_track_mutant_coverage, int mutation_id_base,
       std::stringstream& new_function, int& mutation_id_offset,
       protobufs::MutationReplaceExpr& protobuf_message) const;
@@ -141,7 +150,8 @@ class MutationReplaceExpr : public Mutation {
   std::string GenerateMutatorFunction(
       clang::ASTContext& ast_context, const std::string& function_name,
       const std::string& result_type, const std::string& input_type,
-      bool optimise_mutations, bool only_track_mutant_coverage,
+      bool optimise_mutations, const MutationSelection& mutation_selection,
+      bool only_track_mutant_coverage, bool use_shared_runtime,
       int& mutation_id, protobufs::MutationReplaceExpr& protobuf_message) const;
 
   [[nodiscard]] std::string GetFunctionName(
@@ -151,9 +161,8 @@ class MutationReplaceExpr : public Mutation {
                                    const std::string& input_type,
                                    int local_mutation_id,
                                    clang::ASTContext& ast_context,
-                                   const clang::Preprocessor& preprocessor,
-                                   bool show_ast_node_types,
-                                   clang::Rewriter& rewriter) const;
+                                   const Options& options,
+                                   EditList& edit_list) const;
 
   static void AddMutationInstance(
       int mutation_id_base, protobufs::MutationReplaceExprAction action,
@@ -161,14 +170,17 @@ class MutationReplaceExpr : public Mutation {
       protobufs::MutationReplaceExpr& protobuf_message);
 
   // Determines whether the given expression is the child of both an implicit
-  // cast expression and an initializer list expression. In the presence of
-  // templates, such an expression may have more than two parents, because it
-  // may have the initializer list for the non-instantiated template as a
-  // parent, as well as the initializer list for the instantiated template.
+  // cast expression and an initializer list expression.
   static bool IsSubjectToImplicitCastInInitializerList(
-      const clang::Expr& expr, clang::ASTContext& ast_context);
+      const clang::Expr& expr, const StmtParentMap& parent_map);
 
   const clang::Expr* expr_;
+  // Provides the parents of |expr_| and its ancestors; owned by the visitor
+  // that created this mutation.
+  const StmtParentMap* parent_map_;
+  // Shared by all mutations for the translation unit; owned by the visitor that
+  // created this mutation.
+  ExprAnalysisCache* analysis_cache_;
   InfoForSourceRange info_for_source_range_;
 };
 
@@ -23,10 +23,13 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/OperationKinds.h"
 #include "clang/Lex/Preprocessor.h"
-#include "clang/Rewrite/Core/Rewriter.h"
+#include "libdredd/edit_list.h"
+#include "libdredd/expr_analysis_cache.h"
 #include "libdredd/mutation.h"
+#include "libdredd/mutation_selection.h"
 #include "libdredd/options.h"
 #include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/source_range_cache.h"
 #include "libdredd/util.h"
 
 namespace dredd {
@@ -34,20 +37,25 @@ namespace dredd {
 class MutationReplaceUnaryOperator : public Mutation {
  public:
   MutationReplaceUnaryOperator(const clang::UnaryOperator& unary_operator,
-                               const clang::Preprocessor& preprocessor,
-                               const clang::ASTContext& ast_context);
+                               SourceRangeCache& source_range_cache,
+                               ExprAnalysisCache& analysis_cache);
 
   protobufs::MutationGroup Apply(
       clang::ASTContext& ast_context, const clang::Preprocessor& preprocessor,
       const Options& options, int first_mutation_id_in_file, int& mutation_id,
-      clang::Rewriter& rewriter,
+      EditList& edit_list,
       std::unordered_set<std::string>& dredd_declarations) const override;
 
+  protobufs::MutationGroup CountInstances(clang::ASTContext& ast_context,
+                                          const Options& options,
+                                          int& mutation_id) const override;
+
  private:
   std::string GenerateMutatorFunction(
       clang::ASTContext& ast_context, const std::string& function_name,
       const std::string& result_type, const std::string& input_type,
-      bool optimise_mutations, bool only_track_mutant_coverage,
+      bool optimise_mutations, const MutationSelection& mutation_selection,
+      bool only_track_mutant_coverage, bool use_shared_runtime,
       int& mutation_id,
       protobufs::MutationReplaceUnaryOperator& protobuf_message) const;
 
@@ -57,8 +65,7 @@ class MutationReplaceUnaryOperator : public Mutation {
       clang::UnaryOperatorKind operator_kind) const;
 
   [[nodiscard]] bool IsRedundantReplacementOperator(
-      clang::UnaryOperatorKind operator_kind,
-      const clang::ASTContext& ast_context) const;
+      clang::UnaryOperatorKind operator_kind) const;
 
   [[nodiscard]] bool IsOperatorSelfInverse() const;
 
@@ -67,10 +74,10 @@ class MutationReplaceUnaryOperator : public Mutation {
 
   // Replaces unary operators with other valid unary operators.
   void GenerateUnaryOperatorReplacement(
-      const std::string& arg_evaluated, const clang::ASTContext& ast_context,
-      bool optimise_mutations, bool only_track_mutant_coverage,
-      int mutation_id_base, std::stringstream& new_function,
-      int& mutation_id_offset,
+      const std::string& arg_evaluated, bool optimise_mutations,
+      const MutationSelection& mutation_selection,
+      bool only_track_mutant_coverage, int mutation_id_base,
+      std::stringstream& new_function, int& mutation_id_offset,
       protobufs::MutationReplaceUnaryOperator& protobuf_message) const;
 
   static void AddMutationInstance(
@@ -89,6 +96,9 @@ class MutationReplaceUnaryOperator : public Mutation {
   const clang::UnaryOperator* unary_operator_;
   InfoForSourceRange info_for_overall_expr_;
   InfoForSourceRange info_for_sub_expr_;
+  // Shared by all mutations for the translation unit; owned by the visitor that
+  // created this mutation.
+  ExprAnalysisCache* analysis_cache_;
 };
 
 }  // namespace dredd
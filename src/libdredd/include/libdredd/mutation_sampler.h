@@ -0,0 +1,63 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_MUTATION_SAMPLER_H
+#define LIBDREDD_MUTATION_SAMPLER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "libdredd/mutation_selection.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+
+namespace dredd {
+
+// Randomly, but reproducibly, chooses a subset of the mutants of each source
+// file to keep. Sampling is stratified: for each kind of mutation, the given
+// proportion of the mutants of that kind in a file is kept, rounded up so that
+// every kind of mutation that occurs in a file keeps at least one mutant.
+// Which mutants are kept depends only on the seed, the name of the file (but
+// not its directory) and the mutants of the file.
+class MutationSampler {
+ public:
+  // |rate| must be greater than 0 and at most 1.
+  MutationSampler(double rate, uint64_t seed);
+
+  [[nodiscard]] double GetRate() const { return rate_; }
+
+  [[nodiscard]] uint64_t GetSeed() const { return seed_; }
+
+  // Chooses the mutants to keep among those of the source file |filename|,
+  // given as the mutation groups that the mutations of the file yield, in a
+  // fixed order. For each mutation group, yields a selection that enables
+  // exactly those of its mutants that are kept.
+  [[nodiscard]] std::vector<MutationSelection> Sample(
+      const std::string& filename,
+      const std::vector<protobufs::MutationGroup>& mutation_groups) const;
+
+  [[nodiscard]] protobufs::MutationSampling ToProtobuf() const;
+
+  // Yields a description of the sampler that changes if and only if the
+  // sampler changes.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  double rate_;
+  uint64_t seed_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_MUTATION_SAMPLER_H
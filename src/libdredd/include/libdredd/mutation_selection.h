@@ -0,0 +1,109 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_MUTATION_SELECTION_H
+#define LIBDREDD_MUTATION_SELECTION_H
+
+#include <bitset>
+#include <string>
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace dredd {
+
+// Determines which of Dredd's mutations may be applied. By default every
+// mutation is enabled. Mutations are identified by specifications of the form
+// "kind" or "kind:Action", where kind is one of "remove_stmt", "replace_expr",
+// "replace_binary_operator" and "replace_unary_operator", and Action is the
+// name of an action of that kind, as it appears in mutation info files; e.g.
+// "replace_binary_operator:ReplaceWithLHS".
+class MutationSelection {
+ public:
+  MutationSelection();
+
+  // Enables the mutations identified by |specification|. Returns true if and
+  // only if |specification| is valid; otherwise |error_message| describes the
+  // problem.
+  [[nodiscard]] bool Enable(llvm::StringRef specification,
+                            std::string& error_message);
+
+  // Disables the mutations identified by |specification|.
+  [[nodiscard]] bool Disable(llvm::StringRef specification,
+                             std::string& error_message);
+
+  void DisableAll();
+
+  [[nodiscard]] bool IsRemoveStmtEnabled() const {
+    return remove_stmt_enabled_;
+  }
+
+  [[nodiscard]] bool IsEnabled(
+      protobufs::MutationReplaceExprAction action) const {
+    return replace_expr_actions_.test(static_cast<size_t>(action));
+  }
+
+  [[nodiscard]] bool IsEnabled(
+      protobufs::MutationReplaceBinaryOperatorAction action) const {
+    return replace_binary_operator_actions_.test(static_cast<size_t>(action));
+  }
+
+  [[nodiscard]] bool IsEnabled(
+      protobufs::MutationReplaceUnaryOperatorAction action) const {
+    return replace_unary_operator_actions_.test(static_cast<size_t>(action));
+  }
+
+  // Each of the following holds if and only if some action of the relevant
+  // kind is enabled.
+  [[nodiscard]] bool IsReplaceExprEnabled() const {
+    return replace_expr_actions_.any();
+  }
+
+  [[nodiscard]] bool IsReplaceBinaryOperatorEnabled() const {
+    return replace_binary_operator_actions_.any();
+  }
+
+  [[nodiscard]] bool IsReplaceUnaryOperatorEnabled() const {
+    return replace_unary_operator_actions_.any();
+  }
+
+  [[nodiscard]] bool IsEverythingEnabled() const;
+
+  [[nodiscard]] bool IsAnythingEnabled() const {
+    return remove_stmt_enabled_ || IsReplaceExprEnabled() ||
+           IsReplaceBinaryOperatorEnabled() || IsReplaceUnaryOperatorEnabled();
+  }
+
+  [[nodiscard]] protobufs::MutationSelection ToProtobuf() const;
+
+  // Yields a description of the selection that changes if and only if the
+  // selection changes.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  bool SetEnabled(llvm::StringRef specification, bool enabled,
+                  std::string& error_message);
+
+  bool remove_stmt_enabled_;
+  std::bitset<protobufs::MutationReplaceExprAction_ARRAYSIZE>
+      replace_expr_actions_;
+  std::bitset<protobufs::MutationReplaceBinaryOperatorAction_ARRAYSIZE>
+      replace_binary_operator_actions_;
+  std::bitset<protobufs::MutationReplaceUnaryOperatorAction_ARRAYSIZE>
+      replace_unary_operator_actions_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_MUTATION_SELECTION_H
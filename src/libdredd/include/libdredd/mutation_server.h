@@ -0,0 +1,258 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_MUTATION_SERVER_H
+#define LIBDREDD_MUTATION_SERVER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/options.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+
+namespace dredd {
+
+// A long-running process that mutates source files on request, so that the
+// cost of starting Dredd and loading the compilation database is only paid
+// once. Each request parses its source files, and the headers that they
+// include, afresh, so that changes to any of them are always seen. Requests are
+// received over a Unix domain socket, one line of JSON per request; see
+// ServeRequest and ServeResponse in dredd.proto. Source files are never
+// modified: the mutated text of each file is sent back instead.
+//
+// Source files are mutated on a separate thread, one request at a time, so
+// that the server keeps accepting connections, reading requests and sending
+// responses while a request is being served.
+//
+// On Linux, a client can ask for its source files to be watched. Each time one
+// of them is written, that file alone is mutated again, and a response
+// covering all of the client's source files is sent on the same connection.
+class MutationServer {
+ public:
+  // Mutates the given source files using file-local mutation ids, passing each
+  // mutated file, together with the index of its source file, to the given
+  // consumer, in the order in which the source files are listed. Files that
+  // could not be mutated due to errors are added to |files_with_errors|.
+  // Returns 0 if and only if every source file was mutated successfully.
+  using MutateSourceFilesFunction = std::function<int(
+      const std::vector<std::string>& source_paths,
+      const std::function<void(size_t, const DeferredMutatedFile&)>&
+          consume_deferred_file,
+      std::set<std::string>& files_with_errors)>;
+
+  // |default_source_paths| are mutated in response to requests that do not
+  // list any source files.
+  MutationServer(std::string socket_path, const Options& options,
+                 std::vector<std::string> default_source_paths,
+                 MutateSourceFilesFunction mutate_source_files);
+
+  ~MutationServer();
+
+  MutationServer(const MutationServer&) = delete;
+
+  MutationServer& operator=(const MutationServer&) = delete;
+
+  MutationServer(MutationServer&&) = delete;
+
+  MutationServer& operator=(MutationServer&&) = delete;
+
+  // Serves requests until a shutdown request is received. Returns false if the
+  // server could not be started, or failed while running.
+  [[nodiscard]] bool Run();
+
+ private:
+  struct Client {
+    int fd;
+
+    // Identifies the client uniquely, unlike |fd|, which may be reused, so that
+    // mutations that complete after the client has disconnected are discarded.
+    uint64_t id;
+
+    // Input that has been received, but does not yet form a whole request.
+    std::string pending_input;
+
+    // Responses that have not yet been sent in full. Connections are
+    // non-blocking, so that a client that is slow to read its responses cannot
+    // hold up the server, and no further requests are read from a client until
+    // its pending output has been sent.
+    std::string pending_output;
+
+    // The number of mutations that are queued or in progress for the client.
+    // Requests from the client are handled one at a time, so that responses are
+    // sent in the order in which the requests were made.
+    size_t num_pending_mutations = 0;
+
+    // Set if the client has asked for its source files to be watched, in which
+    // case the remaining fields describe those source files.
+    bool watching = false;
+
+    std::vector<std::string> source_paths;
+
+    // The absolute paths of |source_paths|, used to match changes to files.
+    std::vector<std::string> absolute_source_paths;
+
+    // The result of most recently mutating each source file.
+    std::vector<std::vector<DeferredMutatedFile>> deferred_files;
+  };
+
+  // Source files to be mutated on the mutation thread on behalf of a client,
+  // together with the results, once they have been mutated.
+  struct MutationJob {
+    int client_fd = -1;
+
+    uint64_t client_id = 0;
+
+    std::vector<std::string> source_paths;
+
+    // The index of each of |source_paths| among the source files of the client
+    // that are watched, if |updates_watched_files| is set.
+    std::vector<size_t> indices;
+
+    // Set if the results replace those for the watched source files of the
+    // client, in which case the response covers all of those files.
+    bool updates_watched_files = false;
+
+    // If non-empty, reported in the response.
+    std::string error;
+
+    // The results of mutating each of |source_paths|.
+    std::vector<std::vector<DeferredMutatedFile>> deferred_files;
+
+    std::set<std::string> files_with_errors;
+
+    int return_code = 0;
+  };
+
+  // Creates the socket and starts listening on it. Returns true if and only if
+  // this succeeds.
+  bool Listen();
+
+  // Starts the thread on which source files are mutated. Returns true if and
+  // only if this succeeds.
+  bool StartMutationThread();
+
+  // Mutates the source files of queued jobs, in order, until the server is
+  // destroyed.
+  void RunMutationThread();
+
+  void AcceptClient();
+
+  // Reads from the client and handles any complete requests. Returns false if
+  // the connection should be closed.
+  bool ReadFromClient(Client& client);
+
+  // Handles the complete requests that have been received from the client, as
+  // long as none of its mutations are pending. Returns false if the connection
+  // should be closed.
+  bool HandlePendingInput(Client& client);
+
+  // Returns false if the connection should be closed.
+  bool HandleRequest(Client& client, const std::string& request_json);
+
+  // Queues the files that have changed since this was last invoked to be
+  // mutated for the clients that are watching them.
+  void HandleFileChanges();
+
+  // Sends responses for the jobs that the mutation thread has completed.
+  void HandleCompletedMutations();
+
+  // Queues the job to be mutated on the mutation thread on behalf of the
+  // client.
+  void QueueMutation(Client& client, MutationJob job);
+
+  // Starts watching the source files of the given client. Returns true if and
+  // only if this succeeds.
+  bool WatchSourceFiles(const Client& client);
+
+  // Mutates the source files of the job, recording the results in the job.
+  void MutateSourceFiles(MutationJob& job) const;
+
+  // Assigns global mutation ids to the given files, in order, and yields the
+  // resulting response.
+  [[nodiscard]] protobufs::ServeResponse MakeResponse(
+      const std::vector<std::vector<DeferredMutatedFile>>& deferred_files,
+      const std::set<std::string>& files_with_errors, int return_code) const;
+
+  // Queues the response for the client, and sends as much pending output as
+  // can be sent without blocking. Returns false if the connection should be
+  // closed.
+  static bool SendResponse(Client& client,
+                           const protobufs::ServeResponse& response);
+
+  // Sends as much pending output as can be sent without blocking. Returns false
+  // if the connection should be closed.
+  static bool WriteToClient(Client& client);
+
+  void CloseClient(int fd);
+
+  std::string socket_path_;
+
+  const Options* options_;
+
+  std::vector<std::string> default_source_paths_;
+
+  MutateSourceFilesFunction mutate_source_files_;
+
+  int listen_fd_ = -1;
+
+  // Created when a client first asks for files to be watched.
+  int inotify_fd_ = -1;
+
+  // Maps each inotify watch descriptor to the directory that it watches.
+  // Directories, rather than files, are watched, so that files that are
+  // replaced by editors, rather than written in place, are still tracked.
+  std::map<int, std::string> watched_directories_;
+
+  // Keyed by file descriptor.
+  std::map<int, Client> clients_;
+
+  uint64_t next_client_id_ = 0;
+
+  bool shutdown_requested_ = false;
+
+  // Guards the jobs that are shared with the mutation thread, and
+  // |stop_mutation_thread_|.
+  std::mutex jobs_mutex_;
+
+  // Signalled when a job is queued, or the mutation thread should stop.
+  std::condition_variable jobs_queued_;
+
+  std::deque<MutationJob> queued_jobs_;
+
+  std::deque<MutationJob> completed_jobs_;
+
+  bool stop_mutation_thread_ = false;
+
+  // The mutation thread writes to this pipe each time it completes a job, so
+  // that the server wakes up to send the response.
+  int wake_read_fd_ = -1;
+
+  int wake_write_fd_ = -1;
+
+  std::thread mutation_thread_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_MUTATION_SERVER_H
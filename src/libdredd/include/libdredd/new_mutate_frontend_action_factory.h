@@ -16,18 +16,50 @@
 #define LIBDREDD_NEW_MUTATE_FRONTEND_ACTION_FACTORY_H
 
 #include <memory>
-#include <optional>
+#include <string>
+#include <vector>
 
 #include "clang/Tooling/Tooling.h"
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/mutation_info_writer.h"
 #include "libdredd/options.h"
 #include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/run_statistics.h"
 
 namespace dredd {
 
+// If |mutation_info_writer| is non-null, the mutation info for each file is
+// written to it as soon as the file has been mutated. If |run_statistics| is
+// non-null, timings and counts gathered while mutating each file are added to
+// it.
 std::unique_ptr<clang::tooling::FrontendActionFactory>
-NewMutateFrontendActionFactory(
-    const Options& options, int& mutation_id,
-    std::optional<protobufs::MutationInfo>& mutation_info);
+NewMutateFrontendActionFactory(const Options& options, int& mutation_id,
+                               MutationInfoWriter* mutation_info_writer,
+                               RunStatistics* run_statistics);
+
+// Yields a factory whose actions mutate files using file-local mutation ids,
+// recording each mutated file in |deferred_files| rather than writing it out.
+// Mutation info is recorded for each file if and only if |build_mutation_info|
+// holds. |run_statistics| is as for NewMutateFrontendActionFactory. If
+// |dependencies| is non-null, the paths of all files read while processing each
+// source file, including system headers and the source file itself, are
+// appended to it. Relative paths are relative to the working directory of the
+// compile command.
+std::unique_ptr<clang::tooling::FrontendActionFactory>
+NewDeferredMutateFrontendActionFactory(
+    const Options& options, bool build_mutation_info,
+    std::vector<DeferredMutatedFile>& deferred_files,
+    RunStatistics* run_statistics, std::vector<std::string>* dependencies);
+
+// Yields a factory whose actions do not mutate files: instead, the mutants
+// that would be applied to each file are counted, without any code being
+// generated, and the counts for each file are appended to |mutation_counts|.
+// |run_statistics| is as for NewMutateFrontendActionFactory.
+std::unique_ptr<clang::tooling::FrontendActionFactory>
+NewCountMutationsFrontendActionFactory(
+    const Options& options,
+    std::vector<protobufs::FileMutationCounts>& mutation_counts,
+    RunStatistics* run_statistics);
 
 }  // namespace dredd
 
@@ -0,0 +1,31 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_OFFSET_MUTATION_IDS_H
+#define LIBDREDD_OFFSET_MUTATION_IDS_H
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+
+namespace dredd {
+
+// Adds |offset| to the id of every mutation recorded in the given mutation
+// info. This is used to turn file-local mutation ids, which start from zero,
+// into global mutation ids once the global id of the first mutation in the file
+// is known.
+void OffsetMutationIds(int offset,
+                       protobufs::MutationInfoForFile& mutation_info_for_file);
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_OFFSET_MUTATION_IDS_H
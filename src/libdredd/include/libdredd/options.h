@@ -15,18 +15,97 @@
 #ifndef LIBDREDD_OPTIONS_H
 #define LIBDREDD_OPTIONS_H
 
+#include <memory>
+#include <utility>
+
+#include "libdredd/function_filter.h"
+#include "libdredd/line_ranges.h"
+#include "libdredd/mutation_sampler.h"
+#include "libdredd/mutation_selection.h"
+
 namespace dredd {
 
+// By default, Dredd's optimisations are enabled, and every other option is
+// disabled. Each setter yields the options, so that calls can be chained:
+//
+//   Options options;
+//   options.SetDumpAsts(true).SetUseSharedRuntime(true);
 class Options {
  public:
-  Options(bool optimise_mutations, bool dump_asts,
-          bool only_track_mutant_coverage, bool show_ast_node_types)
-      : optimise_mutations_(optimise_mutations),
-        dump_asts_(dump_asts),
-        only_track_mutant_coverage_(only_track_mutant_coverage),
-        show_ast_node_types_(show_ast_node_types) {}
+  Options& SetOptimiseMutations(bool optimise_mutations) {
+    optimise_mutations_ = optimise_mutations;
+    return *this;
+  }
+
+  Options& SetDumpAsts(bool dump_asts) {
+    dump_asts_ = dump_asts;
+    return *this;
+  }
+
+  Options& SetOnlyTrackMutantCoverage(bool only_track_mutant_coverage) {
+    only_track_mutant_coverage_ = only_track_mutant_coverage;
+    return *this;
+  }
+
+  Options& SetShowAstNodeTypes(bool show_ast_node_types) {
+    show_ast_node_types_ = show_ast_node_types;
+    return *this;
+  }
+
+  Options& SetSkipHeaderFunctionBodies(bool skip_header_function_bodies) {
+    skip_header_function_bodies_ = skip_header_function_bodies;
+    return *this;
+  }
+
+  Options& SetAlsoTrackMutantCoverage(bool also_track_mutant_coverage) {
+    also_track_mutant_coverage_ = also_track_mutant_coverage;
+    return *this;
+  }
+
+  Options& SetUseSharedRuntime(bool use_shared_runtime) {
+    use_shared_runtime_ = use_shared_runtime;
+    return *this;
+  }
+
+  Options& SetUseGlobalMutantRegistry(bool use_global_mutant_registry) {
+    use_global_mutant_registry_ = use_global_mutant_registry;
+    return *this;
+  }
+
+  // Yields the options with which the mutant coverage tracking version of a
+  // source file is produced when |also_track_mutant_coverage_| holds.
+  [[nodiscard]] Options GetCoverageTrackingOptions() const {
+    Options result = *this;
+    result.SetOnlyTrackMutantCoverage(true).SetAlsoTrackMutantCoverage(false);
+    return result;
+  }
+
+  // Restricts mutation to the lines given by |line_range_filter|.
+  Options& SetLineRangeFilter(
+      std::shared_ptr<const LineRangeFilter> line_range_filter) {
+    line_range_filter_ = std::move(line_range_filter);
+    return *this;
+  }
+
+  // Restricts mutation to the functions permitted by |function_filter|.
+  Options& SetFunctionFilter(
+      std::shared_ptr<const FunctionFilter> function_filter) {
+    function_filter_ = std::move(function_filter);
+    return *this;
+  }
+
+  // Restricts mutation to the mutations enabled by |mutation_selection|.
+  Options& SetMutationSelection(const MutationSelection& mutation_selection) {
+    mutation_selection_ = mutation_selection;
+    return *this;
+  }
 
-  Options() : Options(true, false, false, false) {}
+  // Restricts mutation to the mutants chosen by |mutation_sampler|.
+  Options& SetMutationSampler(
+      std::shared_ptr<const MutationSampler> mutation_sampler) {
+    mutation_sampler_ = std::move(mutation_sampler);
+    return *this;
+  }
 
   [[nodiscard]] bool GetOptimiseMutations() const {
     return optimise_mutations_;
@@ -42,21 +121,96 @@ class Options {
     return show_ast_node_types_;
   }
 
+  [[nodiscard]] bool GetSkipHeaderFunctionBodies() const {
+    return skip_header_function_bodies_;
+  }
+
+  [[nodiscard]] bool GetAlsoTrackMutantCoverage() const {
+    return also_track_mutant_coverage_;
+  }
+
+  [[nodiscard]] bool GetUseSharedRuntime() const { return use_shared_runtime_; }
+
+  [[nodiscard]] bool GetUseGlobalMutantRegistry() const {
+    return use_global_mutant_registry_;
+  }
+
+  // Null if mutation is not restricted to particular lines.
+  [[nodiscard]] const LineRangeFilter* GetLineRangeFilter() const {
+    return line_range_filter_.get();
+  }
+
+  // Null if mutation is not restricted to particular functions.
+  [[nodiscard]] const FunctionFilter* GetFunctionFilter() const {
+    return function_filter_.get();
+  }
+
+  [[nodiscard]] const MutationSelection& GetMutationSelection() const {
+    return mutation_selection_;
+  }
+
+  // Null if mutants are not sampled.
+  [[nodiscard]] const MutationSampler* GetMutationSampler() const {
+    return mutation_sampler_.get();
+  }
+
  private:
   // True if and only if Dredd's optimisations are enabled.
-  bool optimise_mutations_;
+  bool optimise_mutations_ = true;
 
   // True if and only if the AST being consumed should be dumped; useful for
   // debugging.
-  bool dump_asts_;
+  bool dump_asts_ = false;
 
   // True if and only if instrumentation should track whether mutants are
   // reached, rather than allowing mutants to be enabled.
-  bool only_track_mutant_coverage_;
+  bool only_track_mutant_coverage_ = false;
 
   // True if and only if a comment showing the type of each mutated AST node
   // should be emitted. This is useful for debugging.
-  bool show_ast_node_types_;
+  bool show_ast_node_types_ = false;
+
+  // True if and only if the bodies of functions that are not declared in the
+  // main file should not be parsed. Dredd only mutates code in the main file,
+  // so this saves parsing time without affecting the result of mutation.
+  bool skip_header_function_bodies_ = false;
+
+  // True if and only if, in addition to the mutated version of each source
+  // file, a version that only tracks mutant coverage should be produced. Both
+  // versions are produced from a single traversal of each translation unit,
+  // and have identical mutation ids. Incompatible with
+  // |only_track_mutant_coverage_|.
+  bool also_track_mutant_coverage_ = false;
+
+  // True if and only if mutator functions should be defined once, in a runtime
+  // shared by all mutated files, rather than in each mutated file. Mutator
+  // functions in the shared runtime are passed global mutation ids, and each
+  // mutated file only has a small prelude that includes the runtime header.
+  bool use_shared_runtime_ = false;
+
+  // True if and only if the mutants that are enabled should be recorded in a
+  // single registry shared by all mutated files of a program, indexed by
+  // global mutation id, rather than in each mutated file. The registry is
+  // defined weakly in every mutated file, so that the linker keeps one copy.
+  // Incompatible with |use_shared_runtime_|, whose runtime already has a
+  // single record of the mutants that are enabled.
+  bool use_global_mutant_registry_ = false;
+
+  // If set, only mutation sites whose source range overlaps the lines of the
+  // main file given by the filter are mutated. Shared, so that copying options
+  // remains cheap.
+  std::shared_ptr<const LineRangeFilter> line_range_filter_;
+
+  // If set, the bodies of functions that the filter does not permit to be
+  // mutated are not traversed.
+  std::shared_ptr<const FunctionFilter> function_filter_;
+
+  // The mutations that may be applied; by default, all of them.
+  MutationSelection mutation_selection_;
+
+  // If set, only the mutants of each file that the sampler chooses, among
+  // those permitted by the other options, are applied.
+  std::shared_ptr<const MutationSampler> mutation_sampler_;
 };
 
 }  // namespace dredd
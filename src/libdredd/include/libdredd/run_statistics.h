@@ -0,0 +1,180 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_RUN_STATISTICS_H
+#define LIBDREDD_RUN_STATISTICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace dredd {
+
+// Accumulates the time spent in each phase of mutating source files, so that
+// the cost of each phase can be reported. Times for different source files are
+// summed, so when files are mutated in parallel the total can exceed the time
+// that has elapsed. Times can be added from multiple threads concurrently.
+//
+// If details are recorded, each phase of processing each source file is also
+// recorded as an event, together with the number of AST nodes traversed and
+// the mutants applied for each source file, so that a detailed report can be
+// written once all source files have been processed.
+class RunStatistics {
+ public:
+  enum class Phase {
+    // Parsing and semantic analysis of a translation unit, up to the point at
+    // which its AST is handed to Dredd.
+    kParse,
+    // Traversal of the AST to identify the mutations that can be applied.
+    kTraverse,
+    // Simplification of the tree of mutations found during traversal.
+    kTidyUp,
+    // Application of mutations, which adds edits to the source file and
+    // generates mutator functions.
+    kApplyMutations,
+    // Remaining edits, and flushing of the edit list to yield the text of the
+    // mutated file.
+    kRewrite,
+    // Generation of the prelude, which depends on global mutation ids, and
+    // writing out of the mutated file.
+    kOutput,
+    // Serialisation of protobufs: mutation info, cache entries and shard file
+    // entries.
+    kSerialise
+  };
+
+  explicit RunStatistics(bool record_details);
+
+  RunStatistics(const RunStatistics&) = delete;
+
+  RunStatistics& operator=(const RunStatistics&) = delete;
+
+  RunStatistics(RunStatistics&&) = delete;
+
+  RunStatistics& operator=(RunStatistics&&) = delete;
+
+  ~RunStatistics() = default;
+
+  [[nodiscard]] bool IsRecordingDetails() const { return record_details_; }
+
+  // Adds the time from |start| to |end| to |phase|. If details are recorded,
+  // this is also recorded as an event for |filename| on the calling thread.
+  void AddTime(Phase phase, const std::string& filename,
+               std::chrono::steady_clock::time_point start,
+               std::chrono::steady_clock::time_point end);
+
+  // If details are recorded, records the number of declarations and statements
+  // traversed when mutating |filename|, and the number of mutants of each kind
+  // and action described by |mutation_info_for_file|.
+  void AddFileCounts(
+      const std::string& filename, int64_t num_decls_traversed,
+      int64_t num_stmts_traversed,
+      const protobufs::MutationInfoForFile& mutation_info_for_file);
+
+  // Prints the time spent in each phase, summed over all source files.
+  void Print(llvm::raw_ostream& stream) const;
+
+  // Writes a JSON report of the recorded details. The report is also a valid
+  // Chrome trace-event file, so that it can be opened in a trace viewer.
+  // Requires IsRecordingDetails().
+  void WriteReport(llvm::raw_ostream& stream) const;
+
+  // Writes the report to |path|. Returns true if and only if writing succeeded.
+  [[nodiscard]] bool WriteReport(const std::string& path) const;
+
+  [[nodiscard]] static const char* GetPhaseName(Phase phase);
+
+ private:
+  static constexpr size_t kNumPhases =
+      static_cast<size_t>(Phase::kSerialise) + 1;
+
+  struct PhaseEvent {
+    std::string filename;
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+    uint64_t thread_id;
+  };
+
+  struct FileCounts {
+    std::string filename;
+    int64_t num_decls_traversed;
+    int64_t num_stmts_traversed;
+    // The mutants applied to the file, as pairs of the kind of mutation and
+    // the name of the action.
+    std::vector<std::pair<std::string, std::string>> mutants;
+  };
+
+  std::array<std::atomic<int64_t>, kNumPhases> nanoseconds_{};
+
+  const bool record_details_;
+
+  // Used as the origin of timestamps in the report.
+  const std::chrono::steady_clock::time_point creation_time_;
+
+  // Guards |phase_events_| and |file_counts_|.
+  mutable std::mutex mutex_;
+
+  std::vector<PhaseEvent> phase_events_;
+
+  std::vector<FileCounts> file_counts_;
+};
+
+// Adds the time between its construction and destruction to the given phase,
+// for the given source file. Does nothing if |run_statistics| is null, so that
+// callers do not need to check whether statistics are being gathered.
+class ScopedPhaseTimer {
+ public:
+  ScopedPhaseTimer(RunStatistics* run_statistics, RunStatistics::Phase phase,
+                   const std::string& filename)
+      : run_statistics_(run_statistics),
+        phase_(phase),
+        filename_(&filename),
+        start_(std::chrono::steady_clock::now()) {}
+
+  ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+
+  ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+  ScopedPhaseTimer(ScopedPhaseTimer&&) = delete;
+
+  ScopedPhaseTimer& operator=(ScopedPhaseTimer&&) = delete;
+
+  ~ScopedPhaseTimer() {
+    if (run_statistics_ != nullptr) {
+      run_statistics_->AddTime(phase_, *filename_, start_,
+                               std::chrono::steady_clock::now());
+    }
+  }
+
+ private:
+  RunStatistics* run_statistics_;
+  RunStatistics::Phase phase_;
+  // Must outlive the timer.
+  const std::string* filename_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_RUN_STATISTICS_H
@@ -0,0 +1,85 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_SHARD_FILE_H
+#define LIBDREDD_SHARD_FILE_H
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+
+namespace google::protobuf::io {
+class ZeroCopyInputStream;
+}  // namespace google::protobuf::io
+
+namespace dredd {
+
+// Writes a shard file: a length-delimited ShardHeader message followed by a
+// length-delimited ShardFileEntry message per mutated file.
+class ShardFileWriter {
+ public:
+  explicit ShardFileWriter(const std::string& filename);
+
+  [[nodiscard]] bool IsOpen() const { return output_stream_.is_open(); }
+
+  // The header must be written before any entries. Each of these methods
+  // returns true if and only if writing succeeds.
+  [[nodiscard]] bool WriteHeader(const protobufs::ShardHeader& header);
+
+  [[nodiscard]] bool WriteEntry(const protobufs::ShardFileEntry& entry);
+
+ private:
+  std::ofstream output_stream_;
+};
+
+// Reads a shard file written by ShardFileWriter, one message at a time, so that
+// the mutated files in a shard do not all need to be held in memory at once.
+class ShardFileReader {
+ public:
+  explicit ShardFileReader(const std::string& filename);
+
+  ~ShardFileReader();
+
+  ShardFileReader(const ShardFileReader&) = delete;
+
+  ShardFileReader& operator=(const ShardFileReader&) = delete;
+
+  ShardFileReader(ShardFileReader&&) = delete;
+
+  ShardFileReader& operator=(ShardFileReader&&) = delete;
+
+  [[nodiscard]] bool IsOpen() const { return input_stream_.is_open(); }
+
+  // Returns true if and only if the header was read successfully. This must be
+  // invoked before any entries are read.
+  [[nodiscard]] bool ReadHeader(protobufs::ShardHeader& header);
+
+  // Returns true if an entry was read successfully. Returns false if there are
+  // no more entries, or if reading failed; HadError distinguishes these cases.
+  [[nodiscard]] bool ReadEntry(protobufs::ShardFileEntry& entry);
+
+  [[nodiscard]] bool HadError() const { return had_error_; }
+
+ private:
+  std::ifstream input_stream_;
+  std::unique_ptr<google::protobuf::io::ZeroCopyInputStream>
+      zero_copy_input_stream_;
+  bool had_error_ = false;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_SHARD_FILE_H
@@ -0,0 +1,88 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_SHARED_RUNTIME_H
+#define LIBDREDD_SHARED_RUNTIME_H
+
+#include <set>
+#include <string>
+
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/options.h"
+
+namespace dredd {
+
+// When Options::GetUseSharedRuntime() holds, the mutator functions that the
+// mutated files call are not added to each file. Instead, this collects them
+// as files are mutated, and generates a runtime that is shared by all mutated
+// files: a header that each mutated file includes, declaring the mutator
+// functions, and a C and/or C++ source file that defines each mutator function
+// once, together with the logic that determines which mutants are enabled (or
+// that records which mutants are covered). The runtime source files must be
+// compiled and linked into the program that contains the mutated files.
+class SharedRuntime {
+ public:
+  explicit SharedRuntime(const Options& options);
+
+  SharedRuntime(const SharedRuntime&) = delete;
+
+  SharedRuntime& operator=(const SharedRuntime&) = delete;
+
+  SharedRuntime(SharedRuntime&&) = delete;
+
+  SharedRuntime& operator=(SharedRuntime&&) = delete;
+
+  // Adds the mutator functions that |deferred_file| calls. Files should be
+  // added in the order in which global mutation ids are assigned to them, so
+  // that the runtime accounts for all of their mutations.
+  void AddFile(const DeferredMutatedFile& deferred_file);
+
+  [[nodiscard]] int GetNumMutations() const { return num_mutations_; }
+
+  // True if and only if a C++ (respectively C) file has been added, in which
+  // case a C++ (respectively C) runtime source file is required.
+  [[nodiscard]] bool HasCppFiles() const { return has_cpp_files_; }
+
+  [[nodiscard]] bool HasCFiles() const { return has_c_files_; }
+
+  [[nodiscard]] std::string GetHeaderText() const;
+
+  [[nodiscard]] std::string GetCppSourceText() const;
+
+  [[nodiscard]] std::string GetCSourceText() const;
+
+  // Writes the runtime header, and those runtime source files that are
+  // required, to |runtime_dir|, creating it if needed. Returns true if and only
+  // if writing succeeded.
+  [[nodiscard]] bool Write(const std::string& runtime_dir) const;
+
+ private:
+  const Options* options_;
+
+  int num_mutations_ = 0;
+
+  bool has_cpp_files_ = false;
+
+  bool has_c_files_ = false;
+
+  // The definitions of the mutator functions called by C++ and C files,
+  // respectively. Ordered sets are used so that the runtime is deterministic.
+  std::set<std::string> cpp_dredd_declarations_;
+
+  std::set<std::string> c_dredd_declarations_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_SHARED_RUNTIME_H
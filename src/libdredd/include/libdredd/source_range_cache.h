@@ -0,0 +1,83 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_SOURCE_RANGE_CACHE_H
+#define LIBDREDD_SOURCE_RANGE_CACHE_H
+
+#include <utility>
+
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/DenseMap.h"
+
+namespace dredd {
+
+// Resolves source ranges to the main file, and measures tokens and computes
+// line and column numbers for source locations, caching the results. The same
+// information is needed for an AST node when deciding whether to mutate it,
+// when creating the mutation, and again when applying the mutation; the walk
+// through macro expansions and the re-lexing of tokens that this involves are
+// performed once per node. A cache should be used for a single translation
+// unit.
+class SourceRangeCache {
+ public:
+  explicit SourceRangeCache(const clang::Preprocessor& preprocessor);
+
+  SourceRangeCache(const SourceRangeCache&) = delete;
+
+  SourceRangeCache& operator=(const SourceRangeCache&) = delete;
+
+  SourceRangeCache(SourceRangeCache&&) = delete;
+
+  SourceRangeCache& operator=(SourceRangeCache&&) = delete;
+
+  ~SourceRangeCache() = default;
+
+  [[nodiscard]] const clang::SourceManager& GetSourceManager() const {
+    return preprocessor_->getSourceManager();
+  }
+
+  // Yields the range of the main file that |source_range| corresponds to, or
+  // an invalid range if it cannot be traced back to the main file.
+  [[nodiscard]] clang::SourceRange GetSourceRangeInMainFile(
+      const clang::SourceRange& source_range);
+
+  template <typename HasSourceRange>
+  [[nodiscard]] clang::SourceRange GetSourceRangeInMainFile(
+      const HasSourceRange& ast_node) {
+    return GetSourceRangeInMainFile(ast_node.getSourceRange());
+  }
+
+  // Yields the length of the token that starts at |location|.
+  [[nodiscard]] unsigned int GetTokenLength(clang::SourceLocation location);
+
+  // Yields the spelling line and column numbers of |location|.
+  [[nodiscard]] std::pair<unsigned int, unsigned int> GetLineAndColumn(
+      clang::SourceLocation location);
+
+ private:
+  const clang::Preprocessor* preprocessor_;
+
+  llvm::DenseMap<std::pair<clang::SourceLocation, clang::SourceLocation>,
+                 clang::SourceRange>
+      source_ranges_in_main_file_;
+  llvm::DenseMap<clang::SourceLocation, unsigned int> token_lengths_;
+  llvm::DenseMap<clang::SourceLocation, std::pair<unsigned int, unsigned int>>
+      lines_and_columns_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_SOURCE_RANGE_CACHE_H
@@ -0,0 +1,130 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_STMT_PARENT_MAP_H
+#define LIBDREDD_STMT_PARENT_MAP_H
+
+#include <cassert>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Stmt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Casting.h"
+
+namespace dredd {
+
+// Records the statement parents of the statements (which include expressions)
+// that are encountered while traversing an AST, as a cheap alternative to
+// ASTContext::getParents. The latter builds a parent map for the entire
+// translation unit, including all included headers and template
+// instantiations, the first time it is queried, which is expensive in both time
+// and memory for large translation units.
+//
+// Only statement-to-statement edges are recorded. A statement whose parent is a
+// declaration (e.g. the initializer of a variable) or a type (e.g. the size
+// expression of a variable-length array) has no recorded parent.
+//
+// In debug builds, the result of each query for a parent of a given type is
+// checked against ASTContext::getParents.
+class StmtParentMap {
+ public:
+  explicit StmtParentMap(clang::ASTContext& ast_context);
+
+  StmtParentMap(const StmtParentMap&) = delete;
+
+  StmtParentMap& operator=(const StmtParentMap&) = delete;
+
+  StmtParentMap(StmtParentMap&&) = delete;
+
+  StmtParentMap& operator=(StmtParentMap&&) = delete;
+
+  ~StmtParentMap() = default;
+
+  // Records |stmt| as a parent of each of its children. This should be invoked
+  // on a statement before any of its children are queried. For an initializer
+  // list, the children of both its syntactic and semantic forms are recorded,
+  // so that an expression in an initializer list that is implicitly cast has
+  // both the initializer list and the implicit cast as parents.
+  void RecordChildren(const clang::Stmt& stmt);
+
+  // Yields the recorded parents of |stmt|, which may be empty.
+  [[nodiscard]] llvm::ArrayRef<const clang::Stmt*> GetParents(
+      const clang::Stmt& stmt) const;
+
+  // It is often necessary to ask whether a given statement has a parent of a
+  // given type. This helper returns nullptr if the given statement has no
+  // parent of the template parameter type, and otherwise returns the first
+  // parent that does have the template parameter type.
+  template <typename RequiredParentT>
+  [[nodiscard]] const RequiredParentT* GetFirstParentOfType(
+      const clang::Stmt& stmt) const {
+    const RequiredParentT* result = nullptr;
+    for (const auto* parent : GetParents(stmt)) {
+      if (const auto* candidate_result =
+              llvm::dyn_cast<RequiredParentT>(parent)) {
+        result = candidate_result;
+        break;
+      }
+    }
+    assert(IsConsistentWithAstContext(stmt, result) &&
+           "The recorded parents of a statement do not match those yielded by "
+           "the AST context.");
+    return result;
+  }
+
+ private:
+  // Returns true if and only if |result| is a parent of |stmt| of the template
+  // parameter type according to ASTContext::getParents, or |result| is nullptr
+  // and |stmt| has no such parent. Only used in assertions, as the first query
+  // makes the AST context build a parent map for the entire translation unit.
+  template <typename RequiredParentT>
+  [[nodiscard]] bool IsConsistentWithAstContext(
+      const clang::Stmt& stmt, const RequiredParentT* result) const {
+    bool has_parent_of_type = false;
+    for (const auto* parent : GetParentsFromAstContext(stmt)) {
+      if (const auto* parent_of_type =
+              llvm::dyn_cast<RequiredParentT>(parent)) {
+        if (parent_of_type == result) {
+          return true;
+        }
+        has_parent_of_type = true;
+      }
+    }
+    return result == nullptr && !has_parent_of_type;
+  }
+
+  // Yields the statement parents of |stmt| according to
+  // ASTContext::getParents.
+  [[nodiscard]] llvm::SmallVector<const clang::Stmt*, 1>
+  GetParentsFromAstContext(const clang::Stmt& stmt) const;
+
+  void RecordParent(const clang::Stmt& child, const clang::Stmt& parent);
+
+  // Records parents for the children of |stmt|, and recursively for all of
+  // their descendants. Used for the implicit semantic forms of initializer
+  // lists, which are not reached during traversal.
+  void RecordSubtree(const clang::Stmt& stmt);
+
+  clang::ASTContext* ast_context_;
+
+  // Most statements have a single parent, hence the inline capacity of 1.
+  llvm::DenseMap<const clang::Stmt*, llvm::SmallVector<const clang::Stmt*, 1>>
+      parents_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_STMT_PARENT_MAP_H
@@ -16,21 +16,29 @@
 #define LIBDREDD_UTIL_H
 
 #include <string>
+#include <vector>
 
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Expr.h"
-#include "clang/AST/ParentMapContext.h"
 #include "clang/AST/Stmt.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Lex/Preprocessor.h"
+#include "libdredd/options.h"
+#include "libdredd/source_range_cache.h"
 #include "llvm/ADT/APFloat.h"
 
 namespace dredd {
 
 class InfoForSourceRange {
  public:
+  // |source_range| must be a valid range in the main file.
   InfoForSourceRange(clang::SourceRange source_range,
-                     const clang::ASTContext& ast_context);
+                     SourceRangeCache& source_range_cache);
+
+  [[nodiscard]] clang::SourceRange GetSourceRange() const {
+    return source_range_;
+  }
+
   [[nodiscard]] unsigned int GetStartLine() const { return start_line_; }
 
   [[nodiscard]] unsigned int GetStartColumn() const { return start_column_; }
@@ -42,6 +50,7 @@ class InfoForSourceRange {
   [[nodiscard]] const std::string& GetSnippet() const { return snippet_; }
 
  private:
+  clang::SourceRange source_range_;
   unsigned int start_line_;
   unsigned int start_column_;
   unsigned int end_line_;
@@ -51,6 +60,47 @@ class InfoForSourceRange {
 
 std::string SpaceToUnderscore(const std::string& input);
 
+// Yields the text of the mutation id argument that is passed to a mutator
+// function for the mutation with file-local id |local_mutation_id|. When a
+// shared runtime is used, mutator functions take global mutation ids. These
+// are formed by adding the file-local id to the global id of the first mutation
+// in the file, which the prelude of the mutated file provides once it is known.
+std::string GetMutatorFunctionMutationIdArgument(const Options& options,
+                                                 int local_mutation_id);
+
+// Yields a suffix for the names of mutator functions that distinguishes the
+// mutation selection of |options|. Mutator functions only contain code for
+// the selected mutants, and when mutants are sampled, mutations of the same
+// form can have different selections, so their mutator functions need
+// distinct names. The suffix is empty if every mutant is selected.
+std::string GetMutatorFunctionNameSuffix(const Options& options);
+
+// Yields a switch statement for a mutator function with |num_mutants|
+// mutants, one of whose |cases| is taken if the corresponding mutant is
+// enabled. The case for the mutant with offset i from the function's
+// |local_mutation_id| must be labelled i. Which of the mutants is enabled is
+// looked up once, so that the cost of a mutator function does not grow with
+// its number of mutants. If several are enabled, the one with the lowest
+// offset is taken. At most 64 mutants are supported.
+std::string GetMutatorFunctionSwitch(int num_mutants, const std::string& cases);
+
+// Yields the type of the parameter via which a C++ mutator function receives
+// an operand that it evaluates on demand, as a callable yielding |type|.
+// Mutator functions in a shared runtime are compiled separately from their
+// callers, so take a non-owning reference to the callable. Otherwise the type
+// of the callable is the template parameter |template_parameter|, so that the
+// callable can be inlined and no type erasure or allocation is needed.
+std::string GetMutatorFunctionCallableType(
+    bool use_shared_runtime, const std::string& type,
+    const std::string& template_parameter);
+
+// Yields the template header of a C++ mutator function with the given
+// callable |template_parameters|, or the empty string if there are none. Each
+// template parameter is required to be callable, so that the template is not
+// chosen over an overload of the mutator function that takes plain values.
+std::string GetMutatorFunctionTemplateHeader(
+    const std::vector<std::string>& template_parameters);
+
 [[nodiscard]] clang::SourceRange GetSourceRangeInMainFile(
     const clang::Preprocessor& preprocessor,
     const clang::SourceRange& source_range);
@@ -65,7 +115,7 @@ template <typename HasSourceRange>
 // range can end earlier than it starts. See "structured_binding.cc" under
 // single file tests.
 bool SourceRangeConsistencyCheck(clang::SourceRange source_range,
-                                 const clang::ASTContext& ast_context);
+                                 SourceRangeCache& source_range_cache);
 
 // Delegates to Expr::EvaluateAsBooleanCondition, but only if the expression is
 // not value-dependent.
@@ -91,23 +141,6 @@ bool EvaluateAsFloat(const clang::Expr& expr,
 bool IsCxx11ConstantExpr(const clang::Expr& expr,
                          const clang::ASTContext& ast_context);
 
-// It is often necessary to ask whether a given statement (which includes
-// expressions) has a parent of a given type. This helper returns nullptr if
-// the given statement has no parent of the template parameter type, and
-// otherwise returns the first parent that does have the template parameter
-// type.
-template <typename RequiredParentT>
-const RequiredParentT* GetFirstParentOfType(const clang::Stmt& stmt,
-                                            clang::ASTContext& ast_context) {
-  for (const auto& parent : ast_context.getParents(stmt)) {
-    const auto* candidate_result = parent.template get<RequiredParentT>();
-    if (candidate_result != nullptr) {
-      return candidate_result;
-    }
-  }
-  return nullptr;
-}
-
 }  // namespace dredd
 
 #endif  // LIBDREDD_UTIL_H
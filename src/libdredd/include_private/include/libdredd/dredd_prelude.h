@@ -0,0 +1,70 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDD_DREDD_PRELUDE_H
+#define LIBDREDD_DREDD_PRELUDE_H
+
+#include <string>
+
+#include "libdredd/options.h"
+
+namespace dredd {
+
+// The functions in this file generate the prelude that is added to each
+// mutated source file. A prelude depends only on the options with which Dredd
+// is run, the global id of the first mutation applied to the file, and the
+// number of mutations applied to the file. In particular it does not depend on
+// the AST of the file, so that it can be generated once the file has been
+// processed.
+
+// The name of the header of the runtime that is shared by all mutated files
+// when Options::GetUseSharedRuntime() holds.
+constexpr const char* kDreddSharedRuntimeHeaderName = "dredd_runtime.h";
+
+[[nodiscard]] std::string GetDreddPreludeCpp(const Options& options,
+                                             int initial_mutation_id,
+                                             int num_mutations);
+
+[[nodiscard]] std::string GetRegularDreddPreludeCpp(int initial_mutation_id,
+                                                    int num_mutations);
+
+[[nodiscard]] std::string GetMutantTrackingDreddPreludeCpp(
+    int initial_mutation_id, int num_mutations);
+
+[[nodiscard]] std::string GetDreddPreludeC(const Options& options,
+                                           int initial_mutation_id,
+                                           int num_mutations);
+
+[[nodiscard]] std::string GetRegularDreddPreludeC(int initial_mutation_id,
+                                                  int num_mutations);
+
+[[nodiscard]] std::string GetMutantTrackingDreddPreludeC(
+    int initial_mutation_id, int num_mutations);
+
+// Yield the prelude of a source file whose enabled mutants are looked up in the
+// global mutant registry, when Options::GetUseGlobalMutantRegistry() holds.
+[[nodiscard]] std::string GetGlobalMutantRegistryDreddPreludeCpp(
+    int initial_mutation_id);
+
+[[nodiscard]] std::string GetGlobalMutantRegistryDreddPreludeC(
+    int initial_mutation_id);
+
+// Yields the prelude of a source file that uses the shared runtime. The same
+// prelude is used for both C and C++ source files.
+[[nodiscard]] std::string GetSharedRuntimeDreddPrelude(const Options& options,
+                                                       int initial_mutation_id);
+
+}  // namespace dredd
+
+#endif  // LIBDREDD_DREDD_PRELUDE_H
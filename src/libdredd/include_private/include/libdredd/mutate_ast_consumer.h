@@ -15,21 +15,31 @@
 #ifndef LIBDREDD_MUTATE_AST_CONSUMER_H
 #define LIBDREDD_MUTATE_AST_CONSUMER_H
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
-#include <optional>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
 #include "clang/AST/Expr.h"
 #include "clang/Frontend/CompilerInstance.h"
-#include "clang/Rewrite/Core/Rewriter.h"
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/edit_list.h"
+#include "libdredd/mutation_counts.h"
 #include "libdredd/mutate_visitor.h"
+#include "libdredd/mutation.h"
+#include "libdredd/mutation_info_writer.h"
+#include "libdredd/mutation_selection.h"
 #include "libdredd/mutation_tree_node.h"
 #include "libdredd/options.h"
 #include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/run_statistics.h"
+#include "libdredd/source_range_cache.h"
 
 namespace dredd {
 
@@ -37,57 +47,122 @@ class MutateAstConsumer : public clang::ASTConsumer {
  public:
   MutateAstConsumer(const clang::CompilerInstance& compiler_instance,
                     const Options& options, int& mutation_id,
-                    std::optional<protobufs::MutationInfo>& mutation_info)
+                    bool build_mutation_info,
+                    MutationInfoWriter* mutation_info_writer,
+                    std::vector<DeferredMutatedFile>* deferred_files,
+                    std::vector<protobufs::FileMutationCounts>* mutation_counts,
+                    RunStatistics* run_statistics)
       : compiler_instance_(&compiler_instance),
         options_(&options),
-        visitor_(std::make_unique<MutateVisitor>(compiler_instance, options)),
+        coverage_tracking_options_(options.GetCoverageTrackingOptions()),
+        source_range_cache_(compiler_instance.getPreprocessor()),
+        visitor_(std::make_unique<MutateVisitor>(compiler_instance, options,
+                                                 source_range_cache_)),
         mutation_id_(&mutation_id),
-        mutation_info_(&mutation_info) {}
+        build_mutation_info_(build_mutation_info),
+        mutation_info_writer_(mutation_info_writer),
+        deferred_files_(deferred_files),
+        mutation_counts_(mutation_counts),
+        run_statistics_(run_statistics),
+        creation_time_(std::chrono::steady_clock::now()) {}
 
   void HandleTranslationUnit(clang::ASTContext& ast_context) override;
 
- private:
-  [[nodiscard]] std::string GetDreddPreludeCpp(int initial_mutation_id) const;
-
-  [[nodiscard]] std::string GetRegularDreddPreludeCpp(
-      int initial_mutation_id) const;
-
-  [[nodiscard]] std::string GetMutantTrackingDreddPreludeCpp(
-      int initial_mutation_id) const;
-
-  [[nodiscard]] std::string GetDreddPreludeC(int initial_mutation_id) const;
-
-  [[nodiscard]] std::string GetRegularDreddPreludeC(
-      int initial_mutation_id) const;
+  // Only consulted if skipping of function bodies has been enabled via the
+  // frontend options, in which case the body of a function is skipped if and
+  // only if the function is not declared in the main file.
+  bool shouldSkipFunctionBody(clang::Decl* decl) override;
 
-  [[nodiscard]] std::string GetMutantTrackingDreddPreludeC(
-      int initial_mutation_id) const;
-
-  void RewriteExpressionsInMainFile();
+ private:
+  void RewriteExpressionsInMainFile(EditList& edit_list);
 
   bool RewriteExpressionInMainFileToIntegerConstant(const clang::Expr* expr,
-                                                    uint64_t integer_constant);
+                                                    uint64_t integer_constant,
+                                                    EditList& edit_list);
 
+  // Applies the mutations in the tree rooted at |dredd_mutation_tree_node|
+  // by adding edits to |edit_list|, in the manner determined by |options|,
+  // numbering them from |mutation_id|.
   void ApplyMutations(
       const MutationTreeNode& dredd_mutation_tree_node, int initial_mutation_id,
-      clang::ASTContext& context,
+      clang::ASTContext& context, const Options& options,
+      EditList& edit_list, int& mutation_id,
       protobufs::MutationInfoForFile& protobufs_mutation_info_for_file,
       protobufs::MutationTreeNode& protobufs_mutation_tree_node,
       std::unordered_set<std::string>& dredd_declarations, bool build_tree);
 
+  // Records the number of mutants of each kind and action in the tree rooted
+  // at |dredd_mutation_tree_node|, without applying them, numbering them from
+  // |mutation_id|.
+  void CountMutations(const MutationTreeNode& dredd_mutation_tree_node,
+                      clang::ASTContext& context, int& mutation_id,
+                      MutationCounter& mutation_counter);
+
+  // Chooses the mutants of the translation unit to keep, using the mutation
+  // sampler of |options_|, and records them in |sampled_mutation_selections_|.
+  void SampleMutations(const std::string& filename,
+                       clang::ASTContext& context);
+
+  // Yields the options with which |mutation| is applied: |options| if mutants
+  // are not sampled, and otherwise |options| restricted to the sampled mutants
+  // of |mutation|, stored in |sampled_options|. Yields null if none of the
+  // mutants of |mutation| were sampled.
+  const Options* GetOptionsForMutation(const Mutation& mutation,
+                                       const Options& options,
+                                       Options& sampled_options) const;
+
   const clang::CompilerInstance* compiler_instance_;
 
   const Options* options_;
 
+  // Used to produce the mutant coverage tracking version of the translation
+  // unit, if options_->GetAlsoTrackMutantCoverage() holds.
+  const Options coverage_tracking_options_;
+
+  // Shared by the visitor and the mutations it creates, so that source ranges
+  // for the translation unit are resolved to the main file only once.
+  SourceRangeCache source_range_cache_;
+
   std::unique_ptr<MutateVisitor> visitor_;
 
-  clang::Rewriter rewriter_;
+  // If mutants are sampled, maps each mutation of the translation unit to the
+  // selection of its mutants that are kept.
+  std::unordered_map<const Mutation*, MutationSelection>
+      sampled_mutation_selections_;
+
+  // Collects the edits made to the main file of the translation unit; created
+  // once the translation unit has been parsed.
+  std::unique_ptr<EditList> edit_list_;
+
+  // Only used if options_->GetAlsoTrackMutantCoverage() holds.
+  std::unique_ptr<EditList> coverage_tracking_edit_list_;
 
   // Counter used to give each mutation a unique id; shared among AST consumers
   // for different translation units.
   int* mutation_id_;
 
-  std::optional<protobufs::MutationInfo>* mutation_info_;
+  bool build_mutation_info_;
+
+  // If non-null, and if |build_mutation_info_| holds, the mutation info for
+  // the translation unit is written to this once it has been mutated.
+  MutationInfoWriter* mutation_info_writer_;
+
+  // If non-null, mutated files are not written out, and their mutation info is
+  // not written to |mutation_info_writer_|. Instead, each mutated file is
+  // recorded here, with file-local mutation ids and without a prelude.
+  std::vector<DeferredMutatedFile>* deferred_files_;
+
+  // If non-null, the translation unit is not mutated: the mutants that would
+  // be applied to it are counted, and the counts are recorded here.
+  std::vector<protobufs::FileMutationCounts>* mutation_counts_;
+
+  // If non-null, the time spent in each phase of processing the translation
+  // unit is added to this.
+  RunStatistics* run_statistics_;
+
+  // The consumer is created just before the translation unit is parsed, so
+  // this is used to measure the time spent parsing.
+  std::chrono::steady_clock::time_point creation_time_;
 };
 
 }  // namespace dredd
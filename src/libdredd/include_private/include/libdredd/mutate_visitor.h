@@ -16,9 +16,10 @@
 #define LIBDREDD_MUTATE_VISITOR_H
 
 #include <cassert>
-#include <memory>
+#include <cstdint>
 #include <optional>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -36,16 +37,20 @@
 #include "clang/AST/TypeLoc.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "libdredd/expr_analysis_cache.h"
+#include "libdredd/line_ranges.h"
 #include "libdredd/mutation.h"
 #include "libdredd/mutation_tree_node.h"
 #include "libdredd/options.h"
+#include "libdredd/source_range_cache.h"
+#include "libdredd/stmt_parent_map.h"
 
 namespace dredd {
 
 class MutateVisitor : public clang::RecursiveASTVisitor<MutateVisitor> {
  public:
   MutateVisitor(const clang::CompilerInstance& compiler_instance,
-                const Options& options);
+                const Options& options, SourceRangeCache& source_range_cache);
 
   bool TraverseDecl(clang::Decl* decl);
 
@@ -102,12 +107,36 @@ class MutateVisitor : public clang::RecursiveASTVisitor<MutateVisitor> {
   // NOLINTNEXTLINE
   bool shouldTraversePostOrder() { return true; }
 
-  // Should only be called after visitation is complete. Yields the tree of
-  // mutations for the translation unit.
+  // Should be called once visitation is complete, to simplify the tree of
+  // mutations that has been built in preparation for applying the mutations
+  // and later turning the tree into a JSON summary.
+  void TidyUpMutations() { mutation_tree_root_.TidyUp(); }
+
+  // Should only be called after the tree of mutations has been tidied up.
+  // Yields the tree of mutations for the translation unit.
   [[nodiscard]] const MutationTreeNode& GetMutations() const {
     return mutation_tree_root_;
   }
 
+  // Yields the innermost function that was being traversed when |mutation|
+  // was found, or null if it was not found in a function.
+  [[nodiscard]] const clang::FunctionDecl* GetEnclosingFunction(
+      const Mutation& mutation) const {
+    auto iterator = enclosing_functions_.find(&mutation);
+    return iterator == enclosing_functions_.end() ? nullptr
+                                                  : iterator->second;
+  }
+
+  // The number of declarations and statements that have been traversed,
+  // including those that were not considered for mutation.
+  [[nodiscard]] int64_t GetNumDeclsTraversed() const {
+    return num_decls_traversed_;
+  }
+
+  [[nodiscard]] int64_t GetNumStmtsTraversed() const {
+    return num_stmts_traversed_;
+  }
+
   // Yields the C++ constant-sized arrays, whose size expressions need to be
   // rewritten.
   [[nodiscard]] const std::vector<const clang::DeclaratorDecl*>&
@@ -142,15 +171,13 @@ class MutateVisitor : public clang::RecursiveASTVisitor<MutateVisitor> {
   // Helper class that uses the RAII pattern to support pushing a new mutation
   // tree node on to the stack of mutation tree nodes used during visitation,
   // and automatically popping the node off the stack when control returns from
-  // the visitor method that performed the push.
+  // the visitor method that performed the push. The node itself is only
+  // created if a mutation is added while it is on the stack; see AddMutation.
   class PushMutationTreeRAII {
    public:
     explicit PushMutationTreeRAII(MutateVisitor& mutate_visitor)
         : mutate_visitor_(&mutate_visitor) {
-      auto child = std::make_unique<MutationTreeNode>();
-      auto* child_ptr = child.get();
-      mutate_visitor_->mutation_tree_path_.back()->AddChild(std::move(child));
-      mutate_visitor_->mutation_tree_path_.push_back(child_ptr);
+      mutate_visitor_->mutation_tree_path_.push_back(nullptr);
     }
 
     ~PushMutationTreeRAII() { mutate_visitor_->mutation_tree_path_.pop_back(); }
@@ -199,14 +226,29 @@ class MutateVisitor : public clang::RecursiveASTVisitor<MutateVisitor> {
   // }
   bool IsInFunction();
 
+  // Returns true if and only if a mutation of the AST node with the given range
+  // in the main file is permitted by the line ranges to which mutation has
+  // been restricted, if any. Mutations of nodes that are not in the main file
+  // are never permitted when mutation is restricted.
+  bool IsInLineRanges(clang::SourceRange source_range_in_main_file);
+
+  // Returns true if and only if the function filter in use, if any, permits
+  // |function_decl| to be mutated.
+  bool ShouldMutateFunction(const clang::FunctionDecl& function_decl) const;
+
+  // Returns true if and only if |decl| has been annotated, via
+  // [[clang::annotate("dredd_skip")]], as not to be mutated.
+  static bool HasDreddSkipAnnotation(const clang::Decl& decl);
+
   // Mutating an enum constant can be problematic when the enum constant is used
   // to implicitly construct a C++ object. This helper method allows detecting
   // this special case, so that it can be ignored.
   bool IsConversionOfEnumToConstructor(const clang::Expr& expr) const;
 
   // Adds details of a mutation that can be applied, and performs associated
-  // bookkeeping.
-  void AddMutation(std::unique_ptr<Mutation> mutation);
+  // bookkeeping. The mutation must have been created by
+  // |mutation_tree_arena_|.
+  void AddMutation(const Mutation& mutation);
 
   // Determines whether the parent of the given expression is a call expression
   // that uses argument-dependent lookup.
@@ -251,17 +293,42 @@ class MutateVisitor : public clang::RecursiveASTVisitor<MutateVisitor> {
   const clang::CompilerInstance* compiler_instance_;
   const Options* options_;
 
+  // The lines of the main file to which mutation is restricted, if mutation is
+  // restricted to particular lines; set when traversal of the translation unit
+  // begins.
+  std::optional<LineRanges> main_file_line_ranges_;
+
+  // Owned by the AST consumer; shared with the mutations that the visitor
+  // creates.
+  SourceRangeCache* source_range_cache_;
+
   // The begin location of a special function that can be written to indicate
   // where the Dredd prelude should be inserted. This is useful to cater for
   // cases where the heuristic that Dredd uses to insert its prelude would lead
   // to compilation problems.
   std::optional<clang::SourceLocation> dredd_prelude_start_location_;
 
+  // Records the parents of the statements that are traversed, so that parent
+  // queries do not require ASTContext::getParents, which builds a parent map
+  // for the entire translation unit. Mutations that are created during
+  // traversal may refer to this when they are applied.
+  StmtParentMap parent_map_;
+
+  // Memoises constant evaluation and side-effect queries, which are made
+  // repeatedly for the same expressions by the visitor and by the mutations it
+  // creates. Mutations may refer to this when they are applied.
+  ExprAnalysisCache analysis_cache_;
+
   // Tracks the nest of declarations currently being traversed. Any new Dredd
   // functions will be put before the start of the current nest, which avoids
   // e.g. putting a Dredd function inside a class or function.
   std::vector<const clang::Decl*> enclosing_decls_;
 
+  // Records the innermost function enclosing each mutation that is found in a
+  // function, so that mutants can be attributed to functions.
+  std::unordered_map<const Mutation*, const clang::FunctionDecl*>
+      enclosing_functions_;
+
   // These fields track whether a statement contains some sub-statement that
   // might cause control to branch outside of the statement. This needs to be
   // tracked to determine when it is legitimate to move a statement into a
@@ -271,11 +338,18 @@ class MutateVisitor : public clang::RecursiveASTVisitor<MutateVisitor> {
   std::unordered_set<clang::Stmt*> contains_continue_for_enclosing_loop_;
   std::unordered_set<clang::Stmt*> contains_case_for_enclosing_switch_;
 
+  // Owns the nodes of the mutation tree, other than its root, and the
+  // mutations that they refer to.
+  MutationTreeArena mutation_tree_arena_;
+
   // Records the mutations that can be applied, in a hierarchical manner.
   MutationTreeNode mutation_tree_root_;
 
   // Used to keep track of how mutations are hierarchically organised while the
-  // AST is being visited.
+  // AST is being visited. An entry is null if no mutation has yet been found
+  // in the corresponding scope, in which case no tree node has been created for
+  // it. Most scopes contain no mutations, so this avoids creating and then
+  // pruning a node for each of them.
   std::vector<MutationTreeNode*> mutation_tree_path_;
 
   // In C++, it is common to introduce a variable in a boolean guard via "auto",
@@ -307,6 +381,10 @@ class MutateVisitor : public clang::RecursiveASTVisitor<MutateVisitor> {
   // so that their expressions can be rewritten with the integers to which they
   // evaluate.
   std::vector<const clang::Expr*> constant_arguments_to_rewrite_;
+
+  int64_t num_decls_traversed_ = 0;
+
+  int64_t num_stmts_traversed_ = 0;
 };
 
 }  // namespace dredd
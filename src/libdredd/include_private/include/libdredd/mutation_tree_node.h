@@ -15,38 +15,129 @@
 #ifndef LIBDREDD_MUTATION_TREE_NODE_H
 #define LIBDREDD_MUTATION_TREE_NODE_H
 
-#include <memory>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "libdredd/mutation.h"
+#include "llvm/ADT/iterator_range.h"
+#include "llvm/Support/Allocator.h"
 
 namespace dredd {
 
+class MutationTreeArena;
+
 // Used to track the hierarchical structure between mutations as they are
 // created during the traversal of an abstract syntax tree. Subsequently, the
 // root MutationTreeNode for a translation unit is turned into a
 // MutationIdTreeNode, which just captures the ids associated with the sets of
 // mutations instantiated by each Mutation object.
+//
+// Nodes and mutations are allocated in a MutationTreeArena, and a node's
+// children and mutations are held in intrusive linked lists, so that building
+// the tree for a large translation unit does not involve many small heap
+// allocations.
 class MutationTreeNode {
  public:
-  // Adds the given mutation to this tree node.
-  void AddMutation(std::unique_ptr<Mutation> mutation);
+  // An entry in the list of mutations associated with a node.
+  struct MutationListEntry {
+    const Mutation* mutation;
+    MutationListEntry* next;
+  };
+
+  // Iterates over the children of a node.
+  class ChildIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = const MutationTreeNode*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    explicit ChildIterator(const MutationTreeNode* node) : node_(node) {}
+
+    const MutationTreeNode* operator*() const { return node_; }
+
+    ChildIterator& operator++() {
+      node_ = node_->next_sibling_;
+      return *this;
+    }
+
+    bool operator==(const ChildIterator& other) const = default;
+
+   private:
+    const MutationTreeNode* node_;
+  };
+
+  // Iterates over the mutations associated with a node.
+  class MutationIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = const Mutation*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    explicit MutationIterator(const MutationListEntry* entry)
+        : entry_(entry) {}
+
+    const Mutation* operator*() const { return entry_->mutation; }
+
+    MutationIterator& operator++() {
+      entry_ = entry_->next;
+      return *this;
+    }
+
+    bool operator==(const MutationIterator& other) const = default;
+
+   private:
+    const MutationListEntry* entry_;
+  };
+
+  MutationTreeNode() = default;
+
+  MutationTreeNode(const MutationTreeNode&) = delete;
+
+  MutationTreeNode& operator=(const MutationTreeNode&) = delete;
+
+  MutationTreeNode(MutationTreeNode&&) = delete;
+
+  MutationTreeNode& operator=(MutationTreeNode&&) = delete;
+
+  ~MutationTreeNode() = default;
 
-  // Moves the given subtree into this tree node as a child.
-  void AddChild(std::unique_ptr<MutationTreeNode> node);
+  // Adds the given mutation, which must have been created by |arena|, to this
+  // tree node.
+  void AddMutation(const Mutation& mutation, MutationTreeArena& arena);
+
+  // Adds the given node, which must have been created by the arena that
+  // created this node's mutations and children, as the last child of this
+  // tree node.
+  void AddChild(MutationTreeNode& node);
 
   // Yields the children of this tree node.
-  [[nodiscard]] std::vector<const MutationTreeNode*> GetChildren() const;
+  [[nodiscard]] llvm::iterator_range<ChildIterator> GetChildren() const {
+    return {ChildIterator(first_child_), ChildIterator(nullptr)};
+  }
+
+  // Returns true if and only if this tree node has exactly one child.
+  [[nodiscard]] bool HasOneChild() const {
+    return first_child_ != nullptr && first_child_->next_sibling_ == nullptr;
+  }
 
   // Yields the mutations associated with this tree node.
-  [[nodiscard]] const std::vector<std::unique_ptr<Mutation>>& GetMutations()
-      const {
-    return mutations_;
+  [[nodiscard]] llvm::iterator_range<MutationIterator> GetMutations() const {
+    return {MutationIterator(first_mutation_), MutationIterator(nullptr)};
   }
 
   // Once the tree has been built, this method should be invoked to make it
-  // simpler, without losing any relationship between mutations. This includes,
-  // for example, pruning empty subtrees.
+  // simpler, without losing any relationship between mutations, by squashing
+  // chains of nodes that hold no mutations and only have one child. The tree
+  // is expected to have no empty subtrees, which MutateVisitor ensures by only
+  // creating a node once a mutation is found beneath it.
   void TidyUp();
 
   // Returns true if and only if every node in the subtree rooted at this node
@@ -54,15 +145,56 @@ class MutationTreeNode {
   [[nodiscard]] bool IsEmpty() const;
 
  private:
-  // Used by "TidyUp" to squash chains of nodes that hold no mutations and only
-  // have one child.
-  void Compress();
+  MutationListEntry* first_mutation_ = nullptr;
+  MutationListEntry* last_mutation_ = nullptr;
+  MutationTreeNode* first_child_ = nullptr;
+  MutationTreeNode* last_child_ = nullptr;
+  MutationTreeNode* next_sibling_ = nullptr;
+};
+
+// Owns the nodes of a mutation tree for a translation unit, and the mutations
+// that they refer to. Everything is bump-allocated and released at once when
+// the arena is destroyed.
+class MutationTreeArena {
+ public:
+  MutationTreeArena() = default;
+
+  MutationTreeArena(const MutationTreeArena&) = delete;
+
+  MutationTreeArena& operator=(const MutationTreeArena&) = delete;
+
+  MutationTreeArena(MutationTreeArena&&) = delete;
 
-  // Used by "TidyUp" to eliminate empty subtrees.
-  void PruneEmptySubtrees();
+  MutationTreeArena& operator=(MutationTreeArena&&) = delete;
+
+  ~MutationTreeArena();
+
+  [[nodiscard]] MutationTreeNode& CreateNode() {
+    return *new (allocator_.Allocate<MutationTreeNode>()) MutationTreeNode();
+  }
+
+  [[nodiscard]] MutationTreeNode::MutationListEntry& CreateMutationListEntry(
+      const Mutation& mutation) {
+    return *new (allocator_.Allocate<MutationTreeNode::MutationListEntry>())
+        MutationTreeNode::MutationListEntry{&mutation, nullptr};
+  }
+
+  template <typename MutationType, typename... Args>
+  [[nodiscard]] const MutationType& CreateMutation(Args&&... args) {
+    static_assert(std::is_base_of_v<Mutation, MutationType>,
+                  "Only mutations can be created.");
+    auto* result = new (allocator_.Allocate<MutationType>())
+        MutationType(std::forward<Args>(args)...);
+    mutations_.push_back(result);
+    return *result;
+  }
+
+ private:
+  llvm::BumpPtrAllocator allocator_;
 
-  std::vector<std::unique_ptr<Mutation>> mutations_;
-  std::vector<std::unique_ptr<MutationTreeNode>> children_;
+  // Unlike tree nodes, mutations have non-trivial destructors, so they are
+  // recorded in order to be destroyed along with the arena.
+  std::vector<Mutation*> mutations_;
 };
 
 }  // namespace dredd
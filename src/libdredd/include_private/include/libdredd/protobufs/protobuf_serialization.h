@@ -12,8 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#ifndef DREDD_PROTOBUFS_PROTOBUF_SERIALIZATION_H
-#define DREDD_PROTOBUFS_PROTOBUF_SERIALIZATION_H
+#ifndef LIBDREDD_PROTOBUFS_PROTOBUF_SERIALIZATION_H
+#define LIBDREDD_PROTOBUFS_PROTOBUF_SERIALIZATION_H
 
 #if defined(__clang__)
 #pragma clang diagnostic push
@@ -35,7 +35,9 @@
 // The following should be the only place in the project where protobuf files
 // related to serialization are are directly included. This is so that they can
 // be compiled in a manner where warnings are ignored.
+#include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/stubs/status.h"
+#include "google/protobuf/util/delimited_message_util.h"
 #include "google/protobuf/util/json_util.h"
 
 #if defined(__clang__)
@@ -46,4 +48,4 @@
 #pragma warning(pop)
 #endif
 
-#endif  // DREDD_PROTOBUFS_PROTOBUF_SERIALIZATION_H
+#endif  // LIBDREDD_PROTOBUFS_PROTOBUF_SERIALIZATION_H
@@ -0,0 +1,180 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/deferred_mutated_file.h"
+
+#include <cassert>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "libdredd/dredd_prelude.h"
+#include "libdredd/offset_mutation_ids.h"
+#include "libdredd/options.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace dredd {
+
+DeferredMutatedFile DeferredMutatedFile::FromProtobuf(
+    const protobufs::DeferredMutatedFile& deferred_mutated_file) {
+  return {deferred_mutated_file.filename(),
+          deferred_mutated_file.output_path(),
+          deferred_mutated_file.is_cpp(),
+          deferred_mutated_file.num_mutations(),
+          deferred_mutated_file.text_before_prelude(),
+          deferred_mutated_file.text_after_prelude(),
+          deferred_mutated_file.mutation_info_for_file(),
+          deferred_mutated_file.has_coverage_tracking_text(),
+          deferred_mutated_file.coverage_tracking_text_before_prelude(),
+          deferred_mutated_file.coverage_tracking_text_after_prelude(),
+          std::vector<std::string>(
+              deferred_mutated_file.dredd_declarations().begin(),
+              deferred_mutated_file.dredd_declarations().end())};
+}
+
+protobufs::DeferredMutatedFile DeferredMutatedFile::ToProtobuf() const {
+  protobufs::DeferredMutatedFile result;
+  result.set_filename(filename_);
+  result.set_output_path(output_path_);
+  result.set_is_cpp(is_cpp_);
+  result.set_num_mutations(num_mutations_);
+  result.set_text_before_prelude(text_before_prelude_);
+  result.set_text_after_prelude(text_after_prelude_);
+  *result.mutable_mutation_info_for_file() = mutation_info_for_file_;
+  result.set_has_coverage_tracking_text(has_coverage_tracking_text_);
+  result.set_coverage_tracking_text_before_prelude(
+      coverage_tracking_text_before_prelude_);
+  result.set_coverage_tracking_text_after_prelude(
+      coverage_tracking_text_after_prelude_);
+  for (const auto& dredd_declaration : dredd_declarations_) {
+    result.add_dredd_declarations(dredd_declaration);
+  }
+  return result;
+}
+
+std::string DeferredMutatedFile::GetMutatedText(const Options& options,
+                                                int initial_mutation_id) const {
+  return text_before_prelude_ +
+         (is_cpp_
+              ? GetDreddPreludeCpp(options, initial_mutation_id, num_mutations_)
+              : GetDreddPreludeC(options, initial_mutation_id,
+                                 num_mutations_)) +
+         text_after_prelude_;
+}
+
+bool DeferredMutatedFile::WriteMutatedText(const Options& options,
+                                           int initial_mutation_id) const {
+  if (llvm::Error error = llvm::writeToOutput(
+          output_path_, [&](llvm::raw_ostream& output_stream) -> llvm::Error {
+            output_stream << GetMutatedText(options, initial_mutation_id);
+            return llvm::Error::success();
+          })) {
+    llvm::errs() << "Unable to overwrite file " << output_path_ << ": "
+                 << llvm::toString(std::move(error)) << "\n";
+    return false;
+  }
+  return true;
+}
+
+std::string DeferredMutatedFile::GetCoverageTrackingText(
+    const Options& options, int initial_mutation_id) const {
+  assert(has_coverage_tracking_text_ && "No coverage tracking text.");
+  const Options coverage_tracking_options =
+      options.GetCoverageTrackingOptions();
+  return coverage_tracking_text_before_prelude_ +
+         (is_cpp_ ? GetDreddPreludeCpp(coverage_tracking_options,
+                                       initial_mutation_id, num_mutations_)
+                  : GetDreddPreludeC(coverage_tracking_options,
+                                     initial_mutation_id, num_mutations_)) +
+         coverage_tracking_text_after_prelude_;
+}
+
+std::string DeferredMutatedFile::GetCoverageTrackingOutputPath(
+    const std::string& source_root,
+    const std::string& coverage_tracking_output_dir) const {
+  llvm::SmallString<128> absolute_source_root(source_root);
+  llvm::sys::fs::make_absolute(absolute_source_root);
+  llvm::sys::path::remove_dots(absolute_source_root, /*remove_dot_dot=*/true);
+  llvm::SmallString<128> absolute_output_path(output_path_);
+  llvm::sys::path::remove_dots(absolute_output_path, /*remove_dot_dot=*/true);
+
+  // Compare whole path components, so that e.g. /a/bc is not regarded as being
+  // under /a/b.
+  auto output_path_iterator = llvm::sys::path::begin(absolute_output_path);
+  const auto output_path_end = llvm::sys::path::end(absolute_output_path);
+  for (auto source_root_iterator = llvm::sys::path::begin(absolute_source_root);
+       source_root_iterator != llvm::sys::path::end(absolute_source_root);
+       ++source_root_iterator, ++output_path_iterator) {
+    if (output_path_iterator == output_path_end ||
+        *output_path_iterator != *source_root_iterator) {
+      return "";
+    }
+  }
+  if (output_path_iterator == output_path_end) {
+    return "";
+  }
+  llvm::SmallString<128> result(coverage_tracking_output_dir);
+  for (; output_path_iterator != output_path_end; ++output_path_iterator) {
+    llvm::sys::path::append(result, *output_path_iterator);
+  }
+  return result.str().str();
+}
+
+bool DeferredMutatedFile::WriteCoverageTrackingText(
+    const Options& options, int initial_mutation_id,
+    const std::string& source_root,
+    const std::string& coverage_tracking_output_dir) const {
+  const std::string coverage_tracking_output_path =
+      GetCoverageTrackingOutputPath(source_root, coverage_tracking_output_dir);
+  if (coverage_tracking_output_path.empty()) {
+    llvm::errs() << "Unable to write a mutant coverage tracking version of "
+                 << output_path_ << ", as it is not under the source root "
+                 << source_root << "\n";
+    return false;
+  }
+  if (const std::error_code error_code = llvm::sys::fs::create_directories(
+          llvm::sys::path::parent_path(coverage_tracking_output_path))) {
+    llvm::errs() << "Unable to create a directory for "
+                 << coverage_tracking_output_path << ": "
+                 << error_code.message() << "\n";
+    return false;
+  }
+  if (llvm::Error error = llvm::writeToOutput(
+          coverage_tracking_output_path,
+          [&](llvm::raw_ostream& output_stream) -> llvm::Error {
+            output_stream << GetCoverageTrackingText(options,
+                                                     initial_mutation_id);
+            return llvm::Error::success();
+          })) {
+    llvm::errs() << "Unable to write file " << coverage_tracking_output_path
+                 << ": " << llvm::toString(std::move(error)) << "\n";
+    return false;
+  }
+  return true;
+}
+
+protobufs::MutationInfoForFile DeferredMutatedFile::GetMutationInfoForFile(
+    int initial_mutation_id) const {
+  protobufs::MutationInfoForFile result = mutation_info_for_file_;
+  OffsetMutationIds(initial_mutation_id, result);
+  return result;
+}
+
+}  // namespace dredd
@@ -0,0 +1,686 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/dredd_prelude.h"
+
+#include <sstream>
+#include <string>
+
+#include "libdredd/options.h"
+
+namespace dredd {
+
+namespace {
+const char* const kDreddPreludeStartComment =
+    "// DREDD PRELUDE START\n"
+    "// If this has been inserted at an inappropriate place in a source file,\n"
+    "// declare a placeholder function with the following signature to\n"
+    "// mandate where the prelude should be placed:\n"
+    "//\n"
+    "// void __dredd_prelude_start();\n"
+    "//\n";
+
+const char* const kDreddPreludeHeadersCpp =
+    "#include <atomic>\n"
+    "#include <cinttypes>\n"
+    "#include <cstddef>\n"
+    "#include <cstdlib>\n"
+    "#include <fstream>\n"
+    "#include <sstream>\n"
+    "#include <string>\n"
+    "#include <utility>\n";
+
+const char* const kDreddPreludeHeadersC =
+    "#include <inttypes.h>\n"
+    "#include <stdatomic.h>\n"
+    "#include <stdbool.h>\n"
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#include <string.h>\n";
+
+// Provides __builtin_expect where it is available, in C or C++.
+const char* const kDreddExpect =
+    "#if defined(__GNUC__) || defined(__clang__)\n"
+    "#define __dredd_expect(expression, value) "
+    "__builtin_expect((expression), (value))\n"
+    "#else\n"
+    "#define __dredd_expect(expression, value) (expression)\n"
+    "#endif\n"
+    "\n";
+
+// When exactly one mutant of the file is enabled, which is by far the most
+// common case when any mutant is enabled, this is its file-local id, so that
+// whether a mutant is enabled can be checked with a single comparison.
+// Otherwise, it is one of the negative values below. It is uninitialised to
+// begin with, so that the enabled mutants are worked out if enabledness is
+// queried before they have been worked out at load time. This is common to C
+// and C++.
+//
+// It is the only state that is consulted before the bitset, and it is
+// published with a release store once the bitset has been filled in, and read
+// with acquire loads. A thread that queries enabledness while another thread is
+// working out the enabled mutants, e.g. before the load-time constructor has
+// run, or with compilers that lack constructors, therefore either sees that
+// they are uninitialised or sees all of the state.
+const char* const kDreddSingleEnabledMutationStates =
+    "enum {\n"
+    "  __dredd_no_mutation_enabled = -1,\n"
+    "  __dredd_mutations_uninitialized = -2,\n"
+    "  __dredd_several_mutations_enabled = -3\n"
+    "};\n";
+
+const char* const kDreddSingleEnabledMutationCpp =
+    "static std::atomic<int> __dredd_single_enabled_mutation("
+    "__dredd_mutations_uninitialized);\n"
+    "static inline int __dredd_get_single_enabled_mutation() {\n"
+    "  return "
+    "__dredd_single_enabled_mutation.load(std::memory_order_acquire);\n"
+    "}\n"
+    "static inline void __dredd_set_single_enabled_mutation(int value) {\n"
+    "  __dredd_single_enabled_mutation.store(value, "
+    "std::memory_order_release);\n"
+    "}\n";
+
+const char* const kDreddSingleEnabledMutationC =
+    "static atomic_int __dredd_single_enabled_mutation = "
+    "__dredd_mutations_uninitialized;\n"
+    "static inline int __dredd_get_single_enabled_mutation(void) {\n"
+    "  return atomic_load_explicit(&__dredd_single_enabled_mutation, "
+    "memory_order_acquire);\n"
+    "}\n"
+    "static inline void __dredd_set_single_enabled_mutation(int value) {\n"
+    "  atomic_store_explicit(&__dredd_single_enabled_mutation, value, "
+    "memory_order_release);\n"
+    "}\n";
+
+// Allows for fast checking that at least *some* mutant in the file is enabled,
+// in C or C++. This holds until the enabled mutants have been worked out, so
+// that mutator functions query enabledness, which works them out.
+const char* const kDreddSomeMutationEnabled =
+    "#define __dredd_some_mutation_enabled "
+    "(__dredd_get_single_enabled_mutation() != __dredd_no_mutation_enabled)\n";
+
+// Records the outcome of working out the enabled mutants, in C or C++, once
+// the bitset has been filled in.
+const char* const kDreddRecordEnabledMutations =
+    "  __dredd_set_single_enabled_mutation(num_enabled_mutations > 1 ? "
+    "__dredd_several_mutations_enabled : single_enabled_mutation);\n";
+
+// Works out the enabled mutants when the program is loaded, in C or C++, so
+// that the state describing them is read-only by the time the program starts
+// any threads. Where constructor functions are not available, the enabled
+// mutants are instead worked out the first time enabledness is queried.
+const char* const kDreddInitializeEnabledMutationsAtLoad =
+    "#if defined(__GNUC__) || defined(__clang__)\n"
+    "__attribute__((constructor)) static void "
+    "__dredd_initialize_enabled_mutations_at_load(void) {\n"
+    "  __dredd_initialize_enabled_mutations();\n"
+    "}\n"
+    "#endif\n\n";
+
+// The start of __dredd_enabled_alternative, in C or C++, which works out the
+// enabled mutants if need be, and only consults the bitset if several mutants
+// are enabled.
+const char* const kDreddEnabledAlternativeFastPath =
+    "  int single_enabled_mutation = __dredd_get_single_enabled_mutation();\n"
+    "  if (single_enabled_mutation == __dredd_mutations_uninitialized) {\n"
+    "    __dredd_initialize_enabled_mutations();\n"
+    "    single_enabled_mutation = __dredd_get_single_enabled_mutation();\n"
+    "  }\n"
+    "  if (single_enabled_mutation != __dredd_several_mutations_enabled) {\n"
+    "    int offset = single_enabled_mutation - local_mutation_id;\n"
+    "    return offset >= 0 && offset < num_alternatives ? offset : -1;\n"
+    "  }\n";
+
+// Yields the number of trailing zeros of the nonzero 64-bit integer
+// |alternatives|, i.e. the offset of the first enabled mutant, in C or C++.
+const char* const kDreddCountTrailingZeros =
+    "#if defined(__GNUC__) || defined(__clang__)\n"
+    "  return __builtin_ctzll(alternatives);\n"
+    "#else\n"
+    "  int result = 0;\n"
+    "  while ((alternatives & 1) == 0) {\n"
+    "    alternatives >>= 1;\n"
+    "    result++;\n"
+    "  }\n"
+    "  return result;\n"
+    "#endif\n";
+
+// Whether a single mutant is enabled, in C or C++. Sites that remove
+// statements pass the element of the bitset holding the mutant's bit, and the
+// mask for that bit, which Dredd works out in advance, so that the check can be
+// inlined and costs a single comparison in the common case.
+const char* const kDreddEnabledMutation =
+    "static inline bool __dredd_enabled_mutation(int local_mutation_id) {\n"
+    "  return __dredd_enabled_alternative(local_mutation_id, 1) == 0;\n"
+    "}\n\n"
+    "static inline bool __dredd_enabled_mutation_with_mask(int "
+    "local_mutation_id, int word, uint64_t mask) {\n"
+    "  int single_enabled_mutation = __dredd_get_single_enabled_mutation();\n"
+    "  if (__dredd_expect(single_enabled_mutation >= "
+    "__dredd_no_mutation_enabled, 1)) {\n"
+    "    return single_enabled_mutation == local_mutation_id;\n"
+    "  }\n"
+    "  if (single_enabled_mutation == __dredd_mutations_uninitialized) {\n"
+    "    return __dredd_enabled_mutation(local_mutation_id);\n"
+    "  }\n"
+    "  return (__dredd_enabled_bitset[word] & mask) != 0;\n"
+    "}\n\n";
+
+// The registry of the mutants that are enabled in the whole program, in C or
+// C++. It is indexed by global mutation id, and is defined weakly, with C
+// linkage, in every mutated file, so that the linker keeps a single copy that
+// is shared by mutated C and C++ files alike. The environment variable is
+// processed once, at load time, or when enabledness is first queried if that
+// happens earlier; an atomic records whether this has not yet happened (0), is
+// happening (1) or has happened (2). The bitset is sized according to the
+// largest enabled mutant, so that the registry does not need to know how many
+// mutants the program has. Mutant ids are ints, so larger ids, which cannot
+// identify mutants, are ignored; the program is aborted if the bitset cannot be
+// allocated, rather than running with no mutant enabled. As in the regular
+// prelude, the single enabled
+// mutant is published with a release store once the bitset has been filled in,
+// and is read with acquire loads.
+const char* const kDreddGlobalMutantRegistry =
+    "#if !defined(__GNUC__) && !defined(__clang__)\n"
+    "#error \"The Dredd global mutant registry requires weak symbols.\"\n"
+    "#endif\n"
+    "#ifdef __cplusplus\n"
+    "extern \"C\" {\n"
+    "#endif\n"
+    "__attribute__((weak)) int __dredd_registry_single_enabled_mutation = "
+    "__dredd_mutations_uninitialized;\n"
+    "__attribute__((weak)) int __dredd_registry_num_words = 0;\n"
+    "__attribute__((weak)) uint64_t* __dredd_registry_bitset = 0;\n"
+    "__attribute__((weak)) int __dredd_registry_state = 0;\n"
+    "__attribute__((weak, constructor)) void "
+    "__dredd_registry_initialize(void) {\n"
+    "  int expected = 0;\n"
+    "  if (__atomic_compare_exchange_n(&__dredd_registry_state, &expected, 1, "
+    "0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {\n"
+    "    int num_enabled_mutations = 0;\n"
+    "    int single_enabled_mutation = __dredd_no_mutation_enabled;\n"
+    "    const char* dredd_environment_variable = "
+    "getenv(\"DREDD_ENABLED_MUTATION\");\n"
+    "    if (dredd_environment_variable) {\n"
+    // The first pass finds the largest enabled mutant, so that the bitset can
+    // be allocated, and the second pass fills in the bitset.
+    "      for (int pass = 0; pass < 2; pass++) {\n"
+    "        const char* token = dredd_environment_variable;\n"
+    "        while (*token) {\n"
+    "          if (*token != ',') {\n"
+    "            long value = strtol(token, 0, 10);\n"
+    "            if (value >= 0 && value <= INT_MAX && pass == 0) {\n"
+    "              if (value / 64 >= __dredd_registry_num_words) {\n"
+    "                __dredd_registry_num_words = (int) (value / 64) + 1;\n"
+    "              }\n"
+    "            } else if (value >= 0 && value <= INT_MAX) {\n"
+    "              uint64_t mask = (uint64_t) 1 << (value % 64);\n"
+    "              if (!(__dredd_registry_bitset[value / 64] & mask)) {\n"
+    "                __dredd_registry_bitset[value / 64] |= mask;\n"
+    "                single_enabled_mutation = (int) value;\n"
+    "                num_enabled_mutations++;\n"
+    "              }\n"
+    "            }\n"
+    "          }\n"
+    "          token = strchr(token, ',');\n"
+    "          if (!token) {\n"
+    "            break;\n"
+    "          }\n"
+    "          token++;\n"
+    "        }\n"
+    "        if (pass == 0 && __dredd_registry_num_words > 0) {\n"
+    "          __dredd_registry_bitset = (uint64_t*) "
+    "calloc((size_t) __dredd_registry_num_words, sizeof(uint64_t));\n"
+    "          if (!__dredd_registry_bitset) {\n"
+    "            fprintf(stderr, \"Dredd: unable to allocate the registry of "
+    "enabled mutants.\\n\");\n"
+    "            abort();\n"
+    "          }\n"
+    "        }\n"
+    "      }\n"
+    "    }\n"
+    "    __atomic_store_n(&__dredd_registry_single_enabled_mutation, "
+    "num_enabled_mutations > 1 ? __dredd_several_mutations_enabled : "
+    "single_enabled_mutation, __ATOMIC_RELEASE);\n"
+    "    __atomic_store_n(&__dredd_registry_state, 2, __ATOMIC_RELEASE);\n"
+    "  }\n"
+    "  while (__atomic_load_n(&__dredd_registry_state, __ATOMIC_ACQUIRE) != "
+    "2) {\n"
+    "  }\n"
+    "}\n"
+    "#ifdef __cplusplus\n"
+    "}\n"
+    "#endif\n\n";
+
+// Yields the part of the prelude of a file that uses the global mutant
+// registry that follows the headers, and is common to C and C++. The file
+// only records the global id of its first mutation, with which it turns
+// file-local mutation ids into indices into the registry.
+std::string GetGlobalMutantRegistryDreddPrelude(int initial_mutation_id) {
+  std::stringstream result;
+  result << kDreddExpect;
+  result << kDreddSingleEnabledMutationStates;
+  result << kDreddGlobalMutantRegistry;
+  result << "enum { __dredd_first_mutation_id = " << initial_mutation_id
+         << " };\n";
+  result << "static inline int "
+            "__dredd_registry_get_single_enabled_mutation(void) {\n";
+  result << "  return __atomic_load_n("
+            "&__dredd_registry_single_enabled_mutation, __ATOMIC_ACQUIRE);\n";
+  result << "}\n";
+  // Until the registry has been initialised, this holds, so that mutator
+  // functions query enabledness, which initialises the registry.
+  result << "#define __dredd_some_mutation_enabled "
+            "(__dredd_registry_get_single_enabled_mutation() != "
+            "__dredd_no_mutation_enabled)\n\n";
+  result << "static int __dredd_enabled_alternative(int local_mutation_id, "
+            "int num_alternatives) {\n";
+  result << "  int mutation_id = __dredd_first_mutation_id + "
+            "local_mutation_id;\n";
+  result << "  int single_enabled_mutation = "
+            "__dredd_registry_get_single_enabled_mutation();\n";
+  result << "  if (single_enabled_mutation == "
+            "__dredd_mutations_uninitialized) {\n";
+  result << "    __dredd_registry_initialize();\n";
+  result << "    single_enabled_mutation = "
+            "__dredd_registry_get_single_enabled_mutation();\n";
+  result << "  }\n";
+  result << "  if (single_enabled_mutation != "
+            "__dredd_several_mutations_enabled) {\n";
+  result << "    int offset = single_enabled_mutation - mutation_id;\n";
+  result << "    return offset >= 0 && offset < num_alternatives ? offset : "
+            "-1;\n";
+  result << "  }\n";
+  // The bitset only extends as far as the largest enabled mutant.
+  result << "  int word = mutation_id / 64;\n";
+  result << "  int bit = mutation_id % 64;\n";
+  result << "  uint64_t alternatives = 0;\n";
+  result << "  if (word < __dredd_registry_num_words) {\n";
+  result << "    alternatives = __dredd_registry_bitset[word] >> bit;\n";
+  result << "    if (bit + num_alternatives > 64 && word + 1 < "
+            "__dredd_registry_num_words) {\n";
+  result << "      alternatives |= __dredd_registry_bitset[word + 1] << "
+            "(64 - bit);\n";
+  result << "    }\n";
+  result << "  }\n";
+  result << "  if (num_alternatives < 64) {\n";
+  result << "    alternatives &= ((uint64_t) 1 << num_alternatives) - 1;\n";
+  result << "  }\n";
+  result << "  if (alternatives == 0) {\n";
+  result << "    return -1;\n";
+  result << "  }\n";
+  result << kDreddCountTrailingZeros;
+  result << "}\n\n";
+  result << "static inline bool __dredd_enabled_mutation(int "
+            "local_mutation_id) {\n";
+  result << "  int single_enabled_mutation = "
+            "__dredd_registry_get_single_enabled_mutation();\n";
+  result << "  if (__dredd_expect(single_enabled_mutation >= "
+            "__dredd_no_mutation_enabled, 1)) {\n";
+  result << "    return single_enabled_mutation == "
+            "__dredd_first_mutation_id + local_mutation_id;\n";
+  result << "  }\n";
+  result
+      << "  return __dredd_enabled_alternative(local_mutation_id, 1) == 0;\n";
+  result << "}\n\n";
+  return result.str();
+}
+
+}  // namespace
+
+std::string GetRegularDreddPreludeCpp(int initial_mutation_id,
+                                      int num_mutations) {
+  // Whether mutants are enabled or not will be tracked using a bitset,
+  // represented as an array of 64-bit integers. First, work out how large this
+  // array will need to be, as ceiling(num_mutations / 64).
+  const int kWordSize = 64;
+  const int num_64_bit_words_required =
+      (num_mutations + kWordSize - 1) / kWordSize;
+
+  std::stringstream result;
+  result << kDreddPreludeHeadersCpp;
+  result << "\n";
+  result << kDreddExpect;
+  // The state describing which mutants are enabled is shared by all threads:
+  // the environment variable is only processed once per process, after which
+  // the state is only read.
+  result << kDreddSingleEnabledMutationStates;
+  result << kDreddSingleEnabledMutationCpp;
+  result << kDreddSomeMutationEnabled;
+  // Array of booleans, one per mutation in this file, determining whether they
+  // are enabled.
+  result << "static uint64_t __dredd_enabled_bitset["
+         << num_64_bit_words_required << "];\n";
+  result << "static void __dredd_parse_enabled_mutations() {\n";
+  // Record locally how many mutations are enabled, and which one was enabled
+  // last.
+  result << "  int num_enabled_mutations = 0;\n";
+  result << "  int single_enabled_mutation = __dredd_no_mutation_enabled;\n";
+  result << "  const char* dredd_environment_variable = "
+            "std::getenv(\"DREDD_ENABLED_MUTATION\");\n";
+  result << "  if (dredd_environment_variable != nullptr) {\n";
+  // The environment variable for mutations is set, so process the contents of
+  // this environment variable as a comma-seprated list of strings.
+  result << "    const std::string contents(dredd_environment_variable);\n";
+  result << "    size_t start = 0;\n";
+  result << "    while (true) {\n";
+  // Find the position of the next comma.
+  result << "      size_t pos = contents.find(',', start);\n";
+  // The next token is either the rest of the string (if there is no comma) or
+  // the part of the string up to the next comma (if there is a comma).
+  result << "      std::string token = contents.substr(start, pos == "
+            "std::string::npos ? std::string::npos : pos - start);\n";
+  // Ignore an empty token: this allows for a trailing comma at the end of the
+  // string.
+  result << "      if (!token.empty()) {\n";
+  // Parse the token as an integer. This will throw an exception if parsing
+  // fails, which is OK: it is expected that the user has set the environment
+  // variable to a legitimate value.
+  result << "        int value = std::stoi(token);\n";
+  result << "        int local_value = value - " << initial_mutation_id
+         << ";\n";
+  // Check whether the mutant id actually corresponds to a mutant in this file;
+  // skip it if it does not.
+  result << "        if (local_value >= 0 && local_value < " << num_mutations
+         << ") {\n";
+  // `local_value / 64` gives the element in the bitset array corresponding to
+  // this mutant. Then `local_value % 64` determines which bit of that element
+  // needs to be set in order to enable the mutant, and a bitwise operation is
+  // used to set the correct bit. A mutant that is listed more than once is
+  // only counted once.
+  result << "          uint64_t mask = static_cast<uint64_t>(1) << "
+            "(local_value % 64);\n";
+  result << "          if ((__dredd_enabled_bitset[local_value / 64] & mask) "
+            "== 0) {\n";
+  result << "            __dredd_enabled_bitset[local_value / 64] |= mask;\n";
+  result << "            single_enabled_mutation = local_value;\n";
+  result << "            num_enabled_mutations++;\n";
+  result << "          }\n";
+  result << "        }\n";
+  result << "      }\n";
+  // If the end of the string has been reached, exit the parsing loop.
+  result << "      if (pos == std::string::npos) {\n";
+  result << "        break;\n";
+  result << "      }\n";
+  // Move past the comma so that the rest of the string can be processed.
+  result << "      start = pos + 1;\n";
+  result << "    }\n";
+  result << "  }\n";
+  // Initialisation is now complete, and which mutations are enabled is known.
+  result << kDreddRecordEnabledMutations;
+  result << "}\n\n";
+  // The environment variable is processed exactly once, even if several
+  // threads query enabledness before the enabled mutants have been worked out,
+  // as the initialisation of a function-local static variable is thread-safe.
+  result << "static void __dredd_initialize_enabled_mutations() {\n";
+  result << "  static const bool initialized = "
+            "(__dredd_parse_enabled_mutations(), true);\n";
+  result << "  (void) initialized;\n";
+  result << "}\n\n";
+  result << kDreddInitializeEnabledMutationsAtLoad;
+  // Yields the offset, from |local_mutation_id|, of the first enabled mutant
+  // among the |num_alternatives| mutants starting at |local_mutation_id|, or
+  // -1 if none of them is enabled. This allows a mutator function to look up
+  // which of its mutants is enabled once, and then to dispatch on the result.
+  result << "static int __dredd_enabled_alternative(int local_mutation_id, "
+            "int num_alternatives) {\n";
+  result << kDreddEnabledAlternativeFastPath;
+  // Similar to the above, a combination of division, modulo and bit-shifting
+  // is used to gather the bits of the mutants in question from the bitset. As
+  // there are at most 64 such mutants, they span at most two elements.
+  result << "  const int word = local_mutation_id / 64;\n";
+  result << "  const int bit = local_mutation_id % 64;\n";
+  result << "  uint64_t alternatives = __dredd_enabled_bitset[word] >> bit;\n";
+  result << "  if (bit + num_alternatives > 64) {\n";
+  result << "    alternatives |= __dredd_enabled_bitset[word + 1] << "
+            "(64 - bit);\n";
+  result << "  }\n";
+  result << "  if (num_alternatives < 64) {\n";
+  result << "    alternatives &= (static_cast<uint64_t>(1) << "
+            "num_alternatives) - 1;\n";
+  result << "  }\n";
+  result << "  if (alternatives == 0) {\n";
+  result << "    return -1;\n";
+  result << "  }\n";
+  result << kDreddCountTrailingZeros;
+  result << "}\n\n";
+  result << kDreddEnabledMutation;
+  return result.str();
+}
+
+std::string GetMutantTrackingDreddPreludeCpp(int initial_mutation_id,
+                                             int num_mutations) {
+  std::stringstream result;
+  result << kDreddPreludeHeadersCpp;
+  result << "\n";
+  result << "static void __dredd_record_covered_mutants(int local_mutation_id, "
+            "int num_mutations) {\n";
+  result << "  static std::atomic<bool> already_recorded[" << num_mutations
+         << "];\n";
+  result
+      << "  if (already_recorded[local_mutation_id].exchange(true)) return;\n";
+  result << "  const char* dredd_tracking_environment_variable = "
+            "std::getenv(\"DREDD_MUTANT_TRACKING_FILE\");\n";
+  result << "  if (dredd_tracking_environment_variable == nullptr) return;\n";
+  result << "  std::ofstream output_file;\n";
+  result << "  output_file.open(dredd_tracking_environment_variable, "
+            "std::ios_base::app);\n";
+  result << "  for (int i = 0; i < num_mutations; i++) {\n";
+  result << "    output_file << (" << std::to_string(initial_mutation_id)
+         << " + local_mutation_id + i) << \"\\n\";\n";
+  result << "  }\n";
+  result << "}\n\n";
+  return result.str();
+}
+
+std::string GetGlobalMutantRegistryDreddPreludeCpp(int initial_mutation_id) {
+  std::stringstream result;
+  result << kDreddPreludeHeadersCpp;
+  // The registry is written in C, so that it can be shared with C files.
+  result << "#include <limits.h>\n";
+  result << "#include <stdio.h>\n";
+  result << "#include <stdlib.h>\n";
+  result << "#include <string.h>\n";
+  result << "\n";
+  result << GetGlobalMutantRegistryDreddPrelude(initial_mutation_id);
+  return result.str();
+}
+
+std::string GetSharedRuntimeDreddPrelude(const Options& options,
+                                        int initial_mutation_id) {
+  // The mutator functions are defined in the shared runtime, and are passed
+  // global mutation ids. Mutations that are applied directly in the source
+  // file, such as statement removal, use file-local ids, so thin wrappers that
+  // turn these into global ids are provided. An enumerator is used to record
+  // the global id of the first mutation in the file, as unlike a variable it
+  // cannot lead to unused variable warnings.
+  std::stringstream result;
+  result << "#include \"" << kDreddSharedRuntimeHeaderName << "\"\n";
+  result << "\n";
+  result << "enum { __dredd_first_mutation_id = " << initial_mutation_id
+         << " };\n";
+  if (options.GetOnlyTrackMutantCoverage()) {
+    result << "static inline void __dredd_record_covered_mutants(int "
+              "local_mutation_id, int num_mutations) {\n";
+    result << "  __dredd_runtime_record_covered_mutants("
+              "__dredd_first_mutation_id + local_mutation_id, "
+              "num_mutations);\n";
+  } else {
+    result << "static inline bool __dredd_enabled_mutation(int "
+              "local_mutation_id) {\n";
+    result << "  return __dredd_runtime_enabled_mutation("
+              "__dredd_first_mutation_id + local_mutation_id);\n";
+  }
+  result << "}\n\n";
+  return result.str();
+}
+
+std::string GetDreddPreludeCpp(const Options& options, int initial_mutation_id,
+                               int num_mutations) {
+  if (options.GetUseSharedRuntime()) {
+    return kDreddPreludeStartComment +
+           GetSharedRuntimeDreddPrelude(options, initial_mutation_id);
+  }
+  if (options.GetOnlyTrackMutantCoverage()) {
+    return kDreddPreludeStartComment +
+           GetMutantTrackingDreddPreludeCpp(initial_mutation_id, num_mutations);
+  }
+  return kDreddPreludeStartComment +
+         (options.GetUseGlobalMutantRegistry()
+              ? GetGlobalMutantRegistryDreddPreludeCpp(initial_mutation_id)
+              : GetRegularDreddPreludeCpp(initial_mutation_id, num_mutations));
+}
+
+std::string GetRegularDreddPreludeC(int initial_mutation_id,
+                                    int num_mutations) {
+  // See comments in GetRegularDreddPreludeCpp - this C version is a
+  // straightforward port.
+  const int kWordSize = 64;
+  const int num_64_bit_words_required =
+      (num_mutations + kWordSize - 1) / kWordSize;
+
+  std::stringstream result;
+  result << kDreddPreludeHeadersC;
+  result << "\n";
+  result << kDreddExpect;
+  result << kDreddSingleEnabledMutationStates;
+  result << kDreddSingleEnabledMutationC;
+  result << kDreddSomeMutationEnabled;
+  result << "static uint64_t __dredd_enabled_bitset["
+         << num_64_bit_words_required << "];\n";
+  result << "static void __dredd_parse_enabled_mutations(void) {\n";
+  result << "  int num_enabled_mutations = 0;\n";
+  result << "  int single_enabled_mutation = __dredd_no_mutation_enabled;\n";
+  result << "  const char* dredd_environment_variable = "
+            "getenv(\"DREDD_ENABLED_MUTATION\");\n";
+  result << "  if (dredd_environment_variable) {\n";
+  // The comma-separated list is walked in place, rather than being copied and
+  // split with strtok, which is not reentrant. Empty tokens are skipped.
+  result << "    const char* token = dredd_environment_variable;\n";
+  result << "    while (*token) {\n";
+  result << "      if (*token != ',') {\n";
+  result << "        int value = atoi(token);\n";
+  result << "        int local_value = value - " << initial_mutation_id
+         << ";\n";
+  result << "        if (local_value >= 0 && local_value < " << num_mutations
+         << ") {\n";
+  result << "          uint64_t mask = (uint64_t) 1 << (local_value % 64);\n";
+  result << "          if (!(__dredd_enabled_bitset[local_value / 64] & "
+            "mask)) {\n";
+  result << "            __dredd_enabled_bitset[local_value / 64] |= mask;\n";
+  result << "            single_enabled_mutation = local_value;\n";
+  result << "            num_enabled_mutations++;\n";
+  result << "          }\n";
+  result << "        }\n";
+  result << "      }\n";
+  result << "      token = strchr(token, ',');\n";
+  result << "      if (!token) {\n";
+  result << "        break;\n";
+  result << "      }\n";
+  result << "      token++;\n";
+  result << "    }\n";
+  result << "  }\n";
+  result << kDreddRecordEnabledMutations;
+  result << "}\n\n";
+  // C has no thread-safe initialisation of static variables, so an atomic
+  // records whether the environment variable has not yet been processed (0),
+  // is being processed (1) or has been processed (2). Threads that query
+  // enabledness while another thread processes the environment variable wait
+  // for it to finish.
+  result << "static atomic_int __dredd_initialization_state;\n";
+  result << "static void __dredd_initialize_enabled_mutations(void) {\n";
+  result << "  int expected = 0;\n";
+  result << "  if (atomic_compare_exchange_strong("
+            "&__dredd_initialization_state, &expected, 1)) {\n";
+  result << "    __dredd_parse_enabled_mutations();\n";
+  result << "    atomic_store(&__dredd_initialization_state, 2);\n";
+  result << "  }\n";
+  result << "  while (atomic_load(&__dredd_initialization_state) != 2) {\n";
+  result << "  }\n";
+  result << "}\n\n";
+  result << kDreddInitializeEnabledMutationsAtLoad;
+  result << "static int __dredd_enabled_alternative(int local_mutation_id, "
+            "int num_alternatives) {\n";
+  result << kDreddEnabledAlternativeFastPath;
+  result << "  int word = local_mutation_id / 64;\n";
+  result << "  int bit = local_mutation_id % 64;\n";
+  result << "  uint64_t alternatives = __dredd_enabled_bitset[word] >> bit;\n";
+  result << "  if (bit + num_alternatives > 64) {\n";
+  result << "    alternatives |= __dredd_enabled_bitset[word + 1] << "
+            "(64 - bit);\n";
+  result << "  }\n";
+  result << "  if (num_alternatives < 64) {\n";
+  result << "    alternatives &= ((uint64_t) 1 << num_alternatives) - 1;\n";
+  result << "  }\n";
+  result << "  if (alternatives == 0) {\n";
+  result << "    return -1;\n";
+  result << "  }\n";
+  result << kDreddCountTrailingZeros;
+  result << "}\n\n";
+  result << kDreddEnabledMutation;
+  return result.str();
+}
+
+std::string GetMutantTrackingDreddPreludeC(int initial_mutation_id,
+                                           int num_mutations) {
+  // See comments in GetMutantTrackingDreddPreludeCpp; this is a straightforward
+  // port to C.
+  std::stringstream result;
+  result << kDreddPreludeHeadersC;
+  result << "\n";
+  result << "static void __dredd_record_covered_mutants(int local_mutation_id, "
+            "int num_mutations) {\n";
+  result << "  static atomic_bool already_recorded[" << num_mutations << "];\n";
+  result << "  if (atomic_exchange(&already_recorded[local_mutation_id], 1)) "
+            "return;\n";
+  result << "  const char* dredd_tracking_environment_variable = "
+            "getenv(\"DREDD_MUTANT_TRACKING_FILE\");\n";
+  result << "  if (!dredd_tracking_environment_variable) return;\n";
+  result << "  FILE* fp = fopen(dredd_tracking_environment_variable, \"a\");\n";
+  result << "  for (int i = 0; i < num_mutations; i++) {\n";
+  result << R"(    fprintf(fp, "%d\n", )" + std::to_string(initial_mutation_id)
+         << " + local_mutation_id + i);\n";
+  result << "  }\n";
+  result << "  fclose(fp);\n";
+  result << "}\n\n";
+  return result.str();
+}
+
+std::string GetGlobalMutantRegistryDreddPreludeC(int initial_mutation_id) {
+  std::stringstream result;
+  result << kDreddPreludeHeadersC;
+  result << "#include <limits.h>\n";
+  result << "\n";
+  result << GetGlobalMutantRegistryDreddPrelude(initial_mutation_id);
+  return result.str();
+}
+
+std::string GetDreddPreludeC(const Options& options, int initial_mutation_id,
+                             int num_mutations) {
+  if (options.GetUseSharedRuntime()) {
+    return kDreddPreludeStartComment +
+           GetSharedRuntimeDreddPrelude(options, initial_mutation_id);
+  }
+  if (options.GetOnlyTrackMutantCoverage()) {
+    return kDreddPreludeStartComment +
+           GetMutantTrackingDreddPreludeC(initial_mutation_id, num_mutations);
+  }
+  return kDreddPreludeStartComment +
+         (options.GetUseGlobalMutantRegistry()
+              ? GetGlobalMutantRegistryDreddPreludeC(initial_mutation_id)
+              : GetRegularDreddPreludeC(initial_mutation_id, num_mutations));
+}
+
+}  // namespace dredd
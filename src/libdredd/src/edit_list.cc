@@ -0,0 +1,201 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/edit_list.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Lexer.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace dredd {
+
+EditList::EditList(const clang::SourceManager& source_manager,
+                   const clang::LangOptions& lang_options)
+    : source_manager_(&source_manager),
+      lang_options_(&lang_options),
+      main_file_id_(source_manager.getMainFileID()),
+      original_text_(source_manager.getBufferData(main_file_id_)) {}
+
+bool EditList::InsertTextBefore(clang::SourceLocation location,
+                                llvm::StringRef text) {
+  unsigned int offset = 0;
+  if (!IsRewritable(location, offset)) {
+    return true;
+  }
+  InsertBefore(offset, text);
+  return false;
+}
+
+bool EditList::InsertTextAfterToken(clang::SourceLocation location,
+                                    llvm::StringRef text) {
+  unsigned int offset = 0;
+  if (!IsRewritable(location, offset)) {
+    return true;
+  }
+  InsertAfter(offset + clang::Lexer::MeasureTokenLength(
+                           location, *source_manager_, *lang_options_),
+              text);
+  return false;
+}
+
+bool EditList::ReplaceText(clang::SourceLocation start, unsigned int length,
+                           llvm::StringRef text) {
+  unsigned int offset = 0;
+  if (!IsRewritable(start, offset)) {
+    return true;
+  }
+  Replace(offset, length, text);
+  return false;
+}
+
+bool EditList::ReplaceText(clang::SourceRange range, llvm::StringRef text) {
+  unsigned int begin_offset = 0;
+  unsigned int end_offset = 0;
+  if (!IsRewritable(range.getBegin(), begin_offset) ||
+      !IsRewritable(range.getEnd(), end_offset)) {
+    return true;
+  }
+  end_offset += clang::Lexer::MeasureTokenLength(
+      range.getEnd(), *source_manager_, *lang_options_);
+  if (end_offset < begin_offset) {
+    return true;
+  }
+  Replace(begin_offset, end_offset - begin_offset, text);
+  return false;
+}
+
+void EditList::InsertBefore(unsigned int offset, llvm::StringRef text) {
+  edits_.push_back(
+      {offset, Kind::kInsertBefore, 0, edits_.size(), text.str()});
+}
+
+void EditList::InsertAfter(unsigned int offset, llvm::StringRef text) {
+  edits_.push_back({offset, Kind::kInsertAfter, 0, edits_.size(), text.str()});
+}
+
+void EditList::Replace(unsigned int offset, unsigned int length,
+                       llvm::StringRef text) {
+  edits_.push_back({offset, Kind::kReplace, length, edits_.size(), text.str()});
+}
+
+unsigned int EditList::GetOffset(clang::SourceLocation location) const {
+  return source_manager_->getFileOffset(location);
+}
+
+std::string EditList::GetRewrittenText() const {
+  size_t unused_split_position = 0;
+  return Materialise(static_cast<unsigned int>(original_text_.size()),
+                     unused_split_position);
+}
+
+std::pair<std::string, std::string> EditList::GetRewrittenTextSplitAt(
+    unsigned int offset) const {
+  size_t split_position = 0;
+  std::string text = Materialise(offset, split_position);
+  std::string text_after = text.substr(split_position);
+  text.resize(split_position);
+  return {std::move(text), std::move(text_after)};
+}
+
+bool EditList::IsRewritable(clang::SourceLocation location,
+                            unsigned int& offset) const {
+  if (location.isInvalid() || !location.isFileID()) {
+    return false;
+  }
+  const auto [file_id, file_offset] =
+      source_manager_->getDecomposedLoc(location);
+  if (file_id != main_file_id_) {
+    return false;
+  }
+  offset = file_offset;
+  return true;
+}
+
+std::string EditList::Materialise(unsigned int split_offset,
+                                  size_t& split_position) const {
+  assert(split_offset <= original_text_.size() &&
+         "Split offset is out of bounds.");
+
+  // Sorting pointers to the edits avoids copying their text, and leaves the
+  // edit list intact so that it can be materialised again.
+  std::vector<const Edit*> sorted_edits;
+  sorted_edits.reserve(edits_.size());
+  size_t result_size = original_text_.size();
+  for (const auto& edit : edits_) {
+    sorted_edits.push_back(&edit);
+    result_size += edit.text.size();
+  }
+  // At a given offset, text inserted before the offset comes first, most
+  // recent first; then text inserted after the offset, least recent first;
+  // then the text of any replacement that starts at the offset.
+  std::sort(sorted_edits.begin(), sorted_edits.end(),
+            [](const Edit* first, const Edit* second) -> bool {
+              if (first->offset != second->offset) {
+                return first->offset < second->offset;
+              }
+              if (first->kind != second->kind) {
+                return first->kind < second->kind;
+              }
+              if (first->kind == Kind::kInsertBefore) {
+                return first->sequence_number > second->sequence_number;
+              }
+              return first->sequence_number < second->sequence_number;
+            });
+
+  std::string result;
+  result.reserve(result_size);
+  split_position = std::string::npos;
+  // The offset into the original text up to which the text has been copied
+  // into, or replaced in, the result.
+  size_t position = 0;
+  for (const Edit* edit : sorted_edits) {
+    assert(edit->offset <= original_text_.size() &&
+           edit->length <= original_text_.size() - edit->offset &&
+           "Edit is out of bounds.");
+    assert(edit->offset >= position &&
+           "An edit overlaps a range that has been replaced.");
+    if (split_position == std::string::npos && edit->offset >= split_offset) {
+      assert(position <= split_offset &&
+             "The split offset lies inside a replaced range.");
+      result.append(original_text_.data() + position,
+                    split_offset - position);
+      position = split_offset;
+      split_position = result.size();
+    }
+    result.append(original_text_.data() + position, edit->offset - position);
+    result.append(edit->text);
+    position = edit->offset + edit->length;
+  }
+  if (split_position == std::string::npos) {
+    assert(position <= split_offset &&
+           "The split offset lies inside a replaced range.");
+    result.append(original_text_.data() + position, split_offset - position);
+    position = split_offset;
+    split_position = result.size();
+  }
+  result.append(original_text_.data() + position,
+                original_text_.size() - position);
+  return result;
+}
+
+}  // namespace dredd
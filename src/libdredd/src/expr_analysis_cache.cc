@@ -0,0 +1,93 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/expr_analysis_cache.h"
+
+#include <optional>
+#include <utility>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Expr.h"
+#include "libdredd/util.h"
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/APSInt.h"
+
+namespace dredd {
+
+ExprAnalysisCache::ExprAnalysisCache(const clang::ASTContext& ast_context)
+    : ast_context_(&ast_context) {}
+
+std::optional<llvm::APSInt> ExprAnalysisCache::GetIntValue(
+    const clang::Expr& expr) {
+  auto iterator = int_values_.find(&expr);
+  if (iterator == int_values_.end()) {
+    std::optional<llvm::APSInt> value;
+    clang::Expr::EvalResult eval_result;
+    if (EvaluateAsInt(expr, *ast_context_, eval_result)) {
+      value = eval_result.Val.getInt();
+    }
+    iterator = int_values_.try_emplace(&expr, std::move(value)).first;
+  }
+  return iterator->second;
+}
+
+std::optional<llvm::APFloat> ExprAnalysisCache::GetFloatValue(
+    const clang::Expr& expr) {
+  auto iterator = float_values_.find(&expr);
+  if (iterator == float_values_.end()) {
+    std::optional<llvm::APFloat> value;
+    llvm::APFloat eval_result(static_cast<double>(0));
+    if (EvaluateAsFloat(expr, *ast_context_, eval_result)) {
+      value = eval_result;
+    }
+    iterator = float_values_.try_emplace(&expr, std::move(value)).first;
+  }
+  return iterator->second;
+}
+
+std::optional<bool> ExprAnalysisCache::GetBoolValue(const clang::Expr& expr) {
+  auto iterator = bool_values_.find(&expr);
+  if (iterator == bool_values_.end()) {
+    std::optional<bool> value;
+    bool eval_result = false;
+    if (EvaluateAsBooleanCondition(expr, *ast_context_, eval_result)) {
+      value = eval_result;
+    }
+    iterator = bool_values_.try_emplace(&expr, value).first;
+  }
+  return iterator->second;
+}
+
+bool ExprAnalysisCache::HasSideEffects(const clang::Expr& expr) {
+  auto iterator = has_side_effects_.find(&expr);
+  if (iterator == has_side_effects_.end()) {
+    iterator =
+        has_side_effects_.try_emplace(&expr, expr.HasSideEffects(*ast_context_))
+            .first;
+  }
+  return iterator->second;
+}
+
+bool ExprAnalysisCache::IsCxx11ConstantExpr(const clang::Expr& expr) {
+  auto iterator = is_cxx11_constant_expr_.find(&expr);
+  if (iterator == is_cxx11_constant_expr_.end()) {
+    iterator = is_cxx11_constant_expr_
+                   .try_emplace(&expr,
+                                dredd::IsCxx11ConstantExpr(expr, *ast_context_))
+                   .first;
+  }
+  return iterator->second;
+}
+
+}  // namespace dredd
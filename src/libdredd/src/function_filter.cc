@@ -0,0 +1,83 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/function_filter.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Regex.h"
+
+namespace dredd {
+
+bool FunctionFilter::AddMutatePattern(const std::string& pattern,
+                                      std::string& error_message) {
+  return AddPattern(pattern, mutate_patterns_, mutate_regexes_, error_message);
+}
+
+bool FunctionFilter::AddSkipPattern(const std::string& pattern,
+                                    std::string& error_message) {
+  return AddPattern(pattern, skip_patterns_, skip_regexes_, error_message);
+}
+
+bool FunctionFilter::ShouldMutate(llvm::StringRef qualified_name) const {
+  if (MatchesAny(skip_regexes_, qualified_name)) {
+    return false;
+  }
+  return mutate_regexes_.empty() || MatchesAny(mutate_regexes_, qualified_name);
+}
+
+std::string FunctionFilter::ToString() const {
+  // Patterns cannot contain newlines, so can be separated by them.
+  std::string result;
+  for (const auto& pattern : mutate_patterns_) {
+    result += "+" + pattern + "\n";
+  }
+  for (const auto& pattern : skip_patterns_) {
+    result += "-" + pattern + "\n";
+  }
+  return result;
+}
+
+bool FunctionFilter::AddPattern(const std::string& pattern,
+                                std::vector<std::string>& patterns,
+                                std::vector<llvm::Regex>& regexes,
+                                std::string& error_message) {
+  if (pattern.find('\n') != std::string::npos) {
+    error_message = "patterns cannot contain newlines";
+    return false;
+  }
+  // Anchoring the pattern means that it must match the whole of a name.
+  llvm::Regex regex("^(" + pattern + ")$");
+  if (!regex.isValid(error_message)) {
+    return false;
+  }
+  patterns.push_back(pattern);
+  regexes.push_back(std::move(regex));
+  return true;
+}
+
+bool FunctionFilter::MatchesAny(const std::vector<llvm::Regex>& regexes,
+                                llvm::StringRef qualified_name) {
+  for (const auto& regex : regexes) {
+    if (regex.match(qualified_name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace dredd
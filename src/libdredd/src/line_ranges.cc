@@ -0,0 +1,256 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/line_ranges.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <tuple>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+namespace dredd {
+
+namespace {
+
+// Parses a line number, which must be positive.
+bool ParseLineNumber(llvm::StringRef text, unsigned int& line) {
+  return !text.getAsInteger(10, line) && line > 0;
+}
+
+// Parses the range "start[,count]" of one side of a hunk header; the count
+// defaults to 1.
+bool ParseHunkRange(llvm::StringRef text, unsigned int& start,
+                    unsigned int& count) {
+  const auto [start_text, count_text] = text.split(',');
+  if (start_text.getAsInteger(10, start)) {
+    return false;
+  }
+  count = 1;
+  return count_text.empty() || !count_text.getAsInteger(10, count);
+}
+
+}  // namespace
+
+void LineRanges::Add(unsigned int first_line, unsigned int last_line) {
+  assert(first_line > 0 && first_line <= last_line && "Invalid line range.");
+  // Absorb any existing ranges that overlap with, or are adjacent to, the new
+  // range, so that ranges remain disjoint and non-adjacent.
+  auto iterator = ranges_.upper_bound(first_line);
+  if (iterator != ranges_.begin()) {
+    auto previous = std::prev(iterator);
+    if (previous->second >= first_line - 1) {
+      first_line = previous->first;
+      last_line = std::max(last_line, previous->second);
+      iterator = ranges_.erase(previous);
+    }
+  }
+  while (iterator != ranges_.end() && iterator->first - 1 <= last_line) {
+    last_line = std::max(last_line, iterator->second);
+    iterator = ranges_.erase(iterator);
+  }
+  ranges_.emplace(first_line, last_line);
+}
+
+bool LineRanges::Overlaps(unsigned int first_line,
+                          unsigned int last_line) const {
+  // Only the last range starting no later than |last_line| can overlap.
+  auto iterator = ranges_.upper_bound(last_line);
+  return iterator != ranges_.begin() &&
+         std::prev(iterator)->second >= first_line;
+}
+
+std::string LineRanges::ToString() const {
+  std::string result;
+  for (const auto& [first_line, last_line] : ranges_) {
+    if (!result.empty()) {
+      result += ",";
+    }
+    result += std::to_string(first_line);
+    if (last_line != first_line) {
+      result += "-" + std::to_string(last_line);
+    }
+  }
+  return result;
+}
+
+void LineRangeFilter::Add(const std::string& filename,
+                          unsigned int first_line, unsigned int last_line) {
+  line_ranges_[NormalisePath(filename)].Add(first_line, last_line);
+}
+
+LineRanges LineRangeFilter::GetLineRangesForFile(
+    const std::string& filename) const {
+  auto iterator = line_ranges_.find(NormalisePath(filename));
+  return iterator == line_ranges_.end() ? LineRanges() : iterator->second;
+}
+
+std::string LineRangeFilter::ToString() const {
+  std::string result;
+  for (const auto& [filename, line_ranges] : line_ranges_) {
+    result += filename + ":" + line_ranges.ToString() + ";";
+  }
+  return result;
+}
+
+std::string LineRangeFilter::NormalisePath(llvm::StringRef filename) {
+  llvm::SmallString<256> real_path;
+  if (!llvm::sys::fs::real_path(filename, real_path)) {
+    return real_path.str().str();
+  }
+  // The file does not exist, so cannot be mutated, but it is still given a
+  // canonical name.
+  llvm::SmallString<256> absolute_path(filename);
+  llvm::sys::fs::make_absolute(absolute_path);
+  llvm::sys::path::remove_dots(absolute_path, /*remove_dot_dot=*/true);
+  return absolute_path.str().str();
+}
+
+bool ParseLineRangesSpecification(llvm::StringRef specification,
+                                  LineRangeFilter& filter,
+                                  std::string& error_message) {
+  const auto [filename, ranges] = specification.rsplit(':');
+  if (filename.empty() || ranges.empty() || filename == specification) {
+    error_message = "expected file:ranges, e.g. foo.cc:3,10-20";
+    return false;
+  }
+  llvm::StringRef remaining_ranges = ranges;
+  while (!remaining_ranges.empty()) {
+    llvm::StringRef range;
+    std::tie(range, remaining_ranges) = remaining_ranges.split(',');
+    const auto [first_text, last_text] = range.split('-');
+    unsigned int first_line = 0;
+    unsigned int last_line = 0;
+    if (!ParseLineNumber(first_text, first_line) ||
+        !ParseLineNumber(last_text.empty() ? first_text : last_text,
+                         last_line) ||
+        first_line > last_line) {
+      error_message = "invalid line range '" + range.str() + "'";
+      return false;
+    }
+    filter.Add(filename.str(), first_line, last_line);
+  }
+  return true;
+}
+
+bool ParseUnifiedDiff(llvm::StringRef diff, LineRangeFilter& filter,
+                      std::string& error_message) {
+  // The new version of the file that the current hunks apply to; unset if the
+  // file is deleted.
+  std::optional<std::string> filename;
+  bool seen_file_header = false;
+  // The lines of the current hunk that remain to be read.
+  unsigned int old_lines_remaining = 0;
+  unsigned int new_lines_remaining = 0;
+  // The line of the new version of the file that the next line of the current
+  // hunk corresponds to.
+  unsigned int new_line = 0;
+  // True if lines have been removed without any lines being added in their
+  // place since the last unchanged line.
+  bool only_removed = false;
+
+  // Considers the lines either side of a removal changed.
+  auto record_removal = [&filename, &filter, &new_line, &only_removed]() {
+    if (only_removed && filename.has_value()) {
+      filter.Add(*filename, std::max(new_line - 1, 1U), new_line);
+    }
+    only_removed = false;
+  };
+
+  llvm::StringRef remaining_diff = diff;
+  unsigned int diff_line_number = 0;
+  while (!remaining_diff.empty()) {
+    llvm::StringRef line;
+    std::tie(line, remaining_diff) = remaining_diff.split('\n');
+    line.consume_back("\r");
+    diff_line_number++;
+
+    if (old_lines_remaining > 0 || new_lines_remaining > 0) {
+      // A line of a hunk. Some tools drop the space that prefixes an empty
+      // unchanged line.
+      if (line.starts_with("\\")) {
+        // "\ No newline at end of file".
+        continue;
+      }
+      if (line.starts_with("+") && new_lines_remaining > 0) {
+        if (filename.has_value()) {
+          filter.Add(*filename, new_line, new_line);
+        }
+        only_removed = false;
+        new_line++;
+        new_lines_remaining--;
+      } else if (line.starts_with("-") && old_lines_remaining > 0) {
+        only_removed = true;
+        old_lines_remaining--;
+      } else if ((line.empty() || line.starts_with(" ")) &&
+                 old_lines_remaining > 0 && new_lines_remaining > 0) {
+        record_removal();
+        new_line++;
+        old_lines_remaining--;
+        new_lines_remaining--;
+      } else {
+        error_message = "unexpected line " + std::to_string(diff_line_number) +
+                        " in hunk";
+        return false;
+      }
+      if (old_lines_remaining == 0 && new_lines_remaining == 0) {
+        record_removal();
+      }
+      continue;
+    }
+
+    if (line.starts_with("+++ ")) {
+      llvm::StringRef path = line.drop_front(4).split('\t').first.rtrim();
+      seen_file_header = true;
+      if (path == "/dev/null") {
+        filename.reset();
+      } else {
+        path.consume_front("b/");
+        filename = path.str();
+      }
+    } else if (line.starts_with("@@ ")) {
+      const auto [old_range, new_range] =
+          line.drop_front(3).split(" @@").first.split(' ');
+      unsigned int old_start = 0;
+      unsigned int new_start = 0;
+      if (!seen_file_header || !old_range.starts_with("-") ||
+          !new_range.starts_with("+") ||
+          !ParseHunkRange(old_range.drop_front(1), old_start,
+                          old_lines_remaining) ||
+          !ParseHunkRange(new_range.drop_front(1), new_start,
+                          new_lines_remaining)) {
+        error_message = "invalid hunk header at line " +
+                        std::to_string(diff_line_number);
+        return false;
+      }
+      // A hunk that adds no lines records the line after which lines were
+      // removed, rather than the first line of the hunk.
+      new_line = new_lines_remaining == 0 ? new_start + 1 : new_start;
+    }
+    // Other lines, such as "diff --git" and "index" lines, are ignored.
+  }
+  if (old_lines_remaining > 0 || new_lines_remaining > 0) {
+    error_message = "the diff ends part way through a hunk";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace dredd
@@ -14,12 +14,17 @@
 
 #include "libdredd/mutate_ast_consumer.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <memory>
 #include <optional>
-#include <set>
 #include <sstream>
 #include <string>
+#include <tuple>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "clang/AST/ASTContext.h"
@@ -30,47 +35,67 @@
 #include "clang/AST/TypeLoc.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileEntry.h"
+#include "clang/Basic/FileManager.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/CompilerInstance.h"
-#include "clang/Rewrite/Core/Rewriter.h"
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/dredd_prelude.h"
+#include "libdredd/edit_list.h"
 #include "libdredd/mutation.h"
-#include "libdredd/util.h"
+#include "libdredd/mutation_counts.h"
+#include "libdredd/mutation_info_writer.h"
+#include "libdredd/mutation_sampler.h"
+#include "libdredd/mutation_selection.h"
+#include "libdredd/offset_mutation_ids.h"
+#include "libdredd/run_statistics.h"
+#include "libdredd/source_range_cache.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/Error.h"
 #include "llvm/Support/raw_ostream.h"
 
 namespace dredd {
 
 namespace {
-const char* const kDreddPreludeStartComment =
-    "// DREDD PRELUDE START\n"
-    "// If this has been inserted at an inappropriate place in a source file,\n"
-    "// declare a placeholder function with the following signature to\n"
-    "// mandate where the prelude should be placed:\n"
-    "//\n"
-    "// void __dredd_prelude_start();\n"
-    "//\n";
-
-const char* const kDreddPreludeHeadersCpp =
-    "#include <atomic>\n"
-    "#include <cinttypes>\n"
-    "#include <cstddef>\n"
-    "#include <fstream>\n"
-    "#include <functional>\n"
-    "#include <sstream>\n"
-    "#include <string>\n\n";
-
-const char* const kDreddPreludeHeadersC =
-    "#include <inttypes.h>\n"
-    "#include <stdatomic.h>\n"
-    "#include <stdbool.h>\n"
-    "#include <stdio.h>\n"
-    "#include <stdlib.h>\n"
-    "#include <string.h>\n";
+
+// Converts the unordered set of Dredd declarations into a sorted sequence, so
+// that the declarations are emitted in a deterministic order.
+std::vector<std::string> SortDreddDeclarations(
+    const std::unordered_set<std::string>& dredd_declarations) {
+  std::vector<std::string> result(dredd_declarations.begin(),
+                                  dredd_declarations.end());
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+// Adds the Dredd declarations at the given location, in sorted order.
+void InsertDreddDeclarations(
+    const std::unordered_set<std::string>& dredd_declarations,
+    clang::SourceLocation location, EditList& edit_list) {
+  for (const auto& decl : SortDreddDeclarations(dredd_declarations)) {
+    const bool edit_result = edit_list.InsertTextBefore(location, decl);
+    (void)edit_result;  // Keep release-mode compilers happy.
+    assert(!edit_result && "Rewrite failed.\n");
+  }
+}
+
+// Appends the mutations in the tree rooted at |mutation_tree_node| to
+// |mutations|, in the order in which they are applied.
+void CollectMutations(const MutationTreeNode& mutation_tree_node,
+                      std::vector<const Mutation*>& mutations) {
+  for (const auto* child : mutation_tree_node.GetChildren()) {
+    CollectMutations(*child, mutations);
+  }
+  for (const auto* mutation : mutation_tree_node.GetMutations()) {
+    mutations.push_back(mutation);
+  }
+}
+
 }  // namespace
 
 void MutateAstConsumer::HandleTranslationUnit(clang::ASTContext& ast_context) {
@@ -80,6 +105,11 @@ void MutateAstConsumer::HandleTranslationUnit(clang::ASTContext& ast_context) {
           ->getName()
           .str();
 
+  if (run_statistics_ != nullptr) {
+    run_statistics_->AddTime(RunStatistics::Phase::kParse, filename,
+                             creation_time_, std::chrono::steady_clock::now());
+  }
+
   llvm::errs() << "Processing " << filename << "\n";
 
   if (ast_context.getDiagnostics().hasErrorOccurred()) {
@@ -92,10 +122,54 @@ void MutateAstConsumer::HandleTranslationUnit(clang::ASTContext& ast_context) {
     ast_context.getTranslationUnitDecl()->dump();
     llvm::errs() << "\n";
   }
-  visitor_->TraverseDecl(ast_context.getTranslationUnitDecl());
+  {
+    const ScopedPhaseTimer timer(run_statistics_,
+                                 RunStatistics::Phase::kTraverse, filename);
+    visitor_->TraverseDecl(ast_context.getTranslationUnitDecl());
+  }
+  {
+    const ScopedPhaseTimer timer(run_statistics_,
+                                 RunStatistics::Phase::kTidyUp, filename);
+    visitor_->TidyUpMutations();
+  }
 
-  rewriter_.setSourceMgr(compiler_instance_->getSourceManager(),
-                         compiler_instance_->getLangOpts());
+  if (options_->GetMutationSampler() != nullptr) {
+    const ScopedPhaseTimer timer(run_statistics_,
+                                 RunStatistics::Phase::kTidyUp, filename);
+    SampleMutations(filename, ast_context);
+  }
+
+  if (mutation_counts_ != nullptr) {
+    const ScopedPhaseTimer timer(
+        run_statistics_, RunStatistics::Phase::kApplyMutations, filename);
+    // Counting starts from zero, as the mutants are not applied.
+    int mutation_id = 0;
+    MutationCounter mutation_counter;
+    CountMutations(visitor_->GetMutations(), ast_context, mutation_id,
+                   mutation_counter);
+    mutation_counts_->push_back(mutation_counter.GetCountsForFile(filename));
+    return;
+  }
+
+  edit_list_ =
+      std::make_unique<EditList>(compiler_instance_->getSourceManager(),
+                                 compiler_instance_->getLangOpts());
+  const bool also_track_mutant_coverage =
+      options_->GetAlsoTrackMutantCoverage();
+  assert((!also_track_mutant_coverage || deferred_files_ != nullptr) &&
+         "A mutant coverage tracking version of a file can only be produced "
+         "when mutated files are deferred.");
+  const bool use_shared_runtime = options_->GetUseSharedRuntime();
+  assert((!use_shared_runtime || deferred_files_ != nullptr) &&
+         "A shared runtime can only be used when mutated files are deferred.");
+  assert(!(use_shared_runtime && also_track_mutant_coverage) &&
+         "A shared runtime cannot be used when a mutant coverage tracking "
+         "version of each file is also produced.");
+  if (also_track_mutant_coverage) {
+    coverage_tracking_edit_list_ =
+        std::make_unique<EditList>(compiler_instance_->getSourceManager(),
+                                   compiler_instance_->getLangOpts());
+  }
 
   // Recording this makes it possible to keep track of how many mutations have
   // been applied to an individual source file, which allows mutations within
@@ -111,29 +185,86 @@ void MutateAstConsumer::HandleTranslationUnit(clang::ASTContext& ast_context) {
   // converted to an ordered set so that declarations can be added to the source
   // file in a deterministic order.
   std::unordered_set<std::string> dredd_declarations;
+  std::unordered_set<std::string> coverage_tracking_dredd_declarations;
 
   protobufs::MutationInfoForFile mutation_info_for_file;
 
   protobufs::MutationTreeNode* root_protobuf_mutation_tree_node =
       mutation_info_for_file.add_mutation_tree();
-  ApplyMutations(visitor_->GetMutations(), initial_mutation_id, ast_context,
-                 mutation_info_for_file, *root_protobuf_mutation_tree_node,
-                 dredd_declarations, mutation_info_->has_value());
+  // The mutation tree is also needed if detailed statistics are being
+  // gathered, as these include counts of the mutants that were applied.
+  const bool build_tree =
+      build_mutation_info_ ||
+      (run_statistics_ != nullptr && run_statistics_->IsRecordingDetails());
+  {
+    const ScopedPhaseTimer timer(
+        run_statistics_, RunStatistics::Phase::kApplyMutations, filename);
+    ApplyMutations(visitor_->GetMutations(), initial_mutation_id, ast_context,
+                   *options_, *edit_list_, *mutation_id_,
+                   mutation_info_for_file, *root_protobuf_mutation_tree_node,
+                   dredd_declarations, build_tree);
+    if (also_track_mutant_coverage) {
+      // The same mutation tree is applied a second time, so that the mutant
+      // coverage tracking version of the file has exactly the same mutation
+      // ids as the mutated version, without the file being traversed again.
+      // The mutation info is identical, so is not recorded again.
+      int coverage_tracking_mutation_id = initial_mutation_id;
+      protobufs::MutationInfoForFile unused_mutation_info_for_file;
+      protobufs::MutationTreeNode* unused_root_protobuf_mutation_tree_node =
+          unused_mutation_info_for_file.add_mutation_tree();
+      ApplyMutations(visitor_->GetMutations(), initial_mutation_id,
+                     ast_context, coverage_tracking_options_,
+                     *coverage_tracking_edit_list_,
+                     coverage_tracking_mutation_id,
+                     unused_mutation_info_for_file,
+                     *unused_root_protobuf_mutation_tree_node,
+                     coverage_tracking_dredd_declarations, false);
+      assert(coverage_tracking_mutation_id == *mutation_id_ &&
+             "Both versions of the file should have the same mutations.");
+    }
+  }
+
+  if (run_statistics_ != nullptr) {
+    run_statistics_->AddFileCounts(filename, visitor_->GetNumDeclsTraversed(),
+                                   visitor_->GetNumStmtsTraversed(),
+                                   mutation_info_for_file);
+  }
 
   if (initial_mutation_id == *mutation_id_) {
     // No possibilities for mutation were found; nothing else to do.
     return;
   }
 
-  RewriteExpressionsInMainFile();
+  if (build_mutation_info_) {
+    mutation_info_for_file.set_filename(filename);
+    const MutationSelection& mutation_selection =
+        options_->GetMutationSelection();
+    if (!mutation_selection.IsEverythingEnabled()) {
+      // Record the restricted set of mutations, so that consumers of the
+      // mutation info know which kinds of mutant are absent by design.
+      *mutation_info_for_file.mutable_mutation_selection() =
+          mutation_selection.ToProtobuf();
+    }
+    if (const auto* mutation_sampler = options_->GetMutationSampler()) {
+      *mutation_info_for_file.mutable_mutation_sampling() =
+          mutation_sampler->ToProtobuf();
+    }
+    if (deferred_files_ == nullptr && mutation_info_writer_ != nullptr) {
+      const ScopedPhaseTimer timer(run_statistics_,
+                                   RunStatistics::Phase::kSerialise, filename);
+      mutation_info_writer_->Write(mutation_info_for_file);
+    }
+  }
+
+  // Covers the remaining edits, up to the point at which the text of the
+  // mutated file is obtained.
+  std::optional<ScopedPhaseTimer> rewrite_timer;
+  rewrite_timer.emplace(run_statistics_, RunStatistics::Phase::kRewrite,
+                        filename);
 
-  if (mutation_info_->has_value()) {
-    mutation_info_for_file.set_filename(
-        ast_context.getSourceManager()
-            .getFileEntryForID(ast_context.getSourceManager().getMainFileID())
-            ->getName()
-            .str());
-    *mutation_info_->value().add_info_for_files() = mutation_info_for_file;
+  RewriteExpressionsInMainFile(*edit_list_);
+  if (also_track_mutant_coverage) {
+    RewriteExpressionsInMainFile(*coverage_tracking_edit_list_);
   }
 
   auto& source_manager = ast_context.getSourceManager();
@@ -147,34 +278,100 @@ void MutateAstConsumer::HandleTranslationUnit(clang::ASTContext& ast_context) {
          "There is at least one mutation, therefore there must be at least one "
          "function.");
 
-  // Convert the unordered set Dredd declarations into an ordered set and add
-  // them to the source file before the first declaration.
-  std::set<std::string> sorted_dredd_declarations;
-  sorted_dredd_declarations.insert(dredd_declarations.begin(),
-                                   dredd_declarations.end());
-  for (const auto& decl : sorted_dredd_declarations) {
-    const bool rewriter_result =
-        rewriter_.InsertTextBefore(dredd_prelude_start_location, decl);
-    (void)rewriter_result;  // Keep release-mode compilers happy.
-    assert(!rewriter_result && "Rewrite failed.\n");
+  // When a shared runtime is used, the declarations are recorded with the
+  // deferred file so that they can be added to the runtime instead.
+  if (!use_shared_runtime) {
+    InsertDreddDeclarations(dredd_declarations, dredd_prelude_start_location,
+                            *edit_list_);
+  }
+  if (also_track_mutant_coverage) {
+    InsertDreddDeclarations(coverage_tracking_dredd_declarations,
+                            dredd_prelude_start_location,
+                            *coverage_tracking_edit_list_);
+  }
+
+  // The mutated file is written to the absolute path of the source file, which
+  // is where clang::Rewriter::overwriteChangedFiles would write it.
+  llvm::SmallString<128> output_path(filename);
+  source_manager.getFileManager().makeAbsolutePath(output_path);
+
+  const int num_mutations = *mutation_id_ - initial_mutation_id;
+
+  if (deferred_files_ != nullptr) {
+    // The prelude is the only part of the mutated file that depends on global
+    // mutation ids. Rather than adding it and overwriting the file, record the
+    // rewritten text either side of the point at which the prelude belongs, so
+    // that the prelude can be added once the global id of the first mutation in
+    // this file is known. The text after the prelude starts before any text
+    // that has been inserted at the prelude location, matching the effect of
+    // inserting the prelude via InsertTextBefore.
+    const unsigned int dredd_prelude_start_offset =
+        edit_list_->GetOffset(dredd_prelude_start_location);
+    auto [text_before_prelude, text_after_prelude] =
+        edit_list_->GetRewrittenTextSplitAt(dredd_prelude_start_offset);
+    std::string coverage_tracking_text_before_prelude;
+    std::string coverage_tracking_text_after_prelude;
+    if (also_track_mutant_coverage) {
+      std::tie(coverage_tracking_text_before_prelude,
+               coverage_tracking_text_after_prelude) =
+          coverage_tracking_edit_list_->GetRewrittenTextSplitAt(
+              dredd_prelude_start_offset);
+    }
+
+    // Make the mutation ids in the recorded mutation info file-local.
+    OffsetMutationIds(-initial_mutation_id, mutation_info_for_file);
+
+    deferred_files_->emplace_back(
+        filename, output_path.str().str(),
+        compiler_instance_->getLangOpts().CPlusPlus, num_mutations,
+        std::move(text_before_prelude), std::move(text_after_prelude),
+        std::move(mutation_info_for_file), also_track_mutant_coverage,
+        std::move(coverage_tracking_text_before_prelude),
+        std::move(coverage_tracking_text_after_prelude),
+        use_shared_runtime ? SortDreddDeclarations(dredd_declarations)
+                           : std::vector<std::string>());
+    return;
   }
 
+  rewrite_timer.reset();
+  const ScopedPhaseTimer output_timer(run_statistics_,
+                                      RunStatistics::Phase::kOutput, filename);
+
   const std::string dredd_prelude =
       compiler_instance_->getLangOpts().CPlusPlus
-          ? GetDreddPreludeCpp(initial_mutation_id)
-          : GetDreddPreludeC(initial_mutation_id);
-
-  bool rewriter_result =
-      rewriter_.InsertTextBefore(dredd_prelude_start_location, dredd_prelude);
-  (void)rewriter_result;  // Keep release-mode compilers happy.
-  assert(!rewriter_result && "Rewrite failed.\n");
+          ? GetDreddPreludeCpp(*options_, initial_mutation_id, num_mutations)
+          : GetDreddPreludeC(*options_, initial_mutation_id, num_mutations);
+
+  const bool edit_result =
+      edit_list_->InsertTextBefore(dredd_prelude_start_location, dredd_prelude);
+  (void)edit_result;  // Keep release-mode compilers happy.
+  assert(!edit_result && "Rewrite failed.\n");
+
+  if (llvm::Error error = llvm::writeToOutput(
+          output_path, [&](llvm::raw_ostream& output_stream) -> llvm::Error {
+            output_stream << edit_list_->GetRewrittenText();
+            return llvm::Error::success();
+          })) {
+    llvm::errs() << "Unable to overwrite file " << output_path << ": "
+                 << llvm::toString(std::move(error)) << "\n";
+  }
+}
 
-  rewriter_result = rewriter_.overwriteChangedFiles();
-  (void)rewriter_result;  // Keep release mode compilers happy
-  assert(!rewriter_result && "Something went wrong emitting rewritten files.");
+bool MutateAstConsumer::shouldSkipFunctionBody(clang::Decl* decl) {
+  // The visitor does not consider declarations that are not wholly contained
+  // in the main file for mutation, so nothing is lost by not parsing their
+  // bodies. The expansion location is used so that functions in the main file
+  // that are declared via macros defined in headers are not skipped. Clang
+  // itself never skips the bodies of constexpr functions or functions with
+  // deduced return types, as these can affect the rest of the translation
+  // unit.
+  const clang::SourceManager& source_manager =
+      compiler_instance_->getSourceManager();
+  return !source_manager.isInMainFile(
+      source_manager.getExpansionLoc(decl->getLocation()));
 }
 
-void MutateAstConsumer::RewriteExpressionsInMainFile() {
+void MutateAstConsumer::RewriteExpressionsInMainFile(EditList& edit_list) {
   // Rewrite the size expressions of constant-sized arrays as needed.
   for (const auto& constant_sized_array_decl :
        visitor_->GetConstantSizedArraysToRewrite()) {
@@ -202,7 +399,8 @@ void MutateAstConsumer::RewriteExpressionsInMainFile() {
                   ->getAsArrayTypeUnsafe()
                   ->getAsArrayTypeUnsafe())
               ->getSize()
-              .getLimitedValue());
+              .getLimitedValue(),
+          edit_list);
       typeloc = constant_array_typeloc.getElementLoc();
     }
   }
@@ -213,7 +411,7 @@ void MutateAstConsumer::RewriteExpressionsInMainFile() {
   for (const auto& static_assert_decl :
        visitor_->GetStaticAssertionsToRewrite()) {
     RewriteExpressionInMainFileToIntegerConstant(
-        static_assert_decl->getAssertExpr(), 1);
+        static_assert_decl->getAssertExpr(), 1, edit_list);
   }
 
   // Rewrite the constant integer arguments of builtin functions and templates.
@@ -224,280 +422,132 @@ void MutateAstConsumer::RewriteExpressionsInMainFile() {
                 compiler_instance_->getASTContext())) {
       // Argument is an integer constant
       RewriteExpressionInMainFileToIntegerConstant(
-          constant_argument_expresion, integer_const_expr->getLimitedValue());
+          constant_argument_expresion, integer_const_expr->getLimitedValue(),
+          edit_list);
     }
   }
 }
 
 bool MutateAstConsumer::RewriteExpressionInMainFileToIntegerConstant(
-    const clang::Expr* expr, uint64_t integer_constant) {
+    const clang::Expr* expr, uint64_t integer_constant,
+    EditList& edit_list) {
   auto source_range_in_main_file =
-      GetSourceRangeInMainFile(compiler_instance_->getPreprocessor(), *expr);
+      source_range_cache_.GetSourceRangeInMainFile(*expr);
 
   // We only consider the rewriting if the source range for the size
   // expression is in the main source file.
   if (source_range_in_main_file.isValid()) {
     std::stringstream stringstream;
     stringstream << integer_constant;
-    rewriter_.ReplaceText(source_range_in_main_file, stringstream.str());
+    edit_list.ReplaceText(source_range_in_main_file, stringstream.str());
     return true;
   }
   return false;
 }
 
-std::string MutateAstConsumer::GetRegularDreddPreludeCpp(
-    int initial_mutation_id) const {
-  // The number of mutations applied to this file is known.
-  const int num_mutations = *mutation_id_ - initial_mutation_id;
-
-  // Whether mutants are enabled or not will be tracked using a bitset,
-  // represented as an array of 64-bit integers. First, work out how large this
-  // array will need to be, as ceiling(num_mutations / 64).
-  const int kWordSize = 64;
-  const int num_64_bit_words_required =
-      (num_mutations + kWordSize - 1) / kWordSize;
-
-  std::stringstream result;
-  result << kDreddPreludeHeadersCpp;
-  result << "\n";
-  result << "#ifdef _MSC_VER\n";
-  result << "#define thread_local __declspec(thread)\n";
-  result << "#elif __APPLE__\n";
-  result << "#define thread_local __thread\n";
-  result << "#endif\n";
-  result << "\n";
-  // This allows for fast checking that at least *some* mutation in the file is
-  // enabled. It is set to true initially so that __dredd_enabled_mutation gets
-  // invoked the first time enabledness is queried. At that point it will get
-  // set to false if no mutations are actually enabled.
-  result << "static thread_local bool __dredd_some_mutation_enabled = true;\n";
-  result << "static bool __dredd_enabled_mutation(int local_mutation_id) {\n";
-  result << "  static thread_local bool initialized = false;\n";
-  // Array of booleans, one per mutation in this file, determining whether they
-  // are enabled.
-  result << "  static thread_local uint64_t enabled_bitset["
-         << num_64_bit_words_required << "];\n";
-  result << "  if (!initialized) {\n";
-  // Record locally whether some mutation is enabled.
-  result << "    bool some_mutation_enabled = false;\n";
-  result << "    const char* dredd_environment_variable = "
-            "std::getenv(\"DREDD_ENABLED_MUTATION\");\n";
-  result << "    if (dredd_environment_variable != nullptr) {\n";
-  // The environment variable for mutations is set, so process the contents of
-  // this environment variable as a comma-seprated list of strings.
-  result << "      std::string contents(dredd_environment_variable);\n";
-  result << "      while (true) {\n";
-  // Find the position of the next comma.
-  result << "        size_t pos = contents.find(\",\");\n";
-  // The next token is either the whole string (if there is no comma) or the
-  // prefix before the next comma (if there is a comma).
-  result << "        std::string token = (pos == std::string::npos ? "
-            "contents : contents.substr(0, pos));\n";
-  // Ignore an empty token: this allows for a trailing comma at the end of the
-  // string.
-  result << "        if (!token.empty()) {\n";
-  // Parse the token as an integer. This will throw an exception if parsing
-  // fails, which is OK: it is expected that the user has set the environment
-  // variable to a legitimate value.
-  result << "          int value = std::stoi(token);\n";
-  result << "          int local_value = value - " << initial_mutation_id
-         << ";\n";
-  // Check whether the mutant id actually corresponds to a mutant in this file;
-  // skip it if it does not.
-  result << "          if (local_value >= 0 && local_value < " << num_mutations
-         << ") {\n";
-  // `local_value / 64` gives the element in the bitset array corresponding to
-  // this mutant. Then `local_value % 64` determines which bit of that element
-  // needs to be set in order to enable the mutant, and a bitwise operation is
-  // used to set the correct bit.
-  result << "            enabled_bitset[local_value / 64] |= "
-            "(static_cast<uint64_t>(1) << "
-            "(local_value % 64));\n";
-  // Note that at least one enabled mutation has been encountered.
-  result << "            some_mutation_enabled = true;\n";
-  result << "          }\n";
-  result << "        }\n";
-  // If the end of the string has been reached, exit the parsing loop.
-  result << "        if (pos == std::string::npos) {\n";
-  result << "          break;\n";
-  result << "        }\n";
-  // Move past the first comma so that the rest of the string can be processed.
-  result << "        contents.erase(0, pos + 1);\n";
-  result << "      }\n";
-  result << "    }\n";
-  // Initialisation is now complete, and whether at least one mutation is
-  // enabled is known.
-  result << "    initialized = true;\n";
-  result << "    __dredd_some_mutation_enabled = some_mutation_enabled;\n";
-  result << "  }\n";
-  // Similar to the above, a combination of division, modulo and bit-shifting
-  // is used to look up whether this mutant is enabled in the bitset.
-  result << "  return (enabled_bitset[local_mutation_id / 64] & "
-            "(static_cast<uint64_t>(1) << "
-            "(local_mutation_id % 64))) != 0;\n";
-  result << "}\n\n";
-  return result.str();
-}
-
-std::string MutateAstConsumer::GetMutantTrackingDreddPreludeCpp(
-    int initial_mutation_id) const {
-  // The number of mutations applied to this file is known.
-  const int num_mutations = *mutation_id_ - initial_mutation_id;
-
-  std::stringstream result;
-  result << kDreddPreludeHeadersCpp;
-  result << "\n";
-  result << "static void __dredd_record_covered_mutants(int local_mutation_id, "
-            "int num_mutations) {\n";
-  result << "  static std::atomic<bool> already_recorded[" << num_mutations
-         << "];\n";
-  result
-      << "  if (already_recorded[local_mutation_id].exchange(true)) return;\n";
-  result << "  const char* dredd_tracking_environment_variable = "
-            "std::getenv(\"DREDD_MUTANT_TRACKING_FILE\");\n";
-  result << "  if (dredd_tracking_environment_variable == nullptr) return;\n";
-  result << "  std::ofstream output_file;\n";
-  result << "  output_file.open(dredd_tracking_environment_variable, "
-            "std::ios_base::app);\n";
-  result << "  for (int i = 0; i < num_mutations; i++) {\n";
-  result << "    output_file << (" << std::to_string(initial_mutation_id)
-         << " + local_mutation_id + i) << \"\\n\";\n";
-  result << "  }\n";
-  result << "}\n\n";
-  return result.str();
-}
-
-std::string MutateAstConsumer::GetDreddPreludeCpp(
-    int initial_mutation_id) const {
-  return kDreddPreludeStartComment +
-         (options_->GetOnlyTrackMutantCoverage()
-              ? GetMutantTrackingDreddPreludeCpp(initial_mutation_id)
-              : GetRegularDreddPreludeCpp(initial_mutation_id));
-}
-
-std::string MutateAstConsumer::GetRegularDreddPreludeC(
-    int initial_mutation_id) const {
-  // See comments in GetRegularDreddPreludeCpp - this C version is a
-  // straightforward port.
-  const int num_mutations = *mutation_id_ - initial_mutation_id;
-  const int kWordSize = 64;
-  const int num_64_bit_words_required =
-      (num_mutations + kWordSize - 1) / kWordSize;
-
-  std::stringstream result;
-  result << kDreddPreludeHeadersC;
-  result << "\n";
-  result << "#ifdef _MSC_VER\n";
-  result << "#define thread_local __declspec(thread)\n";
-  result << "#elif __APPLE__\n";
-  result << "#define thread_local __thread\n";
-  result << "#else\n";
-  result << "#include <threads.h>\n";
-  result << "#endif\n";
-  result << "\n";
-  result << "static thread_local int __dredd_some_mutation_enabled = 1;\n";
-  result << "static bool __dredd_enabled_mutation(int local_mutation_id) {\n";
-  result << "  static thread_local int initialized = 0;\n";
-  result << "  static thread_local uint64_t enabled_bitset["
-         << num_64_bit_words_required << "];\n";
-  result << "  if (!initialized) {\n";
-  result << "    int some_mutation_enabled = 0;\n";
-  result << "    const char* dredd_environment_variable = "
-            "getenv(\"DREDD_ENABLED_MUTATION\");\n";
-  result << "    if (dredd_environment_variable) {\n";
-  result
-      << "      char* temp = malloc(strlen(dredd_environment_variable) + 1);\n";
-  result << "      strcpy(temp, dredd_environment_variable);\n";
-  result << "      char* token;\n";
-  result << "      token = strtok(temp, \",\");\n";
-  result << "      while(token) {\n";
-  result << "        int value = atoi(token);\n";
-  result << "        int local_value = value - " << initial_mutation_id
-         << ";\n";
-  result << "        if (local_value >= 0 && local_value < " << num_mutations
-         << ") {\n";
-  result << "          enabled_bitset[local_value / 64] |= ((uint64_t) 1 << "
-            "(local_value % 64));\n";
-  result << "          some_mutation_enabled = 1;\n";
-  result << "        }\n";
-  result << "        token = strtok(NULL, \",\");\n";
-  result << "      }\n";
-  result << "      free(temp);\n";
-  result << "    }\n";
-  result << "    initialized = 1;\n";
-  result << "    __dredd_some_mutation_enabled = some_mutation_enabled;\n";
-  result << "  }\n";
-  result
-      << "  return enabled_bitset[local_mutation_id / 64] & ((uint64_t) 1 << "
-         "(local_mutation_id % 64));\n";
-  result << "}\n\n";
-  return result.str();
-}
-
-std::string MutateAstConsumer::GetMutantTrackingDreddPreludeC(
-    int initial_mutation_id) const {
-  // See comments in GetMutantTrackingDreddPreludeCpp; this is a straightforward
-  // port to C.
-  const int num_mutations = *mutation_id_ - initial_mutation_id;
-  std::stringstream result;
-  result << kDreddPreludeHeadersC;
-  result << "\n";
-  result << "static void __dredd_record_covered_mutants(int local_mutation_id, "
-            "int num_mutations) {\n";
-  result << "  static atomic_bool already_recorded[" << num_mutations << "];\n";
-  result << "  if (atomic_exchange(&already_recorded[local_mutation_id], 1)) "
-            "return;\n";
-  result << "  const char* dredd_tracking_environment_variable = "
-            "getenv(\"DREDD_MUTANT_TRACKING_FILE\");\n";
-  result << "  if (!dredd_tracking_environment_variable) return;\n";
-  result << "  FILE* fp = fopen(dredd_tracking_environment_variable, \"a\");\n";
-  result << "  for (int i = 0; i < num_mutations; i++) {\n";
-  result << R"(    fprintf(fp, "%d\n", )" + std::to_string(initial_mutation_id)
-         << " + local_mutation_id + i);\n";
-  result << "  }\n";
-  result << "  fclose(fp);\n";
-  result << "}\n\n";
-  return result.str();
-}
-
-std::string MutateAstConsumer::GetDreddPreludeC(int initial_mutation_id) const {
-  return kDreddPreludeStartComment +
-         (options_->GetOnlyTrackMutantCoverage()
-              ? GetMutantTrackingDreddPreludeC(initial_mutation_id)
-              : GetRegularDreddPreludeC(initial_mutation_id));
-}
-
 void MutateAstConsumer::ApplyMutations(
     const MutationTreeNode& dredd_mutation_tree_node, int initial_mutation_id,
-    clang::ASTContext& context,
+    clang::ASTContext& context, const Options& options,
+    EditList& edit_list, int& mutation_id,
     protobufs::MutationInfoForFile& protobufs_mutation_info_for_file,
     protobufs::MutationTreeNode& protobufs_mutation_tree_node,
     std::unordered_set<std::string>& dredd_declarations, bool build_tree) {
   assert(!(dredd_mutation_tree_node.IsEmpty() &&
-           dredd_mutation_tree_node.GetChildren().size() == 1) &&
+           dredd_mutation_tree_node.HasOneChild()) &&
          "The mutation tree should already be compressed.");
-  for (const auto& child : dredd_mutation_tree_node.GetChildren()) {
+  for (const auto* child : dredd_mutation_tree_node.GetChildren()) {
     assert(!child->IsEmpty() &&
            "The mutation tree should not have empty subtrees.");
     protobufs_mutation_tree_node.add_children(static_cast<uint32_t>(
         protobufs_mutation_info_for_file.mutation_tree_size()));
     protobufs::MutationTreeNode* new_protobufs_mutation_tree_node =
         protobufs_mutation_info_for_file.add_mutation_tree();
-    ApplyMutations(
-        *child, initial_mutation_id, context, protobufs_mutation_info_for_file,
-        *new_protobufs_mutation_tree_node, dredd_declarations, build_tree);
+    ApplyMutations(*child, initial_mutation_id, context, options, edit_list,
+                   mutation_id, protobufs_mutation_info_for_file,
+                   *new_protobufs_mutation_tree_node, dredd_declarations,
+                   build_tree);
   }
 
-  for (const auto& mutation : dredd_mutation_tree_node.GetMutations()) {
-    const int mutation_id_old = *mutation_id_;
+  for (const auto* mutation : dredd_mutation_tree_node.GetMutations()) {
+    Options sampled_options;
+    const Options* mutation_options =
+        GetOptionsForMutation(*mutation, options, sampled_options);
+    if (mutation_options == nullptr) {
+      // None of the mutants of this mutation were sampled.
+      continue;
+    }
+    const int mutation_id_old = mutation_id;
     const auto mutation_group = mutation->Apply(
-        context, compiler_instance_->getPreprocessor(), *options_,
-        initial_mutation_id, *mutation_id_, rewriter_, dredd_declarations);
-    if (build_tree && *mutation_id_ > mutation_id_old) {
+        context, compiler_instance_->getPreprocessor(), *mutation_options,
+        initial_mutation_id, mutation_id, edit_list, dredd_declarations);
+    if (build_tree && mutation_id > mutation_id_old) {
       // Only add the result of applying the mutation if it had an effect.
       *protobufs_mutation_tree_node.add_mutation_groups() = mutation_group;
     }
   }
 }
 
+void MutateAstConsumer::CountMutations(
+    const MutationTreeNode& dredd_mutation_tree_node,
+    clang::ASTContext& context, int& mutation_id,
+    MutationCounter& mutation_counter) {
+  for (const auto* child : dredd_mutation_tree_node.GetChildren()) {
+    CountMutations(*child, context, mutation_id, mutation_counter);
+  }
+  for (const auto* mutation : dredd_mutation_tree_node.GetMutations()) {
+    Options sampled_options;
+    const Options* mutation_options =
+        GetOptionsForMutation(*mutation, *options_, sampled_options);
+    if (mutation_options == nullptr) {
+      continue;
+    }
+    const clang::FunctionDecl* function_decl =
+        visitor_->GetEnclosingFunction(*mutation);
+    mutation_counter.Add(function_decl == nullptr
+                             ? ""
+                             : function_decl->getQualifiedNameAsString(),
+                         mutation->CountInstances(context, *mutation_options,
+                                                  mutation_id));
+  }
+}
+
+void MutateAstConsumer::SampleMutations(const std::string& filename,
+                                        clang::ASTContext& context) {
+  std::vector<const Mutation*> mutations;
+  CollectMutations(visitor_->GetMutations(), mutations);
+  // The candidates for sampling are the mutants that would be applied if
+  // mutants were not sampled.
+  std::vector<protobufs::MutationGroup> mutation_groups;
+  mutation_groups.reserve(mutations.size());
+  int unused_mutation_id = 0;
+  for (const auto* mutation : mutations) {
+    mutation_groups.push_back(
+        mutation->CountInstances(context, *options_, unused_mutation_id));
+  }
+  std::vector<MutationSelection> mutation_selections =
+      options_->GetMutationSampler()->Sample(filename, mutation_groups);
+  sampled_mutation_selections_.clear();
+  for (size_t i = 0; i < mutations.size(); i++) {
+    sampled_mutation_selections_.emplace(mutations[i],
+                                         std::move(mutation_selections[i]));
+  }
+}
+
+const Options* MutateAstConsumer::GetOptionsForMutation(
+    const Mutation& mutation, const Options& options,
+    Options& sampled_options) const {
+  if (options.GetMutationSampler() == nullptr) {
+    return &options;
+  }
+  auto iterator = sampled_mutation_selections_.find(&mutation);
+  assert(iterator != sampled_mutation_selections_.end() &&
+         "Every mutation should have been sampled.");
+  if (!iterator->second.IsAnythingEnabled()) {
+    return nullptr;
+  }
+  sampled_options = options;
+  sampled_options.SetMutationSelection(iterator->second);
+  return &sampled_options;
+}
+
 }  // namespace dredd
@@ -18,7 +18,6 @@
 
 #include <cassert>
 #include <cstddef>
-#include <memory>
 #include <optional>
 #include <string>
 
@@ -38,14 +37,18 @@
 #include "clang/Basic/Builtins.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceLocation.h"
+#include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TypeTraits.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "libdredd/function_filter.h"
 #include "libdredd/mutation.h"
 #include "libdredd/mutation_remove_stmt.h"
 #include "libdredd/mutation_replace_binary_operator.h"
 #include "libdredd/mutation_replace_expr.h"
 #include "libdredd/mutation_replace_unary_operator.h"
+#include "libdredd/mutation_selection.h"
 #include "libdredd/options.h"
+#include "libdredd/stmt_parent_map.h"
 #include "libdredd/util.h"
 #include "llvm/ADT/iterator.h"
 #include "llvm/Support/Casting.h"
@@ -53,9 +56,13 @@
 namespace dredd {
 
 MutateVisitor::MutateVisitor(const clang::CompilerInstance& compiler_instance,
-                             const Options& options)
+                             const Options& options,
+                             SourceRangeCache& source_range_cache)
     : compiler_instance_(&compiler_instance),
       options_(&options),
+      source_range_cache_(&source_range_cache),
+      parent_map_(compiler_instance.getASTContext()),
+      analysis_cache_(compiler_instance.getASTContext()),
       mutation_tree_root_() {
   mutation_tree_path_.push_back(&mutation_tree_root_);
 }
@@ -92,23 +99,69 @@ bool MutateVisitor::IsInFunction() {
   return false;
 }
 
+bool MutateVisitor::IsInLineRanges(
+    clang::SourceRange source_range_in_main_file) {
+  if (!main_file_line_ranges_.has_value()) {
+    return true;
+  }
+  if (source_range_in_main_file.isInvalid()) {
+    return false;
+  }
+  return main_file_line_ranges_->Overlaps(
+      source_range_cache_
+          ->GetLineAndColumn(source_range_in_main_file.getBegin())
+          .first,
+      source_range_cache_->GetLineAndColumn(source_range_in_main_file.getEnd())
+          .first);
+}
+
+bool MutateVisitor::ShouldMutateFunction(
+    const clang::FunctionDecl& function_decl) const {
+  const auto* function_filter = options_->GetFunctionFilter();
+  if (function_filter == nullptr) {
+    return true;
+  }
+  if (const auto* method_decl =
+          llvm::dyn_cast<clang::CXXMethodDecl>(&function_decl)) {
+    if (method_decl->getParent()->isLambda()) {
+      // A lambda is mutated if and only if the function that encloses it is.
+      return true;
+    }
+  }
+  return function_filter->ShouldMutate(
+      function_decl.getQualifiedNameAsString());
+}
+
+bool MutateVisitor::HasDreddSkipAnnotation(const clang::Decl& decl) {
+  for (const auto* annotate_attr : decl.specific_attrs<clang::AnnotateAttr>()) {
+    if (annotate_attr->getAnnotation() == "dredd_skip") {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool MutateVisitor::TraverseDecl(clang::Decl* decl) {
   if (decl == nullptr) {
     // A Clang AST can feature nodes with null children; e.g.
     // "catch (...)" leads to a null catch expression.
     return true;
   }
+  num_decls_traversed_++;
   if (llvm::dyn_cast<clang::TranslationUnitDecl>(decl) != nullptr) {
+    if (const auto* line_range_filter = options_->GetLineRangeFilter()) {
+      const clang::SourceManager& source_manager =
+          compiler_instance_->getSourceManager();
+      main_file_line_ranges_ = line_range_filter->GetLineRangesForFile(
+          source_manager.getFileEntryForID(source_manager.getMainFileID())
+              ->getName()
+              .str());
+    }
     // This is the top-level translation unit declaration, so descend into it.
-    const bool result = RecursiveASTVisitor::TraverseDecl(decl);
-    // At this point the translation unit has been fully visited, so the
-    // mutation tree that has been built can be made simpler, in preparation for
-    // later turning it into a JSON summary.
-    mutation_tree_root_.TidyUp();
-    return result;
+    return RecursiveASTVisitor::TraverseDecl(decl);
   }
   auto source_range_in_main_file =
-      GetSourceRangeInMainFile(compiler_instance_->getPreprocessor(), *decl);
+      source_range_cache_->GetSourceRangeInMainFile(*decl);
   if (source_range_in_main_file.isInvalid()) {
     // This declaration is not wholly contained in the main file, so do not
     // consider it for mutation.
@@ -143,6 +196,17 @@ bool MutateVisitor::TraverseDecl(clang::Decl* decl) {
       // C++ constexpr functions, which require compile-time evaluation.
       return true;
     }
+    if (!ShouldMutateFunction(*function_decl)) {
+      // The function has been excluded from mutation, so there is no need to
+      // traverse it.
+      return true;
+    }
+  }
+
+  if (HasDreddSkipAnnotation(*decl)) {
+    // The user has asked for this declaration, e.g. a function, class or
+    // namespace, not to be mutated, so there is no need to traverse it.
+    return true;
   }
 
   // Besides variable declaration, constant-sized C++ arrays can occur inside a
@@ -212,6 +276,7 @@ bool MutateVisitor::TraverseStmt(clang::Stmt* stmt) {
   if (stmt == nullptr) {
     return true;
   }
+  num_stmts_traversed_++;
 
   // Do not mutate user defined literals.
   // TODO(https://github.com/mc-imperial/dredd/issues/223): Consider supporting
@@ -237,8 +302,8 @@ bool MutateVisitor::TraverseStmt(clang::Stmt* stmt) {
   // expressions, hence we ignore children of such expressions, rather than
   // ignoring the expressions themselves.
   if (const auto* unary_expr_or_type_trait_parent =
-          GetFirstParentOfType<clang::UnaryExprOrTypeTraitExpr>(
-              *stmt, compiler_instance_->getASTContext())) {
+          parent_map_.GetFirstParentOfType<clang::UnaryExprOrTypeTraitExpr>(
+              *stmt)) {
     const auto kind = unary_expr_or_type_trait_parent->getKind();
     if (kind == clang::UETT_SizeOf || kind == clang::UETT_AlignOf) {
       return true;
@@ -246,8 +311,8 @@ bool MutateVisitor::TraverseStmt(clang::Stmt* stmt) {
   }
 
   // Do not mutate the condition of a constexpr if statement.
-  if (const auto* if_stmt = GetFirstParentOfType<clang::IfStmt>(
-          *stmt, compiler_instance_->getASTContext())) {
+  if (const auto* if_stmt =
+          parent_map_.GetFirstParentOfType<clang::IfStmt>(*stmt)) {
     if (if_stmt->isConstexpr() && if_stmt->getCond() == stmt) {
       return true;
     }
@@ -256,8 +321,8 @@ bool MutateVisitor::TraverseStmt(clang::Stmt* stmt) {
   // Do not mutate the array size expression of C++'s NewExpr.
   // For instance, we do not want to mutate `2` in new `a[2]{3, 4}`,
   // as doing so requires type `a` to have zero-argument constructor.
-  if (const auto* cxx_new_expr = GetFirstParentOfType<clang::CXXNewExpr>(
-          *stmt, compiler_instance_->getASTContext())) {
+  if (const auto* cxx_new_expr =
+          parent_map_.GetFirstParentOfType<clang::CXXNewExpr>(*stmt)) {
     if (cxx_new_expr->getArraySize() == stmt) {
       return true;
     }
@@ -285,6 +350,10 @@ bool MutateVisitor::TraverseStmt(clang::Stmt* stmt) {
     }
   }
 
+  // The children of this statement are about to be traversed, and may query
+  // their parents.
+  parent_map_.RecordChildren(*stmt);
+
   // Add a node to the mutation tree to capture any mutations beneath this
   // statement.
   const PushMutationTreeRAII push_mutation_tree(*this);
@@ -365,12 +434,16 @@ bool MutateVisitor::TraverseParmVarDecl(clang::ParmVarDecl* parm_var_decl) {
 }
 
 void MutateVisitor::HandleUnaryOperator(clang::UnaryOperator* unary_operator) {
+  if (!options_->GetMutationSelection().IsReplaceUnaryOperatorEnabled()) {
+    return;
+  }
+
   // Check that the argument to the unary expression has a source ranges that is
   // part of the main file. In particular, this avoids mutating expressions that
   // directly involve the use of macros (though it is OK if sub-expressions of
   // arguments use macros).
-  if (GetSourceRangeInMainFile(compiler_instance_->getPreprocessor(),
-                               *unary_operator->getSubExpr())
+  if (source_range_cache_
+          ->GetSourceRangeInMainFile(*unary_operator->getSubExpr())
           .isInvalid()) {
     return;
   }
@@ -398,47 +471,43 @@ void MutateVisitor::HandleUnaryOperator(clang::UnaryOperator* unary_operator) {
   if (options_->GetOptimiseMutations()) {
     if (unary_operator->getOpcode() == clang::UO_Minus &&
         (MutationReplaceExpr::ExprIsEquivalentToInt(
-             *unary_operator->getSubExpr(), 1,
-             compiler_instance_->getASTContext()) ||
+             *unary_operator->getSubExpr(), 1, analysis_cache_) ||
          MutationReplaceExpr::ExprIsEquivalentToFloat(
-             *unary_operator->getSubExpr(), 1.0,
-             compiler_instance_->getASTContext()))) {
+             *unary_operator->getSubExpr(), 1.0, analysis_cache_))) {
       return;
     }
 
     if (unary_operator->getOpcode() == clang::UO_Not &&
         (MutationReplaceExpr::ExprIsEquivalentToInt(
-             *unary_operator->getSubExpr(), 0,
-             compiler_instance_->getASTContext()) ||
+             *unary_operator->getSubExpr(), 0, analysis_cache_) ||
          MutationReplaceExpr::ExprIsEquivalentToFloat(
-             *unary_operator->getSubExpr(), 0.0,
-             compiler_instance_->getASTContext()) ||
+             *unary_operator->getSubExpr(), 0.0, analysis_cache_) ||
          MutationReplaceExpr::ExprIsEquivalentToInt(
-             *unary_operator->getSubExpr(), 1,
-             compiler_instance_->getASTContext()) ||
+             *unary_operator->getSubExpr(), 1, analysis_cache_) ||
          MutationReplaceExpr::ExprIsEquivalentToFloat(
-             *unary_operator->getSubExpr(), 1.0,
-             compiler_instance_->getASTContext()))) {
+             *unary_operator->getSubExpr(), 1.0, analysis_cache_))) {
       return;
     }
   }
 
-  AddMutation(std::make_unique<MutationReplaceUnaryOperator>(
-      *unary_operator, compiler_instance_->getPreprocessor(),
-      compiler_instance_->getASTContext()));
+  AddMutation(
+      mutation_tree_arena_.CreateMutation<MutationReplaceUnaryOperator>(
+          *unary_operator, *source_range_cache_, analysis_cache_));
 }
 
 void MutateVisitor::HandleBinaryOperator(
     clang::BinaryOperator* binary_operator) {
+  if (!options_->GetMutationSelection().IsReplaceBinaryOperatorEnabled()) {
+    return;
+  }
+
   // Check that arguments of the binary expression have source ranges that are
   // part of the main file. In particular, this avoids mutating expressions that
   // directly involve the use of macros (though it is OK if sub-expressions of
   // arguments use macros).
-  if (GetSourceRangeInMainFile(compiler_instance_->getPreprocessor(),
-                               *binary_operator->getLHS())
+  if (source_range_cache_->GetSourceRangeInMainFile(*binary_operator->getLHS())
           .isInvalid() ||
-      GetSourceRangeInMainFile(compiler_instance_->getPreprocessor(),
-                               *binary_operator->getRHS())
+      source_range_cache_->GetSourceRangeInMainFile(*binary_operator->getRHS())
           .isInvalid()) {
     return;
   }
@@ -471,31 +540,31 @@ void MutateVisitor::HandleBinaryOperator(
   // replacement with a constant in all cases.
   if (options_->GetOptimiseMutations() &&
       (MutationReplaceExpr::ExprIsEquivalentToInt(
-           *binary_operator->getLHS(), 0,
-           compiler_instance_->getASTContext()) ||
+           *binary_operator->getLHS(), 0, analysis_cache_) ||
        MutationReplaceExpr::ExprIsEquivalentToFloat(
-           *binary_operator->getLHS(), 0.0,
-           compiler_instance_->getASTContext())) &&
+           *binary_operator->getLHS(), 0.0, analysis_cache_)) &&
       (MutationReplaceExpr::ExprIsEquivalentToInt(
-           *binary_operator->getRHS(), 1,
-           compiler_instance_->getASTContext()) ||
+           *binary_operator->getRHS(), 1, analysis_cache_) ||
        MutationReplaceExpr::ExprIsEquivalentToFloat(
-           *binary_operator->getRHS(), 1.0,
-           compiler_instance_->getASTContext()))) {
+           *binary_operator->getRHS(), 1.0, analysis_cache_))) {
     return;
   }
 
-  AddMutation(std::make_unique<MutationReplaceBinaryOperator>(
-      *binary_operator, compiler_instance_->getPreprocessor(),
-      compiler_instance_->getASTContext()));
+  AddMutation(
+      mutation_tree_arena_.CreateMutation<MutationReplaceBinaryOperator>(
+          *binary_operator, *source_range_cache_, analysis_cache_));
 }
 
 void MutateVisitor::HandleExpr(clang::Expr* expr) {
+  if (!options_->GetMutationSelection().IsReplaceExprEnabled()) {
+    return;
+  }
+
   // L-values are only mutated by inserting the prefix operators ++ and --, and
   // only under specific circumstances as documented by
   // MutationReplaceExpr::CanMutateLValue.
-  if (expr->isLValue() && !MutationReplaceExpr::CanMutateLValue(
-                              compiler_instance_->getASTContext(), *expr)) {
+  if (expr->isLValue() &&
+      !MutationReplaceExpr::CanMutateLValue(parent_map_, *expr)) {
     return;
   }
 
@@ -511,8 +580,8 @@ void MutateVisitor::HandleExpr(clang::Expr* expr) {
           compiler_instance_->getASTContext(),
           clang::Expr::NullPointerConstantValueDependence()) !=
       clang::Expr::NPCK_NotNull) {
-    if (const auto* cast_parent = GetFirstParentOfType<clang::CastExpr>(
-            *expr, compiler_instance_->getASTContext())) {
+    if (const auto* cast_parent =
+            parent_map_.GetFirstParentOfType<clang::CastExpr>(*expr)) {
       if (cast_parent->getType()->isAnyPointerType()) {
         return;
       }
@@ -530,8 +599,8 @@ void MutateVisitor::HandleExpr(clang::Expr* expr) {
   // reference can bind to it.
   if (const auto* cast_expr = llvm::dyn_cast<clang::CastExpr>(expr)) {
     if (cast_expr->getSubExpr()->refersToBitField() &&
-        GetFirstParentOfType<clang::MaterializeTemporaryExpr>(
-            *expr, compiler_instance_->getASTContext()) != nullptr) {
+        parent_map_.GetFirstParentOfType<clang::MaterializeTemporaryExpr>(
+            *expr) != nullptr) {
       return;
     }
   }
@@ -546,11 +615,11 @@ void MutateVisitor::HandleExpr(clang::Expr* expr) {
     // arising due to a change of type are unlikely to be all that interesting,
     // and r-value to r-value implicit casts are very common, e.g. occurring
     // whenever a signed literal, such as `1`, is used in an unsigned context.
-    if (const auto* cast_parent = GetFirstParentOfType<clang::CastExpr>(
-            *expr, compiler_instance_->getASTContext())) {
+    if (const auto* cast_parent =
+            parent_map_.GetFirstParentOfType<clang::CastExpr>(*expr)) {
       if (cast_parent->isLValue() == expr->isLValue() &&
-          GetFirstParentOfType<clang::InitListExpr>(
-              *expr, compiler_instance_->getASTContext()) == nullptr) {
+          parent_map_.GetFirstParentOfType<clang::InitListExpr>(*expr) ==
+              nullptr) {
         // However, this optimization shouldn't be performed on expressions
         // under Initializer List. This is because: (1) Dredd won't act on the
         // outer implicit cast under Initializer List. (2)  Bypassing this
@@ -569,17 +638,15 @@ void MutateVisitor::HandleExpr(clang::Expr* expr) {
     // captured by inserting an increment before a future use of the l-value (it
     // is not exactly the same, because the future use could be dynamically
     // reached in different manners compared with this statement).
-    if (GetFirstParentOfType<clang::CompoundStmt>(
-            *expr, compiler_instance_->getASTContext()) != nullptr ||
-        GetFirstParentOfType<clang::SwitchCase>(
-            *expr, compiler_instance_->getASTContext()) != nullptr) {
+    if (parent_map_.GetFirstParentOfType<clang::CompoundStmt>(*expr) !=
+            nullptr ||
+        parent_map_.GetFirstParentOfType<clang::SwitchCase>(*expr) != nullptr) {
       return;
     }
   }
 
-  AddMutation(std::make_unique<MutationReplaceExpr>(
-      *expr, compiler_instance_->getPreprocessor(),
-      compiler_instance_->getASTContext()));
+  AddMutation(mutation_tree_arena_.CreateMutation<MutationReplaceExpr>(
+      *expr, *source_range_cache_, parent_map_, analysis_cache_));
 }
 
 bool MutateVisitor::VisitExpr(clang::Expr* expr) {
@@ -614,8 +681,15 @@ bool MutateVisitor::VisitExpr(clang::Expr* expr) {
     return true;
   }
 
-  if (GetSourceRangeInMainFile(compiler_instance_->getPreprocessor(), *expr)
-          .isInvalid()) {
+  const clang::SourceRange source_range_in_main_file =
+      source_range_cache_->GetSourceRangeInMainFile(*expr);
+  if (source_range_in_main_file.isInvalid()) {
+    return true;
+  }
+
+  if (!IsInLineRanges(source_range_in_main_file)) {
+    // Mutation has been restricted to lines that this expression does not
+    // span, so none of the mutations of the expression apply.
     return true;
   }
 
@@ -624,7 +698,7 @@ bool MutateVisitor::VisitExpr(clang::Expr* expr) {
   // single file tests. If the Clang issue is indeed a bug and gets fixed, this
   // check (and the associated function) should be removed.
   if (!SourceRangeConsistencyCheck(expr->getSourceRange(),
-                                   compiler_instance_->getASTContext())) {
+                                   *source_range_cache_)) {
     return true;
   }
 
@@ -671,13 +745,18 @@ bool MutateVisitor::TraverseCompoundStmt(clang::CompoundStmt* compound_stmt) {
     // arranged hierarchically in the AST. We therefore traverse any such
     // hierarchy until we reach a statement that is not a switch case, and it
     // is this statement that is considered for removal.
+    //
+    // The switch cases are skipped rather than traversed, so their children
+    // are recorded here: an expression statement that follows a label may
+    // query whether its parent is a switch case.
     clang::Stmt* target_stmt = stmt;
     while (auto* switch_case = llvm::dyn_cast<clang::SwitchCase>(target_stmt)) {
+      parent_map_.RecordChildren(*switch_case);
       target_stmt = switch_case->getSubStmt();
     }
     if (options_->GetOptimiseMutations()) {
       if (const auto* expr = llvm::dyn_cast<clang::Expr>(target_stmt)) {
-        if (!expr->HasSideEffects(compiler_instance_->getASTContext())) {
+        if (!analysis_cache_.HasSideEffects(*expr)) {
           // There is no point mutating a side-effect free expression statement.
           continue;
         }
@@ -692,15 +771,19 @@ bool MutateVisitor::TraverseCompoundStmt(clang::CompoundStmt* compound_stmt) {
 
     assert(llvm::dyn_cast<clang::SwitchCase>(target_stmt) == nullptr &&
            "target_stmt isn't a SwitchCase due to previous AST traversal.");
-    if (GetSourceRangeInMainFile(compiler_instance_->getPreprocessor(),
-                                 *target_stmt)
-            .isInvalid() ||
+    const clang::SourceRange source_range_in_main_file =
+        source_range_cache_->GetSourceRangeInMainFile(*target_stmt);
+    if (!options_->GetMutationSelection().IsRemoveStmtEnabled() ||
+        source_range_in_main_file.isInvalid() ||
+        !IsInLineRanges(source_range_in_main_file) ||
         llvm::dyn_cast<clang::NullStmt>(target_stmt) != nullptr ||
         llvm::dyn_cast<clang::DeclStmt>(target_stmt) != nullptr ||
         llvm::dyn_cast<clang::LabelStmt>(target_stmt) != nullptr) {
       // Wrapping labels and null statements in conditional code
       // has no effect. Declarations cannot be wrapped in conditional code
-      // without risking breaking compilation.
+      // without risking breaking compilation. Statements that do not span any
+      // of the lines to which mutation is restricted are not removed, and no
+      // statement is removed if statement removal is disabled.
       continue;
     }
     if (options_->GetOptimiseMutations() &&
@@ -712,15 +795,43 @@ bool MutateVisitor::TraverseCompoundStmt(clang::CompoundStmt* compound_stmt) {
     assert(!enclosing_decls_.empty() &&
            "Statements can only be removed if they are nested in some "
            "declaration.");
-    AddMutation(std::make_unique<MutationRemoveStmt>(
-        *target_stmt, compiler_instance_->getPreprocessor(),
-        compiler_instance_->getASTContext()));
+    AddMutation(mutation_tree_arena_.CreateMutation<MutationRemoveStmt>(
+        *target_stmt, *source_range_cache_));
   }
   return true;
 }
 
-void MutateVisitor::AddMutation(std::unique_ptr<Mutation> mutation) {
-  mutation_tree_path_.back()->AddMutation(std::move(mutation));
+void MutateVisitor::AddMutation(const Mutation& mutation) {
+  // Create tree nodes for any scopes on the path that do not have one yet,
+  // starting from the innermost scope that does. The root always exists.
+  size_t index = mutation_tree_path_.size() - 1;
+  while (mutation_tree_path_[index] == nullptr) {
+    assert(index > 0 && "The root of the mutation tree should exist.");
+    index--;
+  }
+  for (index++; index < mutation_tree_path_.size(); index++) {
+    MutationTreeNode& node = mutation_tree_arena_.CreateNode();
+    mutation_tree_path_[index - 1]->AddChild(node);
+    mutation_tree_path_[index] = &node;
+  }
+  mutation_tree_path_.back()->AddMutation(mutation, mutation_tree_arena_);
+
+  for (auto iterator = enclosing_decls_.rbegin();
+       iterator != enclosing_decls_.rend(); ++iterator) {
+    if (const auto* function_decl =
+            llvm::dyn_cast<clang::FunctionDecl>(*iterator)) {
+      if (const auto* method_decl =
+              llvm::dyn_cast<clang::CXXMethodDecl>(function_decl)) {
+        if (method_decl->getParent()->isLambda()) {
+          // Attribute mutations in a lambda to the function that encloses
+          // the lambda, rather than to its call operator.
+          continue;
+        }
+      }
+      enclosing_functions_.emplace(&mutation, function_decl);
+      break;
+    }
+  }
 }
 
 bool MutateVisitor::VisitVarDecl(clang::VarDecl* var_decl) {
@@ -749,8 +860,8 @@ bool MutateVisitor::IsConversionOfEnumToConstructor(
     return false;
   }
   // Check whether the parent expression is a C++ constructor.
-  if (GetFirstParentOfType<clang::CXXConstructExpr>(
-          expr, compiler_instance_->getASTContext()) == nullptr) {
+  if (parent_map_.GetFirstParentOfType<clang::CXXConstructExpr>(expr) ==
+      nullptr) {
     return false;
   }
   // Check whether there is an enum constant under the implicit cast.
@@ -764,8 +875,8 @@ bool MutateVisitor::IsConversionOfEnumToConstructor(
 }
 bool MutateVisitor::IsArgumentToArgumentDependentLookupCall(
     const clang::Expr& expr) const {
-  const auto* call_expr = GetFirstParentOfType<clang::CallExpr>(
-      expr, compiler_instance_->getASTContext());
+  const auto* call_expr =
+      parent_map_.GetFirstParentOfType<clang::CallExpr>(expr);
   return call_expr != nullptr && call_expr->usesADL();
 }
 
@@ -809,9 +920,8 @@ bool MutateVisitor::MutatingMayAffectArgumentDependentLookup(
           llvm::dyn_cast<clang::CXXMemberCallExpr>(&expr)) {
     const clang::Expr* possible_adl_call_argument = member_call_expr;
     if (const auto* implicit_cast =
-            GetFirstParentOfType<clang::ImplicitCastExpr>(
-                *possible_adl_call_argument,
-                compiler_instance_->getASTContext())) {
+            parent_map_.GetFirstParentOfType<clang::ImplicitCastExpr>(
+                *possible_adl_call_argument)) {
       possible_adl_call_argument = implicit_cast;
     }
     if (IsArgumentToArgumentDependentLookupCall(*possible_adl_call_argument)) {
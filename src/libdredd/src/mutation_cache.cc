@@ -0,0 +1,174 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/mutation_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA256.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace dredd {
+
+namespace {
+
+// Changing the format of cache entries, or the way in which keys are computed,
+// requires this to be incremented so that stale entries are not used.
+const char* const kCacheFormatVersion = "1";
+
+// Each component of a key is preceded by its length, so that distinct
+// sequences of components cannot yield the same hash input.
+void AddKeyComponent(llvm::StringRef component, llvm::SHA256& hasher) {
+  const std::string length = std::to_string(component.size()) + ":";
+  hasher.update(length);
+  hasher.update(component);
+}
+
+std::optional<std::string> HashFileContents(const std::string& path) {
+  const llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+      llvm::MemoryBuffer::getFile(path, /*IsText=*/false,
+                                  /*RequiresNullTerminator=*/false);
+  if (!buffer) {
+    return std::nullopt;
+  }
+  const llvm::ArrayRef<uint8_t> contents =
+      llvm::arrayRefFromStringRef(buffer.get()->getBuffer());
+  return llvm::toHex(llvm::SHA256::hash(contents), /*LowerCase=*/true);
+}
+
+}  // namespace
+
+MutationCache::MutationCache(std::string cache_directory,
+                             std::string fingerprint)
+    : cache_directory_(std::move(cache_directory)),
+      fingerprint_(std::move(fingerprint)) {}
+
+std::optional<std::string> MutationCache::ComputeKey(
+    const std::string& source_path,
+    const std::vector<clang::tooling::CompileCommand>& compile_commands)
+    const {
+  const std::optional<std::string> source_hash = HashFileContents(source_path);
+  if (!source_hash.has_value()) {
+    return std::nullopt;
+  }
+  llvm::SHA256 hasher;
+  AddKeyComponent(kCacheFormatVersion, hasher);
+  AddKeyComponent(fingerprint_, hasher);
+  AddKeyComponent(source_hash.value(), hasher);
+  for (const auto& compile_command : compile_commands) {
+    AddKeyComponent(compile_command.Directory, hasher);
+    AddKeyComponent(compile_command.Filename, hasher);
+    AddKeyComponent(std::to_string(compile_command.CommandLine.size()),
+                    hasher);
+    for (const auto& argument : compile_command.CommandLine) {
+      AddKeyComponent(argument, hasher);
+    }
+  }
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+bool MutationCache::Lookup(const std::string& key,
+                           std::vector<DeferredMutatedFile>& deferred_files) {
+  // Any problem with the entry, including it not existing, is treated as a
+  // miss, so that the source file is simply mutated again.
+  protobufs::MutationCacheEntry entry;
+  const llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+      llvm::MemoryBuffer::getFile(GetEntryPath(key), /*IsText=*/false,
+                                  /*RequiresNullTerminator=*/false);
+  if (!buffer ||
+      !entry.ParseFromArray(buffer.get()->getBufferStart(),
+                            static_cast<int>(buffer.get()->getBufferSize()))) {
+    num_misses_++;
+    return false;
+  }
+  for (const auto& dependency : entry.dependencies()) {
+    if (HashFileContents(dependency.path()) != dependency.content_hash()) {
+      num_misses_++;
+      return false;
+    }
+  }
+  for (const auto& deferred_mutated_file : entry.deferred_mutated_files()) {
+    deferred_files.push_back(
+        DeferredMutatedFile::FromProtobuf(deferred_mutated_file));
+  }
+  num_hits_++;
+  return true;
+}
+
+bool MutationCache::Store(
+    const std::string& key, const std::string& working_directory,
+    const std::vector<std::string>& dependencies,
+    const std::vector<DeferredMutatedFile>& deferred_files) const {
+  // The working directory may itself be relative, in which case it is relative
+  // to the working directory of the process.
+  llvm::SmallString<128> absolute_working_directory(working_directory);
+  llvm::sys::fs::make_absolute(absolute_working_directory);
+  protobufs::MutationCacheEntry entry;
+  for (const auto& dependency : dependencies) {
+    llvm::SmallString<128> absolute_path(dependency);
+    llvm::sys::fs::make_absolute(absolute_working_directory, absolute_path);
+    llvm::sys::path::remove_dots(absolute_path, /*remove_dot_dot=*/false);
+    // A dependency that cannot be read now could not be checked when the entry
+    // is looked up, so the result of mutation is not cached.
+    const std::optional<std::string> content_hash =
+        HashFileContents(absolute_path.str().str());
+    if (!content_hash.has_value()) {
+      return false;
+    }
+    protobufs::MutationCacheDependency* cache_dependency =
+        entry.add_dependencies();
+    cache_dependency->set_path(absolute_path.str().str());
+    cache_dependency->set_content_hash(content_hash.value());
+  }
+  for (const auto& deferred_file : deferred_files) {
+    *entry.add_deferred_mutated_files() = deferred_file.ToProtobuf();
+  }
+  // The entry is written to a temporary file that is then renamed, so that an
+  // interrupted run cannot leave a partially-written entry behind.
+  if (llvm::Error error = llvm::writeToOutput(
+          GetEntryPath(key),
+          [&entry](llvm::raw_ostream& output_stream) -> llvm::Error {
+            output_stream << entry.SerializeAsString();
+            return llvm::Error::success();
+          })) {
+    llvm::consumeError(std::move(error));
+    return false;
+  }
+  return true;
+}
+
+std::string MutationCache::GetEntryPath(const std::string& key) const {
+  llvm::SmallString<128> result(cache_directory_);
+  llvm::sys::path::append(result, key + ".dredd-cache");
+  return result.str().str();
+}
+
+}  // namespace dredd
@@ -0,0 +1,147 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/mutation_counts.h"
+
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/protobufs/protobuf_serialization.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace dredd {
+
+namespace {
+
+using ActionCountMap = std::map<std::pair<std::string, std::string>, int32_t>;
+
+// Adds an entry for each kind and action in |action_counts| to |actions|, and
+// yields the total number of mutants.
+int32_t AddActionCounts(
+    const ActionCountMap& action_counts,
+    google::protobuf::RepeatedPtrField<protobufs::ActionCount>& actions) {
+  int32_t result = 0;
+  for (const auto& [kind_and_action, num_mutations] : action_counts) {
+    protobufs::ActionCount* action_count = actions.Add();
+    action_count->set_kind(kind_and_action.first);
+    action_count->set_action(kind_and_action.second);
+    action_count->set_num_mutations(num_mutations);
+    result += num_mutations;
+  }
+  return result;
+}
+
+}  // namespace
+
+std::vector<std::pair<std::string, std::string>> GetMutantKindsAndActions(
+    const protobufs::MutationGroup& mutation_group) {
+  std::vector<std::pair<std::string, std::string>> result;
+  if (mutation_group.has_remove_stmt()) {
+    result.emplace_back("remove_stmt", "RemoveStmt");
+  } else if (mutation_group.has_replace_expr()) {
+    for (const auto& instance : mutation_group.replace_expr().instances()) {
+      result.emplace_back(
+          "replace_expr",
+          protobufs::MutationReplaceExprAction_Name(instance.action()));
+    }
+  } else if (mutation_group.has_replace_binary_operator()) {
+    for (const auto& instance :
+         mutation_group.replace_binary_operator().instances()) {
+      result.emplace_back("replace_binary_operator",
+                          protobufs::MutationReplaceBinaryOperatorAction_Name(
+                              instance.action()));
+    }
+  } else {
+    assert(mutation_group.has_replace_unary_operator() &&
+           "Unknown kind of mutation group.");
+    for (const auto& instance :
+         mutation_group.replace_unary_operator().instances()) {
+      result.emplace_back("replace_unary_operator",
+                          protobufs::MutationReplaceUnaryOperatorAction_Name(
+                              instance.action()));
+    }
+  }
+  return result;
+}
+
+void MutationCounter::Add(const std::string& function_name,
+                          const protobufs::MutationGroup& mutation_group) {
+  const auto kinds_and_actions = GetMutantKindsAndActions(mutation_group);
+  if (kinds_and_actions.empty()) {
+    return;
+  }
+  ActionCountMap& function_counts = counts_[function_name];
+  for (const auto& kind_and_action : kinds_and_actions) {
+    function_counts[kind_and_action]++;
+  }
+}
+
+protobufs::FileMutationCounts MutationCounter::GetCountsForFile(
+    const std::string& filename) const {
+  protobufs::FileMutationCounts result;
+  result.set_filename(filename);
+  ActionCountMap file_counts;
+  for (const auto& [function_name, function_counts] : counts_) {
+    protobufs::FunctionMutationCounts* counts_for_function =
+        result.add_functions();
+    counts_for_function->set_function(function_name);
+    counts_for_function->set_num_mutations(AddActionCounts(
+        function_counts, *counts_for_function->mutable_actions()));
+    for (const auto& [kind_and_action, num_mutations] : function_counts) {
+      file_counts[kind_and_action] += num_mutations;
+    }
+  }
+  result.set_num_mutations(
+      AddActionCounts(file_counts, *result.mutable_actions()));
+  return result;
+}
+
+void AddFileMutationCounts(const protobufs::FileMutationCounts& file_counts,
+                           protobufs::MutationCounts& counts) {
+  *counts.add_files() = file_counts;
+  ActionCountMap total_counts;
+  for (const auto& action_count : counts.actions()) {
+    total_counts[{action_count.kind(), action_count.action()}] =
+        action_count.num_mutations();
+  }
+  for (const auto& action_count : file_counts.actions()) {
+    total_counts[{action_count.kind(), action_count.action()}] +=
+        action_count.num_mutations();
+  }
+  counts.clear_actions();
+  counts.set_num_mutations(
+      AddActionCounts(total_counts, *counts.mutable_actions()));
+}
+
+bool WriteMutationCounts(const protobufs::MutationCounts& counts,
+                         llvm::raw_ostream& stream) {
+  auto json_options = google::protobuf::util::JsonOptions();
+  json_options.add_whitespace = true;
+  json_options.always_print_primitive_fields = true;
+  std::string json_string;
+  if (!google::protobuf::util::MessageToJsonString(counts, &json_string,
+                                                   json_options)
+           .ok()) {
+    return false;
+  }
+  stream << json_string;
+  return true;
+}
+
+}  // namespace dredd
@@ -0,0 +1,325 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/mutation_info_writer.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <ios>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libdredd/mutation_info_binary_format.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/protobufs/protobuf_serialization.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace dredd {
+
+namespace {
+
+void AppendFixed(uint64_t value, size_t num_bytes, std::string* buffer) {
+  for (size_t i = 0; i < num_bytes; i++) {
+    buffer->push_back(static_cast<char>((value >> (8U * i)) & 0xffU));
+  }
+}
+
+void AppendVarint(uint64_t value, std::string* buffer) {
+  while (value >= 0x80U) {
+    buffer->push_back(static_cast<char>((value & 0x7fU) | 0x80U));
+    value >>= 7U;
+  }
+  buffer->push_back(static_cast<char>(value));
+}
+
+void AppendSignedVarint(int64_t value, std::string* buffer) {
+  // Zigzag encoding, so that values of small magnitude have short encodings.
+  const auto bits = static_cast<uint64_t>(value);
+  AppendVarint((bits << 1U) ^ (value < 0 ? ~uint64_t{0} : uint64_t{0}),
+               buffer);
+}
+
+// The first location is stored in full. Later locations are typically on the
+// same line as, or on a line close to, the first, so only their line delta is
+// stored.
+void AppendLocations(
+    std::initializer_list<const protobufs::SourceLocation*> locations,
+    std::string* buffer) {
+  const uint32_t first_line = (*locations.begin())->line();
+  bool is_first = true;
+  for (const auto* location : locations) {
+    if (is_first) {
+      AppendVarint(first_line, buffer);
+      is_first = false;
+    } else {
+      AppendSignedVarint(static_cast<int64_t>(location->line()) -
+                             static_cast<int64_t>(first_line),
+                         buffer);
+    }
+    AppendVarint(location->column(), buffer);
+  }
+}
+
+void AppendPadding(uint64_t offset, std::string* buffer) {
+  while ((offset + buffer->size()) % 8 != 0) {
+    buffer->push_back(0);
+  }
+}
+
+}  // namespace
+
+MutationInfoWriter::MutationInfoWriter(const std::string& filename,
+                                       Format format)
+    : output_stream_(filename, format == Format::kBinary
+                                   ? std::ios::out | std::ios::binary
+                                   : std::ios::out),
+      format_(format) {
+  if (format_ == Format::kJson) {
+    output_stream_ << "{\n \"infoForFiles\": [";
+  } else if (format_ == Format::kBinary) {
+    std::string header(kMutationInfoBinaryMagic,
+                       kMutationInfoBinaryMagicSize);
+    AppendFixed(kMutationInfoBinaryVersion, 4, &header);
+    AppendFixed(0, 4, &header);
+    assert(header.size() == kMutationInfoBinaryHeaderSize &&
+           "Unexpected header size.");
+    WriteBuffer(header);
+  }
+}
+
+void MutationInfoWriter::Write(
+    const protobufs::MutationInfoForFile& mutation_info_for_file) {
+  if (format_ == Format::kBinary) {
+    WriteBinary(mutation_info_for_file);
+  } else {
+    WriteJson(mutation_info_for_file);
+  }
+  is_first_entry_ = false;
+  output_stream_.flush();
+  if (!output_stream_) {
+    had_error_ = true;
+  }
+}
+
+void MutationInfoWriter::WriteJson(
+    const protobufs::MutationInfoForFile& mutation_info_for_file) {
+  auto json_options = google::protobuf::util::JsonOptions();
+  json_options.add_whitespace = format_ == Format::kJson;
+  json_options.always_print_primitive_fields = true;
+  std::string json_string;
+  if (!google::protobuf::util::MessageToJsonString(
+           mutation_info_for_file, &json_string, json_options)
+           .ok()) {
+    had_error_ = true;
+    return;
+  }
+  if (format_ == Format::kJsonLines) {
+    output_stream_ << json_string << "\n";
+  } else {
+    // Indent the object to match its position in the "infoForFiles" array.
+    output_stream_ << (is_first_entry_ ? "\n" : ",\n");
+    llvm::StringRef remaining = llvm::StringRef(json_string).rtrim();
+    while (!remaining.empty()) {
+      const auto [line, rest] = remaining.split('\n');
+      output_stream_ << "  " << line.str();
+      if (!rest.empty()) {
+        output_stream_ << "\n";
+      }
+      remaining = rest;
+    }
+  }
+}
+
+void MutationInfoWriter::WriteBinary(
+    const protobufs::MutationInfoForFile& mutation_info_for_file) {
+  const auto file_index = static_cast<uint32_t>(binary_files_.size());
+  BinaryFileEntry file_entry{bytes_written_, 0,
+                             InternString(mutation_info_for_file.filename())};
+  std::string buffer;
+  for (const auto& node : mutation_info_for_file.mutation_tree()) {
+    for (const auto& mutation_group : node.mutation_groups()) {
+      EncodeBinaryMutationGroup(mutation_group, file_index, bytes_written_,
+                                &buffer);
+    }
+  }
+  file_entry.tree_offset = bytes_written_ + buffer.size();
+  AppendVarint(
+      static_cast<uint64_t>(mutation_info_for_file.mutation_tree_size()),
+      &buffer);
+  for (const auto& node : mutation_info_for_file.mutation_tree()) {
+    AppendVarint(static_cast<uint64_t>(node.mutation_groups_size()), &buffer);
+    AppendVarint(static_cast<uint64_t>(node.children_size()), &buffer);
+    for (uint32_t child : node.children()) {
+      AppendVarint(child, &buffer);
+    }
+  }
+  binary_files_.push_back(file_entry);
+  WriteBuffer(buffer);
+}
+
+void MutationInfoWriter::EncodeBinaryMutationGroup(
+    const protobufs::MutationGroup& mutation_group, uint32_t file_index,
+    uint64_t buffer_offset, std::string* buffer) {
+  const uint64_t group_offset = buffer_offset + buffer->size();
+  const auto kind = static_cast<uint8_t>(mutation_group.group_case());
+  buffer->push_back(static_cast<char>(kind));
+  // Pairs of action and mutation id.
+  std::vector<std::pair<int, int>> instances;
+  if (mutation_group.has_remove_stmt()) {
+    const auto& remove_stmt = mutation_group.remove_stmt();
+    AppendLocations({&remove_stmt.start(), &remove_stmt.end()}, buffer);
+    AppendVarint(InternString(remove_stmt.snippet()), buffer);
+    instances.emplace_back(0, remove_stmt.mutation_id());
+  } else if (mutation_group.has_replace_expr()) {
+    const auto& replace_expr = mutation_group.replace_expr();
+    AppendLocations({&replace_expr.start(), &replace_expr.end()}, buffer);
+    AppendVarint(InternString(replace_expr.snippet()), buffer);
+    for (const auto& instance : replace_expr.instances()) {
+      instances.emplace_back(instance.action(), instance.mutation_id());
+    }
+  } else if (mutation_group.has_replace_binary_operator()) {
+    const auto& replace_binary_operator =
+        mutation_group.replace_binary_operator();
+    AppendLocations({&replace_binary_operator.expr_start(),
+                     &replace_binary_operator.expr_end(),
+                     &replace_binary_operator.lhs_start(),
+                     &replace_binary_operator.lhs_end(),
+                     &replace_binary_operator.rhs_start(),
+                     &replace_binary_operator.rhs_end()},
+                    buffer);
+    AppendVarint(InternString(replace_binary_operator.expr_snippet()), buffer);
+    AppendVarint(InternString(replace_binary_operator.lhs_snippet()), buffer);
+    AppendVarint(InternString(replace_binary_operator.rhs_snippet()), buffer);
+    AppendVarint(static_cast<uint64_t>(replace_binary_operator.operator_()),
+                 buffer);
+    for (const auto& instance : replace_binary_operator.instances()) {
+      instances.emplace_back(instance.action(), instance.mutation_id());
+    }
+  } else {
+    assert(mutation_group.has_replace_unary_operator() &&
+           "Unknown kind of mutation group.");
+    const auto& replace_unary_operator =
+        mutation_group.replace_unary_operator();
+    AppendLocations({&replace_unary_operator.expr_start(),
+                     &replace_unary_operator.expr_end(),
+                     &replace_unary_operator.operand_start(),
+                     &replace_unary_operator.operand_end()},
+                    buffer);
+    AppendVarint(InternString(replace_unary_operator.expr_snippet()), buffer);
+    AppendVarint(InternString(replace_unary_operator.operand_snippet()),
+                 buffer);
+    AppendVarint(static_cast<uint64_t>(replace_unary_operator.operator_()),
+                 buffer);
+    for (const auto& instance : replace_unary_operator.instances()) {
+      instances.emplace_back(instance.action(), instance.mutation_id());
+    }
+  }
+  AppendVarint(instances.size(), buffer);
+  int previous_mutation_id = 0;
+  for (const auto& [action, mutation_id] : instances) {
+    assert(mutation_id >= 0 && "Mutation ids should be non-negative.");
+    AppendVarint(static_cast<uint64_t>(action), buffer);
+    AppendSignedVarint(static_cast<int64_t>(mutation_id) -
+                           static_cast<int64_t>(previous_mutation_id),
+                       buffer);
+    previous_mutation_id = mutation_id;
+    const auto index = static_cast<size_t>(mutation_id);
+    if (index >= binary_mutants_.size()) {
+      binary_mutants_.resize(index + 1, BinaryMutantEntry{0, 0, 0, 0});
+    }
+    binary_mutants_[index] = BinaryMutantEntry{
+        group_offset, file_index, kind, static_cast<uint16_t>(action)};
+  }
+}
+
+uint32_t MutationInfoWriter::InternString(const std::string& string) {
+  const auto [iterator, inserted] =
+      string_ids_.try_emplace(string, static_cast<uint32_t>(strings_.size()));
+  if (inserted) {
+    strings_.push_back(iterator->getKey());
+  }
+  return iterator->getValue();
+}
+
+void MutationInfoWriter::FinishBinary() {
+  std::string buffer;
+
+  AppendPadding(bytes_written_, &buffer);
+  const uint64_t strings_offset = bytes_written_ + buffer.size();
+  uint64_t string_data_offset = 0;
+  for (const auto& string : strings_) {
+    AppendFixed(string_data_offset, 8, &buffer);
+    string_data_offset += string.size();
+  }
+  AppendFixed(string_data_offset, 8, &buffer);
+  for (const auto& string : strings_) {
+    buffer.append(string.data(), string.size());
+  }
+
+  AppendPadding(bytes_written_, &buffer);
+  const uint64_t files_offset = bytes_written_ + buffer.size();
+  for (const auto& file_entry : binary_files_) {
+    AppendFixed(file_entry.groups_offset, 8, &buffer);
+    AppendFixed(file_entry.tree_offset, 8, &buffer);
+    AppendFixed(file_entry.filename_id, 4, &buffer);
+    AppendFixed(0, 4, &buffer);
+  }
+
+  const uint64_t mutants_offset = bytes_written_ + buffer.size();
+  for (const auto& mutant_entry : binary_mutants_) {
+    AppendFixed(mutant_entry.group_offset, 8, &buffer);
+    AppendFixed(mutant_entry.file_index, 4, &buffer);
+    AppendFixed(mutant_entry.kind, 1, &buffer);
+    AppendFixed(0, 1, &buffer);
+    AppendFixed(mutant_entry.action, 2, &buffer);
+  }
+
+  const size_t footer_start = buffer.size();
+  AppendFixed(strings_offset, 8, &buffer);
+  AppendFixed(strings_.size(), 8, &buffer);
+  AppendFixed(files_offset, 8, &buffer);
+  AppendFixed(binary_files_.size(), 8, &buffer);
+  AppendFixed(mutants_offset, 8, &buffer);
+  AppendFixed(binary_mutants_.size(), 8, &buffer);
+  buffer.append(kMutationInfoBinaryFooterMagic, kMutationInfoBinaryMagicSize);
+  assert(buffer.size() - footer_start == kMutationInfoBinaryFooterSize &&
+         "Unexpected footer size.");
+  (void)footer_start;  // Keep release-mode compilers happy.
+  WriteBuffer(buffer);
+}
+
+void MutationInfoWriter::WriteBuffer(const std::string& buffer) {
+  output_stream_.write(buffer.data(),
+                       static_cast<std::streamsize>(buffer.size()));
+  bytes_written_ += buffer.size();
+}
+
+bool MutationInfoWriter::Finish() {
+  if (format_ == Format::kJson) {
+    output_stream_ << "\n ]\n}\n";
+  } else if (format_ == Format::kBinary) {
+    FinishBinary();
+  }
+  output_stream_.close();
+  if (!output_stream_) {
+    had_error_ = true;
+  }
+  return !had_error_;
+}
+
+}  // namespace dredd
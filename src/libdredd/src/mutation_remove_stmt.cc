@@ -15,6 +15,7 @@
 #include "libdredd/mutation_remove_stmt.h"
 
 #include <cassert>
+#include <cstdint>
 #include <sstream>
 #include <string>
 #include <unordered_set>
@@ -26,24 +27,24 @@
 #include "clang/Lex/Lexer.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/Token.h"
-#include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/Tooling/Transformer/SourceCode.h"
+#include "libdredd/edit_list.h"
 #include "libdredd/options.h"
 #include "libdredd/util.h"
+#include "llvm/ADT/StringExtras.h"
 
 namespace dredd {
 
 MutationRemoveStmt::MutationRemoveStmt(const clang::Stmt& stmt,
-                                       const clang::Preprocessor& preprocessor,
-                                       const clang::ASTContext& ast_context)
+                                       SourceRangeCache& source_range_cache)
     : stmt_(&stmt),
-      info_for_source_range_(GetSourceRangeInMainFile(preprocessor, stmt),
-                             ast_context) {}
+      info_for_source_range_(source_range_cache.GetSourceRangeInMainFile(stmt),
+                             source_range_cache) {}
 
 protobufs::MutationGroup MutationRemoveStmt::Apply(
     clang::ASTContext& ast_context, const clang::Preprocessor& preprocessor,
     const Options& options, int first_mutation_id_in_file, int& mutation_id,
-    clang::Rewriter& rewriter,
+    EditList& edit_list,
     std::unordered_set<std::string>& dredd_declarations) const {
   (void)dredd_declarations;  // Unused.
 
@@ -59,7 +60,7 @@ protobufs::MutationGroup MutationRemoveStmt::Apply(
   *inner_result.mutable_snippet() = info_for_source_range_.GetSnippet();
 
   clang::CharSourceRange source_range = clang::CharSourceRange::getTokenRange(
-      GetSourceRangeInMainFile(preprocessor, *stmt_));
+      info_for_source_range_.GetSourceRange());
 
   // If the statement is followed immediately by a semicolon, possibly with
   // intervening comments, that semicolon should be part of the code that is
@@ -109,18 +110,36 @@ protobufs::MutationGroup MutationRemoveStmt::Apply(
   }
 
   if (options.GetOnlyTrackMutantCoverage()) {
-    const bool rewriter_result = rewriter.InsertTextBefore(
+    const bool edit_result = edit_list.InsertTextBefore(
         source_range.getBegin(),
         "__dredd_record_covered_mutants" + ast_node_type_comment + "(" +
             std::to_string(local_mutation_id) + ", 1); ");
-    assert(!rewriter_result && "Rewrite failed.\n");
-    (void)rewriter_result;  // Keep release-mode compilers happy.
+    assert(!edit_result && "Rewrite failed.\n");
+    (void)edit_result;  // Keep release-mode compilers happy.
   } else {
-    bool rewriter_result = rewriter.InsertTextBefore(
-        source_range.getBegin(),
-        "if (!__dredd_enabled_mutation" + ast_node_type_comment + "(" +
-            std::to_string(local_mutation_id) + ")) { ");
-    assert(!rewriter_result && "Rewrite failed.\n");
+    // Unless the mutant is queried via a shared runtime or the global mutant
+    // registry, both of which are indexed by global mutation id, the element
+    // of the file's bitset of enabled mutants that holds the mutant's bit, and
+    // the mask for that bit, are worked out here, so that the check is cheap
+    // when inlined.
+    std::string enabled_check =
+        "__dredd_enabled_mutation" + ast_node_type_comment + "(" +
+        std::to_string(local_mutation_id) + ")";
+    if (!options.GetUseSharedRuntime() &&
+        !options.GetUseGlobalMutantRegistry()) {
+      const int kWordSize = 64;
+      enabled_check =
+          "__dredd_enabled_mutation_with_mask" + ast_node_type_comment + "(" +
+          std::to_string(local_mutation_id) + ", " +
+          std::to_string(local_mutation_id / kWordSize) + ", 0x" +
+          llvm::utohexstr(static_cast<uint64_t>(1)
+                              << (local_mutation_id % kWordSize),
+                          /*LowerCase=*/true) +
+          "ULL)";
+    }
+    bool edit_result = edit_list.InsertTextBefore(
+        source_range.getBegin(), "if (!" + enabled_check + ") { ");
+    assert(!edit_result && "Rewrite failed.\n");
     std::string to_insert = " }";
     if (!is_extended_with_semi && IsNextTokenHash(source_range, preprocessor)) {
       // If we did not extend the range to capture an immediately-following
@@ -147,10 +166,10 @@ protobufs::MutationGroup MutationRemoveStmt::Apply(
       // line, but this would make mutated files harder to read.
       to_insert = "\n" + to_insert;
     }
-    rewriter_result =
-        rewriter.InsertTextAfterToken(source_range.getEnd(), to_insert);
-    assert(!rewriter_result && "Rewrite failed.\n");
-    (void)rewriter_result;  // Keep release-mode compilers happy.
+    edit_result =
+        edit_list.InsertTextAfterToken(source_range.getEnd(), to_insert);
+    assert(!edit_result && "Rewrite failed.\n");
+    (void)edit_result;  // Keep release-mode compilers happy.
   }
 
   mutation_id++;
@@ -160,6 +179,18 @@ protobufs::MutationGroup MutationRemoveStmt::Apply(
   return result;
 }
 
+protobufs::MutationGroup MutationRemoveStmt::CountInstances(
+    clang::ASTContext& ast_context, const Options& options,
+    int& mutation_id) const {
+  (void)ast_context;  // Unused.
+  (void)options;      // Unused.
+
+  protobufs::MutationGroup result;
+  result.mutable_remove_stmt()->set_mutation_id(mutation_id);
+  mutation_id++;
+  return result;
+}
+
 bool MutationRemoveStmt::IsNextTokenHash(
     const clang::CharSourceRange& source_range,
     const clang::Preprocessor& preprocessor) {
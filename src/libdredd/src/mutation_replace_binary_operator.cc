@@ -29,8 +29,10 @@
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Lex/Preprocessor.h"
-#include "clang/Rewrite/Core/Rewriter.h"
+#include "libdredd/edit_list.h"
+#include "libdredd/expr_analysis_cache.h"
 #include "libdredd/mutation_replace_expr.h"
+#include "libdredd/mutation_selection.h"
 #include "libdredd/options.h"
 #include "libdredd/util.h"
 #include "llvm/ADT/StringRef.h"
@@ -39,25 +41,25 @@ namespace dredd {
 
 MutationReplaceBinaryOperator::MutationReplaceBinaryOperator(
     const clang::BinaryOperator& binary_operator,
-    const clang::Preprocessor& preprocessor,
-    const clang::ASTContext& ast_context)
+    SourceRangeCache& source_range_cache, ExprAnalysisCache& analysis_cache)
     : binary_operator_(&binary_operator),
       info_for_overall_expr_(
-          GetSourceRangeInMainFile(preprocessor, binary_operator), ast_context),
-      info_for_lhs_(
-          GetSourceRangeInMainFile(preprocessor, *binary_operator.getLHS()),
-          ast_context),
-      info_for_rhs_(
-          GetSourceRangeInMainFile(preprocessor, *binary_operator.getRHS()),
-          ast_context) {}
+          source_range_cache.GetSourceRangeInMainFile(binary_operator),
+          source_range_cache),
+      info_for_lhs_(source_range_cache.GetSourceRangeInMainFile(
+                        *binary_operator.getLHS()),
+                    source_range_cache),
+      info_for_rhs_(source_range_cache.GetSourceRangeInMainFile(
+                        *binary_operator.getRHS()),
+                    source_range_cache),
+      analysis_cache_(&analysis_cache) {}
 
 bool MutationReplaceBinaryOperator::IsRedundantReplacementOperator(
-    clang::BinaryOperatorKind operator_kind,
-    const clang::ASTContext& ast_context) const {
+    clang::BinaryOperatorKind operator_kind) const {
   if (IsRedundantReplacementForBooleanValuedOperator(operator_kind)) {
     return true;
   }
-  if (IsRedundantReplacementForArithmeticOperator(operator_kind, ast_context)) {
+  if (IsRedundantReplacementForArithmeticOperator(operator_kind)) {
     return true;
   }
   return false;
@@ -218,36 +220,36 @@ std::string MutationReplaceBinaryOperator::GetFunctionName(
   // be optimised.
   if (optimise_mutations && !binary_operator_->isAssignmentOp()) {
     if (MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getRHS(),
-                                                   0, ast_context) ||
+                                                   0, *analysis_cache_) ||
         MutationReplaceExpr::ExprIsEquivalentToFloat(
-            *binary_operator_->getRHS(), 0.0, ast_context)) {
+            *binary_operator_->getRHS(), 0.0, *analysis_cache_)) {
       result += "_rhs_zero";
     } else if (MutationReplaceExpr::ExprIsEquivalentToInt(
-                   *binary_operator_->getRHS(), 1, ast_context) ||
+                   *binary_operator_->getRHS(), 1, *analysis_cache_) ||
                MutationReplaceExpr::ExprIsEquivalentToFloat(
-                   *binary_operator_->getRHS(), 1.0, ast_context)) {
+                   *binary_operator_->getRHS(), 1.0, *analysis_cache_)) {
       result += "_rhs_one";
     } else if (MutationReplaceExpr::ExprIsEquivalentToInt(
-                   *binary_operator_->getRHS(), -1, ast_context) ||
+                   *binary_operator_->getRHS(), -1, *analysis_cache_) ||
                MutationReplaceExpr::ExprIsEquivalentToFloat(
-                   *binary_operator_->getRHS(), -1.0, ast_context)) {
+                   *binary_operator_->getRHS(), -1.0, *analysis_cache_)) {
       result += "_rhs_minus_one";
     }
 
     if (MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getLHS(),
-                                                   0, ast_context) ||
+                                                   0, *analysis_cache_) ||
         MutationReplaceExpr::ExprIsEquivalentToFloat(
-            *binary_operator_->getLHS(), 0.0, ast_context)) {
+            *binary_operator_->getLHS(), 0.0, *analysis_cache_)) {
       result += "_lhs_zero";
     } else if (MutationReplaceExpr::ExprIsEquivalentToInt(
-                   *binary_operator_->getLHS(), 1, ast_context) ||
+                   *binary_operator_->getLHS(), 1, *analysis_cache_) ||
                MutationReplaceExpr::ExprIsEquivalentToFloat(
-                   *binary_operator_->getLHS(), 1.0, ast_context)) {
+                   *binary_operator_->getLHS(), 1.0, *analysis_cache_)) {
       result += "_lhs_one";
     } else if (MutationReplaceExpr::ExprIsEquivalentToInt(
-                   *binary_operator_->getLHS(), -1, ast_context) ||
+                   *binary_operator_->getLHS(), -1, *analysis_cache_) ||
                MutationReplaceExpr::ExprIsEquivalentToFloat(
-                   *binary_operator_->getLHS(), -1.0, ast_context)) {
+                   *binary_operator_->getLHS(), -1.0, *analysis_cache_)) {
       result += "_lhs_minus_one";
     }
   }
@@ -257,9 +259,10 @@ std::string MutationReplaceBinaryOperator::GetFunctionName(
 
 void MutationReplaceBinaryOperator::GenerateArgumentReplacement(
     const std::string& arg1_evaluated, const std::string& arg2_evaluated,
-    const clang::ASTContext& ast_context, bool optimise_mutations,
-    bool only_track_mutant_coverage, int mutation_id_base,
-    std::stringstream& new_function, int& mutation_id_offset,
+    bool optimise_mutations, const MutationSelection& mutation_selection,
+    bool only_track_mutant_coverage,
+    int mutation_id_base, std::stringstream& new_function,
+    int& mutation_id_offset,
     protobufs::MutationReplaceBinaryOperator& protobuf_message) const {
   if (optimise_mutations) {
     switch (binary_operator_->getOpcode()) {
@@ -289,23 +292,24 @@ void MutationReplaceBinaryOperator::GenerateArgumentReplacement(
   // LHS
   // These cases are equivalent to constant replacement with the respective
   // constants
-  if (!optimise_mutations ||
-      !(MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getLHS(),
-                                                   0, ast_context) ||
-        MutationReplaceExpr::ExprIsEquivalentToFloat(
-            *binary_operator_->getLHS(), 0.0, ast_context) ||
-        MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getLHS(),
-                                                   1, ast_context) ||
-        MutationReplaceExpr::ExprIsEquivalentToFloat(
-            *binary_operator_->getLHS(), 1.0, ast_context) ||
-        MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getLHS(),
-                                                   -1, ast_context) ||
-        MutationReplaceExpr::ExprIsEquivalentToFloat(
-            *binary_operator_->getLHS(), -1.0, ast_context))) {
+  if (mutation_selection.IsEnabled(
+          protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithLHS) &&
+      (!optimise_mutations ||
+       !(MutationReplaceExpr::ExprIsEquivalentToInt(
+             *binary_operator_->getLHS(), 0, *analysis_cache_) ||
+         MutationReplaceExpr::ExprIsEquivalentToFloat(
+             *binary_operator_->getLHS(), 0.0, *analysis_cache_) ||
+         MutationReplaceExpr::ExprIsEquivalentToInt(
+             *binary_operator_->getLHS(), 1, *analysis_cache_) ||
+         MutationReplaceExpr::ExprIsEquivalentToFloat(
+             *binary_operator_->getLHS(), 1.0, *analysis_cache_) ||
+         MutationReplaceExpr::ExprIsEquivalentToInt(
+             *binary_operator_->getLHS(), -1, *analysis_cache_) ||
+         MutationReplaceExpr::ExprIsEquivalentToFloat(
+             *binary_operator_->getLHS(), -1.0, *analysis_cache_)))) {
     if (!only_track_mutant_coverage) {
-      new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                   << mutation_id_offset << ")) return " << arg1_evaluated
-                   << ";\n";
+      new_function << "    case " << mutation_id_offset << ": return "
+                   << arg1_evaluated << ";\n";
     }
     AddMutationInstance(
         mutation_id_base,
@@ -316,23 +320,24 @@ void MutationReplaceBinaryOperator::GenerateArgumentReplacement(
   // RHS
   // These cases are equivalent to constant replacement with the respective
   // constants
-  if (!optimise_mutations ||
-      !(MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getRHS(),
-                                                   0, ast_context) ||
-        MutationReplaceExpr::ExprIsEquivalentToFloat(
-            *binary_operator_->getRHS(), 0.0, ast_context) ||
-        MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getRHS(),
-                                                   1, ast_context) ||
-        MutationReplaceExpr::ExprIsEquivalentToFloat(
-            *binary_operator_->getRHS(), 1.0, ast_context) ||
-        MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getRHS(),
-                                                   -1, ast_context) ||
-        MutationReplaceExpr::ExprIsEquivalentToFloat(
-            *binary_operator_->getRHS(), -1.0, ast_context))) {
+  if (mutation_selection.IsEnabled(
+          protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithRHS) &&
+      (!optimise_mutations ||
+       !(MutationReplaceExpr::ExprIsEquivalentToInt(
+             *binary_operator_->getRHS(), 0, *analysis_cache_) ||
+         MutationReplaceExpr::ExprIsEquivalentToFloat(
+             *binary_operator_->getRHS(), 0.0, *analysis_cache_) ||
+         MutationReplaceExpr::ExprIsEquivalentToInt(
+             *binary_operator_->getRHS(), 1, *analysis_cache_) ||
+         MutationReplaceExpr::ExprIsEquivalentToFloat(
+             *binary_operator_->getRHS(), 1.0, *analysis_cache_) ||
+         MutationReplaceExpr::ExprIsEquivalentToInt(
+             *binary_operator_->getRHS(), -1, *analysis_cache_) ||
+         MutationReplaceExpr::ExprIsEquivalentToFloat(
+             *binary_operator_->getRHS(), -1.0, *analysis_cache_)))) {
     if (!only_track_mutant_coverage) {
-      new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                   << mutation_id_offset << ")) return " << arg2_evaluated
-                   << ";\n";
+      new_function << "    case " << mutation_id_offset << ": return "
+                   << arg2_evaluated << ";\n";
     }
     AddMutationInstance(
         mutation_id_base,
@@ -343,16 +348,16 @@ void MutationReplaceBinaryOperator::GenerateArgumentReplacement(
 
 void MutationReplaceBinaryOperator::GenerateBinaryOperatorReplacement(
     const std::string& arg1_evaluated, const std::string& arg2_evaluated,
-    const clang::ASTContext& ast_context, bool optimise_mutations,
-    bool only_track_mutant_coverage, int mutation_id_base,
-    std::stringstream& new_function, int& mutation_id_offset,
+    bool optimise_mutations, const MutationSelection& mutation_selection,
+    bool only_track_mutant_coverage,
+    int mutation_id_base, std::stringstream& new_function,
+    int& mutation_id_offset,
     protobufs::MutationReplaceBinaryOperator& protobuf_message) const {
   for (auto operator_kind :
-       GetReplacementOperators(optimise_mutations, ast_context)) {
+       GetReplacementOperators(optimise_mutations, mutation_selection)) {
     if (!only_track_mutant_coverage) {
-      new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                   << mutation_id_offset << ")) return " << arg1_evaluated
-                   << " "
+      new_function << "    case " << mutation_id_offset << ": return "
+                   << arg1_evaluated << " "
                    << clang::BinaryOperator::getOpcodeStr(operator_kind).str()
                    << " " << arg2_evaluated << ";\n";
     }
@@ -363,7 +368,8 @@ void MutationReplaceBinaryOperator::GenerateBinaryOperatorReplacement(
 
 std::vector<clang::BinaryOperatorKind>
 MutationReplaceBinaryOperator::GetReplacementOperators(
-    bool optimise_mutations, const clang::ASTContext& ast_context) const {
+    bool optimise_mutations,
+    const MutationSelection& mutation_selection) const {
   const std::vector<clang::BinaryOperatorKind> kArithmeticOperators = {
       clang::BinaryOperatorKind::BO_Add, clang::BinaryOperatorKind::BO_Div,
       clang::BinaryOperatorKind::BO_Mul, clang::BinaryOperatorKind::BO_Rem,
@@ -426,8 +432,9 @@ MutationReplaceBinaryOperator::GetReplacementOperators(
   for (auto operator_kind : candidate_operator_kinds) {
     if (operator_kind == binary_operator_->getOpcode() ||
         !IsValidReplacementOperator(operator_kind) ||
+        !mutation_selection.IsEnabled(OperatorKindToAction(operator_kind)) ||
         (optimise_mutations &&
-         IsRedundantReplacementOperator(operator_kind, ast_context))) {
+         IsRedundantReplacementOperator(operator_kind))) {
       continue;
     }
     result.push_back(operator_kind);
@@ -439,23 +446,40 @@ std::string MutationReplaceBinaryOperator::GenerateMutatorFunction(
     clang::ASTContext& ast_context, const std::string& function_name,
     const std::string& result_type, const std::string& lhs_type,
     const std::string& rhs_type, bool optimise_mutations,
-    bool only_track_mutant_coverage, int& mutation_id,
+    const MutationSelection& mutation_selection,
+    bool only_track_mutant_coverage, bool use_shared_runtime,
+    int& mutation_id,
     protobufs::MutationReplaceBinaryOperator& protobuf_message) const {
+  const bool lhs_is_callable =
+      ast_context.getLangOpts().CPlusPlus &&
+      analysis_cache_->HasSideEffects(*binary_operator_->getLHS());
+  const bool rhs_is_callable =
+      ast_context.getLangOpts().CPlusPlus &&
+      (binary_operator_->isLogicalOp() ||
+       analysis_cache_->HasSideEffects(*binary_operator_->getRHS()));
+
   std::stringstream new_function;
+  std::vector<std::string> template_parameters;
+  if (lhs_is_callable && !use_shared_runtime) {
+    template_parameters.emplace_back("Arg1");
+  }
+  if (rhs_is_callable && !use_shared_runtime) {
+    template_parameters.emplace_back("Arg2");
+  }
+  new_function << GetMutatorFunctionTemplateHeader(template_parameters);
   new_function << "static " << result_type << " " << function_name << "(";
 
-  if (ast_context.getLangOpts().CPlusPlus &&
-      binary_operator_->getLHS()->HasSideEffects(ast_context)) {
-    new_function << "std::function<" << lhs_type << "()>";
+  if (lhs_is_callable) {
+    new_function << GetMutatorFunctionCallableType(use_shared_runtime,
+                                                   lhs_type, "Arg1");
   } else {
     new_function << lhs_type;
   }
   new_function << " arg1, ";
 
-  if (ast_context.getLangOpts().CPlusPlus &&
-      (binary_operator_->isLogicalOp() ||
-       binary_operator_->getRHS()->HasSideEffects(ast_context))) {
-    new_function << "std::function<" << rhs_type << "()>";
+  if (rhs_is_callable) {
+    new_function << GetMutatorFunctionCallableType(use_shared_runtime,
+                                                   rhs_type, "Arg2");
   } else {
     new_function << rhs_type;
   }
@@ -465,8 +489,7 @@ std::string MutationReplaceBinaryOperator::GenerateMutatorFunction(
   int mutation_id_offset = 0;
 
   std::string arg1_evaluated("arg1");
-  if (ast_context.getLangOpts().CPlusPlus &&
-      binary_operator_->getLHS()->HasSideEffects(ast_context)) {
+  if (lhs_is_callable) {
     arg1_evaluated += "()";
   }
   if (!ast_context.getLangOpts().CPlusPlus &&
@@ -475,9 +498,7 @@ std::string MutationReplaceBinaryOperator::GenerateMutatorFunction(
   }
 
   std::string arg2_evaluated("arg2");
-  if (ast_context.getLangOpts().CPlusPlus &&
-      (binary_operator_->isLogicalOp() ||
-       binary_operator_->getRHS()->HasSideEffects(ast_context))) {
+  if (rhs_is_callable) {
     arg2_evaluated += "()";
   }
 
@@ -492,15 +513,22 @@ std::string MutationReplaceBinaryOperator::GenerateMutatorFunction(
                  << " " << arg2_evaluated << ";\n";
   }
 
+  // The mutants are generated as the cases of a switch statement.
+  std::stringstream switch_cases;
   GenerateBinaryOperatorReplacement(
-      arg1_evaluated, arg2_evaluated, ast_context, optimise_mutations,
-      only_track_mutant_coverage, mutation_id, new_function, mutation_id_offset,
-      protobuf_message);
-  GenerateArgumentReplacement(arg1_evaluated, arg2_evaluated, ast_context,
-                              optimise_mutations, only_track_mutant_coverage,
-                              mutation_id, new_function, mutation_id_offset,
+      arg1_evaluated, arg2_evaluated, optimise_mutations, mutation_selection,
+      only_track_mutant_coverage, mutation_id, switch_cases,
+      mutation_id_offset, protobuf_message);
+  GenerateArgumentReplacement(arg1_evaluated, arg2_evaluated,
+                              optimise_mutations, mutation_selection,
+                              only_track_mutant_coverage, mutation_id,
+                              switch_cases, mutation_id_offset,
                               protobuf_message);
 
+  if (!only_track_mutant_coverage && mutation_id_offset > 0) {
+    new_function << GetMutatorFunctionSwitch(mutation_id_offset,
+                                             switch_cases.str());
+  }
   if (only_track_mutant_coverage) {
     new_function << "  __dredd_record_covered_mutants(local_mutation_id, " +
                         std::to_string(mutation_id_offset) + ");\n";
@@ -523,8 +551,10 @@ std::string MutationReplaceBinaryOperator::GenerateMutatorFunction(
 protobufs::MutationGroup MutationReplaceBinaryOperator::Apply(
     clang::ASTContext& ast_context, const clang::Preprocessor& preprocessor,
     const Options& options, int first_mutation_id_in_file, int& mutation_id,
-    clang::Rewriter& rewriter,
+    EditList& edit_list,
     std::unordered_set<std::string>& dredd_declarations) const {
+  (void)preprocessor;  // Unused.
+
   // The protobuf object for the mutation, which will be wrapped in a
   // MutationGroup.
   protobufs::MutationReplaceBinaryOperator inner_result;
@@ -555,7 +585,8 @@ protobufs::MutationGroup MutationReplaceBinaryOperator::Apply(
   *inner_result.mutable_rhs_snippet() = info_for_rhs_.GetSnippet();
 
   const std::string new_function_name =
-      GetFunctionName(options.GetOptimiseMutations(), ast_context);
+      GetFunctionName(options.GetOptimiseMutations(), ast_context) +
+      GetMutatorFunctionNameSuffix(options);
   std::string result_type = binary_operator_->getType()
                                 ->getAs<clang::BuiltinType>()
                                 ->getName(ast_context.getPrintingPolicy())
@@ -576,10 +607,9 @@ protobufs::MutationGroup MutationReplaceBinaryOperator::Apply(
     // details). Rather than scattering this special treatment throughout the
     // logic for handling other operators, it is simpler to handle this case
     // separately.
-    HandleCLogicalOperator(
-        preprocessor, new_function_name, result_type, lhs_type, rhs_type,
-        options.GetOnlyTrackMutantCoverage(), first_mutation_id_in_file,
-        mutation_id, rewriter, dredd_declarations);
+    HandleCLogicalOperator(new_function_name, result_type, lhs_type, rhs_type,
+                           options, first_mutation_id_in_file, mutation_id,
+                           edit_list, dredd_declarations);
 
     protobufs::MutationGroup result;
     *result.mutable_replace_binary_operator() = inner_result;
@@ -606,12 +636,12 @@ protobufs::MutationGroup MutationReplaceBinaryOperator::Apply(
   }
 
   ReplaceOperator(lhs_type, rhs_type, new_function_name, ast_context,
-                  preprocessor, first_mutation_id_in_file, mutation_id,
-                  options.GetShowAstNodeTypes(), rewriter);
+                  first_mutation_id_in_file, mutation_id, options, edit_list);
 
   const std::string new_function = GenerateMutatorFunction(
       ast_context, new_function_name, result_type, lhs_type, rhs_type,
-      options.GetOptimiseMutations(), options.GetOnlyTrackMutantCoverage(),
+      options.GetOptimiseMutations(), options.GetMutationSelection(),
+      options.GetOnlyTrackMutantCoverage(), options.GetUseSharedRuntime(),
       mutation_id, inner_result);
   assert(!new_function.empty() && "Unsupported opcode.");
 
@@ -624,18 +654,54 @@ protobufs::MutationGroup MutationReplaceBinaryOperator::Apply(
   return result;
 }
 
+protobufs::MutationGroup MutationReplaceBinaryOperator::CountInstances(
+    clang::ASTContext& ast_context, const Options& options,
+    int& mutation_id) const {
+  protobufs::MutationReplaceBinaryOperator inner_result;
+
+  if (!ast_context.getLangOpts().CPlusPlus && binary_operator_->isLogicalOp()) {
+    // See HandleCLogicalOperator: the operator is swapped, or the expression is
+    // replaced with its LHS or with its RHS, for those of these actions that
+    // are enabled. Apply does not record these mutants individually, but they
+    // are reported here so that they are counted.
+    int mutation_id_offset = 0;
+    for (auto action : GetCLogicalOperatorActions(options)) {
+      AddMutationInstance(mutation_id, action, mutation_id_offset,
+                          inner_result);
+    }
+    mutation_id += mutation_id_offset;
+  } else {
+    // The mutants are decided exactly as when the mutator function is
+    // generated. Generating code only to track mutant coverage suppresses all
+    // code for individual mutants, so nothing is written to
+    // |unused_new_function|.
+    std::stringstream unused_new_function;
+    int mutation_id_offset = 0;
+    GenerateBinaryOperatorReplacement(
+        "arg1", "arg2", options.GetOptimiseMutations(),
+        options.GetMutationSelection(), true, mutation_id, unused_new_function,
+        mutation_id_offset, inner_result);
+    GenerateArgumentReplacement(
+        "arg1", "arg2", options.GetOptimiseMutations(),
+        options.GetMutationSelection(), true, mutation_id, unused_new_function,
+        mutation_id_offset, inner_result);
+    mutation_id += mutation_id_offset;
+  }
+
+  protobufs::MutationGroup result;
+  *result.mutable_replace_binary_operator() = inner_result;
+  return result;
+}
+
 void MutationReplaceBinaryOperator::ReplaceOperator(
     const std::string& lhs_type, const std::string& rhs_type,
     const std::string& new_function_name, clang::ASTContext& ast_context,
-    const clang::Preprocessor& preprocessor, int first_mutation_id_in_file,
-    int mutation_id, bool show_ast_node_types,
-    clang::Rewriter& rewriter) const {
+    int first_mutation_id_in_file, int mutation_id, const Options& options,
+    EditList& edit_list) const {
   const clang::SourceRange lhs_source_range_in_main_file =
-      GetSourceRangeInMainFile(preprocessor, *binary_operator_->getLHS());
-  assert(lhs_source_range_in_main_file.isValid() && "Invalid source range.");
+      info_for_lhs_.GetSourceRange();
   const clang::SourceRange rhs_source_range_in_main_file =
-      GetSourceRangeInMainFile(preprocessor, *binary_operator_->getRHS());
-  assert(rhs_source_range_in_main_file.isValid() && "Invalid source range.");
+      info_for_rhs_.GetSourceRange();
 
   // Replace the binary operator expression with a call to the wrapper
   // function.
@@ -650,11 +716,11 @@ void MutationReplaceBinaryOperator::ReplaceOperator(
   // - Inserting suitable text before and after each argument to the binary
   //   operator.
   // This is preferable over the (otherwise more intuitive) approach of directly
-  // replacing the text for the binary operator node, because the Clang rewriter
+  // replacing the text for the binary operator node, because the edit list
   // does not support nested replacements.
 
   // Replace the operator symbol with ","
-  rewriter.ReplaceText(
+  edit_list.ReplaceText(
       binary_operator_->getOperatorLoc(),
       static_cast<unsigned int>(
           clang::BinaryOperator::getOpcodeStr(binary_operator_->getOpcode())
@@ -664,7 +730,7 @@ void MutationReplaceBinaryOperator::ReplaceOperator(
   // These record the text that should be inserted before and after the LHS and
   // RHS operands.
   std::string lhs_prefix = new_function_name;
-  if (show_ast_node_types) {
+  if (options.GetShowAstNodeTypes()) {
     std::stringstream stringstream;
     stringstream << binary_operator_;
     lhs_prefix += "/*" + std::string(binary_operator_->getStmtClassName()) +
@@ -676,13 +742,13 @@ void MutationReplaceBinaryOperator::ReplaceOperator(
   std::string rhs_suffix;
 
   if (ast_context.getLangOpts().CPlusPlus) {
-    if (binary_operator_->getLHS()->HasSideEffects(ast_context)) {
+    if (analysis_cache_->HasSideEffects(*binary_operator_->getLHS())) {
       lhs_prefix.append("[&]() -> " + lhs_type + " { return static_cast<" +
                         lhs_type + ">(");
       lhs_suffix.append("); }");
     }
     if (binary_operator_->isLogicalOp() ||
-        binary_operator_->getRHS()->HasSideEffects(ast_context)) {
+        analysis_cache_->HasSideEffects(*binary_operator_->getRHS())) {
       rhs_prefix.append("[&]() -> " + rhs_type + " { return static_cast<" +
                         rhs_type + ">(");
       rhs_suffix.append("); }");
@@ -693,30 +759,31 @@ void MutationReplaceBinaryOperator::ReplaceOperator(
       lhs_suffix.append(")");
     }
   }
-  rhs_suffix.append(", " + std::to_string(local_mutation_id) + ")");
+  rhs_suffix.append(
+      ", " + GetMutatorFunctionMutationIdArgument(options, local_mutation_id) +
+      ")");
 
   // The prefixes and suffixes are ready, so make the relevant insertions.
-  bool rewriter_result = rewriter.InsertTextBefore(
+  bool edit_result = edit_list.InsertTextBefore(
       lhs_source_range_in_main_file.getBegin(), lhs_prefix);
-  assert(!rewriter_result && "Rewrite failed.\n");
-  rewriter_result = rewriter.InsertTextAfterToken(
+  assert(!edit_result && "Rewrite failed.\n");
+  edit_result = edit_list.InsertTextAfterToken(
       lhs_source_range_in_main_file.getEnd(), lhs_suffix);
-  assert(!rewriter_result && "Rewrite failed.\n");
-  rewriter_result = rewriter.InsertTextBefore(
+  assert(!edit_result && "Rewrite failed.\n");
+  edit_result = edit_list.InsertTextBefore(
       rhs_source_range_in_main_file.getBegin(), rhs_prefix);
-  assert(!rewriter_result && "Rewrite failed.\n");
-  rewriter_result = rewriter.InsertTextAfterToken(
+  assert(!edit_result && "Rewrite failed.\n");
+  edit_result = edit_list.InsertTextAfterToken(
       rhs_source_range_in_main_file.getEnd(), rhs_suffix);
-  assert(!rewriter_result && "Rewrite failed.\n");
-  (void)rewriter_result;  // Keep release-mode compilers happy.
+  assert(!edit_result && "Rewrite failed.\n");
+  (void)edit_result;  // Keep release-mode compilers happy.
 }
 
 void MutationReplaceBinaryOperator::HandleCLogicalOperator(
-    const clang::Preprocessor& preprocessor,
     const std::string& new_function_prefix, const std::string& result_type,
     const std::string& lhs_type, const std::string& rhs_type,
-    bool only_track_mutant_coverage, int first_mutation_id_in_file,
-    int& mutation_id, clang::Rewriter& rewriter,
+    const Options& options, int first_mutation_id_in_file,
+    int& mutation_id, EditList& edit_list,
     std::unordered_set<std::string>& dredd_declarations) const {
   // A C logical operator "op" is handled by transforming:
   //
@@ -738,19 +805,41 @@ void MutationReplaceBinaryOperator::HandleCLogicalOperator(
   // - Case 2: replacing the expression with "b", achieved by having the "outer"
   //   and "rhs" functions do nothing, and the "lhs" function return either 0 or
   //   1, depending on the operator.
-
-  if (!only_track_mutant_coverage) {
+  //
+  // Only the cases whose actions are enabled are handled, and they are given
+  // consecutive offsets from the base mutation id, in the above order.
+  const std::vector<protobufs::MutationReplaceBinaryOperatorAction> actions =
+      GetCLogicalOperatorActions(options);
+  auto get_offset =
+      [&actions](protobufs::MutationReplaceBinaryOperatorAction action) -> int {
+    auto iterator = std::find(actions.begin(), actions.end(), action);
+    return iterator == actions.end()
+               ? -1
+               : static_cast<int>(iterator - actions.begin());
+  };
+  const int swap_offset = get_offset(
+      binary_operator_->getOpcode() == clang::BinaryOperatorKind::BO_LAnd
+          ? protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithLOr
+          : protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithLAnd);
+  const int lhs_offset = get_offset(
+      protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithLHS);
+  const int rhs_offset = get_offset(
+      protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithRHS);
+
+  if (!options.GetOnlyTrackMutantCoverage()) {
     {
       // Rewrite the LHS of the expression, and introduce the associated
       // function.
-      auto source_range_lhs =
-          GetSourceRangeInMainFile(preprocessor, *binary_operator_->getLHS());
+      auto source_range_lhs = info_for_lhs_.GetSourceRange();
       const std::string lhs_function_name = new_function_prefix + "_lhs";
-      rewriter.InsertTextBefore(source_range_lhs.getBegin(),
-                                lhs_function_name + "(");
-      rewriter.InsertTextAfterToken(
+      edit_list.InsertTextBefore(source_range_lhs.getBegin(),
+                                 lhs_function_name + "(");
+      edit_list.InsertTextAfterToken(
           source_range_lhs.getEnd(),
-          ", " + std::to_string(mutation_id - first_mutation_id_in_file) + ")");
+          ", " +
+              GetMutatorFunctionMutationIdArgument(
+                  options, mutation_id - first_mutation_id_in_file) +
+              ")");
 
       std::stringstream lhs_function;
       lhs_function << "static " << lhs_type << " " << lhs_function_name << "("
@@ -760,22 +849,24 @@ void MutationReplaceBinaryOperator::HandleCLogicalOperator(
       // Replacing && with || is achieved by negating the whole expression, and
       // negating each of the LHS and RHS. The same holds for replacing || with
       // &&. This case handles negating the LHS.
-      lhs_function << "  if (__dredd_enabled_mutation(local_mutation_id + 0)) "
-                      "return !arg;\n";
+      if (swap_offset >= 0) {
+        lhs_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
+                     << swap_offset << ")) return !arg;\n";
+      }
 
       // Case 1: replacing with LHS: no action is needed here.
 
-      // Case 2: replacing with RHS.
-      if (binary_operator_->getOpcode() == clang::BinaryOperatorKind::BO_LAnd) {
-        // Replacing "a && b" with "b" is achieved by replacing "a" with "1".
-        lhs_function
-            << "  if (__dredd_enabled_mutation(local_mutation_id + 2)) "
-               "return 1;\n";
-      } else {
-        // Replacing "a || b" with "b" is achieved by replacing "a" with "0".
-        lhs_function
-            << "  if (__dredd_enabled_mutation(local_mutation_id + 2)) "
-               "return 0;\n";
+      // Case 2: replacing with RHS. Replacing "a && b" with "b" is achieved by
+      // replacing "a" with "1"; replacing "a || b" with "b" is achieved by
+      // replacing "a" with "0".
+      if (rhs_offset >= 0) {
+        lhs_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
+                     << rhs_offset << ")) return "
+                     << (binary_operator_->getOpcode() ==
+                                 clang::BinaryOperatorKind::BO_LAnd
+                             ? "1"
+                             : "0")
+                     << ";\n";
       }
       lhs_function << "  return arg;\n";
       lhs_function << "}\n";
@@ -785,14 +876,16 @@ void MutationReplaceBinaryOperator::HandleCLogicalOperator(
     {
       // Rewrite the RHS of the expression, and introduce the associated
       // function.
-      auto source_range_rhs =
-          GetSourceRangeInMainFile(preprocessor, *binary_operator_->getRHS());
+      auto source_range_rhs = info_for_rhs_.GetSourceRange();
       const std::string rhs_function_name = new_function_prefix + "_rhs";
-      rewriter.InsertTextBefore(source_range_rhs.getBegin(),
-                                rhs_function_name + "(");
-      rewriter.InsertTextAfterToken(
+      edit_list.InsertTextBefore(source_range_rhs.getBegin(),
+                                 rhs_function_name + "(");
+      edit_list.InsertTextAfterToken(
           source_range_rhs.getEnd(),
-          ", " + std::to_string(mutation_id - first_mutation_id_in_file) + ")");
+          ", " +
+              GetMutatorFunctionMutationIdArgument(
+                  options, mutation_id - first_mutation_id_in_file) +
+              ")");
 
       std::stringstream rhs_function;
       rhs_function << "static " << rhs_type << " " << rhs_function_name << "("
@@ -802,20 +895,22 @@ void MutationReplaceBinaryOperator::HandleCLogicalOperator(
       // Replacing && with || is achieved by negating the whole expression, and
       // negating each of the LHS and RHS. The same holds for replacing || with
       // &&. This case handles negating the RHS.
-      rhs_function << "  if (__dredd_enabled_mutation(local_mutation_id + 0)) "
-                      "return !arg;\n";
-
-      // Case 1: replacing with LHS.
-      if (binary_operator_->getOpcode() == clang::BinaryOperatorKind::BO_LAnd) {
-        // Replacing "a && b" with "a" is achieved by replacing "b" with "1".
-        rhs_function
-            << "  if (__dredd_enabled_mutation(local_mutation_id + 1)) "
-               "return 1;\n";
-      } else {
-        // Replacing "a || b" with "a" is achieved by replacing "b" with "0".
-        rhs_function
-            << "  if (__dredd_enabled_mutation(local_mutation_id + 1)) "
-               "return 0;\n";
+      if (swap_offset >= 0) {
+        rhs_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
+                     << swap_offset << ")) return !arg;\n";
+      }
+
+      // Case 1: replacing with LHS. Replacing "a && b" with "a" is achieved by
+      // replacing "b" with "1"; replacing "a || b" with "a" is achieved by
+      // replacing "b" with "0".
+      if (lhs_offset >= 0) {
+        rhs_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
+                     << lhs_offset << ")) return "
+                     << (binary_operator_->getOpcode() ==
+                                 clang::BinaryOperatorKind::BO_LAnd
+                             ? "1"
+                             : "0")
+                     << ";\n";
       }
 
       // Case 2: replacing with RHS: no action is needed here.
@@ -828,50 +923,70 @@ void MutationReplaceBinaryOperator::HandleCLogicalOperator(
 
   {
     // Rewrite the overall expression, and introduce the associated function.
-    auto source_range_binary_operator =
-        GetSourceRangeInMainFile(preprocessor, *binary_operator_);
+    auto source_range_binary_operator = info_for_overall_expr_.GetSourceRange();
     const std::string outer_function_name = new_function_prefix + "_outer";
-    rewriter.InsertTextBefore(source_range_binary_operator.getBegin(),
-                              outer_function_name + "(");
-    rewriter.InsertTextAfterToken(
+    edit_list.InsertTextBefore(source_range_binary_operator.getBegin(),
+                               outer_function_name + "(");
+    edit_list.InsertTextAfterToken(
         source_range_binary_operator.getEnd(),
-        ", " + std::to_string(mutation_id - first_mutation_id_in_file) + ")");
+        ", " +
+            GetMutatorFunctionMutationIdArgument(
+                options, mutation_id - first_mutation_id_in_file) +
+            ")");
 
     std::stringstream outer_function;
     outer_function << "static " << result_type << " " << outer_function_name
                    << "(" << result_type << " arg, int local_mutation_id) {\n";
-    if (!only_track_mutant_coverage) {
+    if (!options.GetOnlyTrackMutantCoverage()) {
       // Case 0: swapping the operator.
       // Replacing && with || is achieved by negating the whole expression, and
       // negating each of the LHS and RHS. The same holds for replacing || with
       // &&. This case handles negating the whole expression.
-      outer_function
-          << "  if (__dredd_enabled_mutation(local_mutation_id + 0)) "
-             "return !arg;\n";
+      if (swap_offset >= 0) {
+        outer_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
+                       << swap_offset << ")) return !arg;\n";
+      }
 
       // Case 1: replacing with LHS: no action is needed here.
 
       // Case 2: replacing with RHS: no action is needed here.
     }
-    if (only_track_mutant_coverage) {
-      // The fact that three mutants are covered is recorded, to reflect
-      // swapping the operator, replacing with LHS and replacing with RHS.
-      // It does not matter in which function this is recorded, but intuitively
-      // it seems most elegant for the function enclosing the whole expression
-      // to take care of it.
-      outer_function
-          << "  __dredd_record_covered_mutants(local_mutation_id, 3);\n";
+    if (options.GetOnlyTrackMutantCoverage()) {
+      // The fact that the enabled cases among swapping the operator, replacing
+      // with LHS and replacing with RHS are covered is recorded. It does not
+      // matter in which function this is recorded, but intuitively it seems
+      // most elegant for the function enclosing the whole expression to take
+      // care of it.
+      outer_function << "  __dredd_record_covered_mutants(local_mutation_id, "
+                     << actions.size() << ");\n";
     }
     outer_function << "  return arg;\n";
     outer_function << "}\n";
     dredd_declarations.insert(outer_function.str());
   }
 
-  // The mutation id is increased by 3 due to:
+  // The mutation id is increased by one for each enabled case out of:
   // - Swapping the operator
   // - Replacing with LHS
   // - Replacing with RHS
-  mutation_id += 3;
+  mutation_id += static_cast<int>(actions.size());
+}
+
+std::vector<protobufs::MutationReplaceBinaryOperatorAction>
+MutationReplaceBinaryOperator::GetCLogicalOperatorActions(
+    const Options& options) const {
+  std::vector<protobufs::MutationReplaceBinaryOperatorAction> result;
+  for (auto action :
+       {binary_operator_->getOpcode() == clang::BinaryOperatorKind::BO_LAnd
+            ? protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithLOr
+            : protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithLAnd,
+        protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithLHS,
+        protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithRHS}) {
+    if (options.GetMutationSelection().IsEnabled(action)) {
+      result.push_back(action);
+    }
+  }
+  return result;
 }
 
 void MutationReplaceBinaryOperator::AddMutationInstance(
@@ -1060,18 +1175,17 @@ bool MutationReplaceBinaryOperator::
 }
 
 bool MutationReplaceBinaryOperator::IsRedundantReplacementForArithmeticOperator(
-    clang::BinaryOperatorKind operator_kind,
-    const clang::ASTContext& ast_context) const {
+    clang::BinaryOperatorKind operator_kind) const {
   // In the case where both operands are 0, the only case that isn't covered
   // by constant replacement is undefined behaviour, this is achieved by /.
   if ((MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getLHS(),
-                                                  0, ast_context) ||
+                                                  0, *analysis_cache_) ||
        MutationReplaceExpr::ExprIsEquivalentToFloat(*binary_operator_->getLHS(),
-                                                    0.0, ast_context)) &&
+                                                    0.0, *analysis_cache_)) &&
       (MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getRHS(),
-                                                  0, ast_context) ||
+                                                  0, *analysis_cache_) ||
        MutationReplaceExpr::ExprIsEquivalentToFloat(*binary_operator_->getRHS(),
-                                                    0.0, ast_context))) {
+                                                    0.0, *analysis_cache_))) {
     if (operator_kind == clang::BO_Div) {
       return false;
     }
@@ -1080,9 +1194,9 @@ bool MutationReplaceBinaryOperator::IsRedundantReplacementForArithmeticOperator(
   // In the following cases, the replacement is equivalent to either replacement
   // with a constant or argument replacement.
   if ((MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getRHS(),
-                                                  0, ast_context) ||
+                                                  0, *analysis_cache_) ||
        MutationReplaceExpr::ExprIsEquivalentToFloat(*binary_operator_->getRHS(),
-                                                    0.0, ast_context))) {
+                                                    0.0, *analysis_cache_))) {
     // When the right operand is 0: +, -, << and >> are all equivalent to
     // replacement with the right operand; * is equivalent to replacement with
     // the constant 0 and % is equivalent to replacement with / in that both
@@ -1095,9 +1209,9 @@ bool MutationReplaceBinaryOperator::IsRedundantReplacementForArithmeticOperator(
   }
 
   if ((MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getRHS(),
-                                                  1, ast_context) ||
+                                                  1, *analysis_cache_) ||
        MutationReplaceExpr::ExprIsEquivalentToFloat(*binary_operator_->getRHS(),
-                                                    1.0, ast_context))) {
+                                                    1.0, *analysis_cache_))) {
     // When the right operand is 1: * and / are equivalent to replacement by
     // the left operand.
     if (operator_kind == clang::BO_Mul || operator_kind == clang::BO_Div) {
@@ -1106,9 +1220,9 @@ bool MutationReplaceBinaryOperator::IsRedundantReplacementForArithmeticOperator(
   }
 
   if ((MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getLHS(),
-                                                  0, ast_context) ||
+                                                  0, *analysis_cache_) ||
        MutationReplaceExpr::ExprIsEquivalentToFloat(*binary_operator_->getLHS(),
-                                                    0.0, ast_context))) {
+                                                    0.0, *analysis_cache_))) {
     // When the left operand is 0: *, /, %, << and >> are equivalent to
     // replacement by the constant 0 and + is equivalent to replacement by the
     // right operand.
@@ -1120,9 +1234,9 @@ bool MutationReplaceBinaryOperator::IsRedundantReplacementForArithmeticOperator(
   }
 
   if ((MutationReplaceExpr::ExprIsEquivalentToInt(*binary_operator_->getLHS(),
-                                                  1, ast_context) ||
+                                                  1, *analysis_cache_) ||
        MutationReplaceExpr::ExprIsEquivalentToFloat(*binary_operator_->getLHS(),
-                                                    1.0, ast_context)) &&
+                                                    1.0, *analysis_cache_)) &&
       operator_kind == clang::BO_Mul) {
     // When the left operand is 1: * is equivalent to replacement by the right
     // operand.
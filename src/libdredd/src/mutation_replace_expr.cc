@@ -17,20 +17,24 @@
 #include <cassert>
 #include <cctype>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include "clang/AST/APValue.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTTypeTraits.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/OperationKinds.h"
-#include "clang/AST/ParentMapContext.h"
 #include "clang/AST/Type.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Lex/Preprocessor.h"
-#include "clang/Rewrite/Core/Rewriter.h"
+#include "libdredd/edit_list.h"
+#include "libdredd/expr_analysis_cache.h"
+#include "libdredd/mutation_selection.h"
 #include "libdredd/options.h"
+#include "libdredd/stmt_parent_map.h"
 #include "libdredd/util.h"
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/APSInt.h"
@@ -59,11 +63,13 @@ bool PrecedingCharacterIsIdentifierCharacter(
 
 namespace dredd {
 dredd::MutationReplaceExpr::MutationReplaceExpr(
-    const clang::Expr& expr, const clang::Preprocessor& preprocessor,
-    const clang::ASTContext& ast_context)
+    const clang::Expr& expr, SourceRangeCache& source_range_cache,
+    const StmtParentMap& parent_map, ExprAnalysisCache& analysis_cache)
     : expr_(&expr),
-      info_for_source_range_(GetSourceRangeInMainFile(preprocessor, expr),
-                             ast_context) {}
+      parent_map_(&parent_map),
+      analysis_cache_(&analysis_cache),
+      info_for_source_range_(source_range_cache.GetSourceRangeInMainFile(expr),
+                             source_range_cache) {}
 
 std::string MutationReplaceExpr::GetFunctionName(
     bool optimise_mutations, clang::ASTContext& ast_context) const {
@@ -100,28 +106,27 @@ std::string MutationReplaceExpr::GetFunctionName(
 
 void MutationReplaceExpr::AddOptimisationSpecifier(
     clang::ASTContext& ast_context, std::string& function_name) const {
-  clang::Expr::EvalResult unused_eval_result;
   if ((expr_->getType()->isIntegerType() &&
        !expr_->getType()->isBooleanType()) ||
       expr_->getType()->isFloatingType()) {
-    if (ExprIsEquivalentToInt(*expr_, 0, ast_context) ||
-        ExprIsEquivalentToFloat(*expr_, 0.0, ast_context)) {
+    if (ExprIsEquivalentToInt(*expr_, 0, *analysis_cache_) ||
+        ExprIsEquivalentToFloat(*expr_, 0.0, *analysis_cache_)) {
       function_name += "_zero";
-    } else if (ExprIsEquivalentToInt(*expr_, 1, ast_context) ||
-               ExprIsEquivalentToFloat(*expr_, 1.0, ast_context)) {
+    } else if (ExprIsEquivalentToInt(*expr_, 1, *analysis_cache_) ||
+               ExprIsEquivalentToFloat(*expr_, 1.0, *analysis_cache_)) {
       function_name += "_one";
-    } else if (ExprIsEquivalentToInt(*expr_, -1, ast_context) ||
-               ExprIsEquivalentToFloat(*expr_, -1.0, ast_context)) {
+    } else if (ExprIsEquivalentToInt(*expr_, -1, *analysis_cache_) ||
+               ExprIsEquivalentToFloat(*expr_, -1.0, *analysis_cache_)) {
       function_name += "_minus_one";
-    } else if (EvaluateAsInt(*expr_, ast_context, unused_eval_result)) {
+    } else if (analysis_cache_->GetIntValue(*expr_).has_value()) {
       function_name += "_constant";
     }
   }
 
   if (expr_->getType()->isBooleanType()) {
-    if (ExprIsEquivalentToBool(*expr_, true, ast_context)) {
+    if (ExprIsEquivalentToBool(*expr_, true, *analysis_cache_)) {
       function_name += "_true";
-    } else if (ExprIsEquivalentToBool(*expr_, false, ast_context)) {
+    } else if (ExprIsEquivalentToBool(*expr_, false, *analysis_cache_)) {
       function_name += "_false";
     }
   }
@@ -140,13 +145,12 @@ void MutationReplaceExpr::AddOptimisationSpecifier(
 }
 
 bool MutationReplaceExpr::ExprIsEquivalentToInt(
-    const clang::Expr& expr, int constant,
-    const clang::ASTContext& ast_context) {
-  clang::Expr::EvalResult int_eval_result;
-  if (expr.getType()->isIntegerType() &&
-      EvaluateAsInt(expr, ast_context, int_eval_result)) {
-    return llvm::APSInt::isSameValue(int_eval_result.Val.getInt(),
-                                     llvm::APSInt::get(constant));
+    const clang::Expr& expr, int constant, ExprAnalysisCache& analysis_cache) {
+  if (expr.getType()->isIntegerType()) {
+    if (const auto int_eval_result = analysis_cache.GetIntValue(expr)) {
+      return llvm::APSInt::isSameValue(int_eval_result.value(),
+                                       llvm::APSInt::get(constant));
+    }
   }
 
   return false;
@@ -154,11 +158,11 @@ bool MutationReplaceExpr::ExprIsEquivalentToInt(
 
 bool MutationReplaceExpr::ExprIsEquivalentToFloat(
     const clang::Expr& expr, double constant,
-    const clang::ASTContext& ast_context) {
-  llvm::APFloat float_eval_result(static_cast<double>(0));
-  if (expr.getType()->isFloatingType() &&
-      EvaluateAsFloat(expr, ast_context, float_eval_result)) {
-    return float_eval_result.isExactlyValue(constant);
+    ExprAnalysisCache& analysis_cache) {
+  if (expr.getType()->isFloatingType()) {
+    if (const auto float_eval_result = analysis_cache.GetFloatValue(expr)) {
+      return float_eval_result.value().isExactlyValue(constant);
+    }
   }
 
   return false;
@@ -166,11 +170,11 @@ bool MutationReplaceExpr::ExprIsEquivalentToFloat(
 
 bool MutationReplaceExpr::ExprIsEquivalentToBool(
     const clang::Expr& expr, bool constant,
-    const clang::ASTContext& ast_context) {
-  bool bool_eval_result = false;
-  if (expr.getType()->isBooleanType() &&
-      EvaluateAsBooleanCondition(expr, ast_context, bool_eval_result)) {
-    return bool_eval_result == constant;
+    ExprAnalysisCache& analysis_cache) {
+  if (expr.getType()->isBooleanType()) {
+    if (const auto bool_eval_result = analysis_cache.GetBoolValue(expr)) {
+      return bool_eval_result.value() == constant;
+    }
   }
 
   return false;
@@ -189,11 +193,11 @@ bool MutationReplaceExpr::IsRedundantOperatorInsertion(
 
   switch (operator_kind) {
     case clang::UO_Minus:
-      return IsRedundantUnaryMinusInsertion(ast_context);
+      return IsRedundantUnaryMinusInsertion();
     case clang::UO_Not:
-      return IsRedundantUnaryNotInsertion(ast_context);
+      return IsRedundantUnaryNotInsertion();
     case clang::UO_LNot:
-      return IsRedundantUnaryLogicalNotInsertion(ast_context);
+      return IsRedundantUnaryLogicalNotInsertion();
     default:
       assert(false && "Unknown operator.");
       return false;
@@ -201,35 +205,41 @@ bool MutationReplaceExpr::IsRedundantOperatorInsertion(
 }
 
 void MutationReplaceExpr::GenerateUnaryOperatorInsertionBeforeLValue(
-    const std::string& arg_evaluated, clang::ASTContext& ast_context,
+    const std::string& arg_evaluated,
+    const MutationSelection& mutation_selection,
     bool only_track_mutant_coverage, int mutation_id_base,
     std::stringstream& new_function, int& mutation_id_offset,
     protobufs::MutationReplaceExpr& protobuf_message) const {
-  if (!expr_->isLValue() || !CanMutateLValue(ast_context, *expr_)) {
+  if (!expr_->isLValue() || !CanMutateLValue(*parent_map_, *expr_)) {
     return;
   }
-  if (!only_track_mutant_coverage) {
-    new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                 << mutation_id_offset << ")) return ++(" << arg_evaluated
-                 << ");\n";
+  if (mutation_selection.IsEnabled(
+          protobufs::MutationReplaceExprAction::InsertPreInc)) {
+    if (!only_track_mutant_coverage) {
+      new_function << "    case " << mutation_id_offset << ": return ++("
+                   << arg_evaluated << ");\n";
+    }
+    AddMutationInstance(mutation_id_base,
+                        protobufs::MutationReplaceExprAction::InsertPreInc,
+                        mutation_id_offset, protobuf_message);
   }
-  AddMutationInstance(mutation_id_base,
-                      protobufs::MutationReplaceExprAction::InsertPreInc,
-                      mutation_id_offset, protobuf_message);
 
-  if (!only_track_mutant_coverage) {
-    new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                 << mutation_id_offset << ")) return --(" << arg_evaluated
-                 << ");\n";
+  if (mutation_selection.IsEnabled(
+          protobufs::MutationReplaceExprAction::InsertPreDec)) {
+    if (!only_track_mutant_coverage) {
+      new_function << "    case " << mutation_id_offset << ": return --("
+                   << arg_evaluated << ");\n";
+    }
+    AddMutationInstance(mutation_id_base,
+                        protobufs::MutationReplaceExprAction::InsertPreDec,
+                        mutation_id_offset, protobuf_message);
   }
-  AddMutationInstance(mutation_id_base,
-                      protobufs::MutationReplaceExprAction::InsertPreDec,
-                      mutation_id_offset, protobuf_message);
 }
 
 void MutationReplaceExpr::GenerateUnaryOperatorInsertionBeforeNonLValue(
     const std::string& arg_evaluated, clang::ASTContext& ast_context,
-    bool optimise_mutations, bool only_track_mutant_coverage,
+    bool optimise_mutations, const MutationSelection& mutation_selection,
+    bool only_track_mutant_coverage,
     int mutation_id_base, std::stringstream& new_function,
     int& mutation_id_offset,
     protobufs::MutationReplaceExpr& protobuf_message) const {
@@ -240,12 +250,13 @@ void MutationReplaceExpr::GenerateUnaryOperatorInsertionBeforeNonLValue(
       *expr_->getType()->getAs<clang::BuiltinType>();
   // Insert '!'
   if (exprType.isBooleanType() || exprType.isInteger()) {
-    if (!optimise_mutations ||
-        !IsRedundantOperatorInsertion(ast_context, clang::UO_LNot)) {
+    if (mutation_selection.IsEnabled(
+            protobufs::MutationReplaceExprAction::InsertLNot) &&
+        (!optimise_mutations ||
+         !IsRedundantOperatorInsertion(ast_context, clang::UO_LNot))) {
       if (!only_track_mutant_coverage) {
-        new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                     << mutation_id_offset << ")) return !(" << arg_evaluated
-                     << ");\n";
+        new_function << "    case " << mutation_id_offset << ": return !("
+                     << arg_evaluated << ");\n";
       }
       AddMutationInstance(mutation_id_base,
                           protobufs::MutationReplaceExprAction::InsertLNot,
@@ -255,12 +266,13 @@ void MutationReplaceExpr::GenerateUnaryOperatorInsertionBeforeNonLValue(
 
   // Insert '~'
   if (exprType.isInteger() && !exprType.isBooleanType()) {
-    if (!optimise_mutations ||
-        !IsRedundantOperatorInsertion(ast_context, clang::UO_Not)) {
+    if (mutation_selection.IsEnabled(
+            protobufs::MutationReplaceExprAction::InsertNot) &&
+        (!optimise_mutations ||
+         !IsRedundantOperatorInsertion(ast_context, clang::UO_Not))) {
       if (!only_track_mutant_coverage) {
-        new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                     << mutation_id_offset << ")) return ~(" << arg_evaluated
-                     << ");\n";
+        new_function << "    case " << mutation_id_offset << ": return ~("
+                     << arg_evaluated << ");\n";
       }
       AddMutationInstance(mutation_id_base,
                           protobufs::MutationReplaceExprAction::InsertNot,
@@ -270,12 +282,13 @@ void MutationReplaceExpr::GenerateUnaryOperatorInsertionBeforeNonLValue(
 
   // Insert '-'
   if (exprType.isSignedInteger() || exprType.isFloatingPoint()) {
-    if (!optimise_mutations ||
-        !IsRedundantOperatorInsertion(ast_context, clang::UO_Minus)) {
+    if (mutation_selection.IsEnabled(
+            protobufs::MutationReplaceExprAction::InsertMinus) &&
+        (!optimise_mutations ||
+         !IsRedundantOperatorInsertion(ast_context, clang::UO_Minus))) {
       if (!only_track_mutant_coverage) {
-        new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                     << mutation_id_offset << ")) return -(" << arg_evaluated
-                     << ");\n";
+        new_function << "    case " << mutation_id_offset << ": return -("
+                     << arg_evaluated << ");\n";
       }
       AddMutationInstance(mutation_id_base,
                           protobufs::MutationReplaceExprAction::InsertMinus,
@@ -286,51 +299,54 @@ void MutationReplaceExpr::GenerateUnaryOperatorInsertionBeforeNonLValue(
 
 void MutationReplaceExpr::GenerateUnaryOperatorInsertion(
     const std::string& arg_evaluated, clang::ASTContext& ast_context,
-    bool optimise_mutations, bool only_track_mutant_coverage,
-    int mutation_id_base, std::stringstream& new_function,
-    int& mutation_id_offset,
+    bool optimise_mutations, const MutationSelection& mutation_selection,
+    bool only_track_mutant_coverage, int mutation_id_base,
+    std::stringstream& new_function, int& mutation_id_offset,
     protobufs::MutationReplaceExpr& protobuf_message) const {
   GenerateUnaryOperatorInsertionBeforeLValue(
-      arg_evaluated, ast_context, only_track_mutant_coverage, mutation_id_base,
-      new_function, mutation_id_offset, protobuf_message);
+      arg_evaluated, mutation_selection, only_track_mutant_coverage,
+      mutation_id_base, new_function, mutation_id_offset, protobuf_message);
   GenerateUnaryOperatorInsertionBeforeNonLValue(
-      arg_evaluated, ast_context, optimise_mutations,
+      arg_evaluated, ast_context, optimise_mutations, mutation_selection,
       only_track_mutant_coverage, mutation_id_base, new_function,
       mutation_id_offset, protobuf_message);
 }
 
 void MutationReplaceExpr::GenerateConstantReplacement(
     clang::ASTContext& ast_context, bool optimise_mutations,
+    const MutationSelection& mutation_selection,
     bool only_track_mutant_coverage, int mutation_id_base,
     std::stringstream& new_function, int& mutation_id_offset,
     protobufs::MutationReplaceExpr& protobuf_message) const {
   if (!expr_->isLValue()) {
     GenerateBooleanConstantReplacement(
-        ast_context, optimise_mutations, only_track_mutant_coverage,
-        mutation_id_base, new_function, mutation_id_offset, protobuf_message);
+        ast_context, optimise_mutations, mutation_selection,
+        only_track_mutant_coverage, mutation_id_base, new_function,
+        mutation_id_offset, protobuf_message);
     GenerateIntegerConstantReplacement(
-        ast_context, optimise_mutations, only_track_mutant_coverage,
+        optimise_mutations, mutation_selection, only_track_mutant_coverage,
         mutation_id_base, new_function, mutation_id_offset, protobuf_message);
     GenerateFloatConstantReplacement(
-        ast_context, optimise_mutations, only_track_mutant_coverage,
+        optimise_mutations, mutation_selection, only_track_mutant_coverage,
         mutation_id_base, new_function, mutation_id_offset, protobuf_message);
   }
 }
 
 void MutationReplaceExpr::GenerateFloatConstantReplacement(
-    const clang::ASTContext& ast_context, bool optimise_mutations,
+    bool optimise_mutations, const MutationSelection& mutation_selection,
     bool only_track_mutant_coverage, int mutation_id_base,
     std::stringstream& new_function, int& mutation_id_offset,
     protobufs::MutationReplaceExpr& protobuf_message) const {
   const clang::BuiltinType& exprType =
       *expr_->getType()->getAs<clang::BuiltinType>();
   if (exprType.isFloatingPoint()) {
-    if (!optimise_mutations ||
-        !ExprIsEquivalentToFloat(*expr_, 0.0, ast_context)) {
+    if (mutation_selection.IsEnabled(
+            protobufs::MutationReplaceExprAction::ReplaceWithZeroFloat) &&
+        (!optimise_mutations ||
+         !ExprIsEquivalentToFloat(*expr_, 0.0, *analysis_cache_))) {
       // Replace floating point expression with 0.0
       if (!only_track_mutant_coverage) {
-        new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                     << mutation_id_offset << ")) return 0.0;\n";
+        new_function << "    case " << mutation_id_offset << ": return 0.0;\n";
       }
       AddMutationInstance(
           mutation_id_base,
@@ -338,12 +354,13 @@ void MutationReplaceExpr::GenerateFloatConstantReplacement(
           mutation_id_offset, protobuf_message);
     }
 
-    if (!optimise_mutations ||
-        !ExprIsEquivalentToFloat(*expr_, 1.0, ast_context)) {
+    if (mutation_selection.IsEnabled(
+            protobufs::MutationReplaceExprAction::ReplaceWithOneFloat) &&
+        (!optimise_mutations ||
+         !ExprIsEquivalentToFloat(*expr_, 1.0, *analysis_cache_))) {
       // Replace floating point expression with 1.0
       if (!only_track_mutant_coverage) {
-        new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                     << mutation_id_offset << ")) return 1.0;\n";
+        new_function << "    case " << mutation_id_offset << ": return 1.0;\n";
       }
       AddMutationInstance(
           mutation_id_base,
@@ -351,12 +368,13 @@ void MutationReplaceExpr::GenerateFloatConstantReplacement(
           mutation_id_offset, protobuf_message);
     }
 
-    if (!optimise_mutations ||
-        !ExprIsEquivalentToFloat(*expr_, -1.0, ast_context)) {
+    if (mutation_selection.IsEnabled(
+            protobufs::MutationReplaceExprAction::ReplaceWithMinusOneFloat) &&
+        (!optimise_mutations ||
+         !ExprIsEquivalentToFloat(*expr_, -1.0, *analysis_cache_))) {
       // Replace floating point expression with -1.0
       if (!only_track_mutant_coverage) {
-        new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                     << mutation_id_offset << ")) return -1.0;\n";
+        new_function << "    case " << mutation_id_offset << ": return -1.0;\n";
       }
       AddMutationInstance(
           mutation_id_base,
@@ -366,18 +384,20 @@ void MutationReplaceExpr::GenerateFloatConstantReplacement(
   }
 }
 void MutationReplaceExpr::GenerateIntegerConstantReplacement(
-    const clang::ASTContext& ast_context, bool optimise_mutations,
+    bool optimise_mutations, const MutationSelection& mutation_selection,
     bool only_track_mutant_coverage, int mutation_id_base,
     std::stringstream& new_function, int& mutation_id_offset,
     protobufs::MutationReplaceExpr& protobuf_message) const {
   const clang::BuiltinType& exprType =
       *expr_->getType()->getAs<clang::BuiltinType>();
   if (exprType.isInteger() && !exprType.isBooleanType()) {
-    if (!optimise_mutations || !ExprIsEquivalentToInt(*expr_, 0, ast_context)) {
+    if (mutation_selection.IsEnabled(
+            protobufs::MutationReplaceExprAction::ReplaceWithZeroInt) &&
+        (!optimise_mutations ||
+         !ExprIsEquivalentToInt(*expr_, 0, *analysis_cache_))) {
       // Replace expression with 0
       if (!only_track_mutant_coverage) {
-        new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                     << mutation_id_offset << ")) return 0;\n";
+        new_function << "    case " << mutation_id_offset << ": return 0;\n";
       }
       AddMutationInstance(
           mutation_id_base,
@@ -385,11 +405,13 @@ void MutationReplaceExpr::GenerateIntegerConstantReplacement(
           mutation_id_offset, protobuf_message);
     }
 
-    if (!optimise_mutations || !ExprIsEquivalentToInt(*expr_, 1, ast_context)) {
+    if (mutation_selection.IsEnabled(
+            protobufs::MutationReplaceExprAction::ReplaceWithOneInt) &&
+        (!optimise_mutations ||
+         !ExprIsEquivalentToInt(*expr_, 1, *analysis_cache_))) {
       // Replace expression with 1
       if (!only_track_mutant_coverage) {
-        new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                     << mutation_id_offset << ")) return 1;\n";
+        new_function << "    case " << mutation_id_offset << ": return 1;\n";
       }
       AddMutationInstance(
           mutation_id_base,
@@ -399,12 +421,13 @@ void MutationReplaceExpr::GenerateIntegerConstantReplacement(
   }
 
   if (exprType.isSignedInteger()) {
-    if (!optimise_mutations ||
-        !ExprIsEquivalentToInt(*expr_, -1, ast_context)) {
+    if (mutation_selection.IsEnabled(
+            protobufs::MutationReplaceExprAction::ReplaceWithMinusOneInt) &&
+        (!optimise_mutations ||
+         !ExprIsEquivalentToInt(*expr_, -1, *analysis_cache_))) {
       // Replace signed integer expression with -1
       if (!only_track_mutant_coverage) {
-        new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                     << mutation_id_offset << ")) return -1;\n";
+        new_function << "    case " << mutation_id_offset << ": return -1;\n";
       }
       AddMutationInstance(
           mutation_id_base,
@@ -415,19 +438,22 @@ void MutationReplaceExpr::GenerateIntegerConstantReplacement(
 }
 void MutationReplaceExpr::GenerateBooleanConstantReplacement(
     clang::ASTContext& ast_context, bool optimise_mutations,
+    const MutationSelection& mutation_selection,
     bool only_track_mutant_coverage, int mutation_id_base,
     std::stringstream& new_function, int& mutation_id_offset,
     protobufs::MutationReplaceExpr& protobuf_message) const {
   const clang::BuiltinType& exprType =
       *expr_->getType()->getAs<clang::BuiltinType>();
   if (exprType.isBooleanType()) {
-    if (!optimise_mutations ||
-        (!ExprIsEquivalentToBool(*expr_, true, ast_context) &&
-         !IsBooleanReplacementRedundantForBinaryOperator(true, ast_context))) {
+    if (mutation_selection.IsEnabled(
+            protobufs::MutationReplaceExprAction::ReplaceWithTrue) &&
+        (!optimise_mutations ||
+         (!ExprIsEquivalentToBool(*expr_, true, *analysis_cache_) &&
+          !IsBooleanReplacementRedundantForBinaryOperator(true,
+                                                          ast_context)))) {
       // Replace expression with true
       if (!only_track_mutant_coverage) {
-        new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                     << mutation_id_offset << ")) return "
+        new_function << "    case " << mutation_id_offset << ": return "
                      << (ast_context.getLangOpts().CPlusPlus ? "true" : "1")
                      << ";\n";
       }
@@ -436,13 +462,15 @@ void MutationReplaceExpr::GenerateBooleanConstantReplacement(
                           mutation_id_offset, protobuf_message);
     }
 
-    if (!optimise_mutations ||
-        (!ExprIsEquivalentToBool(*expr_, false, ast_context) &&
-         !IsBooleanReplacementRedundantForBinaryOperator(false, ast_context))) {
+    if (mutation_selection.IsEnabled(
+            protobufs::MutationReplaceExprAction::ReplaceWithFalse) &&
+        (!optimise_mutations ||
+         (!ExprIsEquivalentToBool(*expr_, false, *analysis_cache_) &&
+          !IsBooleanReplacementRedundantForBinaryOperator(false,
+                                                          ast_context)))) {
       // Replace expression with false
       if (!only_track_mutant_coverage) {
-        new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                     << mutation_id_offset << ")) return "
+        new_function << "    case " << mutation_id_offset << ": return "
                      << (ast_context.getLangOpts().CPlusPlus ? "false" : "0")
                      << ";\n";
       }
@@ -457,13 +485,21 @@ void MutationReplaceExpr::GenerateBooleanConstantReplacement(
 std::string MutationReplaceExpr::GenerateMutatorFunction(
     clang::ASTContext& ast_context, const std::string& function_name,
     const std::string& result_type, const std::string& input_type,
-    bool optimise_mutations, bool only_track_mutant_coverage, int& mutation_id,
-    protobufs::MutationReplaceExpr& protobuf_message) const {
+    bool optimise_mutations, const MutationSelection& mutation_selection,
+    bool only_track_mutant_coverage, bool use_shared_runtime,
+    int& mutation_id, protobufs::MutationReplaceExpr& protobuf_message) const {
   std::stringstream new_function;
+  std::vector<std::string> template_parameters;
+  if (ast_context.getLangOpts().CPlusPlus &&
+      analysis_cache_->HasSideEffects(*expr_) && !use_shared_runtime) {
+    template_parameters.emplace_back("Arg");
+  }
+  new_function << GetMutatorFunctionTemplateHeader(template_parameters);
   new_function << "static " << result_type << " " << function_name << "(";
   if (ast_context.getLangOpts().CPlusPlus &&
-      expr_->HasSideEffects(ast_context)) {
-    new_function << "std::function<" << input_type << "()>";
+      analysis_cache_->HasSideEffects(*expr_)) {
+    new_function << GetMutatorFunctionCallableType(use_shared_runtime,
+                                                   input_type, "Arg");
   } else {
     new_function << input_type;
   }
@@ -471,7 +507,7 @@ std::string MutationReplaceExpr::GenerateMutatorFunction(
 
   std::string arg_evaluated = "arg";
   if (ast_context.getLangOpts().CPlusPlus &&
-      expr_->HasSideEffects(ast_context)) {
+      analysis_cache_->HasSideEffects(*expr_)) {
     arg_evaluated += "()";
   }
 
@@ -488,14 +524,21 @@ std::string MutationReplaceExpr::GenerateMutatorFunction(
 
   int mutation_id_offset = 0;
 
-  GenerateUnaryOperatorInsertion(arg_evaluated, ast_context, optimise_mutations,
-                                 only_track_mutant_coverage, mutation_id,
-                                 new_function, mutation_id_offset,
-                                 protobuf_message);
-  GenerateConstantReplacement(
-      ast_context, optimise_mutations, only_track_mutant_coverage, mutation_id,
-      new_function, mutation_id_offset, protobuf_message);
-
+  // The mutants are generated as the cases of a switch statement.
+  std::stringstream switch_cases;
+  GenerateUnaryOperatorInsertion(
+      arg_evaluated, ast_context, optimise_mutations, mutation_selection,
+      only_track_mutant_coverage, mutation_id, switch_cases, mutation_id_offset,
+      protobuf_message);
+  GenerateConstantReplacement(ast_context, optimise_mutations,
+                              mutation_selection, only_track_mutant_coverage,
+                              mutation_id, switch_cases, mutation_id_offset,
+                              protobuf_message);
+
+  if (!only_track_mutant_coverage && mutation_id_offset > 0) {
+    new_function << GetMutatorFunctionSwitch(mutation_id_offset,
+                                             switch_cases.str());
+  }
   if (only_track_mutant_coverage) {
     new_function << "  __dredd_record_covered_mutants(local_mutation_id, " +
                         std::to_string(mutation_id_offset) + ");\n";
@@ -538,19 +581,18 @@ void MutationReplaceExpr::ApplyCTypeModifiers(const clang::Expr& expr,
 void MutationReplaceExpr::ReplaceExprWithFunctionCall(
     const std::string& new_function_name, const std::string& input_type,
     int local_mutation_id, clang::ASTContext& ast_context,
-    const clang::Preprocessor& preprocessor, bool show_ast_node_types,
-    clang::Rewriter& rewriter) const {
+    const Options& options, EditList& edit_list) const {
   // Replacement of an expression with a function call is simulated by
   // Inserting suitable text before and after the expression.
   // This is preferable over the (otherwise more intuitive) approach of directly
-  // replacing the text for the expression node, because the Clang rewriter
+  // replacing the text for the expression node, because the edit list
   // does not support nested replacements.
 
   // These record the text that should be inserted before and after the
   // expression.
   std::string prefix = new_function_name;
 
-  if (show_ast_node_types) {
+  if (options.GetShowAstNodeTypes()) {
     std::stringstream stringstream;
     stringstream << expr_;
     prefix += "/*" + std::string(expr_->getStmtClassName()) + " " +
@@ -561,13 +603,13 @@ void MutationReplaceExpr::ReplaceExprWithFunctionCall(
   std::string suffix;
 
   if (ast_context.getLangOpts().CPlusPlus &&
-      expr_->HasSideEffects(ast_context)) {
+      analysis_cache_->HasSideEffects(*expr_)) {
     prefix.append(+"[&]() -> " + input_type + " { return " +
                   // We don't need to static cast constant expressions
-                  (IsCxx11ConstantExpr(*expr_, ast_context)
+                  (analysis_cache_->IsCxx11ConstantExpr(*expr_)
                        ? ""
                        : "static_cast<" + input_type + ">("));
-    suffix.append(IsCxx11ConstantExpr(*expr_, ast_context) ? "" : ")");
+    suffix.append(analysis_cache_->IsCxx11ConstantExpr(*expr_) ? "" : ")");
     suffix.append("; }");
   }
 
@@ -586,7 +628,9 @@ void MutationReplaceExpr::ReplaceExprWithFunctionCall(
     }
   }
 
-  suffix.append(", " + std::to_string(local_mutation_id) + ")");
+  suffix.append(
+      ", " + GetMutatorFunctionMutationIdArgument(options, local_mutation_id) +
+      ")");
 
   // The following code handles a tricky special case, where constant values are
   // used in an initializer list in a manner that leads to them being implicitly
@@ -596,16 +640,17 @@ void MutationReplaceExpr::ReplaceExprWithFunctionCall(
   // For the following check to work, we need to move up any enclosing
   // parentheses.
   const auto* deparenthesis_expr = expr_;
-  while (const auto* paren_expr = GetFirstParentOfType<clang::ParenExpr>(
-             *deparenthesis_expr, ast_context)) {
+  while (const auto* paren_expr =
+             parent_map_->GetFirstParentOfType<clang::ParenExpr>(
+                 *deparenthesis_expr)) {
     deparenthesis_expr = paren_expr;
   }
   if (IsSubjectToImplicitCastInInitializerList(*deparenthesis_expr,
-                                               ast_context)) {
+                                               *parent_map_)) {
     // Add an explicit cast to the result type of the explicit cast.
     const auto* implicit_cast_expr =
-        GetFirstParentOfType<clang::ImplicitCastExpr>(*deparenthesis_expr,
-                                                      ast_context);
+        parent_map_->GetFirstParentOfType<clang::ImplicitCastExpr>(
+            *deparenthesis_expr);
     prefix = "static_cast<" +
              implicit_cast_expr->getType()
                  ->getAs<clang::BuiltinType>()
@@ -616,8 +661,7 @@ void MutationReplaceExpr::ReplaceExprWithFunctionCall(
   }
 
   const clang::SourceRange expr_source_range_in_main_file =
-      GetSourceRangeInMainFile(preprocessor, *expr_);
-  assert(expr_source_range_in_main_file.isValid() && "Invalid source range.");
+      info_for_source_range_.GetSourceRange();
 
   // Insert a space before the function call if the preceding character could
   // belong to an identifier. This is to guard against the case where the
@@ -629,20 +673,22 @@ void MutationReplaceExpr::ReplaceExprWithFunctionCall(
     prefix = " " + prefix;
   }
 
-  bool rewriter_result = rewriter.InsertTextBefore(
+  bool edit_result = edit_list.InsertTextBefore(
       expr_source_range_in_main_file.getBegin(), prefix);
-  assert(!rewriter_result && "Rewrite failed.\n");
-  rewriter_result = rewriter.InsertTextAfterToken(
+  assert(!edit_result && "Rewrite failed.\n");
+  edit_result = edit_list.InsertTextAfterToken(
       expr_source_range_in_main_file.getEnd(), suffix);
-  assert(!rewriter_result && "Rewrite failed.\n");
-  (void)rewriter_result;  // Keep release mode compilers happy.
+  assert(!edit_result && "Rewrite failed.\n");
+  (void)edit_result;  // Keep release mode compilers happy.
 }
 
 protobufs::MutationGroup MutationReplaceExpr::Apply(
     clang::ASTContext& ast_context, const clang::Preprocessor& preprocessor,
     const Options& options, int first_mutation_id_in_file, int& mutation_id,
-    clang::Rewriter& rewriter,
+    EditList& edit_list,
     std::unordered_set<std::string>& dredd_declarations) const {
+  (void)preprocessor;  // Unused.
+
   // The protobuf object for the mutation, which will be wrapped in a
   // MutationGroup.
   protobufs::MutationReplaceExpr inner_result;
@@ -655,7 +701,8 @@ protobufs::MutationGroup MutationReplaceExpr::Apply(
   *inner_result.mutable_snippet() = info_for_source_range_.GetSnippet();
 
   const std::string new_function_name =
-      GetFunctionName(options.GetOptimiseMutations(), ast_context);
+      GetFunctionName(options.GetOptimiseMutations(), ast_context) +
+      GetMutatorFunctionNameSuffix(options);
   const std::string result_type = expr_->getType()
                                       ->getAs<clang::BuiltinType>()
                                       ->getName(ast_context.getPrintingPolicy())
@@ -677,11 +724,12 @@ protobufs::MutationGroup MutationReplaceExpr::Apply(
   // |mutation_id|, into a file-local mutation id.
   ReplaceExprWithFunctionCall(
       new_function_name, input_type, mutation_id - first_mutation_id_in_file,
-      ast_context, preprocessor, options.GetShowAstNodeTypes(), rewriter);
+      ast_context, options, edit_list);
 
   const std::string new_function = GenerateMutatorFunction(
       ast_context, new_function_name, result_type, input_type,
-      options.GetOptimiseMutations(), options.GetOnlyTrackMutantCoverage(),
+      options.GetOptimiseMutations(), options.GetMutationSelection(),
+      options.GetOnlyTrackMutantCoverage(), options.GetUseSharedRuntime(),
       mutation_id, inner_result);
   assert(!new_function.empty() && "Unsupported expression.");
 
@@ -692,7 +740,32 @@ protobufs::MutationGroup MutationReplaceExpr::Apply(
   return result;
 }
 
-bool MutationReplaceExpr::CanMutateLValue(clang::ASTContext& ast_context,
+protobufs::MutationGroup MutationReplaceExpr::CountInstances(
+    clang::ASTContext& ast_context, const Options& options,
+    int& mutation_id) const {
+  protobufs::MutationReplaceExpr inner_result;
+
+  // The mutants are decided exactly as when the mutator function is generated.
+  // Generating code only to track mutant coverage suppresses all code for
+  // individual mutants, so nothing is written to |unused_new_function|.
+  std::stringstream unused_new_function;
+  int mutation_id_offset = 0;
+  GenerateUnaryOperatorInsertion(
+      "arg", ast_context, options.GetOptimiseMutations(),
+      options.GetMutationSelection(), true, mutation_id, unused_new_function,
+      mutation_id_offset, inner_result);
+  GenerateConstantReplacement(ast_context, options.GetOptimiseMutations(),
+                              options.GetMutationSelection(), true,
+                              mutation_id, unused_new_function,
+                              mutation_id_offset, inner_result);
+  mutation_id += mutation_id_offset;
+
+  protobufs::MutationGroup result;
+  *result.mutable_replace_expr() = inner_result;
+  return result;
+}
+
+bool MutationReplaceExpr::CanMutateLValue(const StmtParentMap& parent_map,
                                           const clang::Expr& expr) {
   assert(expr.isLValue() &&
          "Method should only be invoked on an l-value expression.");
@@ -708,7 +781,7 @@ bool MutationReplaceExpr::CanMutateLValue(clang::ASTContext& ast_context,
   // The following checks that `expr` is the child of an ImplicitCastExpr that
   // yields an r-value.
   const auto* implicit_cast_expr =
-      GetFirstParentOfType<clang::ImplicitCastExpr>(expr, ast_context);
+      parent_map.GetFirstParentOfType<clang::ImplicitCastExpr>(expr);
   if (implicit_cast_expr == nullptr || implicit_cast_expr->isLValue()) {
     return false;
   }
@@ -758,13 +831,12 @@ bool MutationReplaceExpr::IsBooleanReplacementRedundantForBinaryOperator(
   return false;
 }
 
-bool MutationReplaceExpr::IsRedundantUnaryMinusInsertion(
-    const clang::ASTContext& ast_context) const {
+bool MutationReplaceExpr::IsRedundantUnaryMinusInsertion() const {
   // It never makes sense to insert '-' before 0 as this would lead to an
   // equivalent mutant. (Technically this may not be true for floating-point
   // due to two values of 0, but the mutant is likely to be equivalent.)
-  if (ExprIsEquivalentToInt(*expr_, 0, ast_context) ||
-      ExprIsEquivalentToFloat(*expr_, 0.0, ast_context)) {
+  if (ExprIsEquivalentToInt(*expr_, 0, *analysis_cache_) ||
+      ExprIsEquivalentToFloat(*expr_, 0.0, *analysis_cache_)) {
     return true;
   }
 
@@ -772,42 +844,38 @@ bool MutationReplaceExpr::IsRedundantUnaryMinusInsertion(
   // to insert '-' before 1 or -1, as these cases are captured by
   // replacement with -1 and 1, respectively.
   if (expr_->getType()->isSignedIntegerType() &&
-      (ExprIsEquivalentToInt(*expr_, 1, ast_context) ||
-       ExprIsEquivalentToInt(*expr_, -1, ast_context))) {
+      (ExprIsEquivalentToInt(*expr_, 1, *analysis_cache_) ||
+       ExprIsEquivalentToInt(*expr_, -1, *analysis_cache_))) {
     return true;
   }
-  if (ExprIsEquivalentToFloat(*expr_, 1.0, ast_context) ||
-      ExprIsEquivalentToFloat(*expr_, -1.0, ast_context)) {
+  if (ExprIsEquivalentToFloat(*expr_, 1.0, *analysis_cache_) ||
+      ExprIsEquivalentToFloat(*expr_, -1.0, *analysis_cache_)) {
     return true;
   }
   return false;
 }
 
-bool MutationReplaceExpr::IsRedundantUnaryNotInsertion(
-    const clang::ASTContext& ast_context) const {
+bool MutationReplaceExpr::IsRedundantUnaryNotInsertion() const {
   // If the expression is signed, it does not make sense to insert '~'
   // before 0 or -1, as these cases are captured by replacement with -1 and
   // 0, respectively.
   if (expr_->getType()->isSignedIntegerType() &&
-      (ExprIsEquivalentToInt(*expr_, 0, ast_context) ||
-       ExprIsEquivalentToInt(*expr_, -1, ast_context))) {
+      (ExprIsEquivalentToInt(*expr_, 0, *analysis_cache_) ||
+       ExprIsEquivalentToInt(*expr_, -1, *analysis_cache_))) {
     return true;
   }
   return false;
 }
 
-bool MutationReplaceExpr::IsRedundantUnaryLogicalNotInsertion(
-    const clang::ASTContext& ast_context) const {
+bool MutationReplaceExpr::IsRedundantUnaryLogicalNotInsertion() const {
   // If the expression is a boolean constant, it does not make sense to
   // insert '!' because this is captured by replacement with the other
   // boolean constant.
 
-  // We use this value to capture the value that the expression evaluates
-  // to if it does indeed evaluate to a constant, but we do not use this
-  // value because either way, operator insertion would be redundant.
-  bool unused_bool_value;
+  // The value that the expression evaluates to is not used, because either
+  // way, operator insertion would be redundant.
   if (expr_->getType()->isBooleanType() &&
-      EvaluateAsBooleanCondition(*expr_, ast_context, unused_bool_value)) {
+      analysis_cache_->GetBoolValue(*expr_).has_value()) {
     return true;
   }
 
@@ -815,10 +883,9 @@ bool MutationReplaceExpr::IsRedundantUnaryLogicalNotInsertion(
   // insert '!' as the result will either be 0 or 1, which is captured by
   // constant replacement.
 
-  // Similarly, this value is not used as it does not matter which constant
-  // integer the expression evaluates to.
-  clang::Expr::EvalResult unused_result_value;
-  if (EvaluateAsInt(*expr_, ast_context, unused_result_value)) {
+  // Similarly, it does not matter which constant integer the expression
+  // evaluates to.
+  if (analysis_cache_->GetIntValue(*expr_).has_value()) {
     return true;
   }
 
@@ -876,7 +943,7 @@ bool MutationReplaceExpr::
   }
 
   if (const auto* binary_operator =
-          GetFirstParentOfType<clang::BinaryOperator>(*expr_, ast_context)) {
+          parent_map_->GetFirstParentOfType<clang::BinaryOperator>(*expr_)) {
     if (binary_operator->isLogicalOp() &&
         (binary_operator->getLHS() == expr_ ||
          binary_operator->getRHS() == expr_)) {
@@ -887,19 +954,17 @@ bool MutationReplaceExpr::
 }
 
 bool MutationReplaceExpr::IsSubjectToImplicitCastInInitializerList(
-    const clang::Expr& expr, clang::ASTContext& ast_context) {
+    const clang::Expr& expr, const StmtParentMap& parent_map) {
   // The expression that occurs in an initializer list and is then subject to an
-  // explicit cast will have at least two parents: the initializer list and the
-  // implicit cast. (This is probably due to implicit casts being treated as
-  // invisible nodes in the AST.) In the presence of templates there may in
-  // fact be multiple parents of type InitListExpr - one for the uninstantiated
-  // version of the initializer list, and one for the instantiated version.
+  // explicit cast will have at least two parents: the syntactic form of the
+  // initializer list, and the implicit cast in the semantic form of the
+  // initializer list.
   bool found_implicit_cast_parent = false;
   bool found_initializer_list_parent = false;
-  for (const auto& parent : ast_context.getParents<clang::Expr>(expr)) {
-    if (parent.get<clang::ImplicitCastExpr>() != nullptr) {
+  for (const auto* parent : parent_map.GetParents(expr)) {
+    if (llvm::dyn_cast<clang::ImplicitCastExpr>(parent) != nullptr) {
       found_implicit_cast_parent = true;
-    } else if (parent.get<clang::InitListExpr>() != nullptr) {
+    } else if (llvm::dyn_cast<clang::InitListExpr>(parent) != nullptr) {
       found_initializer_list_parent = true;
     }
   }
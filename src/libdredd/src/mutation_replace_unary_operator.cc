@@ -25,8 +25,10 @@
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Lex/Preprocessor.h"
-#include "clang/Rewrite/Core/Rewriter.h"
+#include "libdredd/edit_list.h"
+#include "libdredd/expr_analysis_cache.h"
 #include "libdredd/mutation_replace_expr.h"
+#include "libdredd/mutation_selection.h"
 #include "libdredd/options.h"
 #include "libdredd/util.h"
 #include "llvm/ADT/StringRef.h"
@@ -35,14 +37,15 @@ namespace dredd {
 
 MutationReplaceUnaryOperator::MutationReplaceUnaryOperator(
     const clang::UnaryOperator& unary_operator,
-    const clang::Preprocessor& preprocessor,
-    const clang::ASTContext& ast_context)
+    SourceRangeCache& source_range_cache, ExprAnalysisCache& analysis_cache)
     : unary_operator_(&unary_operator),
       info_for_overall_expr_(
-          GetSourceRangeInMainFile(preprocessor, unary_operator), ast_context),
-      info_for_sub_expr_(
-          GetSourceRangeInMainFile(preprocessor, *unary_operator.getSubExpr()),
-          ast_context) {}
+          source_range_cache.GetSourceRangeInMainFile(unary_operator),
+          source_range_cache),
+      info_for_sub_expr_(source_range_cache.GetSourceRangeInMainFile(
+                             *unary_operator.getSubExpr()),
+                         source_range_cache),
+      analysis_cache_(&analysis_cache) {}
 
 bool MutationReplaceUnaryOperator::IsPrefix(
     clang::UnaryOperatorKind operator_kind) {
@@ -155,23 +158,23 @@ std::string MutationReplaceUnaryOperator::GetFunctionName(
   // be optimised.
   if (optimise_mutations) {
     if (MutationReplaceExpr::ExprIsEquivalentToInt(
-            *unary_operator_->getSubExpr(), 0, ast_context) ||
+            *unary_operator_->getSubExpr(), 0, *analysis_cache_) ||
         MutationReplaceExpr::ExprIsEquivalentToFloat(
-            *unary_operator_->getSubExpr(), 0.0, ast_context)) {
+            *unary_operator_->getSubExpr(), 0.0, *analysis_cache_)) {
       result += "_zero";
     }
 
     if (MutationReplaceExpr::ExprIsEquivalentToInt(
-            *unary_operator_->getSubExpr(), 1, ast_context) ||
+            *unary_operator_->getSubExpr(), 1, *analysis_cache_) ||
         MutationReplaceExpr::ExprIsEquivalentToFloat(
-            *unary_operator_->getSubExpr(), 1.0, ast_context)) {
+            *unary_operator_->getSubExpr(), 1.0, *analysis_cache_)) {
       result += "_one";
     }
 
     if (MutationReplaceExpr::ExprIsEquivalentToInt(
-            *unary_operator_->getSubExpr(), -1, ast_context) ||
+            *unary_operator_->getSubExpr(), -1, *analysis_cache_) ||
         MutationReplaceExpr::ExprIsEquivalentToFloat(
-            *unary_operator_->getSubExpr(), -1.0, ast_context)) {
+            *unary_operator_->getSubExpr(), -1.0, *analysis_cache_)) {
       result += "_minus_one";
     }
   }
@@ -182,13 +185,23 @@ std::string MutationReplaceUnaryOperator::GetFunctionName(
 std::string MutationReplaceUnaryOperator::GenerateMutatorFunction(
     clang::ASTContext& ast_context, const std::string& function_name,
     const std::string& result_type, const std::string& input_type,
-    bool optimise_mutations, bool only_track_mutant_coverage, int& mutation_id,
+    bool optimise_mutations, const MutationSelection& mutation_selection,
+    bool only_track_mutant_coverage, bool use_shared_runtime,
+    int& mutation_id,
     protobufs::MutationReplaceUnaryOperator& protobuf_message) const {
   std::stringstream new_function;
+  std::vector<std::string> template_parameters;
+  if (ast_context.getLangOpts().CPlusPlus &&
+      analysis_cache_->HasSideEffects(*unary_operator_) &&
+      !use_shared_runtime) {
+    template_parameters.emplace_back("Arg");
+  }
+  new_function << GetMutatorFunctionTemplateHeader(template_parameters);
   new_function << "static " << result_type << " " << function_name << "(";
   if (ast_context.getLangOpts().CPlusPlus &&
-      unary_operator_->HasSideEffects(ast_context)) {
-    new_function << "std::function<" << input_type << "()>";
+      analysis_cache_->HasSideEffects(*unary_operator_)) {
+    new_function << GetMutatorFunctionCallableType(use_shared_runtime,
+                                                   input_type, "Arg");
   } else {
     new_function << input_type;
   }
@@ -196,7 +209,7 @@ std::string MutationReplaceUnaryOperator::GenerateMutatorFunction(
 
   std::string arg_evaluated = "arg";
   if (ast_context.getLangOpts().CPlusPlus &&
-      unary_operator_->HasSideEffects(ast_context)) {
+      analysis_cache_->HasSideEffects(*unary_operator_)) {
     arg_evaluated += "()";
   }
 
@@ -224,11 +237,18 @@ std::string MutationReplaceUnaryOperator::GenerateMutatorFunction(
   }
 
   int mutation_id_offset = 0;
-  GenerateUnaryOperatorReplacement(
-      arg_evaluated, ast_context, optimise_mutations,
-      only_track_mutant_coverage, mutation_id, new_function, mutation_id_offset,
-      protobuf_message);
-
+  // The mutants are generated as the cases of a switch statement.
+  std::stringstream switch_cases;
+  GenerateUnaryOperatorReplacement(arg_evaluated, optimise_mutations,
+                                   mutation_selection,
+                                   only_track_mutant_coverage, mutation_id,
+                                   switch_cases, mutation_id_offset,
+                                   protobuf_message);
+
+  if (!only_track_mutant_coverage && mutation_id_offset > 0) {
+    new_function << GetMutatorFunctionSwitch(mutation_id_offset,
+                                             switch_cases.str());
+  }
   if (only_track_mutant_coverage) {
     new_function << "  __dredd_record_covered_mutants(local_mutation_id, " +
                         std::to_string(mutation_id_offset) + ");\n";
@@ -252,19 +272,18 @@ std::string MutationReplaceUnaryOperator::GenerateMutatorFunction(
 }
 
 bool MutationReplaceUnaryOperator::IsRedundantReplacementOperator(
-    clang::UnaryOperatorKind operator_kind,
-    const clang::ASTContext& ast_context) const {
+    clang::UnaryOperatorKind operator_kind) const {
   // When the operand is 0: - is equivalent to replacement with 0 and ! is
   // equivalent to replacement with 1. When the operand is 1: - is equivalent to
   // replacement with -1 and ! is equivalent to replacement with 0.
   if (MutationReplaceExpr::ExprIsEquivalentToInt(*unary_operator_->getSubExpr(),
-                                                 0, ast_context) ||
+                                                 0, *analysis_cache_) ||
       MutationReplaceExpr::ExprIsEquivalentToFloat(
-          *unary_operator_->getSubExpr(), 0.0, ast_context) ||
+          *unary_operator_->getSubExpr(), 0.0, *analysis_cache_) ||
       MutationReplaceExpr::ExprIsEquivalentToInt(*unary_operator_->getSubExpr(),
-                                                 1, ast_context) ||
+                                                 1, *analysis_cache_) ||
       MutationReplaceExpr::ExprIsEquivalentToFloat(
-          *unary_operator_->getSubExpr(), 1.0, ast_context)) {
+          *unary_operator_->getSubExpr(), 1.0, *analysis_cache_)) {
     if (operator_kind == clang::UO_Minus || operator_kind == clang::UO_LNot) {
       return true;
     }
@@ -272,9 +291,9 @@ bool MutationReplaceUnaryOperator::IsRedundantReplacementOperator(
 
   // When the operand is -1: - is equivalent to replacement with 1.
   if ((MutationReplaceExpr::ExprIsEquivalentToInt(
-           *unary_operator_->getSubExpr(), -1, ast_context) ||
+           *unary_operator_->getSubExpr(), -1, *analysis_cache_) ||
        MutationReplaceExpr::ExprIsEquivalentToFloat(
-           *unary_operator_->getSubExpr(), -1.0, ast_context)) &&
+           *unary_operator_->getSubExpr(), -1.0, *analysis_cache_)) &&
       operator_kind == clang::UO_Minus) {
     return true;
   }
@@ -283,10 +302,10 @@ bool MutationReplaceUnaryOperator::IsRedundantReplacementOperator(
 }
 
 void MutationReplaceUnaryOperator::GenerateUnaryOperatorReplacement(
-    const std::string& arg_evaluated, const clang::ASTContext& ast_context,
-    bool optimise_mutations, bool only_track_mutant_coverage,
-    int mutation_id_base, std::stringstream& new_function,
-    int& mutation_id_offset,
+    const std::string& arg_evaluated, bool optimise_mutations,
+    const MutationSelection& mutation_selection,
+    bool only_track_mutant_coverage, int mutation_id_base,
+    std::stringstream& new_function, int& mutation_id_offset,
     protobufs::MutationReplaceUnaryOperator& protobuf_message) const {
   const std::vector<clang::UnaryOperatorKind> candidate_replacement_operators =
       {clang::UnaryOperatorKind::UO_PreInc,
@@ -300,13 +319,13 @@ void MutationReplaceUnaryOperator::GenerateUnaryOperatorReplacement(
   for (const auto operator_kind : candidate_replacement_operators) {
     if (operator_kind == unary_operator_->getOpcode() ||
         !IsValidReplacementOperator(operator_kind) ||
+        !mutation_selection.IsEnabled(OperatorKindToAction(operator_kind)) ||
         (optimise_mutations &&
-         IsRedundantReplacementOperator(operator_kind, ast_context))) {
+         IsRedundantReplacementOperator(operator_kind))) {
       continue;
     }
     if (!only_track_mutant_coverage) {
-      new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                   << mutation_id_offset << ")) return ";
+      new_function << "    case " << mutation_id_offset << ": return ";
       if (IsPrefix(operator_kind)) {
         new_function << clang::UnaryOperator::getOpcodeStr(operator_kind).str()
                      << arg_evaluated + ";\n";
@@ -323,11 +342,12 @@ void MutationReplaceUnaryOperator::GenerateUnaryOperatorReplacement(
   // Various operators are self-inverse, so that removing the operator is
   // equivalent to inserting another occurrence of it, which will be done by
   // another mutation.
-  if (!optimise_mutations || !IsOperatorSelfInverse()) {
+  if (mutation_selection.IsEnabled(
+          protobufs::MutationReplaceUnaryOperatorAction::ReplaceWithOperand) &&
+      (!optimise_mutations || !IsOperatorSelfInverse())) {
     if (!only_track_mutant_coverage) {
-      new_function << "  if (__dredd_enabled_mutation(local_mutation_id + "
-                   << mutation_id_offset
-                   << ")) return " + arg_evaluated + ";\n";
+      new_function << "    case " << mutation_id_offset
+                   << ": return " + arg_evaluated + ";\n";
     }
     AddMutationInstance(
         mutation_id_base,
@@ -339,8 +359,10 @@ void MutationReplaceUnaryOperator::GenerateUnaryOperatorReplacement(
 protobufs::MutationGroup MutationReplaceUnaryOperator::Apply(
     clang::ASTContext& ast_context, const clang::Preprocessor& preprocessor,
     const Options& options, int first_mutation_id_in_file, int& mutation_id,
-    clang::Rewriter& rewriter,
+    EditList& edit_list,
     std::unordered_set<std::string>& dredd_declarations) const {
+  (void)preprocessor;  // Unused.
+
   // The protobuf object for the mutation, which will be wrapped in a
   // MutationGroup.
   protobufs::MutationReplaceUnaryOperator inner_result;
@@ -368,7 +390,8 @@ protobufs::MutationGroup MutationReplaceUnaryOperator::Apply(
   *inner_result.mutable_operand_snippet() = info_for_sub_expr_.GetSnippet();
 
   const std::string new_function_name =
-      GetFunctionName(options.GetOptimiseMutations(), ast_context);
+      GetFunctionName(options.GetOptimiseMutations(), ast_context) +
+      GetMutatorFunctionNameSuffix(options);
   std::string result_type = unary_operator_->getType()
                                 ->getAs<clang::BuiltinType>()
                                 ->getName(ast_context.getPrintingPolicy())
@@ -389,9 +412,7 @@ protobufs::MutationGroup MutationReplaceUnaryOperator::Apply(
   }
 
   const clang::SourceRange unary_operator_source_range_in_main_file =
-      GetSourceRangeInMainFile(preprocessor, *unary_operator_);
-  assert(unary_operator_source_range_in_main_file.isValid() &&
-         "Invalid source range.");
+      info_for_overall_expr_.GetSourceRange();
 
   // Replace the unary operator expression with a call to the wrapper
   // function.
@@ -405,11 +426,11 @@ protobufs::MutationGroup MutationReplaceUnaryOperator::Apply(
   // - Inserting suitable text before and after the argument to the unary
   //   operator.
   // This is preferable over the (otherwise more intuitive) approach of directly
-  // replacing the text for the unary operator node, because the Clang rewriter
+  // replacing the text for the unary operator node, because the edit list
   // does not support nested replacements.
 
   // Remove the operator symbol.
-  rewriter.ReplaceText(
+  edit_list.ReplaceText(
       unary_operator_->getOperatorLoc(),
       static_cast<unsigned int>(
           clang::UnaryOperator::getOpcodeStr(unary_operator_->getOpcode())
@@ -427,16 +448,14 @@ protobufs::MutationGroup MutationReplaceUnaryOperator::Apply(
   prefix += "(";
   std::string suffix;
   if (ast_context.getLangOpts().CPlusPlus &&
-      unary_operator_->HasSideEffects(ast_context)) {
-    prefix.append(
-        "[&]() -> " + input_type + " { return " +
-        // We don't need to static cast constant expressions
-        (IsCxx11ConstantExpr(*unary_operator_->getSubExpr(), ast_context)
-             ? ""
-             : "static_cast<" + input_type + ">("));
-    suffix.append(
-        IsCxx11ConstantExpr(*unary_operator_->getSubExpr(), ast_context) ? ""
-                                                                         : ")");
+      analysis_cache_->HasSideEffects(*unary_operator_)) {
+    const bool sub_expr_is_constant =
+        analysis_cache_->IsCxx11ConstantExpr(*unary_operator_->getSubExpr());
+    prefix.append("[&]() -> " + input_type + " { return " +
+                  // We don't need to static cast constant expressions
+                  (sub_expr_is_constant ? ""
+                                        : "static_cast<" + input_type + ">("));
+    suffix.append(sub_expr_is_constant ? "" : ")");
     suffix.append("; }");
   }
 
@@ -445,20 +464,23 @@ protobufs::MutationGroup MutationReplaceUnaryOperator::Apply(
     prefix.append("&(");
     suffix.append(")");
   }
-  suffix.append(", " + std::to_string(local_mutation_id) + ")");
+  suffix.append(
+      ", " + GetMutatorFunctionMutationIdArgument(options, local_mutation_id) +
+      ")");
 
   // The prefix and suffix are ready, so make the relevant insertions.
-  bool rewriter_result = rewriter.InsertTextBefore(
+  bool edit_result = edit_list.InsertTextBefore(
       unary_operator_source_range_in_main_file.getBegin(), prefix);
-  assert(!rewriter_result && "Rewrite failed.\n");
-  rewriter_result = rewriter.InsertTextAfterToken(
+  assert(!edit_result && "Rewrite failed.\n");
+  edit_result = edit_list.InsertTextAfterToken(
       unary_operator_source_range_in_main_file.getEnd(), suffix);
-  assert(!rewriter_result && "Rewrite failed.\n");
-  (void)rewriter_result;  // Keep release-mode compilers happy.
+  assert(!edit_result && "Rewrite failed.\n");
+  (void)edit_result;  // Keep release-mode compilers happy.
 
   const std::string new_function = GenerateMutatorFunction(
       ast_context, new_function_name, result_type, input_type,
-      options.GetOptimiseMutations(), options.GetOnlyTrackMutantCoverage(),
+      options.GetOptimiseMutations(), options.GetMutationSelection(),
+      options.GetOnlyTrackMutantCoverage(), options.GetUseSharedRuntime(),
       mutation_id, inner_result);
   assert(!new_function.empty() && "Unsupported opcode.");
 
@@ -469,6 +491,29 @@ protobufs::MutationGroup MutationReplaceUnaryOperator::Apply(
   return result;
 }
 
+protobufs::MutationGroup MutationReplaceUnaryOperator::CountInstances(
+    clang::ASTContext& ast_context, const Options& options,
+    int& mutation_id) const {
+  (void)ast_context;  // Unused.
+
+  protobufs::MutationReplaceUnaryOperator inner_result;
+
+  // The mutants are decided exactly as when the mutator function is generated.
+  // Generating code only to track mutant coverage suppresses all code for
+  // individual mutants, so nothing is written to |unused_new_function|.
+  std::stringstream unused_new_function;
+  int mutation_id_offset = 0;
+  GenerateUnaryOperatorReplacement(
+      "arg", options.GetOptimiseMutations(), options.GetMutationSelection(),
+      true, mutation_id, unused_new_function, mutation_id_offset,
+      inner_result);
+  mutation_id += mutation_id_offset;
+
+  protobufs::MutationGroup result;
+  *result.mutable_replace_unary_operator() = inner_result;
+  return result;
+}
+
 void MutationReplaceUnaryOperator::AddMutationInstance(
     int mutation_id_base, protobufs::MutationReplaceUnaryOperatorAction action,
     int& mutation_id_offset,
@@ -0,0 +1,121 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/mutation_sampler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "libdredd/mutation_counts.h"
+#include "libdredd/mutation_selection.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
+
+namespace dredd {
+
+namespace {
+
+// A mutant that may be kept: the action |kind|:|action| of the mutation group
+// with index |group_index|. Candidates are kept in order of |priority|, which
+// is a hash of their identity.
+struct Candidate {
+  uint64_t priority;
+  size_t group_index;
+  std::string action;
+};
+
+bool operator<(const Candidate& first, const Candidate& second) {
+  return std::tie(first.priority, first.group_index, first.action) <
+         std::tie(second.priority, second.group_index, second.action);
+}
+
+}  // namespace
+
+MutationSampler::MutationSampler(double rate, uint64_t seed)
+    : rate_(rate), seed_(seed) {
+  assert(rate > 0.0 && rate <= 1.0 && "Sample rate out of range.");
+}
+
+std::vector<MutationSelection> MutationSampler::Sample(
+    const std::string& filename,
+    const std::vector<protobufs::MutationGroup>& mutation_groups) const {
+  // Using only the name of the file means that the mutants that are kept do
+  // not depend on where the source code is checked out.
+  const std::string prefix = std::to_string(seed_) + ":" +
+                             llvm::sys::path::filename(filename).str() + ":";
+
+  // Each kind of mutation is a separate stratum.
+  std::map<std::string, std::vector<Candidate>> strata;
+  for (size_t group_index = 0; group_index < mutation_groups.size();
+       group_index++) {
+    if (mutation_groups[group_index].group_case() ==
+        protobufs::MutationGroup::GROUP_NOT_SET) {
+      continue;
+    }
+    for (auto& [kind, action] :
+         GetMutantKindsAndActions(mutation_groups[group_index])) {
+      const uint64_t priority = llvm::xxHash64(
+          prefix + kind + ":" + std::to_string(group_index) + ":" + action);
+      strata[kind].push_back({priority, group_index, std::move(action)});
+    }
+  }
+
+  std::vector<MutationSelection> result(mutation_groups.size());
+  for (auto& selection : result) {
+    selection.DisableAll();
+  }
+  for (auto& [kind, candidates] : strata) {
+    std::sort(candidates.begin(), candidates.end());
+    const auto num_kept = std::min(
+        candidates.size(),
+        static_cast<size_t>(
+            std::ceil(rate_ * static_cast<double>(candidates.size()))));
+    for (size_t i = 0; i < num_kept; i++) {
+      std::string error_message;
+      const bool valid = result[candidates[i].group_index].Enable(
+          kind + ":" + candidates[i].action, error_message);
+      assert(valid && "Mutant kinds and actions should be valid.");
+      (void)valid;  // Keep release-mode compilers happy.
+    }
+  }
+  return result;
+}
+
+protobufs::MutationSampling MutationSampler::ToProtobuf() const {
+  protobufs::MutationSampling result;
+  result.set_rate(rate_);
+  result.set_seed(seed_);
+  return result;
+}
+
+std::string MutationSampler::ToString() const {
+  std::stringstream result;
+  result << std::setprecision(std::numeric_limits<double>::max_digits10)
+         << rate_ << ":" << seed_;
+  return result.str();
+}
+
+}  // namespace dredd
@@ -0,0 +1,160 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/mutation_selection.h"
+
+#include <cstddef>
+#include <string>
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace dredd {
+
+namespace {
+
+const char* const kRemoveStmt = "remove_stmt";
+const char* const kReplaceExpr = "replace_expr";
+const char* const kReplaceBinaryOperator = "replace_binary_operator";
+const char* const kReplaceUnaryOperator = "replace_unary_operator";
+
+// Sets the bit of |actions| associated with the action named |action_name|, or
+// every bit if |action_name| is empty. Returns false if there is no such
+// action.
+template <typename ActionT, typename BitsetT, typename ParseT>
+bool SetActions(llvm::StringRef action_name, bool enabled, ParseT parse,
+                BitsetT& actions) {
+  if (action_name.empty()) {
+    if (enabled) {
+      actions.set();
+    } else {
+      actions.reset();
+    }
+    return true;
+  }
+  ActionT action;
+  if (!parse(action_name.str(), &action)) {
+    return false;
+  }
+  actions.set(static_cast<size_t>(action), enabled);
+  return true;
+}
+
+}  // namespace
+
+MutationSelection::MutationSelection() : remove_stmt_enabled_(true) {
+  replace_expr_actions_.set();
+  replace_binary_operator_actions_.set();
+  replace_unary_operator_actions_.set();
+}
+
+bool MutationSelection::Enable(llvm::StringRef specification,
+                               std::string& error_message) {
+  return SetEnabled(specification, true, error_message);
+}
+
+bool MutationSelection::Disable(llvm::StringRef specification,
+                                std::string& error_message) {
+  return SetEnabled(specification, false, error_message);
+}
+
+void MutationSelection::DisableAll() {
+  remove_stmt_enabled_ = false;
+  replace_expr_actions_.reset();
+  replace_binary_operator_actions_.reset();
+  replace_unary_operator_actions_.reset();
+}
+
+bool MutationSelection::IsEverythingEnabled() const {
+  return remove_stmt_enabled_ && replace_expr_actions_.all() &&
+         replace_binary_operator_actions_.all() &&
+         replace_unary_operator_actions_.all();
+}
+
+protobufs::MutationSelection MutationSelection::ToProtobuf() const {
+  protobufs::MutationSelection result;
+  result.set_remove_stmt(remove_stmt_enabled_);
+  for (size_t i = 0; i < replace_expr_actions_.size(); i++) {
+    if (replace_expr_actions_.test(i)) {
+      result.add_replace_expr_actions(
+          static_cast<protobufs::MutationReplaceExprAction>(i));
+    }
+  }
+  for (size_t i = 0; i < replace_binary_operator_actions_.size(); i++) {
+    if (replace_binary_operator_actions_.test(i)) {
+      result.add_replace_binary_operator_actions(
+          static_cast<protobufs::MutationReplaceBinaryOperatorAction>(i));
+    }
+  }
+  for (size_t i = 0; i < replace_unary_operator_actions_.size(); i++) {
+    if (replace_unary_operator_actions_.test(i)) {
+      result.add_replace_unary_operator_actions(
+          static_cast<protobufs::MutationReplaceUnaryOperatorAction>(i));
+    }
+  }
+  return result;
+}
+
+std::string MutationSelection::ToString() const {
+  return std::string(remove_stmt_enabled_ ? "1" : "0") + ":" +
+         replace_expr_actions_.to_string() + ":" +
+         replace_binary_operator_actions_.to_string() + ":" +
+         replace_unary_operator_actions_.to_string();
+}
+
+bool MutationSelection::SetEnabled(llvm::StringRef specification,
+                                   bool enabled, std::string& error_message) {
+  auto [kind, action_name] = specification.split(':');
+  bool has_action = specification.contains(':');
+  if (has_action && action_name.empty()) {
+    error_message = "missing action in '" + specification.str() + "'";
+    return false;
+  }
+  bool valid_action = true;
+  if (kind == kRemoveStmt) {
+    // Statement removal has a single action.
+    valid_action = !has_action || action_name == "RemoveStmt";
+    if (valid_action) {
+      remove_stmt_enabled_ = enabled;
+    }
+  } else if (kind == kReplaceExpr) {
+    valid_action = SetActions<protobufs::MutationReplaceExprAction>(
+        action_name, enabled, protobufs::MutationReplaceExprAction_Parse,
+        replace_expr_actions_);
+  } else if (kind == kReplaceBinaryOperator) {
+    valid_action = SetActions<protobufs::MutationReplaceBinaryOperatorAction>(
+        action_name, enabled,
+        protobufs::MutationReplaceBinaryOperatorAction_Parse,
+        replace_binary_operator_actions_);
+  } else if (kind == kReplaceUnaryOperator) {
+    valid_action = SetActions<protobufs::MutationReplaceUnaryOperatorAction>(
+        action_name, enabled,
+        protobufs::MutationReplaceUnaryOperatorAction_Parse,
+        replace_unary_operator_actions_);
+  } else {
+    error_message = "unknown kind of mutation '" + kind.str() +
+                    "'; expected one of " + kRemoveStmt + ", " + kReplaceExpr +
+                    ", " + kReplaceBinaryOperator + ", " +
+                    kReplaceUnaryOperator;
+    return false;
+  }
+  if (!valid_action) {
+    error_message = "unknown action '" + action_name.str() +
+                    "' for kind of mutation '" + kind.str() + "'";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace dredd
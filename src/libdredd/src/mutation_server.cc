@@ -0,0 +1,628 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/mutation_server.h"
+
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/options.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/protobufs/protobuf_serialization.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Errno.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+
+namespace dredd {
+
+namespace {
+
+// A client that disconnects early must not cause the server to be killed by
+// SIGPIPE. Where MSG_NOSIGNAL is unavailable, SO_NOSIGPIPE is set on each
+// connection instead.
+#if defined(MSG_NOSIGNAL)
+const int kSendFlags = MSG_NOSIGNAL;
+#else
+const int kSendFlags = 0;
+#endif
+
+const size_t kReadBufferSize = 65536;
+
+#if !defined(_WIN32)
+// Returns true if and only if the file descriptor was made non-blocking.
+bool SetNonBlocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL);
+  return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+#endif
+
+std::string GetAbsolutePath(const std::string& path) {
+  llvm::SmallString<128> absolute_path(path);
+  llvm::sys::fs::make_absolute(absolute_path);
+  llvm::sys::path::remove_dots(absolute_path, true);
+  return absolute_path.str().str();
+}
+
+}  // namespace
+
+MutationServer::MutationServer(std::string socket_path, const Options& options,
+                               std::vector<std::string> default_source_paths,
+                               MutateSourceFilesFunction mutate_source_files)
+    : socket_path_(std::move(socket_path)),
+      options_(&options),
+      default_source_paths_(std::move(default_source_paths)),
+      mutate_source_files_(std::move(mutate_source_files)) {}
+
+MutationServer::~MutationServer() {
+  // A job that is in progress is finished, but queued jobs are abandoned, as
+  // there is nobody left to send their responses to.
+  {
+    const std::lock_guard<std::mutex> lock(jobs_mutex_);
+    stop_mutation_thread_ = true;
+  }
+  jobs_queued_.notify_one();
+  if (mutation_thread_.joinable()) {
+    mutation_thread_.join();
+  }
+#if !defined(_WIN32)
+  while (!clients_.empty()) {
+    CloseClient(clients_.begin()->first);
+  }
+  if (wake_read_fd_ != -1) {
+    close(wake_read_fd_);
+    close(wake_write_fd_);
+  }
+  if (inotify_fd_ != -1) {
+    close(inotify_fd_);
+  }
+  if (listen_fd_ != -1) {
+    close(listen_fd_);
+    unlink(socket_path_.c_str());
+  }
+#endif
+}
+
+bool MutationServer::Run() {
+#if defined(_WIN32)
+  llvm::errs() << "Serving is not supported on Windows.\n";
+  return false;
+#else
+  if (!Listen() || !StartMutationThread()) {
+    return false;
+  }
+  llvm::errs() << "Serving on " << socket_path_ << "\n";
+  while (!shutdown_requested_) {
+    std::vector<pollfd> poll_fds;
+    poll_fds.push_back({listen_fd_, POLLIN, 0});
+    poll_fds.push_back({wake_read_fd_, POLLIN, 0});
+    if (inotify_fd_ != -1) {
+      poll_fds.push_back({inotify_fd_, POLLIN, 0});
+    }
+    for (const auto& client : clients_) {
+      // Nothing is read from a client while its mutations are pending, but a
+      // hang-up is reported regardless of the events that are asked for.
+      short events = 0;
+      if (!client.second.pending_output.empty()) {
+        events = POLLOUT;
+      } else if (client.second.num_pending_mutations == 0) {
+        events = POLLIN;
+      }
+      poll_fds.push_back({client.first, events, 0});
+    }
+    if (poll(poll_fds.data(), poll_fds.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      llvm::errs() << "Error waiting for requests: " << llvm::sys::StrError()
+                   << "\n";
+      return false;
+    }
+    for (const auto& poll_fd : poll_fds) {
+      if (poll_fd.revents == 0) {
+        continue;
+      }
+      if (poll_fd.fd == listen_fd_) {
+        AcceptClient();
+      } else if (poll_fd.fd == wake_read_fd_) {
+        HandleCompletedMutations();
+      } else if (poll_fd.fd == inotify_fd_) {
+        HandleFileChanges();
+      } else {
+        // The client may have been closed after sending its completed
+        // mutations failed.
+        const auto client = clients_.find(poll_fd.fd);
+        if (client == clients_.end()) {
+          continue;
+        }
+        // Either pending output can now be sent, or input can be read. A
+        // hang-up or error is reported whichever was asked for, and shows up
+        // as a failure to write or read.
+        if ((poll_fd.revents & POLLOUT) != 0
+                ? !WriteToClient(client->second)
+                : !ReadFromClient(client->second)) {
+          CloseClient(poll_fd.fd);
+        }
+      }
+      if (shutdown_requested_) {
+        break;
+      }
+    }
+  }
+  return true;
+#endif
+}
+
+bool MutationServer::Listen() {
+#if defined(_WIN32)
+  return false;
+#else
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (socket_path_.size() >= sizeof(address.sun_path)) {
+    llvm::errs() << "Socket path " << socket_path_ << " is too long.\n";
+    return false;
+  }
+  std::memcpy(address.sun_path, socket_path_.c_str(), socket_path_.size() + 1);
+
+  // A socket left behind by a server that was not shut down cleanly is
+  // replaced, but no other kind of file is.
+  struct stat status {};
+  if (lstat(socket_path_.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+    unlink(socket_path_.c_str());
+  }
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) {
+    llvm::errs() << "Unable to create socket: " << llvm::sys::StrError()
+                 << "\n";
+    return false;
+  }
+  // Only the owner may connect, as the server sends back the contents of any
+  // file that a client names. Connecting is only possible once the socket is
+  // listening, so restricting the permissions of the socket file before then
+  // leaves no window in which others can connect.
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) !=
+          0 ||
+      chmod(socket_path_.c_str(), S_IRUSR | S_IWUSR) != 0 ||
+      !SetNonBlocking(fd) || listen(fd, SOMAXCONN) != 0) {
+    llvm::errs() << "Unable to listen on " << socket_path_ << ": "
+                 << llvm::sys::StrError() << "\n";
+    close(fd);
+    return false;
+  }
+  listen_fd_ = fd;
+  return true;
+#endif
+}
+
+bool MutationServer::StartMutationThread() {
+#if defined(_WIN32)
+  return false;
+#else
+  int wake_fds[2];
+  if (pipe(wake_fds) != 0) {
+    llvm::errs() << "Unable to create pipe: " << llvm::sys::StrError() << "\n";
+    return false;
+  }
+  wake_read_fd_ = wake_fds[0];
+  wake_write_fd_ = wake_fds[1];
+  // If the pipe is full, the server has yet to wake up anyway.
+  if (!SetNonBlocking(wake_read_fd_) || !SetNonBlocking(wake_write_fd_)) {
+    llvm::errs() << "Unable to create pipe: " << llvm::sys::StrError() << "\n";
+    return false;
+  }
+  mutation_thread_ = std::thread([this]() -> void { RunMutationThread(); });
+  return true;
+#endif
+}
+
+void MutationServer::RunMutationThread() {
+#if !defined(_WIN32)
+  while (true) {
+    MutationJob job;
+    {
+      std::unique_lock<std::mutex> lock(jobs_mutex_);
+      jobs_queued_.wait(lock, [this]() -> bool {
+        return stop_mutation_thread_ || !queued_jobs_.empty();
+      });
+      if (stop_mutation_thread_) {
+        return;
+      }
+      job = std::move(queued_jobs_.front());
+      queued_jobs_.pop_front();
+    }
+    MutateSourceFiles(job);
+    {
+      const std::lock_guard<std::mutex> lock(jobs_mutex_);
+      completed_jobs_.push_back(std::move(job));
+    }
+    const char wake = 0;
+    const ssize_t num_bytes = write(wake_write_fd_, &wake, 1);
+    (void)num_bytes;  // Unused.
+  }
+#endif
+}
+
+void MutationServer::AcceptClient() {
+#if !defined(_WIN32)
+  const int fd = accept(listen_fd_, nullptr, nullptr);
+  if (fd == -1) {
+    // The listening socket is non-blocking, so that a connection that is
+    // abandoned before it is accepted does not block the server.
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      llvm::errs() << "Unable to accept connection: " << llvm::sys::StrError()
+                   << "\n";
+    }
+    return;
+  }
+  if (!SetNonBlocking(fd)) {
+    llvm::errs() << "Unable to accept connection: " << llvm::sys::StrError()
+                 << "\n";
+    close(fd);
+    return;
+  }
+#if defined(SO_NOSIGPIPE)
+  const int no_sigpipe = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+  Client client;
+  client.fd = fd;
+  client.id = next_client_id_++;
+  clients_.emplace(fd, std::move(client));
+#endif
+}
+
+bool MutationServer::ReadFromClient(Client& client) {
+#if defined(_WIN32)
+  (void)client;  // Unused.
+  return false;
+#else
+  std::vector<char> buffer(kReadBufferSize);
+  const ssize_t num_bytes = recv(client.fd, buffer.data(), buffer.size(), 0);
+  if (num_bytes < 0 &&
+      (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+    return true;
+  }
+  if (num_bytes <= 0) {
+    // The client has disconnected, or the connection has failed.
+    return false;
+  }
+  client.pending_input.append(buffer.data(), static_cast<size_t>(num_bytes));
+  return HandlePendingInput(client);
+#endif
+}
+
+bool MutationServer::HandlePendingInput(Client& client) {
+  size_t newline = client.pending_input.find('\n');
+  while (client.num_pending_mutations == 0 && newline != std::string::npos) {
+    const std::string request_json = client.pending_input.substr(0, newline);
+    client.pending_input.erase(0, newline + 1);
+    if (!HandleRequest(client, request_json)) {
+      return false;
+    }
+    newline = client.pending_input.find('\n');
+  }
+  return true;
+}
+
+bool MutationServer::HandleRequest(Client& client,
+                                   const std::string& request_json) {
+  protobufs::ServeRequest request;
+  protobufs::ServeResponse response;
+  if (!google::protobuf::util::JsonStringToMessage(request_json, &request)
+           .ok()) {
+    response.set_error("Malformed request.");
+    return SendResponse(client, response);
+  }
+  if (request.shutdown()) {
+    shutdown_requested_ = true;
+    (void)SendResponse(client, response);
+    return false;
+  }
+#if !defined(__linux__)
+  if (request.watch()) {
+    response.set_error("Watching source files is only supported on Linux.");
+    return SendResponse(client, response);
+  }
+#endif
+
+  // As when source files are passed to dredd, a file that is listed multiple
+  // times is only mutated once.
+  std::vector<std::string> source_paths;
+  std::vector<std::string> absolute_source_paths;
+  std::set<std::string> seen_absolute_source_paths;
+  for (const auto& source_path :
+       request.source_paths().empty()
+           ? default_source_paths_
+           : std::vector<std::string>(request.source_paths().begin(),
+                                      request.source_paths().end())) {
+    std::string absolute_source_path = GetAbsolutePath(source_path);
+    if (seen_absolute_source_paths.insert(absolute_source_path).second) {
+      source_paths.push_back(source_path);
+      absolute_source_paths.push_back(std::move(absolute_source_path));
+    }
+  }
+
+  MutationJob job;
+  if (request.watch()) {
+    // The source files are watched before they are first mutated, so that any
+    // change made meanwhile is mutated afterwards.
+    client.watching = true;
+    client.source_paths = source_paths;
+    client.absolute_source_paths = std::move(absolute_source_paths);
+    client.deferred_files =
+        std::vector<std::vector<DeferredMutatedFile>>(source_paths.size());
+    if (WatchSourceFiles(client)) {
+      job.updates_watched_files = true;
+    } else {
+      client.watching = false;
+      job.error = "Unable to watch the source files.";
+    }
+  }
+  for (size_t i = 0; i < source_paths.size(); i++) {
+    job.indices.push_back(i);
+  }
+  job.source_paths = std::move(source_paths);
+  QueueMutation(client, std::move(job));
+  return true;
+}
+
+void MutationServer::HandleFileChanges() {
+#if defined(__linux__)
+  // Gather every change that is pending, so that a file that is written
+  // several times in quick succession is only mutated once.
+  std::set<std::string> changed_paths;
+  std::vector<char> buffer(kReadBufferSize);
+  while (true) {
+    const ssize_t num_bytes = read(inotify_fd_, buffer.data(), buffer.size());
+    if (num_bytes <= 0) {
+      break;
+    }
+    size_t offset = 0;
+    while (offset < static_cast<size_t>(num_bytes)) {
+      inotify_event event{};
+      std::memcpy(&event, buffer.data() + offset, sizeof(inotify_event));
+      const auto directory = watched_directories_.find(event.wd);
+      if (event.len > 0 && directory != watched_directories_.end()) {
+        llvm::SmallString<128> path(directory->second);
+        llvm::sys::path::append(
+            path, std::string(buffer.data() + offset + sizeof(inotify_event)));
+        changed_paths.insert(path.str().str());
+      }
+      offset += sizeof(inotify_event) + event.len;
+    }
+  }
+
+  for (auto& fd_and_client : clients_) {
+    Client& client = fd_and_client.second;
+    if (!client.watching) {
+      continue;
+    }
+    MutationJob job;
+    job.updates_watched_files = true;
+    for (size_t i = 0; i < client.source_paths.size(); i++) {
+      if (changed_paths.count(client.absolute_source_paths[i]) > 0) {
+        job.source_paths.push_back(client.source_paths[i]);
+        job.indices.push_back(i);
+      }
+    }
+    if (!job.indices.empty()) {
+      QueueMutation(client, std::move(job));
+    }
+  }
+#endif
+}
+
+void MutationServer::HandleCompletedMutations() {
+#if !defined(_WIN32)
+  // Each completed job writes to the pipe, but all of them are handled at once.
+  std::vector<char> buffer(kReadBufferSize);
+  while (read(wake_read_fd_, buffer.data(), buffer.size()) > 0) {
+  }
+#endif
+  std::deque<MutationJob> completed_jobs;
+  {
+    const std::lock_guard<std::mutex> lock(jobs_mutex_);
+    completed_jobs.swap(completed_jobs_);
+  }
+  for (auto& job : completed_jobs) {
+    const auto fd_and_client = clients_.find(job.client_fd);
+    if (fd_and_client == clients_.end() ||
+        fd_and_client->second.id != job.client_id) {
+      // The client has disconnected.
+      continue;
+    }
+    Client& client = fd_and_client->second;
+    client.num_pending_mutations--;
+    protobufs::ServeResponse response;
+    if (job.updates_watched_files) {
+      for (size_t i = 0; i < job.indices.size(); i++) {
+        client.deferred_files[job.indices[i]] =
+            std::move(job.deferred_files[i]);
+      }
+      response = MakeResponse(client.deferred_files, job.files_with_errors,
+                              job.return_code);
+    } else {
+      response = MakeResponse(job.deferred_files, job.files_with_errors,
+                              job.return_code);
+    }
+    if (!job.error.empty()) {
+      response.set_error(job.error);
+    }
+    if (!SendResponse(client, response) || !HandlePendingInput(client)) {
+      CloseClient(client.fd);
+    }
+  }
+}
+
+void MutationServer::QueueMutation(Client& client, MutationJob job) {
+  job.client_fd = client.fd;
+  job.client_id = client.id;
+  client.num_pending_mutations++;
+  {
+    const std::lock_guard<std::mutex> lock(jobs_mutex_);
+    queued_jobs_.push_back(std::move(job));
+  }
+  jobs_queued_.notify_one();
+}
+
+bool MutationServer::WatchSourceFiles(const Client& client) {
+#if defined(__linux__)
+  if (inotify_fd_ == -1) {
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ == -1) {
+      llvm::errs() << "Unable to watch files: " << llvm::sys::StrError()
+                   << "\n";
+      return false;
+    }
+  }
+  for (const auto& absolute_source_path : client.absolute_source_paths) {
+    const std::string directory =
+        llvm::sys::path::parent_path(absolute_source_path).str();
+    // Watching a directory that is already watched yields the same watch
+    // descriptor.
+    const int watch_descriptor = inotify_add_watch(
+        inotify_fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch_descriptor == -1) {
+      llvm::errs() << "Unable to watch " << directory << ": "
+                   << llvm::sys::StrError() << "\n";
+      return false;
+    }
+    watched_directories_[watch_descriptor] = directory;
+  }
+  return true;
+#else
+  (void)client;  // Unused.
+  return false;
+#endif
+}
+
+void MutationServer::MutateSourceFiles(MutationJob& job) const {
+  job.deferred_files =
+      std::vector<std::vector<DeferredMutatedFile>>(job.source_paths.size());
+  job.return_code = mutate_source_files_(
+      job.source_paths,
+      [&job](size_t index, const DeferredMutatedFile& deferred_file) -> void {
+        job.deferred_files[index].push_back(deferred_file);
+      },
+      job.files_with_errors);
+}
+
+protobufs::ServeResponse MutationServer::MakeResponse(
+    const std::vector<std::vector<DeferredMutatedFile>>& deferred_files,
+    const std::set<std::string>& files_with_errors, int return_code) const {
+  protobufs::ServeResponse response;
+  // Global mutation ids are assigned exactly as they are when dredd mutates
+  // source files in parallel.
+  int mutation_id = 0;
+  for (const auto& deferred_files_for_source : deferred_files) {
+    for (const auto& deferred_file : deferred_files_for_source) {
+      protobufs::ServedMutatedFile* served_file = response.add_files();
+      served_file->set_filename(deferred_file.GetFilename());
+      served_file->set_mutated_text(
+          deferred_file.GetMutatedText(*options_, mutation_id));
+      *served_file->mutable_mutation_info_for_file() =
+          deferred_file.GetMutationInfoForFile(mutation_id);
+      mutation_id += deferred_file.GetNumMutations();
+    }
+  }
+  response.set_num_mutations(mutation_id);
+  for (const auto& file : files_with_errors) {
+    response.add_files_with_errors(file);
+  }
+  if (return_code != 0 && files_with_errors.empty()) {
+    response.set_error("Mutation failed; see the server's output for details.");
+  }
+  return response;
+}
+
+bool MutationServer::SendResponse(Client& client,
+                                  const protobufs::ServeResponse& response) {
+  // Primitive fields are always printed, so that mutation info is presented
+  // exactly as it is in mutation info files.
+  auto json_options = google::protobuf::util::JsonOptions();
+  json_options.always_print_primitive_fields = true;
+  std::string response_json;
+  if (!google::protobuf::util::MessageToJsonString(response, &response_json,
+                                                   json_options)
+           .ok()) {
+    return false;
+  }
+  client.pending_output += response_json;
+  client.pending_output += "\n";
+  return WriteToClient(client);
+}
+
+bool MutationServer::WriteToClient(Client& client) {
+#if defined(_WIN32)
+  (void)client;  // Unused.
+  return false;
+#else
+  size_t offset = 0;
+  while (offset < client.pending_output.size()) {
+    const ssize_t num_bytes = send(client.fd,
+                                   client.pending_output.data() + offset,
+                                   client.pending_output.size() - offset,
+                                   kSendFlags);
+    if (num_bytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        // The rest is sent once the client has read enough.
+        break;
+      }
+      return false;
+    }
+    offset += static_cast<size_t>(num_bytes);
+  }
+  client.pending_output.erase(0, offset);
+  return true;
+#endif
+}
+
+void MutationServer::CloseClient(int fd) {
+#if !defined(_WIN32)
+  close(fd);
+#endif
+  clients_.erase(fd);
+}
+
+}  // namespace dredd
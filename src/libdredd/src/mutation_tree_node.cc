@@ -14,28 +14,49 @@
 
 #include "libdredd/mutation_tree_node.h"
 
-#include <utility>
-
 namespace dredd {
 
-void MutationTreeNode::AddChild(std::unique_ptr<MutationTreeNode> node) {
-  children_.push_back(std::move(node));
+void MutationTreeNode::AddMutation(const Mutation& mutation,
+                                   MutationTreeArena& arena) {
+  MutationListEntry& entry = arena.CreateMutationListEntry(mutation);
+  if (last_mutation_ == nullptr) {
+    first_mutation_ = &entry;
+  } else {
+    last_mutation_->next = &entry;
+  }
+  last_mutation_ = &entry;
 }
 
-void MutationTreeNode::AddMutation(std::unique_ptr<Mutation> mutation) {
-  mutations_.push_back(std::move(mutation));
+void MutationTreeNode::AddChild(MutationTreeNode& node) {
+  if (last_child_ == nullptr) {
+    first_child_ = &node;
+  } else {
+    last_child_->next_sibling_ = &node;
+  }
+  last_child_ = &node;
 }
 
 void MutationTreeNode::TidyUp() {
-  PruneEmptySubtrees();
-  Compress();
+  // Nodes are owned by the arena, so a node that is squashed away is simply
+  // no longer referred to.
+  while (first_mutation_ == nullptr && HasOneChild()) {
+    MutationTreeNode* child = first_child_;
+    first_mutation_ = child->first_mutation_;
+    last_mutation_ = child->last_mutation_;
+    first_child_ = child->first_child_;
+    last_child_ = child->last_child_;
+  }
+  for (MutationTreeNode* child = first_child_; child != nullptr;
+       child = child->next_sibling_) {
+    child->TidyUp();
+  }
 }
 
 bool MutationTreeNode::IsEmpty() const {
-  if (!mutations_.empty()) {
+  if (first_mutation_ != nullptr) {
     return false;
   }
-  for (const auto& child : children_) {
+  for (const auto* child : GetChildren()) {
     if (!child->IsEmpty()) {
       return false;
     }
@@ -43,42 +64,10 @@ bool MutationTreeNode::IsEmpty() const {
   return true;
 }
 
-void MutationTreeNode::Compress() {
-  while (mutations_.empty() && children_.size() == 1) {
-    std::vector<std::unique_ptr<Mutation>> child_mutations;
-    for (auto& child_mutation : children_[0]->mutations_) {
-      child_mutations.push_back(std::move(child_mutation));
-    }
-    std::vector<std::unique_ptr<MutationTreeNode>> child_children;
-    for (auto& child_child : children_[0]->children_) {
-      child_children.push_back(std::move(child_child));
-    }
-    mutations_ = std::move(child_mutations);
-    children_ = std::move(child_children);
-  }
-  for (auto& child : children_) {
-    child->Compress();
-  }
-}
-
-void MutationTreeNode::PruneEmptySubtrees() {
-  auto child_iterator = children_.begin();
-  while (child_iterator != children_.end()) {
-    if ((*child_iterator)->IsEmpty()) {
-      child_iterator = children_.erase(child_iterator);
-    } else {
-      (*child_iterator)->PruneEmptySubtrees();
-      ++child_iterator;
-    }
-  }
-}
-
-std::vector<const MutationTreeNode*> MutationTreeNode::GetChildren() const {
-  std::vector<const MutationTreeNode*> result;
-  for (const auto& child : children_) {
-    result.push_back(child.get());
+MutationTreeArena::~MutationTreeArena() {
+  for (auto* mutation : mutations_) {
+    mutation->~Mutation();
   }
-  return result;
 }
 
 }  // namespace dredd
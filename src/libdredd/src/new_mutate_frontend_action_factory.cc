@@ -15,16 +15,23 @@
 #include "libdredd/new_mutate_frontend_action_factory.h"
 
 #include <cassert>
+#include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "clang/AST/ASTConsumer.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Frontend/FrontendOptions.h"
+#include "clang/Frontend/Utils.h"
 #include "clang/Tooling/Tooling.h"
+#include "libdredd/deferred_mutated_file.h"
 #include "libdredd/mutate_ast_consumer.h"
+#include "libdredd/mutation_info_writer.h"
 #include "libdredd/options.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/run_statistics.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -33,19 +40,29 @@ namespace dredd {
 class MutateFrontendAction : public clang::ASTFrontendAction {
  public:
   MutateFrontendAction(const Options& options, int& mutation_id,
-                       std::optional<protobufs::MutationInfo>& mutation_info,
-                       std::set<std::string>& processed_files)
+                       bool build_mutation_info,
+                       MutationInfoWriter* mutation_info_writer,
+                       std::set<std::string>& processed_files,
+                       std::vector<DeferredMutatedFile>* deferred_files,
+                       std::vector<protobufs::FileMutationCounts>*
+                           mutation_counts,
+                       RunStatistics* run_statistics,
+                       std::vector<std::string>* dependencies)
       : options_(&options),
         mutation_id_(&mutation_id),
-        mutation_info_(&mutation_info),
-        processed_files_(&processed_files) {}
+        build_mutation_info_(build_mutation_info),
+        mutation_info_writer_(mutation_info_writer),
+        processed_files_(&processed_files),
+        deferred_files_(deferred_files),
+        mutation_counts_(mutation_counts),
+        run_statistics_(run_statistics),
+        dependencies_(dependencies) {}
 
   std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(
       clang::CompilerInstance& compiler_instance,
       llvm::StringRef file) override;
 
   bool BeginInvocation(clang::CompilerInstance& compiler_instance) override {
-    (void)compiler_instance;  // Unused.
     const bool input_exists = !getCurrentInput().isEmpty();
     (void)input_exists;  // Keep release-mode compilers happy.
     assert(input_exists && "No current file.");
@@ -55,54 +72,186 @@ class MutateFrontendAction : public clang::ASTFrontendAction {
       return false;
     }
     processed_files_->insert(getCurrentFile().str());
+    if (options_->GetSkipHeaderFunctionBodies()) {
+      // The AST consumer decides which function bodies are skipped.
+      compiler_instance.getFrontendOpts().SkipFunctionBodies = true;
+    }
+    if (dependencies_ != nullptr) {
+      // By default, a dependency collector ignores system headers. They are
+      // required here so that a change to, e.g., the standard library in use is
+      // noticed.
+      class AllDependenciesCollector : public clang::DependencyCollector {
+       public:
+        bool needSystemDependencies() override { return true; }
+      };
+      // This must be attached before the preprocessor is created, which happens
+      // after this method returns.
+      dependency_collector_ = std::make_shared<AllDependenciesCollector>();
+      compiler_instance.addDependencyCollector(dependency_collector_);
+    }
     return true;
   }
 
+  void EndSourceFileAction() override {
+    if (dependency_collector_ != nullptr) {
+      for (const auto& dependency : dependency_collector_->getDependencies()) {
+        dependencies_->push_back(dependency);
+      }
+      dependency_collector_ = nullptr;
+    }
+  }
+
  private:
   const Options* options_;
   int* mutation_id_;
-  std::optional<protobufs::MutationInfo>* mutation_info_;
+  bool build_mutation_info_;
+  MutationInfoWriter* mutation_info_writer_;
   std::set<std::string>* processed_files_;
+  std::vector<DeferredMutatedFile>* deferred_files_;
+  std::vector<protobufs::FileMutationCounts>* mutation_counts_;
+  RunStatistics* run_statistics_;
+  std::vector<std::string>* dependencies_;
+  std::shared_ptr<clang::DependencyCollector> dependency_collector_;
 };
 
 std::unique_ptr<clang::tooling::FrontendActionFactory>
 NewMutateFrontendActionFactory(
     const Options& options, int& mutation_id,
-    std::optional<protobufs::MutationInfo>& mutation_info) {
+    MutationInfoWriter* mutation_info_writer, RunStatistics* run_statistics) {
   class MutateFrontendActionFactory
       : public clang::tooling::FrontendActionFactory {
    public:
-    MutateFrontendActionFactory(
-        const Options& options, int& mutation_id,
-        std::optional<protobufs::MutationInfo>& mutation_info)
+    MutateFrontendActionFactory(const Options& options, int& mutation_id,
+                                MutationInfoWriter* mutation_info_writer,
+                                RunStatistics* run_statistics)
         : options_(&options),
           mutation_id_(&mutation_id),
-          mutation_info_(&mutation_info) {}
+          mutation_info_writer_(mutation_info_writer),
+          run_statistics_(run_statistics) {}
 
     std::unique_ptr<clang::FrontendAction> create() override {
       return std::make_unique<MutateFrontendAction>(
-          *options_, *mutation_id_, *mutation_info_, processed_files_);
+          *options_, *mutation_id_, mutation_info_writer_ != nullptr,
+          mutation_info_writer_, processed_files_, nullptr, nullptr,
+          run_statistics_, nullptr);
     }
 
    private:
     const Options* options_;
     int* mutation_id_;
-    std::optional<protobufs::MutationInfo>* mutation_info_;
+    MutationInfoWriter* mutation_info_writer_;
+    RunStatistics* run_statistics_;
+
+    // Stores the ids of the files that have been processed so far, to avoid
+    // processing a file multiple times.
+    std::set<std::string> processed_files_;
+  };
+
+  return std::make_unique<MutateFrontendActionFactory>(
+      options, mutation_id, mutation_info_writer, run_statistics);
+}
+
+std::unique_ptr<clang::tooling::FrontendActionFactory>
+NewDeferredMutateFrontendActionFactory(
+    const Options& options, bool build_mutation_info,
+    std::vector<DeferredMutatedFile>& deferred_files,
+    RunStatistics* run_statistics, std::vector<std::string>* dependencies) {
+  class DeferredMutateFrontendActionFactory
+      : public clang::tooling::FrontendActionFactory {
+   public:
+    DeferredMutateFrontendActionFactory(
+        const Options& options, bool build_mutation_info,
+        std::vector<DeferredMutatedFile>& deferred_files,
+        RunStatistics* run_statistics, std::vector<std::string>* dependencies)
+        : options_(&options),
+          build_mutation_info_(build_mutation_info),
+          deferred_files_(&deferred_files),
+          run_statistics_(run_statistics),
+          dependencies_(dependencies) {}
+
+    std::unique_ptr<clang::FrontendAction> create() override {
+      return std::make_unique<MutateFrontendAction>(
+          *options_, mutation_id_, build_mutation_info_, nullptr,
+          processed_files_, deferred_files_, nullptr, run_statistics_,
+          dependencies_);
+    }
+
+   private:
+    const Options* options_;
+
+    // Mutation ids are counted from zero for this factory; they are made
+    // file-local by the AST consumer in any case.
+    int mutation_id_ = 0;
+
+    // In deferred mode, mutation info is recorded in each deferred file rather
+    // than being written out.
+    bool build_mutation_info_;
+
+    std::vector<DeferredMutatedFile>* deferred_files_;
+
+    RunStatistics* run_statistics_;
+
+    std::vector<std::string>* dependencies_;
+
+    // Stores the ids of the files that have been processed so far, to avoid
+    // processing a file multiple times.
+    std::set<std::string> processed_files_;
+  };
+
+  return std::make_unique<DeferredMutateFrontendActionFactory>(
+      options, build_mutation_info, deferred_files, run_statistics,
+      dependencies);
+}
+
+std::unique_ptr<clang::tooling::FrontendActionFactory>
+NewCountMutationsFrontendActionFactory(
+    const Options& options,
+    std::vector<protobufs::FileMutationCounts>& mutation_counts,
+    RunStatistics* run_statistics) {
+  class CountMutationsFrontendActionFactory
+      : public clang::tooling::FrontendActionFactory {
+   public:
+    CountMutationsFrontendActionFactory(
+        const Options& options,
+        std::vector<protobufs::FileMutationCounts>& mutation_counts,
+        RunStatistics* run_statistics)
+        : options_(&options),
+          mutation_counts_(&mutation_counts),
+          run_statistics_(run_statistics) {}
+
+    std::unique_ptr<clang::FrontendAction> create() override {
+      return std::make_unique<MutateFrontendAction>(
+          *options_, mutation_id_, false, nullptr, processed_files_, nullptr,
+          mutation_counts_, run_statistics_, nullptr);
+    }
+
+   private:
+    const Options* options_;
+
+    // Not used when counting mutations, which are numbered from zero for each
+    // file.
+    int mutation_id_ = 0;
+
+    std::vector<protobufs::FileMutationCounts>* mutation_counts_;
+
+    RunStatistics* run_statistics_;
 
     // Stores the ids of the files that have been processed so far, to avoid
     // processing a file multiple times.
     std::set<std::string> processed_files_;
   };
 
-  return std::make_unique<MutateFrontendActionFactory>(options, mutation_id,
-                                                       mutation_info);
+  return std::make_unique<CountMutationsFrontendActionFactory>(
+      options, mutation_counts, run_statistics);
 }
 
 std::unique_ptr<clang::ASTConsumer> MutateFrontendAction::CreateASTConsumer(
     clang::CompilerInstance& compiler_instance, llvm::StringRef file) {
   (void)file;  // Unused.
-  return std::make_unique<MutateAstConsumer>(compiler_instance, *options_,
-                                             *mutation_id_, *mutation_info_);
+  return std::make_unique<MutateAstConsumer>(
+      compiler_instance, *options_, *mutation_id_, build_mutation_info_,
+      mutation_info_writer_, deferred_files_, mutation_counts_,
+      run_statistics_);
 }
 
 }  // namespace dredd
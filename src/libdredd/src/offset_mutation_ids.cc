@@ -0,0 +1,53 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/offset_mutation_ids.h"
+
+#include <cassert>
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+
+namespace dredd {
+
+void OffsetMutationIds(int offset,
+                       protobufs::MutationInfoForFile& mutation_info_for_file) {
+  for (auto& mutation_tree_node :
+       *mutation_info_for_file.mutable_mutation_tree()) {
+    for (auto& mutation_group : *mutation_tree_node.mutable_mutation_groups()) {
+      if (mutation_group.has_remove_stmt()) {
+        auto* remove_stmt = mutation_group.mutable_remove_stmt();
+        remove_stmt->set_mutation_id(remove_stmt->mutation_id() + offset);
+      } else if (mutation_group.has_replace_expr()) {
+        for (auto& instance :
+             *mutation_group.mutable_replace_expr()->mutable_instances()) {
+          instance.set_mutation_id(instance.mutation_id() + offset);
+        }
+      } else if (mutation_group.has_replace_binary_operator()) {
+        for (auto& instance : *mutation_group.mutable_replace_binary_operator()
+                                   ->mutable_instances()) {
+          instance.set_mutation_id(instance.mutation_id() + offset);
+        }
+      } else {
+        assert(mutation_group.has_replace_unary_operator() &&
+               "Unknown kind of mutation group.");
+        for (auto& instance : *mutation_group.mutable_replace_unary_operator()
+                                   ->mutable_instances()) {
+          instance.set_mutation_id(instance.mutation_id() + offset);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace dredd
@@ -0,0 +1,296 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/run_statistics.h"
+
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libdredd/mutation_counts.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+namespace dredd {
+
+namespace {
+
+const double kNanosecondsPerMicrosecond = 1000.0;
+const double kNanosecondsPerMillisecond = 1000000.0;
+
+double ToMilliseconds(int64_t nanoseconds) {
+  return static_cast<double>(nanoseconds) / kNanosecondsPerMillisecond;
+}
+
+int64_t ToNanoseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+double ToMicroseconds(std::chrono::steady_clock::duration duration) {
+  return static_cast<double>(ToNanoseconds(duration)) /
+         kNanosecondsPerMicrosecond;
+}
+
+// Yields the peak resident set size of the process in bytes, if it is
+// available on this platform.
+std::optional<int64_t> GetPeakResidentSetSize() {
+#if defined(_WIN32)
+  return std::nullopt;
+#else
+  struct rusage usage {};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return std::nullopt;
+  }
+#if defined(__APPLE__)
+  // Reported in bytes on macOS.
+  return static_cast<int64_t>(usage.ru_maxrss);
+#else
+  // Reported in kilobytes elsewhere.
+  const int64_t kBytesPerKilobyte = 1024;
+  return static_cast<int64_t>(usage.ru_maxrss) * kBytesPerKilobyte;
+#endif
+#endif
+}
+
+// Writes the number of mutants, the number of mutants of each kind, and the
+// number of mutants of each kind with each action, as attributes of the
+// current JSON object.
+void WriteMutantCounts(
+    const std::vector<std::pair<std::string, std::string>>& mutants,
+    llvm::json::OStream& json) {
+  std::map<std::string, int64_t> by_kind;
+  std::map<std::string, std::map<std::string, int64_t>> by_action;
+  for (const auto& [kind, action] : mutants) {
+    by_kind[kind]++;
+    by_action[kind][action]++;
+  }
+  json.attribute("num_mutants", static_cast<int64_t>(mutants.size()));
+  json.attributeObject("mutants_by_kind", [&json, &by_kind]() -> void {
+    for (const auto& [kind, count] : by_kind) {
+      json.attribute(kind, count);
+    }
+  });
+  json.attributeObject("mutants_by_action", [&json, &by_action]() -> void {
+    for (const auto& [kind, actions] : by_action) {
+      json.attributeObject(kind, [&json, &actions]() -> void {
+        for (const auto& [action, count] : actions) {
+          json.attribute(action, count);
+        }
+      });
+    }
+  });
+}
+
+template <size_t NumPhases>
+void WritePhaseTimes(const std::array<int64_t, NumPhases>& nanoseconds,
+                     llvm::json::OStream& json) {
+  json.attributeObject("phase_ms", [&json, &nanoseconds]() -> void {
+    for (size_t i = 0; i < nanoseconds.size(); i++) {
+      json.attribute(
+          RunStatistics::GetPhaseName(static_cast<RunStatistics::Phase>(i)),
+          ToMilliseconds(nanoseconds[i]));
+    }
+  });
+}
+
+}  // namespace
+
+RunStatistics::RunStatistics(bool record_details)
+    : record_details_(record_details),
+      creation_time_(std::chrono::steady_clock::now()) {}
+
+const char* RunStatistics::GetPhaseName(Phase phase) {
+  switch (phase) {
+    case Phase::kParse:
+      return "parse";
+    case Phase::kTraverse:
+      return "traverse";
+    case Phase::kTidyUp:
+      return "tidy up";
+    case Phase::kApplyMutations:
+      return "apply mutations";
+    case Phase::kRewrite:
+      return "rewrite";
+    case Phase::kOutput:
+      return "prelude and output";
+    case Phase::kSerialise:
+      return "serialise";
+  }
+  assert(false && "Unknown phase.");
+  return "";
+}
+
+void RunStatistics::AddTime(Phase phase, const std::string& filename,
+                            std::chrono::steady_clock::time_point start,
+                            std::chrono::steady_clock::time_point end) {
+  nanoseconds_[static_cast<size_t>(phase)] += ToNanoseconds(end - start);
+  if (!record_details_) {
+    return;
+  }
+  const std::lock_guard<std::mutex> lock(mutex_);
+  phase_events_.push_back({filename, phase, start, end, llvm::get_threadid()});
+}
+
+void RunStatistics::AddFileCounts(
+    const std::string& filename, int64_t num_decls_traversed,
+    int64_t num_stmts_traversed,
+    const protobufs::MutationInfoForFile& mutation_info_for_file) {
+  if (!record_details_) {
+    return;
+  }
+  FileCounts file_counts{filename, num_decls_traversed, num_stmts_traversed,
+                         {}};
+  for (const auto& node : mutation_info_for_file.mutation_tree()) {
+    for (const auto& mutation_group : node.mutation_groups()) {
+      for (auto& kind_and_action : GetMutantKindsAndActions(mutation_group)) {
+        file_counts.mutants.push_back(std::move(kind_and_action));
+      }
+    }
+  }
+  const std::lock_guard<std::mutex> lock(mutex_);
+  file_counts_.push_back(std::move(file_counts));
+}
+
+void RunStatistics::Print(llvm::raw_ostream& stream) const {
+  stream << "Phase timings (summed over all source files):\n";
+  int64_t total_nanoseconds = 0;
+  for (size_t i = 0; i < kNumPhases; i++) {
+    const int64_t phase_nanoseconds = nanoseconds_[i];
+    total_nanoseconds += phase_nanoseconds;
+    stream << llvm::format("  %-20s%12.3f ms\n",
+                           GetPhaseName(static_cast<Phase>(i)),
+                           ToMilliseconds(phase_nanoseconds));
+  }
+  stream << llvm::format("  %-20s%12.3f ms\n",
+                         static_cast<const char*>("total"),
+                         ToMilliseconds(total_nanoseconds));
+}
+
+void RunStatistics::WriteReport(llvm::raw_ostream& stream) const {
+  assert(record_details_ && "Details must be recorded to write a report.");
+  const std::lock_guard<std::mutex> lock(mutex_);
+
+  // Per-file phase times, derived from the recorded events. Files are reported
+  // in order of name, so that the report is deterministic other than in its
+  // times.
+  std::map<std::string, std::array<int64_t, kNumPhases>> file_nanoseconds;
+  for (const auto& event : phase_events_) {
+    file_nanoseconds[event.filename][static_cast<size_t>(event.phase)] +=
+        ToNanoseconds(event.end - event.start);
+  }
+  std::map<std::string, const FileCounts*> file_counts_by_name;
+  std::vector<std::pair<std::string, std::string>> all_mutants;
+  int64_t num_decls_traversed = 0;
+  int64_t num_stmts_traversed = 0;
+  for (const auto& file_counts : file_counts_) {
+    file_counts_by_name[file_counts.filename] = &file_counts;
+    file_nanoseconds.try_emplace(file_counts.filename);
+    all_mutants.insert(all_mutants.end(), file_counts.mutants.begin(),
+                       file_counts.mutants.end());
+    num_decls_traversed += file_counts.num_decls_traversed;
+    num_stmts_traversed += file_counts.num_stmts_traversed;
+  }
+  std::array<int64_t, kNumPhases> total_nanoseconds{};
+  for (size_t i = 0; i < kNumPhases; i++) {
+    total_nanoseconds[i] = nanoseconds_[i];
+  }
+
+  llvm::json::OStream json(stream, 1);
+  json.object([&]() -> void {
+    json.attribute("displayTimeUnit", "ms");
+    json.attributeObject("summary", [&]() -> void {
+      json.attribute("num_files",
+                     static_cast<int64_t>(file_nanoseconds.size()));
+      json.attribute("wall_time_ms",
+                     ToMilliseconds(ToNanoseconds(
+                         std::chrono::steady_clock::now() - creation_time_)));
+      const std::optional<int64_t> peak_rss = GetPeakResidentSetSize();
+      if (peak_rss.has_value()) {
+        json.attribute("peak_rss_bytes", peak_rss.value());
+      } else {
+        json.attribute("peak_rss_bytes", nullptr);
+      }
+      WritePhaseTimes(total_nanoseconds, json);
+      json.attribute("num_decls_traversed", num_decls_traversed);
+      json.attribute("num_stmts_traversed", num_stmts_traversed);
+      WriteMutantCounts(all_mutants, json);
+    });
+    json.attributeArray("files", [&]() -> void {
+      for (const auto& [filename, nanoseconds] : file_nanoseconds) {
+        json.object([&]() -> void {
+          json.attribute("filename", filename);
+          WritePhaseTimes(nanoseconds, json);
+          const auto file_counts = file_counts_by_name.find(filename);
+          if (file_counts != file_counts_by_name.end()) {
+            json.attribute("num_decls_traversed",
+                           file_counts->second->num_decls_traversed);
+            json.attribute("num_stmts_traversed",
+                           file_counts->second->num_stmts_traversed);
+            WriteMutantCounts(file_counts->second->mutants, json);
+          }
+        });
+      }
+    });
+    // Complete events in the Chrome trace-event format, with timestamps and
+    // durations in microseconds.
+    json.attributeArray("traceEvents", [&]() -> void {
+      for (const auto& event : phase_events_) {
+        json.object([&]() -> void {
+          json.attribute("name", GetPhaseName(event.phase));
+          json.attribute("cat", "dredd");
+          json.attribute("ph", "X");
+          json.attribute("ts", ToMicroseconds(event.start - creation_time_));
+          json.attribute("dur", ToMicroseconds(event.end - event.start));
+          json.attribute("pid", 0);
+          json.attribute("tid", event.thread_id);
+          json.attributeObject("args", [&]() -> void {
+            json.attribute("file", event.filename);
+          });
+        });
+      }
+    });
+  });
+  stream << "\n";
+}
+
+bool RunStatistics::WriteReport(const std::string& path) const {
+  if (llvm::Error error = llvm::writeToOutput(
+          path, [&](llvm::raw_ostream& output_stream) -> llvm::Error {
+            WriteReport(output_stream);
+            return llvm::Error::success();
+          })) {
+    llvm::errs() << "Unable to write file " << path << ": "
+                 << llvm::toString(std::move(error)) << "\n";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace dredd
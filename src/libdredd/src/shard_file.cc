@@ -0,0 +1,68 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/shard_file.h"
+
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <string>
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/protobufs/protobuf_serialization.h"
+
+namespace dredd {
+
+ShardFileWriter::ShardFileWriter(const std::string& filename)
+    : output_stream_(filename, std::ios::binary) {}
+
+bool ShardFileWriter::WriteHeader(const protobufs::ShardHeader& header) {
+  return google::protobuf::util::SerializeDelimitedToOstream(header,
+                                                             &output_stream_);
+}
+
+bool ShardFileWriter::WriteEntry(const protobufs::ShardFileEntry& entry) {
+  return google::protobuf::util::SerializeDelimitedToOstream(entry,
+                                                             &output_stream_);
+}
+
+ShardFileReader::ShardFileReader(const std::string& filename)
+    : input_stream_(filename, std::ios::binary),
+      zero_copy_input_stream_(
+          std::make_unique<google::protobuf::io::IstreamInputStream>(
+              &input_stream_)) {}
+
+ShardFileReader::~ShardFileReader() = default;
+
+bool ShardFileReader::ReadHeader(protobufs::ShardHeader& header) {
+  bool clean_eof = false;
+  if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+          &header, zero_copy_input_stream_.get(), &clean_eof)) {
+    had_error_ = true;
+    return false;
+  }
+  return true;
+}
+
+bool ShardFileReader::ReadEntry(protobufs::ShardFileEntry& entry) {
+  bool clean_eof = false;
+  if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+          &entry, zero_copy_input_stream_.get(), &clean_eof)) {
+    had_error_ = !clean_eof;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace dredd
@@ -0,0 +1,240 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/shared_runtime.h"
+
+#include <algorithm>
+#include <cassert>
+#include <set>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/dredd_prelude.h"
+#include "libdredd/options.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace dredd {
+
+namespace {
+
+const char* const kGeneratedComment =
+    "// Generated by Dredd: the runtime shared by all mutated source files.\n";
+
+// Mutator functions are generated as static functions of the form
+// "static <signature> {\n<body>}\n", so that they can be added to individual
+// source files. In the shared runtime they have external linkage instead.
+llvm::StringRef StripStatic(const std::string& definition) {
+  llvm::StringRef result(definition);
+  const bool is_static = result.consume_front("static ");
+  (void)is_static;  // Keep release-mode compilers happy.
+  assert(is_static && "Mutator functions should be static.");
+  return result;
+}
+
+// Yields a declaration of the given mutator function.
+std::string GetPrototype(const std::string& definition) {
+  const llvm::StringRef result = StripStatic(definition);
+  return result.substr(0, result.find(" {\n")).str() + ";\n";
+}
+
+// Yields the declaration of the function via which mutated files query whether
+// a mutant is enabled, or record that mutants are covered.
+std::string GetRuntimeFunctionSignature(const Options& options) {
+  return options.GetOnlyTrackMutantCoverage()
+             ? "void __dredd_runtime_record_covered_mutants(int mutation_id, "
+               "int num_mutations)"
+             : "bool __dredd_runtime_enabled_mutation(int mutation_id)";
+}
+
+// Yields a definition of the runtime function that forwards to the function
+// defined by the prelude of the runtime source file.
+std::string GetRuntimeFunctionDefinition(const Options& options) {
+  std::stringstream result;
+  result << GetRuntimeFunctionSignature(options) << " {\n";
+  if (options.GetOnlyTrackMutantCoverage()) {
+    result << "  __dredd_record_covered_mutants(mutation_id, num_mutations);\n";
+  } else {
+    result << "  return __dredd_enabled_mutation(mutation_id);\n";
+  }
+  result << "}\n\n";
+  return result.str();
+}
+
+// A non-owning reference to a callable that takes no arguments, via which
+// mutator functions evaluate operands with side effects on demand. Unlike
+// std::function, constructing it never allocates. The callable, a lambda at
+// the call site of the mutator function, outlives the call.
+const char* const kDreddFunctionRef =
+    "template <typename Result>\n"
+    "class __dredd_function_ref {\n"
+    " public:\n"
+    "  template <typename Callable>\n"
+    "  __dredd_function_ref(const Callable& callable)\n"
+    "      : callable_(&callable),\n"
+    "        call_([](const void* callable) -> Result {\n"
+    "          return (*static_cast<const Callable*>(callable))();\n"
+    "        }) {}\n"
+    "\n"
+    "  Result operator()() const { return call_(callable_); }\n"
+    "\n"
+    " private:\n"
+    "  const void* callable_;\n"
+    "  Result (*call_)(const void*);\n"
+    "};\n"
+    "\n";
+
+bool WriteFile(const std::string& path, const std::string& text) {
+  if (llvm::Error error = llvm::writeToOutput(
+          path, [&](llvm::raw_ostream& output_stream) -> llvm::Error {
+            output_stream << text;
+            return llvm::Error::success();
+          })) {
+    llvm::errs() << "Unable to write file " << path << ": "
+                 << llvm::toString(std::move(error)) << "\n";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+SharedRuntime::SharedRuntime(const Options& options) : options_(&options) {
+  assert(options.GetUseSharedRuntime() &&
+         "A shared runtime should only be used if enabled in the options.");
+}
+
+void SharedRuntime::AddFile(const DeferredMutatedFile& deferred_file) {
+  num_mutations_ += deferred_file.GetNumMutations();
+  std::set<std::string>& dredd_declarations =
+      deferred_file.IsCpp() ? cpp_dredd_declarations_ : c_dredd_declarations_;
+  dredd_declarations.insert(deferred_file.GetDreddDeclarations().begin(),
+                            deferred_file.GetDreddDeclarations().end());
+  if (deferred_file.IsCpp()) {
+    has_cpp_files_ = true;
+  } else {
+    has_c_files_ = true;
+  }
+}
+
+std::string SharedRuntime::GetHeaderText() const {
+  std::stringstream result;
+  result << kGeneratedComment;
+  result << "#ifndef DREDD_RUNTIME_H\n";
+  result << "#define DREDD_RUNTIME_H\n";
+  result << "\n";
+  result << "#ifdef __cplusplus\n";
+  result << "\n";
+  // Only what is needed by the mutator function signatures is provided, so
+  // that including the runtime header is cheap.
+  if (std::any_of(cpp_dredd_declarations_.begin(),
+                  cpp_dredd_declarations_.end(),
+                  [](const std::string& declaration) -> bool {
+                    return llvm::StringRef(GetPrototype(declaration))
+                        .contains("__dredd_function_ref");
+                  })) {
+    result << kDreddFunctionRef;
+  }
+  result << GetRuntimeFunctionSignature(*options_) << ";\n";
+  for (const auto& declaration : cpp_dredd_declarations_) {
+    result << GetPrototype(declaration);
+  }
+  result << "\n";
+  result << "#else\n";
+  result << "\n";
+  result << "#include <stdbool.h>\n";
+  result << "\n";
+  result << GetRuntimeFunctionSignature(*options_) << ";\n";
+  for (const auto& declaration : c_dredd_declarations_) {
+    result << GetPrototype(declaration);
+  }
+  result << "\n";
+  result << "#endif\n";
+  result << "\n";
+  result << "#endif  // DREDD_RUNTIME_H\n";
+  return result.str();
+}
+
+std::string SharedRuntime::GetCppSourceText() const {
+  // The runtime is queried using global mutation ids, so its prelude treats
+  // the whole project as a single file whose first mutation has id zero. At
+  // least one mutation is accounted for, so that the prelude does not declare
+  // an empty array.
+  const int num_mutations = std::max(1, num_mutations_);
+  std::stringstream result;
+  result << kGeneratedComment;
+  result << "#include \"" << kDreddSharedRuntimeHeaderName << "\"\n";
+  result << "\n";
+  result << (options_->GetOnlyTrackMutantCoverage()
+                 ? GetMutantTrackingDreddPreludeCpp(0, num_mutations)
+                 : GetRegularDreddPreludeCpp(0, num_mutations));
+  result << GetRuntimeFunctionDefinition(*options_);
+  for (const auto& declaration : cpp_dredd_declarations_) {
+    result << StripStatic(declaration).str();
+  }
+  return result.str();
+}
+
+std::string SharedRuntime::GetCSourceText() const {
+  // See comments in GetCppSourceText.
+  const int num_mutations = std::max(1, num_mutations_);
+  std::stringstream result;
+  result << kGeneratedComment;
+  result << "#include \"" << kDreddSharedRuntimeHeaderName << "\"\n";
+  result << "\n";
+  result << (options_->GetOnlyTrackMutantCoverage()
+                 ? GetMutantTrackingDreddPreludeC(0, num_mutations)
+                 : GetRegularDreddPreludeC(0, num_mutations));
+  result << GetRuntimeFunctionDefinition(*options_);
+  for (const auto& declaration : c_dredd_declarations_) {
+    result << StripStatic(declaration).str();
+  }
+  return result.str();
+}
+
+bool SharedRuntime::Write(const std::string& runtime_dir) const {
+  if (const std::error_code error_code =
+          llvm::sys::fs::create_directories(runtime_dir)) {
+    llvm::errs() << "Unable to create runtime directory " << runtime_dir
+                 << ": " << error_code.message() << "\n";
+    return false;
+  }
+  llvm::SmallString<128> header_path(runtime_dir);
+  llvm::sys::path::append(header_path, kDreddSharedRuntimeHeaderName);
+  bool result = WriteFile(header_path.str().str(), GetHeaderText());
+  if (has_cpp_files_) {
+    llvm::SmallString<128> cpp_source_path(runtime_dir);
+    llvm::sys::path::append(cpp_source_path, "dredd_runtime.cc");
+    if (!WriteFile(cpp_source_path.str().str(), GetCppSourceText())) {
+      result = false;
+    }
+  }
+  if (has_c_files_) {
+    llvm::SmallString<128> c_source_path(runtime_dir);
+    llvm::sys::path::append(c_source_path, "dredd_runtime.c");
+    if (!WriteFile(c_source_path.str().str(), GetCSourceText())) {
+      result = false;
+    }
+  }
+  return result;
+}
+
+}  // namespace dredd
@@ -0,0 +1,69 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/source_range_cache.h"
+
+#include <utility>
+
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/Preprocessor.h"
+#include "libdredd/util.h"
+
+namespace dredd {
+
+SourceRangeCache::SourceRangeCache(const clang::Preprocessor& preprocessor)
+    : preprocessor_(&preprocessor) {}
+
+clang::SourceRange SourceRangeCache::GetSourceRangeInMainFile(
+    const clang::SourceRange& source_range) {
+  const auto key =
+      std::make_pair(source_range.getBegin(), source_range.getEnd());
+  auto iterator = source_ranges_in_main_file_.find(key);
+  if (iterator == source_ranges_in_main_file_.end()) {
+    iterator = source_ranges_in_main_file_
+                   .try_emplace(key, dredd::GetSourceRangeInMainFile(
+                                         *preprocessor_, source_range))
+                   .first;
+  }
+  return iterator->second;
+}
+
+unsigned int SourceRangeCache::GetTokenLength(clang::SourceLocation location) {
+  auto iterator = token_lengths_.find(location);
+  if (iterator == token_lengths_.end()) {
+    iterator = token_lengths_
+                   .try_emplace(location, clang::Lexer::MeasureTokenLength(
+                                              location, GetSourceManager(),
+                                              preprocessor_->getLangOpts()))
+                   .first;
+  }
+  return iterator->second;
+}
+
+std::pair<unsigned int, unsigned int> SourceRangeCache::GetLineAndColumn(
+    clang::SourceLocation location) {
+  auto iterator = lines_and_columns_.find(location);
+  if (iterator == lines_and_columns_.end()) {
+    const clang::SourceManager& source_manager = GetSourceManager();
+    const unsigned int line = source_manager.getSpellingLineNumber(location);
+    const unsigned int column =
+        source_manager.getSpellingColumnNumber(location);
+    iterator = lines_and_columns_.try_emplace(location, line, column).first;
+  }
+  return iterator->second;
+}
+
+}  // namespace dredd
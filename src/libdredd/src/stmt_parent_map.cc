@@ -0,0 +1,107 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/stmt_parent_map.h"
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/ParentMapContext.h"
+#include "clang/AST/Stmt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Casting.h"
+
+namespace dredd {
+
+StmtParentMap::StmtParentMap(clang::ASTContext& ast_context)
+    : ast_context_(&ast_context) {}
+
+void StmtParentMap::RecordChildren(const clang::Stmt& stmt) {
+  if (llvm::dyn_cast<clang::DeclStmt>(&stmt) != nullptr) {
+    // The children of a declaration statement are the initializers of the
+    // declared variables, whose parents are the variable declarations rather
+    // than the declaration statement.
+    return;
+  }
+  if (const auto* init_list_expr = llvm::dyn_cast<clang::InitListExpr>(&stmt)) {
+    const clang::InitListExpr* syntactic_form =
+        init_list_expr->isSyntacticForm() ? init_list_expr
+                                          : init_list_expr->getSyntacticForm();
+    const clang::InitListExpr* semantic_form =
+        init_list_expr->isSemanticForm() ? init_list_expr
+                                         : init_list_expr->getSemanticForm();
+    if (syntactic_form != nullptr) {
+      for (const auto* child : syntactic_form->children()) {
+        if (child != nullptr) {
+          RecordParent(*child, *syntactic_form);
+        }
+      }
+    }
+    // Only the syntactic form of an initializer list is traversed, so the
+    // parents of the (implicit) nodes of the semantic form are recorded
+    // eagerly.
+    if (semantic_form != nullptr && semantic_form != syntactic_form) {
+      RecordSubtree(*semantic_form);
+    }
+    return;
+  }
+  for (const auto* child : stmt.children()) {
+    if (child != nullptr) {
+      RecordParent(*child, stmt);
+    }
+  }
+}
+
+llvm::ArrayRef<const clang::Stmt*> StmtParentMap::GetParents(
+    const clang::Stmt& stmt) const {
+  auto iterator = parents_.find(&stmt);
+  if (iterator == parents_.end()) {
+    return {};
+  }
+  return iterator->second;
+}
+
+llvm::SmallVector<const clang::Stmt*, 1>
+StmtParentMap::GetParentsFromAstContext(const clang::Stmt& stmt) const {
+  llvm::SmallVector<const clang::Stmt*, 1> result;
+  for (const auto& parent : ast_context_->getParents(stmt)) {
+    if (const auto* parent_stmt = parent.get<clang::Stmt>()) {
+      result.push_back(parent_stmt);
+    }
+  }
+  return result;
+}
+
+void StmtParentMap::RecordParent(const clang::Stmt& child,
+                                 const clang::Stmt& parent) {
+  auto& parents = parents_[&child];
+  if (!llvm::is_contained(parents, &parent)) {
+    parents.push_back(&parent);
+  }
+}
+
+void StmtParentMap::RecordSubtree(const clang::Stmt& stmt) {
+  const bool is_decl_stmt = llvm::dyn_cast<clang::DeclStmt>(&stmt) != nullptr;
+  for (const auto* child : stmt.children()) {
+    if (child != nullptr) {
+      if (!is_decl_stmt) {
+        RecordParent(*child, stmt);
+      }
+      RecordSubtree(*child);
+    }
+  }
+}
+
+}  // namespace dredd
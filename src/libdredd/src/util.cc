@@ -16,16 +16,23 @@
 
 #include <algorithm>
 #include <cassert>
+#include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Expr.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/SourceManager.h"
-#include "clang/Lex/Lexer.h"
 #include "clang/Lex/Preprocessor.h"
+#include "libdredd/mutation_selection.h"
+#include "libdredd/options.h"
+#include "libdredd/source_range_cache.h"
 #include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/xxhash.h"
 
 namespace dredd {
 
@@ -96,36 +103,86 @@ std::string SpaceToUnderscore(const std::string& input) {
   return result;
 }
 
+std::string GetMutatorFunctionMutationIdArgument(const Options& options,
+                                                 int local_mutation_id) {
+  if (options.GetUseSharedRuntime()) {
+    return "__dredd_first_mutation_id + " + std::to_string(local_mutation_id);
+  }
+  return std::to_string(local_mutation_id);
+}
+
+std::string GetMutatorFunctionSwitch(int num_mutants,
+                                     const std::string& cases) {
+  assert(num_mutants > 0 && num_mutants <= 64 &&
+         "Unsupported number of mutants for a mutator function.");
+  return "  switch (__dredd_enabled_alternative(local_mutation_id, " +
+         std::to_string(num_mutants) + ")) {\n" + cases + "  }\n";
+}
+
+std::string GetMutatorFunctionCallableType(
+    bool use_shared_runtime, const std::string& type,
+    const std::string& template_parameter) {
+  if (use_shared_runtime) {
+    return "__dredd_function_ref<" + type + ">";
+  }
+  return template_parameter;
+}
+
+std::string GetMutatorFunctionTemplateHeader(
+    const std::vector<std::string>& template_parameters) {
+  if (template_parameters.empty()) {
+    return "";
+  }
+  std::string result = "template <";
+  for (const auto& template_parameter : template_parameters) {
+    result += "typename " + template_parameter + ", ";
+  }
+  for (size_t i = 0; i < template_parameters.size(); i++) {
+    if (i > 0) {
+      result += ", ";
+    }
+    result += "typename = decltype(std::declval<" + template_parameters[i] +
+              "&>()())";
+  }
+  return result + ">\n";
+}
+
+std::string GetMutatorFunctionNameSuffix(const Options& options) {
+  const MutationSelection& mutation_selection = options.GetMutationSelection();
+  if (mutation_selection.IsEverythingEnabled()) {
+    return "";
+  }
+  return "_selection_" +
+         llvm::utohexstr(llvm::xxHash64(mutation_selection.ToString()));
+}
+
 bool SourceRangeConsistencyCheck(clang::SourceRange source_range,
-                                 const clang::ASTContext& ast_context) {
-  const auto& source_manager = ast_context.getSourceManager();
+                                 SourceRangeCache& source_range_cache) {
   auto char_source_range = clang::CharSourceRange::getTokenRange(source_range);
   assert(char_source_range.isTokenRange() && "Expected a token range.");
   (void)char_source_range;  // Keep release-mode compilers happy.
-  const unsigned int final_token_length = clang::Lexer::MeasureTokenLength(
-      source_range.getEnd(), source_manager, ast_context.getLangOpts());
-
-  const unsigned int start_line =
-      source_manager.getSpellingLineNumber(source_range.getBegin());
-  const unsigned int start_column =
-      source_manager.getSpellingColumnNumber(source_range.getBegin());
-  const unsigned int end_line =
-      source_manager.getSpellingLineNumber(source_range.getEnd());
-  const unsigned int end_column =
-      source_manager.getSpellingColumnNumber(source_range.getEnd()) +
-      final_token_length;
+  const unsigned int final_token_length =
+      source_range_cache.GetTokenLength(source_range.getEnd());
+
+  const auto [start_line, start_column] =
+      source_range_cache.GetLineAndColumn(source_range.getBegin());
+  const auto [end_line, end_token_column] =
+      source_range_cache.GetLineAndColumn(source_range.getEnd());
+  const unsigned int end_column = end_token_column + final_token_length;
 
   return start_line < end_line || start_column < end_column;
 }
 
 InfoForSourceRange::InfoForSourceRange(clang::SourceRange source_range,
-                                       const clang::ASTContext& ast_context) {
-  const auto& source_manager = ast_context.getSourceManager();
+                                       SourceRangeCache& source_range_cache)
+    : source_range_(source_range) {
+  assert(source_range.isValid() && "Expected a valid source range.");
+  const auto& source_manager = source_range_cache.GetSourceManager();
   auto char_source_range = clang::CharSourceRange::getTokenRange(source_range);
   assert(char_source_range.isTokenRange() && "Expected a token range.");
   (void)char_source_range;  // Keep release-mode compilers happy.
-  const unsigned int final_token_length = clang::Lexer::MeasureTokenLength(
-      source_range.getEnd(), source_manager, ast_context.getLangOpts());
+  const unsigned int final_token_length =
+      source_range_cache.GetTokenLength(source_range.getEnd());
 
   auto start_loc_decomposed =
       source_manager.getDecomposedLoc(source_range.getBegin());
@@ -133,12 +190,11 @@ InfoForSourceRange::InfoForSourceRange(clang::SourceRange source_range,
       source_manager.getDecomposedLoc(source_range.getEnd());
   auto buffer_data = source_manager.getBufferData(start_loc_decomposed.first);
 
-  start_line_ = source_manager.getSpellingLineNumber(source_range.getBegin());
-  start_column_ =
-      source_manager.getSpellingColumnNumber(source_range.getBegin());
-  end_line_ = source_manager.getSpellingLineNumber(source_range.getEnd());
-  end_column_ = source_manager.getSpellingColumnNumber(source_range.getEnd()) +
-                final_token_length;
+  std::tie(start_line_, start_column_) =
+      source_range_cache.GetLineAndColumn(source_range.getBegin());
+  std::tie(end_line_, end_column_) =
+      source_range_cache.GetLineAndColumn(source_range.getEnd());
+  end_column_ += final_token_length;
 
   assert((start_line_ < end_line_ || start_column_ < end_column_) &&
          "Bad source range.");
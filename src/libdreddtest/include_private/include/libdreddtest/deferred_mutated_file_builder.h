@@ -0,0 +1,96 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBDREDDTEST_DEFERRED_MUTATED_FILE_BUILDER_H
+#define LIBDREDDTEST_DEFERRED_MUTATED_FILE_BUILDER_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+
+namespace dredd {
+
+// Builds deferred mutated files for tests, so that each test only sets the
+// fields that it cares about. By default, the file is a C file with no
+// mutations and no coverage tracking text, whose text before and after the
+// prelude is "before\n" and "after\n".
+class DeferredMutatedFileBuilder {
+ public:
+  // |filename| is used as both the filename and the output path of the file.
+  explicit DeferredMutatedFileBuilder(std::string filename)
+      : filename_(std::move(filename)) {}
+
+  DeferredMutatedFileBuilder& SetIsCpp(bool is_cpp) {
+    is_cpp_ = is_cpp;
+    return *this;
+  }
+
+  DeferredMutatedFileBuilder& SetNumMutations(int num_mutations) {
+    num_mutations_ = num_mutations;
+    return *this;
+  }
+
+  DeferredMutatedFileBuilder& SetMutationInfoForFile(
+      protobufs::MutationInfoForFile mutation_info_for_file) {
+    mutation_info_for_file_ = std::move(mutation_info_for_file);
+    return *this;
+  }
+
+  // Gives the file a coverage tracking version, with the given text before and
+  // after its prelude.
+  DeferredMutatedFileBuilder& SetCoverageTrackingText(
+      std::string text_before_prelude, std::string text_after_prelude) {
+    has_coverage_tracking_text_ = true;
+    coverage_tracking_text_before_prelude_ = std::move(text_before_prelude);
+    coverage_tracking_text_after_prelude_ = std::move(text_after_prelude);
+    return *this;
+  }
+
+  DeferredMutatedFileBuilder& SetDreddDeclarations(
+      std::vector<std::string> dredd_declarations) {
+    dredd_declarations_ = std::move(dredd_declarations);
+    return *this;
+  }
+
+  [[nodiscard]] DeferredMutatedFile Build() const {
+    return {filename_,
+            filename_,
+            is_cpp_,
+            num_mutations_,
+            "before\n",
+            "after\n",
+            mutation_info_for_file_,
+            has_coverage_tracking_text_,
+            coverage_tracking_text_before_prelude_,
+            coverage_tracking_text_after_prelude_,
+            dredd_declarations_};
+  }
+
+ private:
+  std::string filename_;
+  bool is_cpp_ = false;
+  int num_mutations_ = 0;
+  protobufs::MutationInfoForFile mutation_info_for_file_;
+  bool has_coverage_tracking_text_ = false;
+  std::string coverage_tracking_text_before_prelude_;
+  std::string coverage_tracking_text_after_prelude_;
+  std::vector<std::string> dredd_declarations_;
+};
+
+}  // namespace dredd
+
+#endif  // LIBDREDDTEST_DEFERRED_MUTATED_FILE_BUILDER_H
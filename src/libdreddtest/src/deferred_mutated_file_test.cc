@@ -0,0 +1,93 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/deferred_mutated_file.h"
+
+#include <string>
+
+#include "libdredd/options.h"
+#include "libdreddtest/deferred_mutated_file_builder.h"
+#include "libdreddtest/gtest.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+namespace dredd {
+namespace {
+
+DeferredMutatedFile MakeCoverageTrackingFile(const std::string& output_path) {
+  return DeferredMutatedFileBuilder(output_path)
+      .SetNumMutations(2)
+      .SetCoverageTrackingText("tracking before\n", "tracking after\n")
+      .Build();
+}
+
+std::string GetPathInCurrentDirectory(const std::string& first,
+                                      const std::string& second) {
+  llvm::SmallString<128> result;
+  EXPECT_FALSE(llvm::sys::fs::current_path(result));
+  llvm::sys::path::append(result, first, second);
+  return result.str().str();
+}
+
+TEST(DeferredMutatedFileTest, CoverageTrackingText) {
+  const DeferredMutatedFile deferred_file =
+      MakeCoverageTrackingFile(GetPathInCurrentDirectory("src", "a.c"));
+  ASSERT_TRUE(deferred_file.HasCoverageTrackingText());
+  const Options options = Options().SetAlsoTrackMutantCoverage(true);
+  const std::string mutated_text = deferred_file.GetMutatedText(options, 5);
+  const std::string coverage_tracking_text =
+      deferred_file.GetCoverageTrackingText(options, 5);
+  ASSERT_TRUE(llvm::StringRef(mutated_text).starts_with("before\n"));
+  ASSERT_TRUE(llvm::StringRef(mutated_text).ends_with("after\n"));
+  ASSERT_TRUE(
+      llvm::StringRef(coverage_tracking_text).starts_with("tracking before\n"));
+  ASSERT_TRUE(
+      llvm::StringRef(coverage_tracking_text).ends_with("tracking after\n"));
+  // The two versions of the file have different preludes.
+  ASSERT_NE(mutated_text.substr(7, mutated_text.size() - 13),
+            coverage_tracking_text.substr(
+                16, coverage_tracking_text.size() - 31));
+
+  // Coverage tracking text survives a round trip through a protobuf.
+  const DeferredMutatedFile round_tripped =
+      DeferredMutatedFile::FromProtobuf(deferred_file.ToProtobuf());
+  ASSERT_TRUE(round_tripped.HasCoverageTrackingText());
+  ASSERT_EQ(coverage_tracking_text,
+            round_tripped.GetCoverageTrackingText(options, 5));
+  ASSERT_FALSE(DeferredMutatedFile::FromProtobuf(
+                   DeferredMutatedFileBuilder("a.c").Build().ToProtobuf())
+                   .HasCoverageTrackingText());
+}
+
+TEST(DeferredMutatedFileTest, CoverageTrackingOutputPath) {
+  const DeferredMutatedFile deferred_file =
+      MakeCoverageTrackingFile(GetPathInCurrentDirectory("src", "a.c"));
+  llvm::SmallString<128> expected("tracking");
+  llvm::sys::path::append(expected, "src", "a.c");
+  ASSERT_EQ(expected.str().str(),
+            deferred_file.GetCoverageTrackingOutputPath(".", "tracking"));
+  expected = "tracking";
+  llvm::sys::path::append(expected, "a.c");
+  ASSERT_EQ(expected.str().str(),
+            deferred_file.GetCoverageTrackingOutputPath("src", "tracking"));
+  // Paths are compared component by component.
+  ASSERT_EQ("", deferred_file.GetCoverageTrackingOutputPath("sr", "tracking"));
+  ASSERT_EQ("",
+            deferred_file.GetCoverageTrackingOutputPath("other", "tracking"));
+}
+
+}  // namespace
+}  // namespace dredd
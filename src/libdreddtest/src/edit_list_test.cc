@@ -0,0 +1,121 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/edit_list.h"
+
+#include <string>
+#include <utility>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Expr.h"
+#include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/ASTMatchers/ASTMatchers.h"
+#include "clang/ASTMatchers/ASTMatchersInternal.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/Tooling.h"
+#include "libdreddtest/gtest.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace dredd {
+namespace {
+
+// Offsets:                0123456789012345
+const char* const kCode = "int x = 10 + 2;\n";
+
+TEST(EditListTest, NoEdits) {
+  auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(kCode, {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  const EditList edit_list(ast_unit->getSourceManager(),
+                           ast_unit->getLangOpts());
+  ASSERT_TRUE(edit_list.IsEmpty());
+  ASSERT_EQ(kCode, edit_list.GetRewrittenText());
+}
+
+TEST(EditListTest, InsertionsAtTheSameOffset) {
+  auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(kCode, {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  EditList edit_list(ast_unit->getSourceManager(), ast_unit->getLangOpts());
+  // Insertions before an offset precede all earlier insertions at the offset;
+  // insertions after an offset follow them.
+  edit_list.InsertAfter(8, "c");
+  edit_list.InsertBefore(8, "b");
+  edit_list.InsertAfter(8, "d");
+  edit_list.InsertBefore(8, "a");
+  edit_list.InsertAfter(16, "e");
+  ASSERT_EQ(5, edit_list.GetNumEdits());
+  ASSERT_EQ("int x = abcd10 + 2;\ne", edit_list.GetRewrittenText());
+}
+
+TEST(EditListTest, ReplacementsAndSurroundingInsertions) {
+  auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(kCode, {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  EditList edit_list(ast_unit->getSourceManager(), ast_unit->getLangOpts());
+  // This simulates the way in which a binary operator is replaced with a call
+  // to a function.
+  edit_list.Replace(11, 1, ",");
+  edit_list.InsertBefore(8, "f(");
+  edit_list.InsertAfter(14, ", 0)");
+  // Text inserted at the start of a replaced range precedes the replacement.
+  edit_list.InsertAfter(11, "/*op*/");
+  edit_list.Replace(4, 1, "y");
+  edit_list.Replace(6, 0, "=");
+  ASSERT_EQ("int y == f(10 /*op*/, 2, 0);\n", edit_list.GetRewrittenText());
+}
+
+TEST(EditListTest, SplitAtOffset) {
+  auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(kCode, {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  EditList edit_list(ast_unit->getSourceManager(), ast_unit->getLangOpts());
+  edit_list.InsertBefore(0, "A");
+  edit_list.InsertBefore(4, "B");
+  edit_list.InsertAfter(4, "C");
+  edit_list.Replace(8, 2, "D");
+  // Text inserted at the split offset belongs to the text after the split.
+  ASSERT_EQ(std::make_pair(std::string(), std::string("Aint BCx = D + 2;\n")),
+            edit_list.GetRewrittenTextSplitAt(0));
+  ASSERT_EQ(std::make_pair(std::string("Aint "), std::string("BCx = D + 2;\n")),
+            edit_list.GetRewrittenTextSplitAt(4));
+  ASSERT_EQ(std::make_pair(std::string("Aint BCx = D + 2;\n"), std::string()),
+            edit_list.GetRewrittenTextSplitAt(16));
+  // Splitting does not disturb the edits.
+  ASSERT_EQ("Aint BCx = D + 2;\n", edit_list.GetRewrittenText());
+}
+
+TEST(EditListTest, LocationBasedEdits) {
+  auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(kCode, {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  EditList edit_list(ast_unit->getSourceManager(), ast_unit->getLangOpts());
+
+  auto binary_operator = clang::ast_matchers::match(
+      clang::ast_matchers::binaryOperator().bind("op"),
+      ast_unit->getASTContext());
+  ASSERT_EQ(1, binary_operator.size());
+  const auto* op = binary_operator[0].getNodeAs<clang::BinaryOperator>("op");
+  ASSERT_EQ(8, edit_list.GetOffset(op->getBeginLoc()));
+
+  ASSERT_FALSE(edit_list.InsertTextBefore(op->getBeginLoc(), "f("));
+  ASSERT_FALSE(edit_list.InsertTextAfterToken(op->getLHS()->getEndLoc(), ")"));
+  ASSERT_FALSE(edit_list.ReplaceText(op->getOperatorLoc(), 1, "-"));
+  ASSERT_FALSE(edit_list.ReplaceText(op->getRHS()->getSourceRange(), "3"));
+  ASSERT_FALSE(edit_list.InsertTextAfterToken(op->getEndLoc(), ";"));
+  ASSERT_EQ("int x = f(10) - 3;;\n", edit_list.GetRewrittenText());
+
+  // Locations that are not in the main file cannot be edited.
+  ASSERT_TRUE(edit_list.InsertTextBefore(clang::SourceLocation(), "x"));
+}
+
+}  // namespace
+}  // namespace dredd
@@ -0,0 +1,88 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/expr_analysis_cache.h"
+
+#include <string>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Expr.h"
+#include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/ASTMatchers/ASTMatchers.h"
+#include "clang/ASTMatchers/ASTMatchersInternal.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/Tooling.h"
+#include "libdreddtest/gtest.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace dredd {
+namespace {
+
+TEST(ExprAnalysisCacheTest, ConstantAndNonConstantOperands) {
+  const std::string original = "void foo(int x) { x + (2 * 3); }";
+  auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(original, {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  ExprAnalysisCache analysis_cache(ast_unit->getASTContext());
+
+  auto binary_operator = clang::ast_matchers::match(
+      clang::ast_matchers::binaryOperator(
+          clang::ast_matchers::hasOperatorName("+"))
+          .bind("op"),
+      ast_unit->getASTContext());
+  ASSERT_EQ(1, binary_operator.size());
+  const auto* op = binary_operator[0].getNodeAs<clang::BinaryOperator>("op");
+
+  // Query each property twice, so that the second query is served from the
+  // cache.
+  for (int i = 0; i < 2; i++) {
+    ASSERT_FALSE(analysis_cache.GetIntValue(*op->getLHS()).has_value());
+    auto rhs_value = analysis_cache.GetIntValue(*op->getRHS());
+    ASSERT_TRUE(rhs_value.has_value());
+    ASSERT_EQ(6, rhs_value.value().getExtValue());
+    ASSERT_FALSE(analysis_cache.GetFloatValue(*op->getRHS()).has_value());
+    ASSERT_TRUE(analysis_cache.IsCxx11ConstantExpr(*op->getRHS()));
+    ASSERT_FALSE(analysis_cache.IsCxx11ConstantExpr(*op->getLHS()));
+    ASSERT_FALSE(analysis_cache.HasSideEffects(*op));
+  }
+}
+
+TEST(ExprAnalysisCacheTest, SideEffectsAndBooleans) {
+  const std::string original = "void foo(int x) { x++; !true; }";
+  auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(original, {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  ExprAnalysisCache analysis_cache(ast_unit->getASTContext());
+
+  auto unary_operator = clang::ast_matchers::match(
+      clang::ast_matchers::unaryOperator().bind("op"),
+      ast_unit->getASTContext());
+  ASSERT_EQ(2, unary_operator.size());
+  for (const auto& match : unary_operator) {
+    const auto* op = match.getNodeAs<clang::UnaryOperator>("op");
+    if (op->getOpcode() == clang::UO_PostInc) {
+      ASSERT_TRUE(analysis_cache.HasSideEffects(*op));
+      ASSERT_TRUE(analysis_cache.HasSideEffects(*op));
+      ASSERT_FALSE(analysis_cache.GetBoolValue(*op).has_value());
+    } else {
+      ASSERT_EQ(clang::UO_LNot, op->getOpcode());
+      ASSERT_FALSE(analysis_cache.HasSideEffects(*op));
+      auto value = analysis_cache.GetBoolValue(*op);
+      ASSERT_TRUE(value.has_value());
+      ASSERT_FALSE(value.value());
+    }
+  }
+}
+
+}  // namespace
+}  // namespace dredd
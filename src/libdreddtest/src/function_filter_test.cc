@@ -0,0 +1,81 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/function_filter.h"
+
+#include <string>
+
+#include "libdreddtest/gtest.h"
+
+namespace dredd {
+namespace {
+
+TEST(FunctionFilterTest, EmptyFilterMutatesEverything) {
+  const FunctionFilter filter;
+  ASSERT_TRUE(filter.ShouldMutate("foo"));
+  ASSERT_TRUE(filter.ShouldMutate("ns::Class::Method"));
+  ASSERT_EQ("", filter.ToString());
+}
+
+TEST(FunctionFilterTest, MutatePatterns) {
+  FunctionFilter filter;
+  std::string error_message;
+  ASSERT_TRUE(filter.AddMutatePattern("compute::.*", error_message));
+  ASSERT_TRUE(filter.AddMutatePattern("main", error_message));
+  ASSERT_TRUE(filter.ShouldMutate("compute::Sum"));
+  ASSERT_TRUE(filter.ShouldMutate("compute::Matrix::Multiply"));
+  ASSERT_TRUE(filter.ShouldMutate("main"));
+  // Patterns must match whole names.
+  ASSERT_FALSE(filter.ShouldMutate("precompute::Sum"));
+  ASSERT_FALSE(filter.ShouldMutate("domain"));
+  ASSERT_FALSE(filter.ShouldMutate("main2"));
+}
+
+TEST(FunctionFilterTest, SkipPatternsTakePrecedence) {
+  FunctionFilter filter;
+  std::string error_message;
+  ASSERT_TRUE(
+      filter.AddSkipPattern("logging::.*|.*::Serialize", error_message));
+  ASSERT_FALSE(filter.ShouldMutate("logging::Write"));
+  ASSERT_FALSE(filter.ShouldMutate("proto::Message::Serialize"));
+  ASSERT_TRUE(filter.ShouldMutate("proto::Message::Parse"));
+  ASSERT_TRUE(filter.AddMutatePattern("proto::.*", error_message));
+  ASSERT_FALSE(filter.ShouldMutate("proto::Message::Serialize"));
+  ASSERT_TRUE(filter.ShouldMutate("proto::Message::Parse"));
+  ASSERT_FALSE(filter.ShouldMutate("main"));
+}
+
+TEST(FunctionFilterTest, InvalidPatterns) {
+  FunctionFilter filter;
+  std::string error_message;
+  ASSERT_FALSE(filter.AddMutatePattern("foo(", error_message));
+  ASSERT_FALSE(error_message.empty());
+  ASSERT_FALSE(filter.AddSkipPattern("[a-", error_message));
+  ASSERT_FALSE(filter.AddSkipPattern("a\nb", error_message));
+  // Invalid patterns are not added.
+  ASSERT_TRUE(filter.ShouldMutate("foo"));
+  ASSERT_EQ("", filter.ToString());
+}
+
+TEST(FunctionFilterTest, ToStringDistinguishesMutateAndSkipPatterns) {
+  FunctionFilter mutate_filter;
+  FunctionFilter skip_filter;
+  std::string error_message;
+  ASSERT_TRUE(mutate_filter.AddMutatePattern("foo", error_message));
+  ASSERT_TRUE(skip_filter.AddSkipPattern("foo", error_message));
+  ASSERT_NE(mutate_filter.ToString(), skip_filter.ToString());
+}
+
+}  // namespace
+}  // namespace dredd
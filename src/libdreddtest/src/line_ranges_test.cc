@@ -0,0 +1,176 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/line_ranges.h"
+
+#include <string>
+
+#include "libdreddtest/gtest.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+namespace dredd {
+namespace {
+
+// Resolves |filename| against the current directory, as the file names of a
+// diff are.
+std::string MakeAbsolute(llvm::StringRef filename) {
+  llvm::SmallString<256> result(filename);
+  llvm::sys::fs::make_absolute(result);
+  llvm::sys::path::remove_dots(result, /*remove_dot_dot=*/true);
+  return result.str().str();
+}
+
+TEST(LineRangesTest, Empty) {
+  const LineRanges line_ranges;
+  ASSERT_TRUE(line_ranges.IsEmpty());
+  ASSERT_FALSE(line_ranges.Overlaps(1, 100));
+  ASSERT_EQ("", line_ranges.ToString());
+}
+
+TEST(LineRangesTest, Overlaps) {
+  LineRanges line_ranges;
+  line_ranges.Add(5, 7);
+  line_ranges.Add(10, 10);
+  ASSERT_FALSE(line_ranges.Overlaps(1, 4));
+  ASSERT_TRUE(line_ranges.Overlaps(1, 5));
+  ASSERT_TRUE(line_ranges.Overlaps(6, 6));
+  ASSERT_TRUE(line_ranges.Overlaps(7, 9));
+  ASSERT_FALSE(line_ranges.Overlaps(8, 9));
+  ASSERT_TRUE(line_ranges.Overlaps(2, 20));
+  ASSERT_TRUE(line_ranges.Overlaps(10, 10));
+  ASSERT_FALSE(line_ranges.Overlaps(11, 20));
+}
+
+TEST(LineRangesTest, MergesOverlappingAndAdjacentRanges) {
+  LineRanges line_ranges;
+  line_ranges.Add(10, 12);
+  line_ranges.Add(1, 2);
+  line_ranges.Add(20, 20);
+  ASSERT_EQ("1-2,10-12,20", line_ranges.ToString());
+  line_ranges.Add(3, 3);
+  ASSERT_EQ("1-3,10-12,20", line_ranges.ToString());
+  line_ranges.Add(11, 19);
+  ASSERT_EQ("1-3,10-20", line_ranges.ToString());
+  line_ranges.Add(2, 25);
+  ASSERT_EQ("1-25", line_ranges.ToString());
+}
+
+TEST(LineRangeFilterTest, FilesAreIdentifiedByNormalisedPath) {
+  LineRangeFilter filter;
+  filter.Add("/nonexistent/src/foo.cc", 3, 4);
+  filter.Add("/nonexistent/src/../src/./foo.cc", 8, 8);
+  ASSERT_EQ("3-4,8",
+            filter.GetLineRangesForFile("/nonexistent/src/foo.cc").ToString());
+  ASSERT_TRUE(filter.GetLineRangesForFile("/nonexistent/src/bar.cc").IsEmpty());
+}
+
+TEST(LineRangeFilterTest, ParseSpecification) {
+  LineRangeFilter filter;
+  std::string error_message;
+  ASSERT_TRUE(ParseLineRangesSpecification("/nonexistent/foo.cc:3,10-20,5",
+                                           filter, error_message));
+  ASSERT_EQ("3,5,10-20",
+            filter.GetLineRangesForFile("/nonexistent/foo.cc").ToString());
+}
+
+TEST(LineRangeFilterTest, ParseInvalidSpecifications) {
+  LineRangeFilter filter;
+  std::string error_message;
+  ASSERT_FALSE(ParseLineRangesSpecification("/nonexistent/foo.cc", filter,
+                                            error_message));
+  ASSERT_FALSE(ParseLineRangesSpecification("/nonexistent/foo.cc:", filter,
+                                            error_message));
+  ASSERT_FALSE(ParseLineRangesSpecification(":1-2", filter, error_message));
+  ASSERT_FALSE(ParseLineRangesSpecification("/nonexistent/foo.cc:0", filter,
+                                            error_message));
+  ASSERT_FALSE(ParseLineRangesSpecification("/nonexistent/foo.cc:5-3", filter,
+                                            error_message));
+  ASSERT_FALSE(ParseLineRangesSpecification("/nonexistent/foo.cc:1,,2", filter,
+                                            error_message));
+  ASSERT_FALSE(ParseLineRangesSpecification("/nonexistent/foo.cc:x", filter,
+                                            error_message));
+}
+
+TEST(LineRangeFilterTest, ParseUnifiedDiff) {
+  const std::string diff =
+      "diff --git a/nonexistent/foo.cc b/nonexistent/foo.cc\n"
+      "index 0123456..789abcd 100644\n"
+      "--- a/nonexistent/foo.cc\n"
+      "+++ b/nonexistent/foo.cc\n"
+      "@@ -1,6 +1,6 @@ int main() {\n"
+      " int a = 1;\n"
+      "-int b = 2;\n"
+      "+int b = 3;\n"
+      "+int c = 4;\n"
+      " int d = 5;\n"
+      "-int e = 6;\n"
+      " int f = 7;\n"
+      "\n"
+      "@@ -20 +21,0 @@\n"
+      "--- removed line that looks like a header\n"
+      "diff --git a/nonexistent/bar.cc b/nonexistent/bar.cc\n"
+      "deleted file mode 100644\n"
+      "--- a/nonexistent/bar.cc\n"
+      "+++ /dev/null\n"
+      "@@ -1,2 +0,0 @@\n"
+      "-int x;\n"
+      "-int y;\n"
+      "diff --git a/nonexistent/baz.cc b/nonexistent/baz.cc\n"
+      "new file mode 100644\n"
+      "--- /dev/null\n"
+      "+++ b/nonexistent/baz.cc\n"
+      "@@ -0,0 +1,2 @@\n"
+      "+int z;\n"
+      "+++z;\n"
+      "\\ No newline at end of file\n";
+  LineRangeFilter filter;
+  std::string error_message;
+  ASSERT_TRUE(ParseUnifiedDiff(diff, filter, error_message)) << error_message;
+  // Lines 2 and 3 are added or changed. Line 5 is removed, so the lines that
+  // now surround it, 4 and 5, are considered changed. After line 21, a line is
+  // removed, so lines 21 and 22 are considered changed. A line consisting of
+  // just a newline is an unchanged line.
+  ASSERT_EQ("2-5,21-22",
+            filter.GetLineRangesForFile(MakeAbsolute("nonexistent/foo.cc"))
+                .ToString());
+  ASSERT_TRUE(filter.GetLineRangesForFile(MakeAbsolute("nonexistent/bar.cc"))
+                  .IsEmpty());
+  ASSERT_EQ("1-2",
+            filter.GetLineRangesForFile(MakeAbsolute("nonexistent/baz.cc"))
+                .ToString());
+}
+
+TEST(LineRangeFilterTest, ParseInvalidUnifiedDiffs) {
+  LineRangeFilter filter;
+  std::string error_message;
+  // A hunk without a file header.
+  ASSERT_FALSE(
+      ParseUnifiedDiff("@@ -1 +1 @@\n-a\n+b\n", filter, error_message));
+  // A malformed hunk header.
+  ASSERT_FALSE(ParseUnifiedDiff("+++ b/nonexistent/foo.cc\n@@ -1 1 @@\n",
+                                filter, error_message));
+  // A hunk with an unexpected line.
+  ASSERT_FALSE(ParseUnifiedDiff("+++ b/nonexistent/foo.cc\n@@ -1 +1 @@\n?\n",
+                                filter, error_message));
+  // A truncated hunk.
+  ASSERT_FALSE(
+      ParseUnifiedDiff("+++ b/nonexistent/foo.cc\n@@ -1,2 +1,2 @@\n-a\n",
+                       filter, error_message));
+}
+
+}  // namespace
+}  // namespace dredd
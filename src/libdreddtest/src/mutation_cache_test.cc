@@ -0,0 +1,172 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/mutation_cache.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/options.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdreddtest/deferred_mutated_file_builder.h"
+#include "libdreddtest/gtest.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace dredd {
+namespace {
+
+class MutationCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("dredd-mutation-cache",
+                                                      temp_directory_));
+    source_path_ = GetPath("source.c");
+    header_path_ = GetPath("header.h");
+    WriteFile(source_path_, "#include \"header.h\"\nint foo() { return X; }\n");
+    WriteFile(header_path_, "#define X 1\n");
+  }
+
+  void TearDown() override {
+    ASSERT_FALSE(llvm::sys::fs::remove_directories(temp_directory_));
+  }
+
+  [[nodiscard]] std::string GetPath(const std::string& filename) const {
+    llvm::SmallString<128> result(temp_directory_);
+    llvm::sys::path::append(result, filename);
+    return result.str().str();
+  }
+
+  static void WriteFile(const std::string& path, llvm::StringRef contents) {
+    ASSERT_FALSE(llvm::writeToOutput(
+        path, [contents](llvm::raw_ostream& output_stream) -> llvm::Error {
+          output_stream << contents;
+          return llvm::Error::success();
+        }));
+  }
+
+  [[nodiscard]] std::vector<clang::tooling::CompileCommand> GetCompileCommands(
+      const std::string& flag) const {
+    return {clang::tooling::CompileCommand(temp_directory_.str(), source_path_,
+                                           {"clang", flag, source_path_}, "")};
+  }
+
+  [[nodiscard]] DeferredMutatedFile MakeDeferredMutatedFile() const {
+    protobufs::MutationInfoForFile mutation_info_for_file;
+    mutation_info_for_file.set_filename(source_path_);
+    return DeferredMutatedFileBuilder(source_path_)
+        .SetNumMutations(3)
+        .SetMutationInfoForFile(mutation_info_for_file)
+        .Build();
+  }
+
+  llvm::SmallString<128> temp_directory_;
+  std::string source_path_;
+  std::string header_path_;
+};
+
+TEST_F(MutationCacheTest, KeyDependsOnSourceCommandAndFingerprint) {
+  const MutationCache cache(temp_directory_.str().str(), "fingerprint");
+  const std::optional<std::string> key =
+      cache.ComputeKey(source_path_, GetCompileCommands("-O0"));
+  ASSERT_TRUE(key.has_value());
+  ASSERT_EQ(key, cache.ComputeKey(source_path_, GetCompileCommands("-O0")));
+  ASSERT_NE(key, cache.ComputeKey(source_path_, GetCompileCommands("-O1")));
+
+  const MutationCache other_cache(temp_directory_.str().str(), "other");
+  ASSERT_NE(key,
+            other_cache.ComputeKey(source_path_, GetCompileCommands("-O0")));
+
+  WriteFile(source_path_, "int foo() { return 2; }\n");
+  ASSERT_NE(key, cache.ComputeKey(source_path_, GetCompileCommands("-O0")));
+
+  ASSERT_FALSE(cache
+                   .ComputeKey(GetPath("does_not_exist.c"),
+                               GetCompileCommands("-O0"))
+                   .has_value());
+}
+
+TEST_F(MutationCacheTest, StoreThenLookup) {
+  MutationCache cache(temp_directory_.str().str(), "fingerprint");
+  const std::string key =
+      cache.ComputeKey(source_path_, GetCompileCommands("-O0")).value();
+  std::vector<DeferredMutatedFile> deferred_files;
+  ASSERT_FALSE(cache.Lookup(key, deferred_files));
+  ASSERT_TRUE(deferred_files.empty());
+
+  // The header is given relative to the working directory.
+  ASSERT_TRUE(cache.Store(key, temp_directory_.str().str(),
+                          {source_path_, "header.h"},
+                          {MakeDeferredMutatedFile()}));
+  ASSERT_TRUE(cache.Lookup(key, deferred_files));
+  ASSERT_EQ(1, deferred_files.size());
+  ASSERT_EQ(source_path_, deferred_files[0].GetFilename());
+  ASSERT_EQ(3, deferred_files[0].GetNumMutations());
+  const Options options;
+  ASSERT_EQ(MakeDeferredMutatedFile().GetMutatedText(options, 10),
+            deferred_files[0].GetMutatedText(options, 10));
+  ASSERT_EQ(1, cache.GetNumHits());
+  ASSERT_EQ(1, cache.GetNumMisses());
+}
+
+TEST_F(MutationCacheTest, NoMutations) {
+  MutationCache cache(temp_directory_.str().str(), "fingerprint");
+  const std::string key =
+      cache.ComputeKey(source_path_, GetCompileCommands("-O0")).value();
+  ASSERT_TRUE(cache.Store(key, temp_directory_.str().str(), {source_path_},
+                          {}));
+  std::vector<DeferredMutatedFile> deferred_files;
+  ASSERT_TRUE(cache.Lookup(key, deferred_files));
+  ASSERT_TRUE(deferred_files.empty());
+}
+
+TEST_F(MutationCacheTest, ChangedDependencyInvalidatesEntry) {
+  MutationCache cache(temp_directory_.str().str(), "fingerprint");
+  const std::string key =
+      cache.ComputeKey(source_path_, GetCompileCommands("-O0")).value();
+  ASSERT_TRUE(cache.Store(key, temp_directory_.str().str(),
+                          {source_path_, header_path_},
+                          {MakeDeferredMutatedFile()}));
+  WriteFile(header_path_, "#define X 2\n");
+  std::vector<DeferredMutatedFile> deferred_files;
+  ASSERT_FALSE(cache.Lookup(key, deferred_files));
+  ASSERT_TRUE(deferred_files.empty());
+
+  // A dependency that no longer exists also invalidates the entry.
+  ASSERT_TRUE(cache.Store(key, temp_directory_.str().str(),
+                          {source_path_, header_path_},
+                          {MakeDeferredMutatedFile()}));
+  ASSERT_FALSE(llvm::sys::fs::remove(header_path_));
+  ASSERT_FALSE(cache.Lookup(key, deferred_files));
+}
+
+TEST_F(MutationCacheTest, CorruptEntryIsAMiss) {
+  MutationCache cache(temp_directory_.str().str(), "fingerprint");
+  const std::string key =
+      cache.ComputeKey(source_path_, GetCompileCommands("-O0")).value();
+  WriteFile(GetPath(key + ".dredd-cache"), "not a cache entry");
+  std::vector<DeferredMutatedFile> deferred_files;
+  ASSERT_FALSE(cache.Lookup(key, deferred_files));
+  ASSERT_TRUE(deferred_files.empty());
+}
+
+}  // namespace
+}  // namespace dredd
@@ -0,0 +1,153 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/mutation_counts.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdreddtest/gtest.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace dredd {
+namespace {
+
+protobufs::MutationGroup MakeRemoveStmt() {
+  protobufs::MutationGroup result;
+  result.mutable_remove_stmt()->set_mutation_id(0);
+  return result;
+}
+
+protobufs::MutationGroup MakeReplaceBinaryOperator() {
+  protobufs::MutationGroup result;
+  protobufs::MutationReplaceBinaryOperator* replace_binary_operator =
+      result.mutable_replace_binary_operator();
+  replace_binary_operator->add_instances()->set_action(
+      protobufs::ReplaceWithLHS);
+  replace_binary_operator->add_instances()->set_action(
+      protobufs::ReplaceWithRHS);
+  return result;
+}
+
+void CheckActionCount(const protobufs::ActionCount& action_count,
+                      const std::string& kind, const std::string& action,
+                      int num_mutations) {
+  ASSERT_EQ(kind, action_count.kind());
+  ASSERT_EQ(action, action_count.action());
+  ASSERT_EQ(num_mutations, action_count.num_mutations());
+}
+
+TEST(MutationCountsTest, GetMutantKindsAndActions) {
+  const std::vector<std::pair<std::string, std::string>> expected_remove_stmt =
+      {{"remove_stmt", "RemoveStmt"}};
+  ASSERT_EQ(expected_remove_stmt, GetMutantKindsAndActions(MakeRemoveStmt()));
+  const std::vector<std::pair<std::string, std::string>>
+      expected_replace_binary_operator = {
+          {"replace_binary_operator", "ReplaceWithLHS"},
+          {"replace_binary_operator", "ReplaceWithRHS"}};
+  ASSERT_EQ(expected_replace_binary_operator,
+            GetMutantKindsAndActions(MakeReplaceBinaryOperator()));
+  // A mutation group without any instances has no mutants.
+  protobufs::MutationGroup empty_group;
+  empty_group.mutable_replace_expr();
+  ASSERT_TRUE(GetMutantKindsAndActions(empty_group).empty());
+}
+
+TEST(MutationCountsTest, CountsForFile) {
+  MutationCounter mutation_counter;
+  mutation_counter.Add("foo", MakeReplaceBinaryOperator());
+  mutation_counter.Add("foo", MakeRemoveStmt());
+  mutation_counter.Add("bar", MakeRemoveStmt());
+  mutation_counter.Add("", MakeReplaceBinaryOperator());
+
+  const protobufs::FileMutationCounts counts =
+      mutation_counter.GetCountsForFile("a.cc");
+  ASSERT_EQ("a.cc", counts.filename());
+  ASSERT_EQ(6, counts.num_mutations());
+  ASSERT_EQ(3, counts.actions_size());
+  CheckActionCount(counts.actions(0), "remove_stmt", "RemoveStmt", 2);
+  CheckActionCount(counts.actions(1), "replace_binary_operator",
+                   "ReplaceWithLHS", 2);
+  CheckActionCount(counts.actions(2), "replace_binary_operator",
+                   "ReplaceWithRHS", 2);
+
+  // Functions are sorted by name, with mutants outside any function first.
+  ASSERT_EQ(3, counts.functions_size());
+  ASSERT_EQ("", counts.functions(0).function());
+  ASSERT_EQ(2, counts.functions(0).num_mutations());
+  ASSERT_EQ("bar", counts.functions(1).function());
+  ASSERT_EQ(1, counts.functions(1).num_mutations());
+  ASSERT_EQ(1, counts.functions(1).actions_size());
+  CheckActionCount(counts.functions(1).actions(0), "remove_stmt", "RemoveStmt",
+                   1);
+  ASSERT_EQ("foo", counts.functions(2).function());
+  ASSERT_EQ(3, counts.functions(2).num_mutations());
+  ASSERT_EQ(3, counts.functions(2).actions_size());
+}
+
+TEST(MutationCountsTest, CountsForFileWithoutMutants) {
+  MutationCounter mutation_counter;
+  protobufs::MutationGroup empty_group;
+  empty_group.mutable_replace_unary_operator();
+  mutation_counter.Add("foo", empty_group);
+  const protobufs::FileMutationCounts counts =
+      mutation_counter.GetCountsForFile("a.cc");
+  ASSERT_EQ(0, counts.num_mutations());
+  ASSERT_EQ(0, counts.actions_size());
+  ASSERT_EQ(0, counts.functions_size());
+}
+
+TEST(MutationCountsTest, AddFileMutationCounts) {
+  MutationCounter first_counter;
+  first_counter.Add("foo", MakeReplaceBinaryOperator());
+  MutationCounter second_counter;
+  second_counter.Add("bar", MakeRemoveStmt());
+  second_counter.Add("bar", MakeReplaceBinaryOperator());
+
+  protobufs::MutationCounts counts;
+  AddFileMutationCounts(first_counter.GetCountsForFile("b.cc"), counts);
+  AddFileMutationCounts(second_counter.GetCountsForFile("a.cc"), counts);
+
+  // Files are kept in the order in which they were added.
+  ASSERT_EQ(2, counts.files_size());
+  ASSERT_EQ("b.cc", counts.files(0).filename());
+  ASSERT_EQ("a.cc", counts.files(1).filename());
+  ASSERT_EQ(5, counts.num_mutations());
+  ASSERT_EQ(3, counts.actions_size());
+  CheckActionCount(counts.actions(0), "remove_stmt", "RemoveStmt", 1);
+  CheckActionCount(counts.actions(1), "replace_binary_operator",
+                   "ReplaceWithLHS", 2);
+  CheckActionCount(counts.actions(2), "replace_binary_operator",
+                   "ReplaceWithRHS", 2);
+}
+
+TEST(MutationCountsTest, WriteMutationCounts) {
+  MutationCounter mutation_counter;
+  mutation_counter.Add("foo", MakeRemoveStmt());
+  protobufs::MutationCounts counts;
+  AddFileMutationCounts(mutation_counter.GetCountsForFile("a.cc"), counts);
+  std::string output;
+  llvm::raw_string_ostream stream(output);
+  ASSERT_TRUE(WriteMutationCounts(counts, stream));
+  stream.flush();
+  ASSERT_NE(std::string::npos, output.find("\"numMutations\": 1"));
+  ASSERT_NE(std::string::npos, output.find("\"function\": \"foo\""));
+  // Primitive fields are always printed.
+  ASSERT_NE(std::string::npos, output.find("\"filesWithErrors\": []"));
+}
+
+}  // namespace
+}  // namespace dredd
@@ -0,0 +1,201 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/mutation_info_writer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "libdredd/mutation_info_binary_format.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdreddtest/gtest.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+
+namespace dredd {
+namespace {
+
+class MutationInfoWriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("dredd-mutation-info",
+                                                      temp_directory_));
+    llvm::SmallString<128> path(temp_directory_);
+    llvm::sys::path::append(path, "info.json");
+    output_path_ = path.str().str();
+  }
+
+  void TearDown() override {
+    ASSERT_FALSE(llvm::sys::fs::remove_directories(temp_directory_));
+  }
+
+  // Writes mutation info for the given files using the given format.
+  void WriteMutationInfo(const std::vector<std::string>& filenames,
+                         MutationInfoWriter::Format format) const {
+    MutationInfoWriter writer(output_path_, format);
+    ASSERT_TRUE(writer.IsOpen());
+    for (const auto& filename : filenames) {
+      protobufs::MutationInfoForFile mutation_info_for_file;
+      mutation_info_for_file.set_filename(filename);
+      protobufs::MutationRemoveStmt* remove_stmt =
+          mutation_info_for_file.add_mutation_tree()
+              ->add_mutation_groups()
+              ->mutable_remove_stmt();
+      remove_stmt->set_mutation_id(static_cast<int>(filename.size()));
+      remove_stmt->set_snippet("x = \"y\";\n");
+      writer.Write(mutation_info_for_file);
+    }
+    ASSERT_TRUE(writer.Finish());
+  }
+
+  [[nodiscard]] std::string ReadOutput() const {
+    auto buffer = llvm::MemoryBuffer::getFile(output_path_);
+    EXPECT_TRUE(buffer);
+    return buffer ? buffer.get()->getBuffer().str() : "";
+  }
+
+  llvm::SmallString<128> temp_directory_;
+  std::string output_path_;
+};
+
+TEST_F(MutationInfoWriterTest, Json) {
+  WriteMutationInfo({"a.c", "bb.cc"}, MutationInfoWriter::Format::kJson);
+  llvm::Expected<llvm::json::Value> json = llvm::json::parse(ReadOutput());
+  ASSERT_TRUE(static_cast<bool>(json));
+  const llvm::json::Array* info_for_files =
+      json->getAsObject()->getArray("infoForFiles");
+  ASSERT_NE(nullptr, info_for_files);
+  ASSERT_EQ(2, info_for_files->size());
+  ASSERT_EQ("a.c", (*info_for_files)[0].getAsObject()->getString("filename"));
+  ASSERT_EQ("bb.cc",
+            (*info_for_files)[1].getAsObject()->getString("filename"));
+  const llvm::json::Object* remove_stmt = (*info_for_files)[1]
+                                              .getAsObject()
+                                              ->getArray("mutationTree")
+                                              ->front()
+                                              .getAsObject()
+                                              ->getArray("mutationGroups")
+                                              ->front()
+                                              .getAsObject()
+                                              ->getObject("removeStmt");
+  ASSERT_NE(nullptr, remove_stmt);
+  ASSERT_EQ(5, remove_stmt->getInteger("mutationId"));
+  ASSERT_EQ("x = \"y\";\n", remove_stmt->getString("snippet"));
+}
+
+TEST_F(MutationInfoWriterTest, JsonNoFiles) {
+  WriteMutationInfo({}, MutationInfoWriter::Format::kJson);
+  llvm::Expected<llvm::json::Value> json = llvm::json::parse(ReadOutput());
+  ASSERT_TRUE(static_cast<bool>(json));
+  const llvm::json::Array* info_for_files =
+      json->getAsObject()->getArray("infoForFiles");
+  ASSERT_NE(nullptr, info_for_files);
+  ASSERT_TRUE(info_for_files->empty());
+}
+
+TEST_F(MutationInfoWriterTest, JsonLines) {
+  WriteMutationInfo({"a.c", "bb.cc"}, MutationInfoWriter::Format::kJsonLines);
+  const std::string output = ReadOutput();
+  llvm::SmallVector<llvm::StringRef> lines;
+  llvm::StringRef(output).split(lines, '\n', -1, /*KeepEmpty=*/false);
+  ASSERT_EQ(2, lines.size());
+  for (size_t i = 0; i < lines.size(); i++) {
+    llvm::Expected<llvm::json::Value> json = llvm::json::parse(lines[i]);
+    ASSERT_TRUE(static_cast<bool>(json));
+    ASSERT_EQ(i == 0 ? "a.c" : "bb.cc",
+              json->getAsObject()->getString("filename"));
+  }
+}
+
+// Reads a little-endian integer of the given size from the given offset.
+uint64_t ReadFixed(const std::string& data, size_t offset, size_t num_bytes) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < num_bytes; i++) {
+    const auto byte = static_cast<unsigned char>(data[offset + i]);
+    result |= static_cast<uint64_t>(byte) << (8U * i);
+  }
+  return result;
+}
+
+TEST_F(MutationInfoWriterTest, Binary) {
+  WriteMutationInfo({"a.c", "bb.cc"}, MutationInfoWriter::Format::kBinary);
+  const std::string output = ReadOutput();
+  ASSERT_LE(kMutationInfoBinaryHeaderSize + kMutationInfoBinaryFooterSize,
+            output.size());
+  ASSERT_EQ(kMutationInfoBinaryMagic,
+            output.substr(0, kMutationInfoBinaryMagicSize));
+  ASSERT_EQ(kMutationInfoBinaryVersion,
+            ReadFixed(output, kMutationInfoBinaryMagicSize, 4));
+
+  const size_t footer = output.size() - kMutationInfoBinaryFooterSize;
+  ASSERT_EQ(kMutationInfoBinaryFooterMagic,
+            output.substr(output.size() - kMutationInfoBinaryMagicSize));
+  const uint64_t strings_offset = ReadFixed(output, footer, 8);
+  const uint64_t num_strings = ReadFixed(output, footer + 8, 8);
+  const uint64_t num_files = ReadFixed(output, footer + 24, 8);
+  const uint64_t mutants_offset = ReadFixed(output, footer + 32, 8);
+  const uint64_t num_mutants = ReadFixed(output, footer + 40, 8);
+
+  // The filenames and the (shared) snippet are interned.
+  ASSERT_EQ(3, num_strings);
+  const uint64_t string_data = strings_offset + 8 * (num_strings + 1);
+  const uint64_t snippet_start = ReadFixed(output, strings_offset + 8, 8);
+  const uint64_t snippet_end = ReadFixed(output, strings_offset + 16, 8);
+  ASSERT_EQ("x = \"y\";\n", output.substr(string_data + snippet_start,
+                                         snippet_end - snippet_start));
+  ASSERT_EQ(2, num_files);
+
+  // The mutation ids are 3 and 5, the lengths of the filenames, so the index
+  // has entries for mutation ids 0 to 5, of which only two are present.
+  ASSERT_EQ(6, num_mutants);
+  for (uint64_t mutation_id = 0; mutation_id < num_mutants; mutation_id++) {
+    const uint64_t entry =
+        mutants_offset + mutation_id * kMutationInfoBinaryMutantEntrySize;
+    const uint64_t group_offset = ReadFixed(output, entry, 8);
+    if (mutation_id != 3 && mutation_id != 5) {
+      ASSERT_EQ(0, group_offset);
+      continue;
+    }
+    const auto kind =
+        static_cast<uint64_t>(protobufs::MutationGroup::kRemoveStmt);
+    ASSERT_EQ(mutation_id == 3 ? 0 : 1, ReadFixed(output, entry + 8, 4));
+    ASSERT_EQ(kind, ReadFixed(output, entry + 12, 1));
+    ASSERT_EQ(kind, ReadFixed(output, group_offset, 1));
+  }
+  // The first file's only mutation group immediately follows the header.
+  ASSERT_EQ(kMutationInfoBinaryHeaderSize,
+            ReadFixed(output,
+                      mutants_offset + 3 * kMutationInfoBinaryMutantEntrySize,
+                      8));
+}
+
+TEST_F(MutationInfoWriterTest, CannotOpen) {
+  llvm::SmallString<128> path(temp_directory_);
+  llvm::sys::path::append(path, "does_not_exist", "info.json");
+  MutationInfoWriter writer(path.str().str(),
+                            MutationInfoWriter::Format::kJson);
+  ASSERT_FALSE(writer.IsOpen());
+  ASSERT_FALSE(writer.Finish());
+}
+
+}  // namespace
+}  // namespace dredd
@@ -29,9 +29,10 @@
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Lex/Preprocessor.h"
-#include "clang/Rewrite/Core/RewriteBuffer.h"
-#include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/Tooling/Tooling.h"
+#include "libdredd/edit_list.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/source_range_cache.h"
 #include "libdreddtest/gtest.h"
 #include "llvm/ADT/SmallVector.h"
 
@@ -39,41 +40,46 @@ namespace dredd {
 namespace {
 
 void TestRemoval(const std::string& original, const std::string& expected,
-                 std::function<MutationRemoveStmt(const clang::Preprocessor&,
+                 std::function<MutationRemoveStmt(SourceRangeCache&,
                                                   clang::ASTContext&)>
                      mutation_supplier) {
   auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(original, {"-w"});
   ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
-  clang::Rewriter rewriter(ast_unit->getSourceManager(),
-                           ast_unit->getLangOpts());
+  EditList edit_list(ast_unit->getSourceManager(), ast_unit->getLangOpts());
   int mutation_id = 0;
   std::unordered_set<std::string> dredd_declarations;
-  mutation_supplier(ast_unit->getPreprocessor(), ast_unit->getASTContext())
-      .Apply(ast_unit->getASTContext(), ast_unit->getPreprocessor(), Options(),
-             0, mutation_id, rewriter, dredd_declarations);
+  SourceRangeCache source_range_cache(ast_unit->getPreprocessor());
+  const MutationRemoveStmt mutation =
+      mutation_supplier(source_range_cache, ast_unit->getASTContext());
+  mutation.Apply(ast_unit->getASTContext(), ast_unit->getPreprocessor(),
+                 Options(), 0, mutation_id, edit_list, dredd_declarations);
   ASSERT_EQ(1, mutation_id);
   ASSERT_EQ(0, dredd_declarations.size());
-  const clang::RewriteBuffer* rewrite_buffer = rewriter.getRewriteBufferFor(
-      ast_unit->getSourceManager().getMainFileID());
-  const std::string rewritten_text(rewrite_buffer->begin(),
-                                   rewrite_buffer->end());
-  ASSERT_EQ(expected, rewritten_text);
+  ASSERT_EQ(expected, edit_list.GetRewrittenText());
+
+  int counted_mutation_id = 0;
+  const protobufs::MutationGroup counted_mutation_group =
+      mutation.CountInstances(ast_unit->getASTContext(), Options(),
+                              counted_mutation_id);
+  ASSERT_EQ(1, counted_mutation_id);
+  ASSERT_TRUE(counted_mutation_group.has_remove_stmt());
+  ASSERT_EQ(0, counted_mutation_group.remove_stmt().mutation_id());
 }
 
 TEST(MutationRemoveStmtTest, BasicTest) {
   const std::string original = "void foo() { 1 + 2; }";
   const std::string expected =
-      R"(void foo() { if (!__dredd_enabled_mutation(0)) { 1 + 2; } })";
-  const std::function<MutationRemoveStmt(const clang::Preprocessor&,
+      R"(void foo() { if (!__dredd_enabled_mutation_with_mask(0, 0, 0x1ULL)) { 1 + 2; } })";
+  const std::function<MutationRemoveStmt(SourceRangeCache&,
                                          clang::ASTContext&)>
       mutation_supplier =
-          [](const clang::Preprocessor& preprocessor,
+          [](SourceRangeCache& source_range_cache,
              clang::ASTContext& ast_context) -> MutationRemoveStmt {
     auto statement = clang::ast_matchers::match(
         clang::ast_matchers::binaryOperator().bind("op"), ast_context);
     EXPECT_EQ(1, statement.size());
-    return {*statement[0].getNodeAs<clang::BinaryOperator>("op"), preprocessor,
-            ast_context};
+    return {*statement[0].getNodeAs<clang::BinaryOperator>("op"),
+            source_range_cache};
   };
   TestRemoval(original, expected, mutation_supplier);
 }
@@ -81,17 +87,16 @@ TEST(MutationRemoveStmtTest, BasicTest) {
 TEST(MutationRemoveStmtTest, RemoveIfStatement) {
   const std::string original = "void foo() { if (true) { } }";
   const std::string expected =
-      R"(void foo() { if (!__dredd_enabled_mutation(0)) { if (true) { } } })";
-  const std::function<MutationRemoveStmt(const clang::Preprocessor&,
+      R"(void foo() { if (!__dredd_enabled_mutation_with_mask(0, 0, 0x1ULL)) { if (true) { } } })";
+  const std::function<MutationRemoveStmt(SourceRangeCache&,
                                          clang::ASTContext&)>
       mutation_supplier =
-          [](const clang::Preprocessor& preprocessor,
+          [](SourceRangeCache& source_range_cache,
              clang::ASTContext& ast_context) -> MutationRemoveStmt {
     auto statement = clang::ast_matchers::match(
         clang::ast_matchers::ifStmt().bind("if"), ast_context);
     EXPECT_EQ(1, statement.size());
-    return {*statement[0].getNodeAs<clang::IfStmt>("if"), preprocessor,
-            ast_context};
+    return {*statement[0].getNodeAs<clang::IfStmt>("if"), source_range_cache};
   };
   TestRemoval(original, expected, mutation_supplier);
 }
@@ -99,17 +104,16 @@ TEST(MutationRemoveStmtTest, RemoveIfStatement) {
 TEST(MutationRemoveStmtTest, RemoveIfStatementWithTrailingSemi) {
   const std::string original = "void foo() { if (true) { }; }";
   const std::string expected =
-      R"(void foo() { if (!__dredd_enabled_mutation(0)) { if (true) { }; } })";
-  const std::function<MutationRemoveStmt(const clang::Preprocessor&,
+      R"(void foo() { if (!__dredd_enabled_mutation_with_mask(0, 0, 0x1ULL)) { if (true) { }; } })";
+  const std::function<MutationRemoveStmt(SourceRangeCache&,
                                          clang::ASTContext&)>
       mutation_supplier =
-          [](const clang::Preprocessor& preprocessor,
+          [](SourceRangeCache& source_range_cache,
              clang::ASTContext& ast_context) -> MutationRemoveStmt {
     auto statement = clang::ast_matchers::match(
         clang::ast_matchers::ifStmt().bind("if"), ast_context);
     EXPECT_EQ(1, statement.size());
-    return {*statement[0].getNodeAs<clang::IfStmt>("if"), preprocessor,
-            ast_context};
+    return {*statement[0].getNodeAs<clang::IfStmt>("if"), source_range_cache};
   };
   TestRemoval(original, expected, mutation_supplier);
 }
@@ -117,17 +121,16 @@ TEST(MutationRemoveStmtTest, RemoveIfStatementWithTrailingSemi) {
 TEST(MutationRemoveStmtTest, RemoveIfStatementWithTrailingSemis) {
   const std::string original = "void foo() { if (true) { };; }";
   const std::string expected =
-      R"(void foo() { if (!__dredd_enabled_mutation(0)) { if (true) { }; }; })";
-  const std::function<MutationRemoveStmt(const clang::Preprocessor&,
+      R"(void foo() { if (!__dredd_enabled_mutation_with_mask(0, 0, 0x1ULL)) { if (true) { }; }; })";
+  const std::function<MutationRemoveStmt(SourceRangeCache&,
                                          clang::ASTContext&)>
       mutation_supplier =
-          [](const clang::Preprocessor& preprocessor,
+          [](SourceRangeCache& source_range_cache,
              clang::ASTContext& ast_context) -> MutationRemoveStmt {
     auto statement = clang::ast_matchers::match(
         clang::ast_matchers::ifStmt().bind("if"), ast_context);
     EXPECT_EQ(1, statement.size());
-    return {*statement[0].getNodeAs<clang::IfStmt>("if"), preprocessor,
-            ast_context};
+    return {*statement[0].getNodeAs<clang::IfStmt>("if"), source_range_cache};
   };
   TestRemoval(original, expected, mutation_supplier);
 }
@@ -135,17 +138,16 @@ TEST(MutationRemoveStmtTest, RemoveIfStatementWithTrailingSemis) {
 TEST(MutationRemoveStmtTest, RemoveIfStatementWithoutBraces) {
   const std::string original = "void foo() { if (true) return; }";
   const std::string expected =
-      R"(void foo() { if (!__dredd_enabled_mutation(0)) { if (true) return; } })";
-  const std::function<MutationRemoveStmt(const clang::Preprocessor&,
+      R"(void foo() { if (!__dredd_enabled_mutation_with_mask(0, 0, 0x1ULL)) { if (true) return; } })";
+  const std::function<MutationRemoveStmt(SourceRangeCache&,
                                          clang::ASTContext&)>
       mutation_supplier =
-          [](const clang::Preprocessor& preprocessor,
+          [](SourceRangeCache& source_range_cache,
              clang::ASTContext& ast_context) -> MutationRemoveStmt {
     auto statement = clang::ast_matchers::match(
         clang::ast_matchers::ifStmt().bind("if"), ast_context);
     EXPECT_EQ(1, statement.size());
-    return {*statement[0].getNodeAs<clang::IfStmt>("if"), preprocessor,
-            ast_context};
+    return {*statement[0].getNodeAs<clang::IfStmt>("if"), source_range_cache};
   };
   TestRemoval(original, expected, mutation_supplier);
 }
@@ -153,17 +155,17 @@ TEST(MutationRemoveStmtTest, RemoveIfStatementWithoutBraces) {
 TEST(MutationRemoveStmtTest, RemoveReturnStmt) {
   const std::string original = "void foo() { return; }";
   const std::string expected =
-      R"(void foo() { if (!__dredd_enabled_mutation(0)) { return; } })";
-  const std::function<MutationRemoveStmt(const clang::Preprocessor&,
+      R"(void foo() { if (!__dredd_enabled_mutation_with_mask(0, 0, 0x1ULL)) { return; } })";
+  const std::function<MutationRemoveStmt(SourceRangeCache&,
                                          clang::ASTContext&)>
       mutation_supplier =
-          [](const clang::Preprocessor& preprocessor,
+          [](SourceRangeCache& source_range_cache,
              clang::ASTContext& ast_context) -> MutationRemoveStmt {
     auto statement = clang::ast_matchers::match(
         clang::ast_matchers::returnStmt().bind("return"), ast_context);
     EXPECT_EQ(1, statement.size());
-    return {*statement[0].getNodeAs<clang::ReturnStmt>("return"), preprocessor,
-            ast_context};
+    return {*statement[0].getNodeAs<clang::ReturnStmt>("return"),
+            source_range_cache};
   };
   TestRemoval(original, expected, mutation_supplier);
 }
@@ -171,17 +173,17 @@ TEST(MutationRemoveStmtTest, RemoveReturnStmt) {
 TEST(MutationRemoveStmtTest, RemoveBreakStmt) {
   const std::string original = "void foo() { while (true) { break; } }";
   const std::string expected =
-      R"(void foo() { while (true) { if (!__dredd_enabled_mutation(0)) { break; } } })";
-  const std::function<MutationRemoveStmt(const clang::Preprocessor&,
+      R"(void foo() { while (true) { if (!__dredd_enabled_mutation_with_mask(0, 0, 0x1ULL)) { break; } } })";
+  const std::function<MutationRemoveStmt(SourceRangeCache&,
                                          clang::ASTContext&)>
       mutation_supplier =
-          [](const clang::Preprocessor& preprocessor,
+          [](SourceRangeCache& source_range_cache,
              clang::ASTContext& ast_context) -> MutationRemoveStmt {
     auto statement = clang::ast_matchers::match(
         clang::ast_matchers::breakStmt().bind("break"), ast_context);
     EXPECT_EQ(1, statement.size());
-    return {*statement[0].getNodeAs<clang::BreakStmt>("break"), preprocessor,
-            ast_context};
+    return {*statement[0].getNodeAs<clang::BreakStmt>("break"),
+            source_range_cache};
   };
   TestRemoval(original, expected, mutation_supplier);
 }
@@ -192,20 +194,65 @@ TEST(MutationRemoveStmtTest, RemoveMacroStmt) {
       "void foo() { int x; ASSIGN(x, 1); }";
   const std::string expected =
       R"(#define ASSIGN(A, B) A = B
-void foo() { int x; if (!__dredd_enabled_mutation(0)) { ASSIGN(x, 1); } })";
-  const std::function<MutationRemoveStmt(const clang::Preprocessor&,
+void foo() { int x; if (!__dredd_enabled_mutation_with_mask(0, 0, 0x1ULL)) { ASSIGN(x, 1); } })";
+  const std::function<MutationRemoveStmt(SourceRangeCache&,
                                          clang::ASTContext&)>
       mutation_supplier =
-          [](const clang::Preprocessor& preprocessor,
+          [](SourceRangeCache& source_range_cache,
              clang::ASTContext& ast_context) -> MutationRemoveStmt {
     auto statement = clang::ast_matchers::match(
         clang::ast_matchers::binaryOperator().bind("assign"), ast_context);
     EXPECT_EQ(1, statement.size());
     return {*statement[0].getNodeAs<clang::BinaryOperator>("assign"),
-            preprocessor, ast_context};
+            source_range_cache};
   };
   TestRemoval(original, expected, mutation_supplier);
 }
 
+void TestRemovalOfLaterMutant(const Options& options,
+                              const std::string& expected) {
+  auto ast_unit =
+      clang::tooling::buildASTFromCodeWithArgs("void foo() { 1 + 2; }", {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  EditList edit_list(ast_unit->getSourceManager(), ast_unit->getLangOpts());
+  std::unordered_set<std::string> dredd_declarations;
+  SourceRangeCache source_range_cache(ast_unit->getPreprocessor());
+  auto statement = clang::ast_matchers::match(
+      clang::ast_matchers::binaryOperator().bind("op"),
+      ast_unit->getASTContext());
+  ASSERT_EQ(1, statement.size());
+  const MutationRemoveStmt mutation(
+      *statement[0].getNodeAs<clang::BinaryOperator>("op"), source_range_cache);
+  // The mutation has global id 75 and file-local id 70, so its bit is bit 6 of
+  // the second element of the bitset of enabled mutants.
+  int mutation_id = 75;
+  mutation.Apply(ast_unit->getASTContext(), ast_unit->getPreprocessor(),
+                 options, 5, mutation_id, edit_list, dredd_declarations);
+  ASSERT_EQ(76, mutation_id);
+  ASSERT_EQ(expected, edit_list.GetRewrittenText());
+}
+
+TEST(MutationRemoveStmtTest, WordAndMaskOfMutant) {
+  TestRemovalOfLaterMutant(
+      Options(),
+      R"(void foo() { if (!__dredd_enabled_mutation_with_mask(70, 1, 0x40ULL)) { 1 + 2; } })");
+}
+
+TEST(MutationRemoveStmtTest, SharedRuntimeHasNoWordAndMask) {
+  // With a shared runtime, the bitset of enabled mutants is not part of the
+  // mutated file.
+  TestRemovalOfLaterMutant(
+      Options().SetUseSharedRuntime(true),
+      R"(void foo() { if (!__dredd_enabled_mutation(70)) { 1 + 2; } })");
+}
+
+TEST(MutationRemoveStmtTest, GlobalMutantRegistryHasNoWordAndMask) {
+  // The global mutant registry is indexed by global mutation id, so the
+  // file-local word and mask of the mutant do not apply to it.
+  TestRemovalOfLaterMutant(
+      Options().SetUseGlobalMutantRegistry(true),
+      R"(void foo() { if (!__dredd_enabled_mutation(70)) { 1 + 2; } })");
+}
+
 }  // namespace
 }  // namespace dredd
@@ -27,9 +27,13 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/ASTUnit.h"
-#include "clang/Rewrite/Core/RewriteBuffer.h"
-#include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/Tooling/Tooling.h"
+#include "libdredd/edit_list.h"
+#include "libdredd/expr_analysis_cache.h"
+#include "libdredd/mutation_counts.h"
+#include "libdredd/options.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/source_range_cache.h"
 #include "libdreddtest/gtest.h"
 #include "llvm/ADT/SmallVector.h"
 
@@ -52,26 +56,31 @@ void TestReplacement(const std::string& original, const std::string& expected,
       ast_unit->getASTContext());
   ASSERT_EQ(1, binary_operator.size());
 
+  ExprAnalysisCache analysis_cache(ast_unit->getASTContext());
+  SourceRangeCache source_range_cache(ast_unit->getPreprocessor());
   const MutationReplaceBinaryOperator mutation(
       *binary_operator[0].getNodeAs<clang::BinaryOperator>("op"),
-      ast_unit->getPreprocessor(), ast_unit->getASTContext());
+      source_range_cache, analysis_cache);
 
-  clang::Rewriter rewriter(ast_unit->getSourceManager(),
-                           ast_unit->getLangOpts());
+  EditList edit_list(ast_unit->getSourceManager(), ast_unit->getLangOpts());
   int mutation_id = 0;
   std::unordered_set<std::string> dredd_declarations;
-  mutation.Apply(ast_unit->getASTContext(), ast_unit->getPreprocessor(),
-                 Options(optimise_mutations, false, false, false), 0,
-                 mutation_id, rewriter, dredd_declarations);
+  const Options options = Options().SetOptimiseMutations(optimise_mutations);
+  const protobufs::MutationGroup mutation_group =
+      mutation.Apply(ast_unit->getASTContext(), ast_unit->getPreprocessor(),
+                     options, 0, mutation_id, edit_list, dredd_declarations);
   ASSERT_EQ(num_replacements, mutation_id);
+
+  // Counting the mutants should yield exactly the mutants that were applied.
+  int counted_mutation_id = 0;
+  ASSERT_EQ(GetMutantKindsAndActions(mutation_group),
+            GetMutantKindsAndActions(mutation.CountInstances(
+                ast_unit->getASTContext(), options, counted_mutation_id)));
+  ASSERT_EQ(num_replacements, counted_mutation_id);
   ASSERT_EQ(1, dredd_declarations.size());
   ASSERT_EQ(expected_dredd_declaration, *dredd_declarations.begin());
 
-  const clang::RewriteBuffer* rewrite_buffer = rewriter.getRewriteBufferFor(
-      ast_unit->getSourceManager().getMainFileID());
-  const std::string rewritten_text(rewrite_buffer->begin(),
-                                   rewrite_buffer->end());
-  ASSERT_EQ(expected, rewritten_text);
+  ASSERT_EQ(expected, edit_list.GetRewrittenText());
 }
 
 TEST(MutationReplaceBinaryOperatorTest, MutateAdd) {
@@ -84,10 +93,12 @@ TEST(MutationReplaceBinaryOperatorTest, MutateAdd) {
   const std::string expected_dredd_declaration_opt =
       R"(static int __dredd_replace_binary_operator_Add_arg1_int_arg2_int_lhs_one(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 + arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 / arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 % arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 - arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 4)) {
+    case 0: return arg1 / arg2;
+    case 1: return arg1 % arg2;
+    case 2: return arg1 - arg2;
+    case 3: return arg2;
+  }
   return arg1 + arg2;
 }
 
@@ -104,12 +115,14 @@ TEST(MutationReplaceBinaryOperatorTest, MutateAdd) {
   const std::string expected_dredd_declaration_no_opt =
       R"(static int __dredd_replace_binary_operator_Add_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 + arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 / arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 * arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 % arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 - arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 5)) return arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 6)) {
+    case 0: return arg1 / arg2;
+    case 1: return arg1 * arg2;
+    case 2: return arg1 % arg2;
+    case 3: return arg1 - arg2;
+    case 4: return arg1;
+    case 5: return arg2;
+  }
   return arg1 + arg2;
 }
 
@@ -131,11 +144,14 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLAnd) {
 }
 )";
   const std::string expected_dredd_declaration_opt =
-      R"(static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(bool arg1, std::function<bool()> arg2, int local_mutation_id) {
+      R"(template <typename Arg2, typename = decltype(std::declval<Arg2&>()())>
+static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(bool arg1, Arg2 arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 && arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 == arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg2();
+  switch (__dredd_enabled_alternative(local_mutation_id, 3)) {
+    case 0: return arg1 == arg2();
+    case 1: return arg1;
+    case 2: return arg2();
+  }
   return arg1 && arg2();
 }
 
@@ -151,13 +167,16 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLAnd) {
 }
 )";
   const std::string expected_dredd_declaration_no_opt =
-      R"(static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(bool arg1, std::function<bool()> arg2, int local_mutation_id) {
+      R"(template <typename Arg2, typename = decltype(std::declval<Arg2&>()())>
+static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(bool arg1, Arg2 arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 && arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 || arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 == arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 != arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg2();
+  switch (__dredd_enabled_alternative(local_mutation_id, 5)) {
+    case 0: return arg1 || arg2();
+    case 1: return arg1 == arg2();
+    case 2: return arg1 != arg2();
+    case 3: return arg1;
+    case 4: return arg2();
+  }
   return arg1 && arg2();
 }
 
@@ -179,11 +198,14 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLOr) {
 }
 )";
   const std::string expected_dredd_declaration_opt =
-      R"(static bool __dredd_replace_binary_operator_LOr_arg1_bool_arg2_bool(bool arg1, std::function<bool()> arg2, int local_mutation_id) {
+      R"(template <typename Arg2, typename = decltype(std::declval<Arg2&>()())>
+static bool __dredd_replace_binary_operator_LOr_arg1_bool_arg2_bool(bool arg1, Arg2 arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 || arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 != arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg2();
+  switch (__dredd_enabled_alternative(local_mutation_id, 3)) {
+    case 0: return arg1 != arg2();
+    case 1: return arg1;
+    case 2: return arg2();
+  }
   return arg1 || arg2();
 }
 
@@ -199,13 +221,16 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLOr) {
 }
 )";
   const std::string expected_dredd_declaration_no_opt =
-      R"(static bool __dredd_replace_binary_operator_LOr_arg1_bool_arg2_bool(bool arg1, std::function<bool()> arg2, int local_mutation_id) {
+      R"(template <typename Arg2, typename = decltype(std::declval<Arg2&>()())>
+static bool __dredd_replace_binary_operator_LOr_arg1_bool_arg2_bool(bool arg1, Arg2 arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 || arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 && arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 == arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 != arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg2();
+  switch (__dredd_enabled_alternative(local_mutation_id, 5)) {
+    case 0: return arg1 && arg2();
+    case 1: return arg1 == arg2();
+    case 2: return arg1 != arg2();
+    case 3: return arg1;
+    case 4: return arg2();
+  }
   return arg1 || arg2();
 }
 
@@ -229,8 +254,10 @@ TEST(MutationReplaceBinaryOperatorTest, MutateGT) {
   const std::string expected_dredd_declaration_opt =
       R"(static bool __dredd_replace_binary_operator_GT_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 > arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 != arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 >= arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return arg1 != arg2;
+    case 1: return arg1 >= arg2;
+  }
   return arg1 > arg2;
 }
 
@@ -248,13 +275,15 @@ TEST(MutationReplaceBinaryOperatorTest, MutateGT) {
   const std::string expected_dredd_declaration_no_opt =
       R"(static bool __dredd_replace_binary_operator_GT_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 > arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 == arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 != arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 >= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 <= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg1 < arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 5)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 6)) return arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 7)) {
+    case 0: return arg1 == arg2;
+    case 1: return arg1 != arg2;
+    case 2: return arg1 >= arg2;
+    case 3: return arg1 <= arg2;
+    case 4: return arg1 < arg2;
+    case 5: return arg1;
+    case 6: return arg2;
+  }
   return arg1 > arg2;
 }
 
@@ -278,8 +307,10 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLT) {
   const std::string expected_dredd_declaration_opt =
       R"(static bool __dredd_replace_binary_operator_LT_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 < arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 != arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 <= arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return arg1 != arg2;
+    case 1: return arg1 <= arg2;
+  }
   return arg1 < arg2;
 }
 
@@ -297,13 +328,15 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLT) {
   const std::string expected_dredd_declaration_no_opt =
       R"(static bool __dredd_replace_binary_operator_LT_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 < arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 == arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 != arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 >= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 > arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg1 <= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 5)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 6)) return arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 7)) {
+    case 0: return arg1 == arg2;
+    case 1: return arg1 != arg2;
+    case 2: return arg1 >= arg2;
+    case 3: return arg1 > arg2;
+    case 4: return arg1 <= arg2;
+    case 5: return arg1;
+    case 6: return arg2;
+  }
   return arg1 < arg2;
 }
 
@@ -327,8 +360,10 @@ TEST(MutationReplaceBinaryOperatorTest, MutateEQ) {
   const std::string expected_dredd_declaration_opt =
       R"(static bool __dredd_replace_binary_operator_EQ_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 == arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 >= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 <= arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return arg1 >= arg2;
+    case 1: return arg1 <= arg2;
+  }
   return arg1 == arg2;
 }
 
@@ -346,13 +381,15 @@ TEST(MutationReplaceBinaryOperatorTest, MutateEQ) {
   const std::string expected_dredd_declaration_no_opt =
       R"(static bool __dredd_replace_binary_operator_EQ_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 == arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 != arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 >= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 > arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 <= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg1 < arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 5)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 6)) return arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 7)) {
+    case 0: return arg1 != arg2;
+    case 1: return arg1 >= arg2;
+    case 2: return arg1 > arg2;
+    case 3: return arg1 <= arg2;
+    case 4: return arg1 < arg2;
+    case 5: return arg1;
+    case 6: return arg2;
+  }
   return arg1 == arg2;
 }
 
@@ -376,8 +413,10 @@ TEST(MutationReplaceBinaryOperatorTest, MutateGE) {
   const std::string expected_dredd_declaration_opt =
       R"(static bool __dredd_replace_binary_operator_GE_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 >= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 == arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 > arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return arg1 == arg2;
+    case 1: return arg1 > arg2;
+  }
   return arg1 >= arg2;
 }
 
@@ -395,13 +434,15 @@ TEST(MutationReplaceBinaryOperatorTest, MutateGE) {
   const std::string expected_dredd_declaration_no_opt =
       R"(static bool __dredd_replace_binary_operator_GE_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 >= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 == arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 != arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 > arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 <= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg1 < arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 5)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 6)) return arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 7)) {
+    case 0: return arg1 == arg2;
+    case 1: return arg1 != arg2;
+    case 2: return arg1 > arg2;
+    case 3: return arg1 <= arg2;
+    case 4: return arg1 < arg2;
+    case 5: return arg1;
+    case 6: return arg2;
+  }
   return arg1 >= arg2;
 }
 
@@ -425,8 +466,10 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLE) {
   const std::string expected_dredd_declaration_opt =
       R"(static bool __dredd_replace_binary_operator_LE_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 <= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 == arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 < arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return arg1 == arg2;
+    case 1: return arg1 < arg2;
+  }
   return arg1 <= arg2;
 }
 
@@ -444,13 +487,15 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLE) {
   const std::string expected_dredd_declaration_no_opt =
       R"(static bool __dredd_replace_binary_operator_LE_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 <= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 == arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 != arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 >= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 > arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg1 < arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 5)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 6)) return arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 7)) {
+    case 0: return arg1 == arg2;
+    case 1: return arg1 != arg2;
+    case 2: return arg1 >= arg2;
+    case 3: return arg1 > arg2;
+    case 4: return arg1 < arg2;
+    case 5: return arg1;
+    case 6: return arg2;
+  }
   return arg1 <= arg2;
 }
 
@@ -474,8 +519,10 @@ TEST(MutationReplaceBinaryOperatorTest, MutateNE) {
   const std::string expected_dredd_declaration_opt =
       R"(static bool __dredd_replace_binary_operator_NE_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 != arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 > arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 < arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return arg1 > arg2;
+    case 1: return arg1 < arg2;
+  }
   return arg1 != arg2;
 }
 
@@ -493,13 +540,15 @@ TEST(MutationReplaceBinaryOperatorTest, MutateNE) {
   const std::string expected_dredd_declaration_no_opt =
       R"(static bool __dredd_replace_binary_operator_NE_arg1_int_arg2_int(int arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 != arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 == arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 >= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 > arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 <= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg1 < arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 5)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 6)) return arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 7)) {
+    case 0: return arg1 == arg2;
+    case 1: return arg1 >= arg2;
+    case 2: return arg1 > arg2;
+    case 3: return arg1 <= arg2;
+    case 4: return arg1 < arg2;
+    case 5: return arg1;
+    case 6: return arg2;
+  }
   return arg1 != arg2;
 }
 
@@ -525,16 +574,18 @@ TEST(MutationReplaceBinaryOperatorTest, MutateAssign) {
   const std::string expected_dredd_declaration_opt =
       R"(static int& __dredd_replace_binary_operator_Assign_arg1_int_arg2_int(int& arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 = arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 += arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 &= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 /= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 *= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg1 |= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 5)) return arg1 %= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 6)) return arg1 <<= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 7)) return arg1 >>= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 8)) return arg1 -= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 9)) return arg1 ^= arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 10)) {
+    case 0: return arg1 += arg2;
+    case 1: return arg1 &= arg2;
+    case 2: return arg1 /= arg2;
+    case 3: return arg1 *= arg2;
+    case 4: return arg1 |= arg2;
+    case 5: return arg1 %= arg2;
+    case 6: return arg1 <<= arg2;
+    case 7: return arg1 >>= arg2;
+    case 8: return arg1 -= arg2;
+    case 9: return arg1 ^= arg2;
+  }
   return arg1 = arg2;
 }
 
@@ -553,16 +604,18 @@ TEST(MutationReplaceBinaryOperatorTest, MutateAssign) {
   const std::string expected_dredd_declaration_no_opt =
       R"(static int& __dredd_replace_binary_operator_Assign_arg1_int_arg2_int(int& arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 = arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 += arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 &= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 /= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 *= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg1 |= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 5)) return arg1 %= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 6)) return arg1 <<= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 7)) return arg1 >>= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 8)) return arg1 -= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 9)) return arg1 ^= arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 10)) {
+    case 0: return arg1 += arg2;
+    case 1: return arg1 &= arg2;
+    case 2: return arg1 /= arg2;
+    case 3: return arg1 *= arg2;
+    case 4: return arg1 |= arg2;
+    case 5: return arg1 %= arg2;
+    case 6: return arg1 <<= arg2;
+    case 7: return arg1 >>= arg2;
+    case 8: return arg1 -= arg2;
+    case 9: return arg1 ^= arg2;
+  }
   return arg1 = arg2;
 }
 
@@ -592,16 +645,18 @@ void foo() {
   const std::string expected_dredd_declaration_opt =
       R"(static int& __dredd_replace_binary_operator_Assign_arg1_int_arg2_int(int& arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 = arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 += arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 &= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 /= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 *= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg1 |= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 5)) return arg1 %= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 6)) return arg1 <<= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 7)) return arg1 >>= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 8)) return arg1 -= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 9)) return arg1 ^= arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 10)) {
+    case 0: return arg1 += arg2;
+    case 1: return arg1 &= arg2;
+    case 2: return arg1 /= arg2;
+    case 3: return arg1 *= arg2;
+    case 4: return arg1 |= arg2;
+    case 5: return arg1 %= arg2;
+    case 6: return arg1 <<= arg2;
+    case 7: return arg1 >>= arg2;
+    case 8: return arg1 -= arg2;
+    case 9: return arg1 ^= arg2;
+  }
   return arg1 = arg2;
 }
 
@@ -622,16 +677,18 @@ void foo() {
   const std::string expected_dredd_declaration_no_opt =
       R"(static int& __dredd_replace_binary_operator_Assign_arg1_int_arg2_int(int& arg1, int arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 = arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 += arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 &= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 /= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 *= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg1 |= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 5)) return arg1 %= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 6)) return arg1 <<= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 7)) return arg1 >>= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 8)) return arg1 -= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 9)) return arg1 ^= arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 10)) {
+    case 0: return arg1 += arg2;
+    case 1: return arg1 &= arg2;
+    case 2: return arg1 /= arg2;
+    case 3: return arg1 *= arg2;
+    case 4: return arg1 |= arg2;
+    case 5: return arg1 %= arg2;
+    case 6: return arg1 <<= arg2;
+    case 7: return arg1 >>= arg2;
+    case 8: return arg1 -= arg2;
+    case 9: return arg1 ^= arg2;
+  }
   return arg1 = arg2;
 }
 
@@ -659,11 +716,13 @@ TEST(MutationReplaceBinaryOperatorTest, MutateFloatDiv) {
   const std::string expected_dredd_declaration_opt =
       R"(static float __dredd_replace_binary_operator_Div_arg1_float_arg2_float(float arg1, float arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 / arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 + arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 * arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 - arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 5)) {
+    case 0: return arg1 + arg2;
+    case 1: return arg1 * arg2;
+    case 2: return arg1 - arg2;
+    case 3: return arg1;
+    case 4: return arg2;
+  }
   return arg1 / arg2;
 }
 
@@ -683,11 +742,13 @@ TEST(MutationReplaceBinaryOperatorTest, MutateFloatDiv) {
   const std::string expected_dredd_declaration_no_opt =
       R"(static float __dredd_replace_binary_operator_Div_arg1_float_arg2_float(float arg1, float arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 / arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 + arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 * arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 - arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 5)) {
+    case 0: return arg1 + arg2;
+    case 1: return arg1 * arg2;
+    case 2: return arg1 - arg2;
+    case 3: return arg1;
+    case 4: return arg2;
+  }
   return arg1 / arg2;
 }
 
@@ -715,10 +776,12 @@ TEST(MutationReplaceBinaryOperatorTest, MutateFloatSubAssign) {
   const std::string expected_dredd_declaration_opt =
       R"(static double& __dredd_replace_binary_operator_SubAssign_arg1_double_arg2_double(double& arg1, double arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 -= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 += arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 = arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 /= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 *= arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 4)) {
+    case 0: return arg1 += arg2;
+    case 1: return arg1 = arg2;
+    case 2: return arg1 /= arg2;
+    case 3: return arg1 *= arg2;
+  }
   return arg1 -= arg2;
 }
 
@@ -738,10 +801,12 @@ TEST(MutationReplaceBinaryOperatorTest, MutateFloatSubAssign) {
   const std::string expected_dredd_declaration_no_opt =
       R"(static double& __dredd_replace_binary_operator_SubAssign_arg1_double_arg2_double(double& arg1, double arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 -= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 += arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 = arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 /= arg2;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1 *= arg2;
+  switch (__dredd_enabled_alternative(local_mutation_id, 4)) {
+    case 0: return arg1 += arg2;
+    case 1: return arg1 = arg2;
+    case 2: return arg1 /= arg2;
+    case 3: return arg1 *= arg2;
+  }
   return arg1 -= arg2;
 }
 
@@ -763,11 +828,14 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLAndWithLhsSideEffect) {
 }
 )";
   const std::string expected_dredd_declaration_opt =
-      R"(static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(std::function<bool()> arg1, std::function<bool()> arg2, int local_mutation_id) {
+      R"(template <typename Arg1, typename Arg2, typename = decltype(std::declval<Arg1&>()()), typename = decltype(std::declval<Arg2&>()())>
+static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(Arg1 arg1, Arg2 arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1() && arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1() == arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1();
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg2();
+  switch (__dredd_enabled_alternative(local_mutation_id, 3)) {
+    case 0: return arg1() == arg2();
+    case 1: return arg1();
+    case 2: return arg2();
+  }
   return arg1() && arg2();
 }
 
@@ -783,13 +851,16 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLAndWithLhsSideEffect) {
 }
 )";
   const std::string expected_dredd_declaration_no_opt =
-      R"(static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(std::function<bool()> arg1, std::function<bool()> arg2, int local_mutation_id) {
+      R"(template <typename Arg1, typename Arg2, typename = decltype(std::declval<Arg1&>()()), typename = decltype(std::declval<Arg2&>()())>
+static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(Arg1 arg1, Arg2 arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1() && arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1() || arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1() == arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1() != arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1();
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg2();
+  switch (__dredd_enabled_alternative(local_mutation_id, 5)) {
+    case 0: return arg1() || arg2();
+    case 1: return arg1() == arg2();
+    case 2: return arg1() != arg2();
+    case 3: return arg1();
+    case 4: return arg2();
+  }
   return arg1() && arg2();
 }
 
@@ -811,11 +882,14 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLAndWithRhsSideEffect) {
 }
 )";
   const std::string expected_dredd_declaration_opt =
-      R"(static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(bool arg1, std::function<bool()> arg2, int local_mutation_id) {
+      R"(template <typename Arg2, typename = decltype(std::declval<Arg2&>()())>
+static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(bool arg1, Arg2 arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 && arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 == arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg2();
+  switch (__dredd_enabled_alternative(local_mutation_id, 3)) {
+    case 0: return arg1 == arg2();
+    case 1: return arg1;
+    case 2: return arg2();
+  }
   return arg1 && arg2();
 }
 
@@ -831,13 +905,16 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLAndWithRhsSideEffect) {
 }
 )";
   const std::string expected_dredd_declaration_no_opt =
-      R"(static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(bool arg1, std::function<bool()> arg2, int local_mutation_id) {
+      R"(template <typename Arg2, typename = decltype(std::declval<Arg2&>()())>
+static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(bool arg1, Arg2 arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1 && arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1 || arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1 == arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1 != arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg2();
+  switch (__dredd_enabled_alternative(local_mutation_id, 5)) {
+    case 0: return arg1 || arg2();
+    case 1: return arg1 == arg2();
+    case 2: return arg1 != arg2();
+    case 3: return arg1;
+    case 4: return arg2();
+  }
   return arg1 && arg2();
 }
 
@@ -859,11 +936,14 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLAndWithLhsRhsSideEffect) {
 }
 )";
   const std::string expected_dredd_declaration_opt =
-      R"(static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(std::function<bool()> arg1, std::function<bool()> arg2, int local_mutation_id) {
+      R"(template <typename Arg1, typename Arg2, typename = decltype(std::declval<Arg1&>()()), typename = decltype(std::declval<Arg2&>()())>
+static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(Arg1 arg1, Arg2 arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1() && arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1() == arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1();
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg2();
+  switch (__dredd_enabled_alternative(local_mutation_id, 3)) {
+    case 0: return arg1() == arg2();
+    case 1: return arg1();
+    case 2: return arg2();
+  }
   return arg1() && arg2();
 }
 
@@ -879,13 +959,16 @@ TEST(MutationReplaceBinaryOperatorTest, MutateLAndWithLhsRhsSideEffect) {
 }
 )";
   const std::string expected_dredd_declaration_no_opt =
-      R"(static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(std::function<bool()> arg1, std::function<bool()> arg2, int local_mutation_id) {
+      R"(template <typename Arg1, typename Arg2, typename = decltype(std::declval<Arg1&>()()), typename = decltype(std::declval<Arg2&>()())>
+static bool __dredd_replace_binary_operator_LAnd_arg1_bool_arg2_bool(Arg1 arg1, Arg2 arg2, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg1() && arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg1() || arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg1() == arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg1() != arg2();
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return arg1();
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg2();
+  switch (__dredd_enabled_alternative(local_mutation_id, 5)) {
+    case 0: return arg1() || arg2();
+    case 1: return arg1() == arg2();
+    case 2: return arg1() != arg2();
+    case 3: return arg1();
+    case 4: return arg2();
+  }
   return arg1() && arg2();
 }
 
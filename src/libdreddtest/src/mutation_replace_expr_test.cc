@@ -30,9 +30,14 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/ASTUnit.h"
-#include "clang/Rewrite/Core/RewriteBuffer.h"
-#include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/Tooling/Tooling.h"
+#include "libdredd/edit_list.h"
+#include "libdredd/expr_analysis_cache.h"
+#include "libdredd/mutation_counts.h"
+#include "libdredd/options.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/source_range_cache.h"
+#include "libdredd/stmt_parent_map.h"
 #include "libdreddtest/gtest.h"
 #include "llvm/ADT/SmallVector.h"
 
@@ -56,25 +61,39 @@ void TestReplacement(const std::string& original, const std::string& expected,
   ASSERT_GT(expression.size(), 0);
 
   ASSERT_LT(expression_to_replace, expression.size());
+
+  StmtParentMap parent_map(ast_unit->getASTContext());
+  for (const auto& statement : clang::ast_matchers::match(
+           clang::ast_matchers::stmt().bind("stmt"),
+           ast_unit->getASTContext())) {
+    parent_map.RecordChildren(*statement.getNodeAs<clang::Stmt>("stmt"));
+  }
+
+  ExprAnalysisCache analysis_cache(ast_unit->getASTContext());
+  SourceRangeCache source_range_cache(ast_unit->getPreprocessor());
   const MutationReplaceExpr mutation(
       *expression[expression_to_replace].getNodeAs<clang::Expr>("expr"),
-      ast_unit->getPreprocessor(), ast_unit->getASTContext());
+      source_range_cache, parent_map, analysis_cache);
 
-  clang::Rewriter rewriter(ast_unit->getSourceManager(),
-                           ast_unit->getLangOpts());
+  EditList edit_list(ast_unit->getSourceManager(), ast_unit->getLangOpts());
   int mutation_id = 0;
   std::unordered_set<std::string> dredd_declarations;
-  mutation.Apply(ast_unit->getASTContext(), ast_unit->getPreprocessor(),
-                 Options(), 0, mutation_id, rewriter, dredd_declarations);
+  const Options options;
+  const protobufs::MutationGroup mutation_group =
+      mutation.Apply(ast_unit->getASTContext(), ast_unit->getPreprocessor(),
+                     options, 0, mutation_id, edit_list, dredd_declarations);
   ASSERT_EQ(num_replacements, mutation_id);
+
+  // Counting the mutants should yield exactly the mutants that were applied.
+  int counted_mutation_id = 0;
+  ASSERT_EQ(GetMutantKindsAndActions(mutation_group),
+            GetMutantKindsAndActions(mutation.CountInstances(
+                ast_unit->getASTContext(), options, counted_mutation_id)));
+  ASSERT_EQ(num_replacements, counted_mutation_id);
   ASSERT_EQ(1, dredd_declarations.size());
   ASSERT_EQ(expected_dredd_declaration, *dredd_declarations.begin());
 
-  const clang::RewriteBuffer* rewrite_buffer = rewriter.getRewriteBufferFor(
-      ast_unit->getSourceManager().getMainFileID());
-  const std::string rewritten_text(rewrite_buffer->begin(),
-                                   rewrite_buffer->end());
-  ASSERT_EQ(expected, rewritten_text);
+  ASSERT_EQ(expected, edit_list.GetRewrittenText());
 }
 
 TEST(MutationReplaceExprTest, MutateSignedConstants) {
@@ -84,11 +103,13 @@ TEST(MutationReplaceExprTest, MutateSignedConstants) {
   const std::string expected_dredd_declaration =
       R"(static int __dredd_replace_expr_int_constant(int arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return ~(arg);
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return -(arg);
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return 0;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return 1;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return -1;
+  switch (__dredd_enabled_alternative(local_mutation_id, 5)) {
+    case 0: return ~(arg);
+    case 1: return -(arg);
+    case 2: return 0;
+    case 3: return 1;
+    case 4: return -1;
+  }
   return arg;
 }
 
@@ -106,9 +127,11 @@ TEST(MutationReplaceExprTest, MutateUnsignedConstants) {
   const std::string expected_dredd_declaration =
       R"(static unsigned int __dredd_replace_expr_unsigned_int_constant(unsigned int arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return ~(arg);
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return 0;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return 1;
+  switch (__dredd_enabled_alternative(local_mutation_id, 3)) {
+    case 0: return ~(arg);
+    case 1: return 0;
+    case 2: return 1;
+  }
   return arg;
 }
 
@@ -125,10 +148,12 @@ TEST(MutationReplaceExprTest, MutateFloatConstants) {
   const std::string expected_dredd_declaration =
       R"(static double __dredd_replace_expr_double(double arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return -(arg);
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return 0.0;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return 1.0;
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return -1.0;
+  switch (__dredd_enabled_alternative(local_mutation_id, 4)) {
+    case 0: return -(arg);
+    case 1: return 0.0;
+    case 2: return 1.0;
+    case 3: return -1.0;
+  }
   return arg;
 }
 
@@ -154,8 +179,10 @@ TEST(MutationReplaceExprTest, MutateLValues) {
   const std::string expected_dredd_declaration =
       R"(static int __dredd_replace_expr_int_lvalue(int& arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return ++(arg);
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return --(arg);
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return ++(arg);
+    case 1: return --(arg);
+  }
   return arg;
 }
 
@@ -195,12 +222,14 @@ int neg(int x) {
   const std::string expected_dredd_declaration =
       R"(static int __dredd_replace_expr_int(int arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return !(arg);
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return ~(arg);
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return -(arg);
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return 0;
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return 1;
-  if (__dredd_enabled_mutation(local_mutation_id + 5)) return -1;
+  switch (__dredd_enabled_alternative(local_mutation_id, 6)) {
+    case 0: return !(arg);
+    case 1: return ~(arg);
+    case 2: return -(arg);
+    case 3: return 0;
+    case 4: return 1;
+    case 5: return -1;
+  }
   return arg;
 }
 
@@ -226,7 +255,9 @@ bool foo(bool a, bool b) {
   const std::string expected_dredd_declaration =
       R"(static bool __dredd_replace_expr_bool_omit_true(bool arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return false;
+  switch (__dredd_enabled_alternative(local_mutation_id, 1)) {
+    case 0: return false;
+  }
   return arg;
 }
 
@@ -252,7 +283,9 @@ bool foo(bool a, bool b) {
   const std::string expected_dredd_declaration =
       R"(static bool __dredd_replace_expr_bool_omit_false(bool arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return true;
+  switch (__dredd_enabled_alternative(local_mutation_id, 1)) {
+    case 0: return true;
+  }
   return arg;
 }
 
@@ -28,9 +28,13 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/ASTUnit.h"
-#include "clang/Rewrite/Core/RewriteBuffer.h"
-#include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/Tooling/Tooling.h"
+#include "libdredd/edit_list.h"
+#include "libdredd/expr_analysis_cache.h"
+#include "libdredd/mutation_counts.h"
+#include "libdredd/options.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdredd/source_range_cache.h"
 #include "libdreddtest/gtest.h"
 #include "llvm/ADT/SmallVector.h"
 
@@ -53,26 +57,31 @@ void TestReplacement(const std::string& original, const std::string& expected,
       ast_unit->getASTContext());
   ASSERT_EQ(1, unary_operator.size());
 
+  ExprAnalysisCache analysis_cache(ast_unit->getASTContext());
+  SourceRangeCache source_range_cache(ast_unit->getPreprocessor());
   const MutationReplaceUnaryOperator mutation(
       *unary_operator[0].getNodeAs<clang::UnaryOperator>("op"),
-      ast_unit->getPreprocessor(), ast_unit->getASTContext());
+      source_range_cache, analysis_cache);
 
-  clang::Rewriter rewriter(ast_unit->getSourceManager(),
-                           ast_unit->getLangOpts());
+  EditList edit_list(ast_unit->getSourceManager(), ast_unit->getLangOpts());
   int mutation_id = 0;
   std::unordered_set<std::string> dredd_declarations;
-  mutation.Apply(ast_unit->getASTContext(), ast_unit->getPreprocessor(),
-                 Options(optimise_mutations, false, false, false), 0,
-                 mutation_id, rewriter, dredd_declarations);
+  const Options options = Options().SetOptimiseMutations(optimise_mutations);
+  const protobufs::MutationGroup mutation_group =
+      mutation.Apply(ast_unit->getASTContext(), ast_unit->getPreprocessor(),
+                     options, 0, mutation_id, edit_list, dredd_declarations);
   ASSERT_EQ(num_replacements, mutation_id);
+
+  // Counting the mutants should yield exactly the mutants that were applied.
+  int counted_mutation_id = 0;
+  ASSERT_EQ(GetMutantKindsAndActions(mutation_group),
+            GetMutantKindsAndActions(mutation.CountInstances(
+                ast_unit->getASTContext(), options, counted_mutation_id)));
+  ASSERT_EQ(num_replacements, counted_mutation_id);
   ASSERT_EQ(1, dredd_declarations.size());
   ASSERT_EQ(expected_dredd_declaration, *dredd_declarations.begin());
 
-  const clang::RewriteBuffer* rewrite_buffer = rewriter.getRewriteBufferFor(
-      ast_unit->getSourceManager().getMainFileID());
-  const std::string rewritten_text(rewrite_buffer->begin(),
-                                   rewrite_buffer->end());
-  ASSERT_EQ(expected, rewritten_text);
+  ASSERT_EQ(expected, edit_list.GetRewrittenText());
 }
 
 TEST(MutationReplaceUnaryOperatorTest, MutateMinus) {
@@ -82,8 +91,10 @@ TEST(MutationReplaceUnaryOperatorTest, MutateMinus) {
   const std::string expected_dredd_declaration_opt =
       R"(static int __dredd_replace_unary_operator_Minus_int(int arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return -arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return ~arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return !arg;
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return ~arg;
+    case 1: return !arg;
+  }
   return -arg;
 }
 
@@ -99,9 +110,11 @@ TEST(MutationReplaceUnaryOperatorTest, MutateMinus) {
   const std::string expected_dredd_declaration_no_opt =
       R"(static int __dredd_replace_unary_operator_Minus_int(int arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return -arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return ~arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return !arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg;
+  switch (__dredd_enabled_alternative(local_mutation_id, 3)) {
+    case 0: return ~arg;
+    case 1: return !arg;
+    case 2: return arg;
+  }
   return -arg;
 }
 
@@ -128,8 +141,10 @@ TEST(MutationReplaceUnaryOperatorTest, MutateNot) {
   const std::string expected_dredd_declaration_opt =
       R"(static bool __dredd_replace_unary_operator_LNot_bool(bool arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return !arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return ~arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return -arg;
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return ~arg;
+    case 1: return -arg;
+  }
   return !arg;
 }
 
@@ -149,9 +164,11 @@ TEST(MutationReplaceUnaryOperatorTest, MutateNot) {
   const std::string expected_dredd_declaration_no_opt =
       R"(static bool __dredd_replace_unary_operator_LNot_bool(bool arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return !arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return ~arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return -arg;
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return arg;
+  switch (__dredd_enabled_alternative(local_mutation_id, 3)) {
+    case 0: return ~arg;
+    case 1: return -arg;
+    case 2: return arg;
+  }
   return !arg;
 }
 
@@ -176,10 +193,13 @@ TEST(MutationReplaceUnaryOperatorTest, MutateIncrement) {
 }
 )";
   const std::string expected_dredd_declaration_opt =
-      R"(static double& __dredd_replace_unary_operator_PreInc_double(std::function<double&()> arg, int local_mutation_id) {
+      R"(template <typename Arg, typename = decltype(std::declval<Arg&>()())>
+static double& __dredd_replace_unary_operator_PreInc_double(Arg arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return ++arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return --arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg();
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return --arg();
+    case 1: return arg();
+  }
   return ++arg();
 }
 
@@ -197,10 +217,13 @@ TEST(MutationReplaceUnaryOperatorTest, MutateIncrement) {
 }
 )";
   const std::string expected_dredd_declaration_noopt =
-      R"(static double& __dredd_replace_unary_operator_PreInc_double(std::function<double&()> arg, int local_mutation_id) {
+      R"(template <typename Arg, typename = decltype(std::declval<Arg&>()())>
+static double& __dredd_replace_unary_operator_PreInc_double(Arg arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return ++arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return --arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg();
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return --arg();
+    case 1: return arg();
+  }
   return ++arg();
 }
 
@@ -225,13 +248,16 @@ TEST(MutationReplaceUnaryOperatorTest, MutateDecrement) {
 }
 )";
   const std::string expected_dredd_declaration_opt =
-      R"(static int __dredd_replace_unary_operator_PostDec_int(std::function<int&()> arg, int local_mutation_id) {
+      R"(template <typename Arg, typename = decltype(std::declval<Arg&>()())>
+static int __dredd_replace_unary_operator_PostDec_int(Arg arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg()--;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg()++;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return ~arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return -arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return !arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg();
+  switch (__dredd_enabled_alternative(local_mutation_id, 5)) {
+    case 0: return arg()++;
+    case 1: return ~arg();
+    case 2: return -arg();
+    case 3: return !arg();
+    case 4: return arg();
+  }
   return arg()--;
 }
 
@@ -249,13 +275,16 @@ TEST(MutationReplaceUnaryOperatorTest, MutateDecrement) {
 }
 )";
   const std::string expected_dredd_declaration_no_opt =
-      R"(static int __dredd_replace_unary_operator_PostDec_int(std::function<int&()> arg, int local_mutation_id) {
+      R"(template <typename Arg, typename = decltype(std::declval<Arg&>()())>
+static int __dredd_replace_unary_operator_PostDec_int(Arg arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return arg()--;
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return arg()++;
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return ~arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 2)) return -arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 3)) return !arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 4)) return arg();
+  switch (__dredd_enabled_alternative(local_mutation_id, 5)) {
+    case 0: return arg()++;
+    case 1: return ~arg();
+    case 2: return -arg();
+    case 3: return !arg();
+    case 4: return arg();
+  }
   return arg()--;
 }
 
@@ -280,10 +309,13 @@ TEST(MutationReplaceUnaryOperatorTest, MutateDecrementAssign) {
 }
 )";
   const std::string expected_dredd_declaration_opt =
-      R"(static int& __dredd_replace_unary_operator_PreDec_int(std::function<int&()> arg, int local_mutation_id) {
+      R"(template <typename Arg, typename = decltype(std::declval<Arg&>()())>
+static int& __dredd_replace_unary_operator_PreDec_int(Arg arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return --arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return ++arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg();
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return ++arg();
+    case 1: return arg();
+  }
   return --arg();
 }
 
@@ -301,10 +333,13 @@ TEST(MutationReplaceUnaryOperatorTest, MutateDecrementAssign) {
 }
 )";
   const std::string expected_dredd_declaration_no_opt =
-      R"(static int& __dredd_replace_unary_operator_PreDec_int(std::function<int&()> arg, int local_mutation_id) {
+      R"(template <typename Arg, typename = decltype(std::declval<Arg&>()())>
+static int& __dredd_replace_unary_operator_PreDec_int(Arg arg, int local_mutation_id) {
   if (!__dredd_some_mutation_enabled) return --arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 0)) return ++arg();
-  if (__dredd_enabled_mutation(local_mutation_id + 1)) return arg();
+  switch (__dredd_enabled_alternative(local_mutation_id, 2)) {
+    case 0: return ++arg();
+    case 1: return arg();
+  }
   return --arg();
 }
 
@@ -0,0 +1,117 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/mutation_sampler.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "libdredd/mutation_selection.h"
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdreddtest/gtest.h"
+
+namespace dredd {
+namespace {
+
+// Yields |num_remove_stmt| statement removals followed by |num_binary| binary
+// operator replacements, each of which has two actions.
+std::vector<protobufs::MutationGroup> MakeMutationGroups(
+    size_t num_remove_stmt, size_t num_binary) {
+  std::vector<protobufs::MutationGroup> result;
+  for (size_t i = 0; i < num_remove_stmt; i++) {
+    protobufs::MutationGroup group;
+    group.mutable_remove_stmt();
+    result.push_back(group);
+  }
+  for (size_t i = 0; i < num_binary; i++) {
+    protobufs::MutationGroup group;
+    auto* replace_binary_operator = group.mutable_replace_binary_operator();
+    replace_binary_operator->add_instances()->set_action(
+        protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithLHS);
+    replace_binary_operator->add_instances()->set_action(
+        protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithRHS);
+    result.push_back(group);
+  }
+  return result;
+}
+
+void CountKept(const std::vector<MutationSelection>& selections,
+               size_t& num_remove_stmt, size_t& num_binary) {
+  num_remove_stmt = 0;
+  num_binary = 0;
+  for (const auto& selection : selections) {
+    if (selection.IsRemoveStmtEnabled()) {
+      num_remove_stmt++;
+    }
+    for (auto action :
+         {protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithLHS,
+          protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithRHS}) {
+      if (selection.IsEnabled(action)) {
+        num_binary++;
+      }
+    }
+  }
+}
+
+TEST(MutationSamplerTest, KeepsProportionOfEachKind) {
+  const MutationSampler sampler(0.25, 0);
+  auto selections = sampler.Sample("a.cc", MakeMutationGroups(10, 3));
+  ASSERT_EQ(13, selections.size());
+  size_t num_remove_stmt = 0;
+  size_t num_binary = 0;
+  CountKept(selections, num_remove_stmt, num_binary);
+  // 25% of 10 statement removals and of 6 binary operator mutants, rounded
+  // up.
+  ASSERT_EQ(3, num_remove_stmt);
+  ASSERT_EQ(2, num_binary);
+}
+
+TEST(MutationSamplerTest, KeepsAtLeastOneOfEachKind) {
+  const MutationSampler sampler(0.01, 0);
+  auto selections = sampler.Sample("a.cc", MakeMutationGroups(1, 1));
+  size_t num_remove_stmt = 0;
+  size_t num_binary = 0;
+  CountKept(selections, num_remove_stmt, num_binary);
+  ASSERT_EQ(1, num_remove_stmt);
+  ASSERT_EQ(1, num_binary);
+}
+
+TEST(MutationSamplerTest, Reproducible) {
+  const auto mutation_groups = MakeMutationGroups(50, 0);
+  auto kept = [&mutation_groups](uint64_t seed, const std::string& filename) {
+    const MutationSampler sampler(0.5, seed);
+    std::vector<bool> result;
+    for (const auto& selection : sampler.Sample(filename, mutation_groups)) {
+      result.push_back(selection.IsRemoveStmtEnabled());
+    }
+    return result;
+  };
+  ASSERT_EQ(kept(1, "a.cc"), kept(1, "a.cc"));
+  ASSERT_EQ(kept(1, "a.cc"), kept(1, "/some/directory/a.cc"));
+  ASSERT_NE(kept(1, "a.cc"), kept(2, "a.cc"));
+  ASSERT_NE(kept(1, "a.cc"), kept(1, "b.cc"));
+}
+
+TEST(MutationSamplerTest, ToString) {
+  ASSERT_EQ(MutationSampler(0.5, 3).ToString(),
+            MutationSampler(0.5, 3).ToString());
+  ASSERT_NE(MutationSampler(0.5, 3).ToString(),
+            MutationSampler(0.5, 4).ToString());
+  ASSERT_NE(MutationSampler(0.5, 3).ToString(),
+            MutationSampler(0.25, 3).ToString());
+}
+
+}  // namespace
+}  // namespace dredd
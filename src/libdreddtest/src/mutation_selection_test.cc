@@ -0,0 +1,123 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/mutation_selection.h"
+
+#include <string>
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdreddtest/gtest.h"
+
+namespace dredd {
+namespace {
+
+TEST(MutationSelectionTest, EverythingEnabledByDefault) {
+  const MutationSelection selection;
+  ASSERT_TRUE(selection.IsEverythingEnabled());
+  ASSERT_TRUE(selection.IsRemoveStmtEnabled());
+  ASSERT_TRUE(selection.IsReplaceExprEnabled());
+  ASSERT_TRUE(selection.IsReplaceBinaryOperatorEnabled());
+  ASSERT_TRUE(selection.IsReplaceUnaryOperatorEnabled());
+  ASSERT_TRUE(selection.IsEnabled(
+      protobufs::MutationReplaceExprAction::ReplaceWithFalse));
+  ASSERT_TRUE(selection.IsEnabled(
+      protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithShr));
+  ASSERT_TRUE(selection.IsEnabled(
+      protobufs::MutationReplaceUnaryOperatorAction::ReplaceWithOperand));
+}
+
+TEST(MutationSelectionTest, EnableKindsAndActions) {
+  MutationSelection selection;
+  selection.DisableAll();
+  ASSERT_FALSE(selection.IsRemoveStmtEnabled());
+  ASSERT_FALSE(selection.IsReplaceExprEnabled());
+  ASSERT_FALSE(selection.IsReplaceBinaryOperatorEnabled());
+  ASSERT_FALSE(selection.IsReplaceUnaryOperatorEnabled());
+
+  std::string error_message;
+  ASSERT_TRUE(selection.Enable("remove_stmt", error_message));
+  ASSERT_TRUE(selection.Enable("replace_binary_operator:ReplaceWithLHS",
+                               error_message));
+  ASSERT_TRUE(selection.IsRemoveStmtEnabled());
+  ASSERT_TRUE(selection.IsReplaceBinaryOperatorEnabled());
+  ASSERT_TRUE(selection.IsEnabled(
+      protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithLHS));
+  ASSERT_FALSE(selection.IsEnabled(
+      protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithRHS));
+  ASSERT_FALSE(selection.IsReplaceExprEnabled());
+  ASSERT_FALSE(selection.IsEverythingEnabled());
+
+  const protobufs::MutationSelection message = selection.ToProtobuf();
+  ASSERT_TRUE(message.remove_stmt());
+  ASSERT_EQ(0, message.replace_expr_actions_size());
+  ASSERT_EQ(1, message.replace_binary_operator_actions_size());
+  ASSERT_EQ(protobufs::MutationReplaceBinaryOperatorAction::ReplaceWithLHS,
+            message.replace_binary_operator_actions(0));
+  ASSERT_EQ(0, message.replace_unary_operator_actions_size());
+}
+
+TEST(MutationSelectionTest, DisableKindsAndActions) {
+  MutationSelection selection;
+  std::string error_message;
+  ASSERT_TRUE(selection.Disable("replace_unary_operator", error_message));
+  ASSERT_TRUE(selection.Disable("replace_expr:InsertMinus", error_message));
+  ASSERT_TRUE(selection.Disable("remove_stmt:RemoveStmt", error_message));
+  ASSERT_FALSE(selection.IsRemoveStmtEnabled());
+  ASSERT_FALSE(selection.IsReplaceUnaryOperatorEnabled());
+  ASSERT_TRUE(selection.IsReplaceExprEnabled());
+  ASSERT_FALSE(
+      selection.IsEnabled(protobufs::MutationReplaceExprAction::InsertMinus));
+  ASSERT_TRUE(
+      selection.IsEnabled(protobufs::MutationReplaceExprAction::InsertNot));
+  ASSERT_EQ(protobufs::MutationReplaceExprAction_ARRAYSIZE - 1,
+            selection.ToProtobuf().replace_expr_actions_size());
+}
+
+TEST(MutationSelectionTest, InvalidSpecifications) {
+  MutationSelection selection;
+  std::string error_message;
+  ASSERT_FALSE(selection.Disable("replace_statement", error_message));
+  ASSERT_FALSE(error_message.empty());
+  error_message.clear();
+  ASSERT_FALSE(selection.Disable("", error_message));
+  ASSERT_FALSE(error_message.empty());
+  error_message.clear();
+  // Actions must belong to the given kind of mutation.
+  ASSERT_FALSE(selection.Disable("replace_expr:ReplaceWithLHS", error_message));
+  ASSERT_FALSE(error_message.empty());
+  error_message.clear();
+  ASSERT_FALSE(selection.Disable("remove_stmt:InsertMinus", error_message));
+  ASSERT_FALSE(error_message.empty());
+  error_message.clear();
+  ASSERT_FALSE(selection.Disable("replace_expr:", error_message));
+  ASSERT_FALSE(error_message.empty());
+  // Invalid specifications leave the selection unchanged.
+  ASSERT_TRUE(selection.IsEverythingEnabled());
+}
+
+TEST(MutationSelectionTest, ToStringReflectsSelection) {
+  MutationSelection selection;
+  const std::string everything = selection.ToString();
+  std::string error_message;
+  ASSERT_TRUE(selection.Disable("replace_unary_operator:ReplaceWithNot",
+                                error_message));
+  const std::string restricted = selection.ToString();
+  ASSERT_NE(everything, restricted);
+  ASSERT_TRUE(selection.Enable("replace_unary_operator:ReplaceWithNot",
+                               error_message));
+  ASSERT_EQ(everything, selection.ToString());
+}
+
+}  // namespace
+}  // namespace dredd
@@ -0,0 +1,130 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/run_statistics.h"
+
+#include <chrono>
+#include <string>
+
+#include "libdredd/protobufs/dredd_protobufs.h"
+#include "libdreddtest/gtest.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace dredd {
+namespace {
+
+// Yields mutation info with a statement removal and a binary operator
+// replacement with two instances.
+protobufs::MutationInfoForFile MakeMutationInfo() {
+  protobufs::MutationInfoForFile mutation_info_for_file;
+  mutation_info_for_file.add_mutation_tree()
+      ->add_mutation_groups()
+      ->mutable_remove_stmt()
+      ->set_mutation_id(0);
+  protobufs::MutationReplaceBinaryOperator* replace_binary_operator =
+      mutation_info_for_file.add_mutation_tree()
+          ->add_mutation_groups()
+          ->mutable_replace_binary_operator();
+  protobufs::MutationReplaceBinaryOperatorInstance* instance =
+      replace_binary_operator->add_instances();
+  instance->set_action(protobufs::ReplaceWithLHS);
+  instance->set_mutation_id(1);
+  instance = replace_binary_operator->add_instances();
+  instance->set_action(protobufs::ReplaceWithRHS);
+  instance->set_mutation_id(2);
+  return mutation_info_for_file;
+}
+
+TEST(RunStatisticsTest, Print) {
+  RunStatistics run_statistics(false);
+  const auto start = std::chrono::steady_clock::now();
+  run_statistics.AddTime(RunStatistics::Phase::kParse, "a.cc", start,
+                         start + std::chrono::milliseconds(2));
+  std::string output;
+  llvm::raw_string_ostream stream(output);
+  run_statistics.Print(stream);
+  stream.flush();
+  for (const auto* phase_name :
+       {"parse", "traverse", "tidy up", "apply mutations", "rewrite",
+        "prelude and output", "serialise", "total"}) {
+    ASSERT_NE(std::string::npos, output.find(phase_name));
+  }
+  ASSERT_NE(std::string::npos, output.find("2.000 ms"));
+}
+
+TEST(RunStatisticsTest, Report) {
+  RunStatistics run_statistics(true);
+  ASSERT_TRUE(run_statistics.IsRecordingDetails());
+  const auto start = std::chrono::steady_clock::now();
+  run_statistics.AddTime(RunStatistics::Phase::kParse, "b.cc", start,
+                         start + std::chrono::milliseconds(3));
+  run_statistics.AddTime(RunStatistics::Phase::kTraverse, "b.cc", start,
+                         start + std::chrono::milliseconds(1));
+  run_statistics.AddTime(RunStatistics::Phase::kParse, "a.cc", start,
+                         start + std::chrono::milliseconds(1));
+  run_statistics.AddFileCounts("b.cc", 10, 20, MakeMutationInfo());
+  run_statistics.AddFileCounts("a.cc", 1, 2,
+                               protobufs::MutationInfoForFile());
+
+  std::string output;
+  llvm::raw_string_ostream stream(output);
+  run_statistics.WriteReport(stream);
+  stream.flush();
+  llvm::Expected<llvm::json::Value> json = llvm::json::parse(output);
+  ASSERT_TRUE(static_cast<bool>(json));
+  const llvm::json::Object* report = json->getAsObject();
+  ASSERT_NE(nullptr, report);
+
+  const llvm::json::Array* trace_events = report->getArray("traceEvents");
+  ASSERT_NE(nullptr, trace_events);
+  ASSERT_EQ(3, trace_events->size());
+  const llvm::json::Object* first_event = (*trace_events)[0].getAsObject();
+  ASSERT_EQ("parse", first_event->getString("name"));
+  ASSERT_EQ("X", first_event->getString("ph"));
+  ASSERT_EQ(3000.0, first_event->getNumber("dur"));
+  ASSERT_EQ("b.cc", first_event->getObject("args")->getString("file"));
+
+  const llvm::json::Object* summary = report->getObject("summary");
+  ASSERT_NE(nullptr, summary);
+  ASSERT_EQ(2, summary->getInteger("num_files"));
+  ASSERT_EQ(11, summary->getInteger("num_decls_traversed"));
+  ASSERT_EQ(22, summary->getInteger("num_stmts_traversed"));
+  ASSERT_EQ(3, summary->getInteger("num_mutants"));
+  ASSERT_EQ(4.0, summary->getObject("phase_ms")->getNumber("parse"));
+  ASSERT_EQ(
+      1, summary->getObject("mutants_by_kind")->getInteger("remove_stmt"));
+  ASSERT_EQ(2, summary->getObject("mutants_by_kind")
+                   ->getInteger("replace_binary_operator"));
+  ASSERT_EQ(1, summary->getObject("mutants_by_action")
+                   ->getObject("replace_binary_operator")
+                   ->getInteger("ReplaceWithLHS"));
+
+  // Files are reported in order of name.
+  const llvm::json::Array* files = report->getArray("files");
+  ASSERT_NE(nullptr, files);
+  ASSERT_EQ(2, files->size());
+  const llvm::json::Object* first_file = (*files)[0].getAsObject();
+  ASSERT_EQ("a.cc", first_file->getString("filename"));
+  ASSERT_EQ(0, first_file->getInteger("num_mutants"));
+  const llvm::json::Object* second_file = (*files)[1].getAsObject();
+  ASSERT_EQ("b.cc", second_file->getString("filename"));
+  ASSERT_EQ(10, second_file->getInteger("num_decls_traversed"));
+  ASSERT_EQ(3, second_file->getInteger("num_mutants"));
+  ASSERT_EQ(1.0, second_file->getObject("phase_ms")->getNumber("traverse"));
+}
+
+}  // namespace
+}  // namespace dredd
@@ -0,0 +1,149 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/shared_runtime.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libdredd/deferred_mutated_file.h"
+#include "libdredd/options.h"
+#include "libdreddtest/deferred_mutated_file_builder.h"
+#include "libdreddtest/gtest.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace dredd {
+namespace {
+
+const char* const kCppMutator =
+    "static int __dredd_replace_binary_operator_Add_arg1_int_arg2_int(int "
+    "arg1, int arg2, int local_mutation_id) {\n"
+    "  switch (__dredd_enabled_alternative(local_mutation_id, 1)) {\n"
+    "    case 0: return arg1 - arg2;\n"
+    "  }\n"
+    "  return arg1 + arg2;\n"
+    "}\n\n";
+
+const char* const kCppLambdaMutator =
+    "static int __dredd_replace_expr_int(__dredd_function_ref<int> arg, "
+    "int local_mutation_id) {\n"
+    "  switch (__dredd_enabled_alternative(local_mutation_id, 1)) {\n"
+    "    case 0: return 0;\n"
+    "  }\n"
+    "  return arg();\n"
+    "}\n\n";
+
+const char* const kCMutator =
+    "static int __dredd_replace_unary_operator_Minus_int(int arg, int "
+    "local_mutation_id) {\n"
+    "  switch (__dredd_enabled_alternative(local_mutation_id, 1)) {\n"
+    "    case 0: return arg;\n"
+    "  }\n"
+    "  return -arg;\n"
+    "}\n\n";
+
+DeferredMutatedFile MakeCppFile(int num_mutations,
+                                std::vector<std::string> dredd_declarations) {
+  return DeferredMutatedFileBuilder("a.cc")
+      .SetIsCpp(true)
+      .SetNumMutations(num_mutations)
+      .SetDreddDeclarations(std::move(dredd_declarations))
+      .Build();
+}
+
+TEST(SharedRuntimeTest, MutatorFunctionsAreDefinedOnce) {
+  const Options options = Options().SetUseSharedRuntime(true);
+  SharedRuntime shared_runtime(options);
+  shared_runtime.AddFile(MakeCppFile(2, {kCppMutator}));
+  shared_runtime.AddFile(MakeCppFile(3, {kCppLambdaMutator, kCppMutator}));
+  ASSERT_EQ(5, shared_runtime.GetNumMutations());
+  ASSERT_TRUE(shared_runtime.HasCppFiles());
+  ASSERT_FALSE(shared_runtime.HasCFiles());
+
+  const std::string header_text = shared_runtime.GetHeaderText();
+  ASSERT_TRUE(
+      llvm::StringRef(header_text).contains("class __dredd_function_ref {\n"));
+  ASSERT_TRUE(llvm::StringRef(header_text)
+                  .contains("bool __dredd_runtime_enabled_mutation(int "
+                            "mutation_id);\n"));
+  ASSERT_TRUE(llvm::StringRef(header_text)
+                  .contains("\nint __dredd_replace_binary_operator_Add_arg1_"
+                            "int_arg2_int(int arg1, int arg2, int "
+                            "local_mutation_id);\n"));
+  // Nothing in the header has the static storage class: the mutator functions
+  // it declares have external linkage.
+  ASSERT_FALSE(llvm::StringRef(header_text).starts_with("static "));
+  ASSERT_FALSE(llvm::StringRef(header_text).contains("\nstatic "));
+
+  const std::string source_text = shared_runtime.GetCppSourceText();
+  ASSERT_TRUE(
+      llvm::StringRef(source_text).contains("#include \"dredd_runtime.h\"\n"));
+  // The definition of the mutator function occurs exactly once, with external
+  // linkage.
+  const std::string definition = std::string(kCppMutator).substr(7);
+  const size_t position = source_text.find(definition);
+  ASSERT_NE(std::string::npos, position);
+  ASSERT_EQ(std::string::npos, source_text.find(definition, position + 1));
+  ASSERT_FALSE(llvm::StringRef(source_text).contains("static " + definition));
+}
+
+TEST(SharedRuntimeTest, CAndCppFilesAreKeptApart) {
+  const Options options =
+      Options().SetOnlyTrackMutantCoverage(true).SetUseSharedRuntime(true);
+  SharedRuntime shared_runtime(options);
+  shared_runtime.AddFile(MakeCppFile(1, {kCppMutator}));
+  shared_runtime.AddFile(DeferredMutatedFileBuilder("a.c")
+                             .SetNumMutations(1)
+                             .SetDreddDeclarations({kCMutator})
+                             .Build());
+  ASSERT_TRUE(shared_runtime.HasCppFiles());
+  ASSERT_TRUE(shared_runtime.HasCFiles());
+
+  const std::string header_text = shared_runtime.GetHeaderText();
+  ASSERT_FALSE(llvm::StringRef(header_text).contains("__dredd_function_ref"));
+  ASSERT_TRUE(llvm::StringRef(header_text)
+                  .contains("void __dredd_runtime_record_covered_mutants("));
+  const size_t else_position = header_text.find("#else\n");
+  ASSERT_NE(std::string::npos, else_position);
+  ASSERT_LT(header_text.find("__dredd_replace_binary_operator"), else_position);
+  ASSERT_GT(header_text.find("__dredd_replace_unary_operator"), else_position);
+
+  ASSERT_FALSE(llvm::StringRef(shared_runtime.GetCppSourceText())
+                   .contains("__dredd_replace_unary_operator"));
+  ASSERT_FALSE(llvm::StringRef(shared_runtime.GetCSourceText())
+                   .contains("__dredd_replace_binary_operator"));
+}
+
+TEST(SharedRuntimeTest, PreludeOfMutatedFile) {
+  const Options options = Options().SetUseSharedRuntime(true);
+  const DeferredMutatedFile deferred_file = MakeCppFile(2, {kCppMutator});
+  const std::string mutated_text = deferred_file.GetMutatedText(options, 7);
+  ASSERT_TRUE(llvm::StringRef(mutated_text)
+                  .contains("#include \"dredd_runtime.h\"\n"));
+  ASSERT_TRUE(llvm::StringRef(mutated_text)
+                  .contains("enum { __dredd_first_mutation_id = 7 };\n"));
+  // The mutator functions are not part of the mutated file.
+  ASSERT_FALSE(llvm::StringRef(mutated_text)
+                   .contains("__dredd_replace_binary_operator"));
+
+  // The mutator functions survive a round trip through a protobuf.
+  ASSERT_EQ(std::vector<std::string>({kCppMutator}),
+            DeferredMutatedFile::FromProtobuf(deferred_file.ToProtobuf())
+                .GetDreddDeclarations());
+}
+
+}  // namespace
+}  // namespace dredd
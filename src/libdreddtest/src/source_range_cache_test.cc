@@ -0,0 +1,88 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/source_range_cache.h"
+
+#include <string>
+#include <utility>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Expr.h"
+#include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/ASTMatchers/ASTMatchers.h"
+#include "clang/ASTMatchers/ASTMatchersInternal.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/Tooling.h"
+#include "libdredd/util.h"
+#include "libdreddtest/gtest.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace dredd {
+namespace {
+
+TEST(SourceRangeCacheTest, RangeLineColumnAndTokenLength) {
+  const std::string original = "void foo(int xyz) {\n  xyz + 22;\n}\n";
+  auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(original, {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  SourceRangeCache source_range_cache(ast_unit->getPreprocessor());
+
+  auto binary_operator = clang::ast_matchers::match(
+      clang::ast_matchers::binaryOperator().bind("op"),
+      ast_unit->getASTContext());
+  ASSERT_EQ(1, binary_operator.size());
+  const auto* op = binary_operator[0].getNodeAs<clang::BinaryOperator>("op");
+
+  // Query each property twice, so that the second query is served from the
+  // cache.
+  for (int i = 0; i < 2; i++) {
+    const clang::SourceRange source_range =
+        source_range_cache.GetSourceRangeInMainFile(*op);
+    ASSERT_TRUE(source_range.isValid());
+    ASSERT_EQ(GetSourceRangeInMainFile(ast_unit->getPreprocessor(), *op),
+              source_range);
+    ASSERT_EQ(std::make_pair(2U, 3U),
+              source_range_cache.GetLineAndColumn(source_range.getBegin()));
+    ASSERT_EQ(std::make_pair(2U, 9U),
+              source_range_cache.GetLineAndColumn(source_range.getEnd()));
+    ASSERT_EQ(3U, source_range_cache.GetTokenLength(source_range.getBegin()));
+    ASSERT_EQ(2U, source_range_cache.GetTokenLength(source_range.getEnd()));
+  }
+}
+
+TEST(SourceRangeCacheTest, MacroArgumentIsNotInMainFile) {
+  const std::string original =
+      "#define PLUS(a, b) a + b\nvoid foo(int x) { PLUS(x, 1); }\n";
+  auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(original, {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  SourceRangeCache source_range_cache(ast_unit->getPreprocessor());
+
+  auto binary_operator = clang::ast_matchers::match(
+      clang::ast_matchers::binaryOperator().bind("op"),
+      ast_unit->getASTContext());
+  ASSERT_EQ(1, binary_operator.size());
+  const auto* op = binary_operator[0].getNodeAs<clang::BinaryOperator>("op");
+
+  // The operator as a whole corresponds to the macro invocation, but its
+  // operands are in the middle of the macro expansion.
+  ASSERT_TRUE(source_range_cache.GetSourceRangeInMainFile(*op).isValid());
+  for (int i = 0; i < 2; i++) {
+    ASSERT_TRUE(source_range_cache.GetSourceRangeInMainFile(*op->getRHS())
+                    .isInvalid());
+  }
+}
+
+}  // namespace
+}  // namespace dredd
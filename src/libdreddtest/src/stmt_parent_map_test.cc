@@ -0,0 +1,109 @@
+// Copyright 2022 The Dredd Project Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libdredd/stmt_parent_map.h"
+
+#include <string>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/Stmt.h"
+#include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/ASTMatchers/ASTMatchers.h"
+#include "clang/ASTMatchers/ASTMatchersInternal.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/Tooling.h"
+#include "libdreddtest/gtest.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace dredd {
+namespace {
+
+void RecordAllStatements(clang::ASTContext& ast_context,
+                         StmtParentMap& parent_map) {
+  for (const auto& statement : clang::ast_matchers::match(
+           clang::ast_matchers::stmt().bind("stmt"), ast_context)) {
+    parent_map.RecordChildren(*statement.getNodeAs<clang::Stmt>("stmt"));
+  }
+}
+
+TEST(StmtParentMapTest, BinaryOperatorOperands) {
+  const std::string original = "void foo(int x) { x + 2; }";
+  auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(original, {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  StmtParentMap parent_map(ast_unit->getASTContext());
+  RecordAllStatements(ast_unit->getASTContext(), parent_map);
+
+  auto binary_operator = clang::ast_matchers::match(
+      clang::ast_matchers::binaryOperator().bind("op"),
+      ast_unit->getASTContext());
+  ASSERT_EQ(1, binary_operator.size());
+  const auto* op = binary_operator[0].getNodeAs<clang::BinaryOperator>("op");
+  ASSERT_EQ(op, parent_map.GetFirstParentOfType<clang::BinaryOperator>(
+                    *op->getRHS()));
+  ASSERT_EQ(nullptr, parent_map.GetFirstParentOfType<clang::CallExpr>(
+                         *op->getRHS()));
+  // The binary operator is directly under the function body.
+  ASSERT_NE(nullptr,
+            parent_map.GetFirstParentOfType<clang::CompoundStmt>(*op));
+}
+
+TEST(StmtParentMapTest, VariableInitializerHasNoStatementParent) {
+  const std::string original = "void foo() { int x = 2; }";
+  auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(original, {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  StmtParentMap parent_map(ast_unit->getASTContext());
+  RecordAllStatements(ast_unit->getASTContext(), parent_map);
+
+  auto literal = clang::ast_matchers::match(
+      clang::ast_matchers::integerLiteral().bind("literal"),
+      ast_unit->getASTContext());
+  ASSERT_EQ(1, literal.size());
+  ASSERT_TRUE(
+      parent_map.GetParents(*literal[0].getNodeAs<clang::Expr>("literal"))
+          .empty());
+}
+
+TEST(StmtParentMapTest, ImplicitCastInInitializerList) {
+  const std::string original =
+      "struct S { long a; }; void foo() { S s = {2}; }";
+  auto ast_unit = clang::tooling::buildASTFromCodeWithArgs(original, {"-w"});
+  ASSERT_FALSE(ast_unit->getDiagnostics().hasErrorOccurred());
+  StmtParentMap parent_map(ast_unit->getASTContext());
+  // Only record the children of the initializer list, as reached during
+  // traversal, to check that its semantic form is accounted for.
+  auto init_list_expr = clang::ast_matchers::match(
+      clang::ast_matchers::initListExpr().bind("init"),
+      ast_unit->getASTContext());
+  ASSERT_FALSE(init_list_expr.empty());
+  parent_map.RecordChildren(
+      *init_list_expr[0].getNodeAs<clang::InitListExpr>("init"));
+
+  // The literal occurs directly in the syntactic form of the initializer list,
+  // and under an implicit conversion to long in its semantic form.
+  auto literal = clang::ast_matchers::match(
+      clang::ast_matchers::integerLiteral().bind("literal"),
+      ast_unit->getASTContext());
+  ASSERT_EQ(1, literal.size());
+  const auto* literal_expr = literal[0].getNodeAs<clang::Expr>("literal");
+  ASSERT_EQ(2, parent_map.GetParents(*literal_expr).size());
+  ASSERT_NE(nullptr, parent_map.GetFirstParentOfType<clang::InitListExpr>(
+                         *literal_expr));
+  ASSERT_NE(nullptr, parent_map.GetFirstParentOfType<clang::ImplicitCastExpr>(
+                         *literal_expr));
+}
+
+}  // namespace
+}  // namespace dredd
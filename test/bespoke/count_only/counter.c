@@ -0,0 +1,13 @@
+static int counter = 0;
+
+void increment(int amount) {
+  if (amount > 0) {
+    counter += amount;
+  }
+}
+
+int get_count(void) {
+  int result = counter;
+  result--;
+  return -result;
+}
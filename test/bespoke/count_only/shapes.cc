@@ -0,0 +1,31 @@
+namespace shapes {
+
+class Rectangle {
+ public:
+  Rectangle(int width, int height) : width_(width), height_(height) {}
+
+  int Area() const { return width_ * height_; }
+
+  bool IsSquare() const { return width_ == height_ && width_ > 0; }
+
+ private:
+  int width_;
+  int height_;
+};
+
+int TotalArea(const Rectangle* rectangles, int count) {
+  int result = 0;
+  for (int i = 0; i < count; i++) {
+    result += rectangles[i].Area();
+  }
+  return result;
+}
+
+}  // namespace shapes
+
+int main() {
+  shapes::Rectangle rectangles[2] = {shapes::Rectangle(2, 3),
+                                     shapes::Rectangle(4, 4)};
+  auto twice = [](int x) -> int { return 2 * x; };
+  return twice(shapes::TotalArea(rectangles, 2)) - 52;
+}
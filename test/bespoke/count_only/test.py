@@ -0,0 +1,105 @@
+import filecmp
+import json
+import os
+import shutil
+import subprocess
+import sys
+from collections import Counter
+from pathlib import Path
+
+DREDD_REPO_ROOT = os.environ['DREDD_REPO_ROOT']
+DREDD_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd')
+
+SOURCE_FILES = ['shapes.cc', 'counter.c']
+
+# Maps the kinds of mutation group in mutation info to the kinds used in mutation counts.
+KINDS = {'removeStmt': 'remove_stmt', 'replaceExpr': 'replace_expr',
+         'replaceBinaryOperator': 'replace_binary_operator', 'replaceUnaryOperator': 'replace_unary_operator'}
+
+
+def count_mutations(extra_args):
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--count-only'] + extra_args + SOURCE_FILES + ['--'],
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert result.returncode == 0, result.stderr.decode('utf-8')
+    # Counting must leave the source files unchanged.
+    for filename in SOURCE_FILES:
+        assert filecmp.cmp(Path('original', filename), filename, shallow=False), filename
+    return json.loads(result.stdout.decode('utf-8'))
+
+
+def mutate(extra_args):
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=Path('original', filename), dst=filename)
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info.json'] + extra_args +
+                            SOURCE_FILES + ['--'], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert result.returncode == 0, result.stderr.decode('utf-8')
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=Path('original', filename), dst=filename)
+    with open('info.json', 'r') as json_input:
+        return json.load(json_input)
+
+
+def action_counts_from_info(info_for_file):
+    result = Counter()
+    for node in info_for_file['mutationTree']:
+        for group in node['mutationGroups']:
+            for kind, mutation in group.items():
+                if kind == 'removeStmt':
+                    result[('remove_stmt', 'RemoveStmt')] += 1
+                else:
+                    for instance in mutation['instances']:
+                        result[(KINDS[kind], instance['action'])] += 1
+    return result
+
+
+def action_counts_from_counts(actions):
+    return Counter({(action['kind'], action['action']): action['numMutations'] for action in actions})
+
+
+def check_counts(extra_args):
+    counts = count_mutations(extra_args)
+    # Counting in parallel must give the same result.
+    assert counts == count_mutations(extra_args + ['--jobs', '2'])
+
+    assert counts['filesWithErrors'] == []
+    assert [Path(file_counts['filename']).name for file_counts in counts['files']] == SOURCE_FILES
+    info = mutate(extra_args)
+    info_for_files = {info_for_file['filename']: info_for_file for info_for_file in info['infoForFiles']}
+    total = Counter()
+    for file_counts in counts['files']:
+        # The counts must match the mutants that are actually applied.
+        expected = action_counts_from_info(info_for_files[file_counts['filename']])
+        assert action_counts_from_counts(file_counts['actions']) == expected, file_counts['filename']
+        assert file_counts['numMutations'] == sum(expected.values())
+        # The per-function counts must add up to the counts for the file.
+        function_total = Counter()
+        for function_counts in file_counts['functions']:
+            function_actions = action_counts_from_counts(function_counts['actions'])
+            assert function_counts['numMutations'] == sum(function_actions.values())
+            function_total += function_actions
+        assert function_total == expected
+        total += expected
+    assert action_counts_from_counts(counts['actions']) == total
+    assert counts['numMutations'] == sum(total.values())
+    return counts
+
+
+def main():
+    Path('original').mkdir()
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=filename, dst=Path('original', filename))
+
+    counts = check_counts([])
+    check_counts(['--no-mutation-opts'])
+
+    functions = {function_counts['function'] for file_counts in counts['files']
+                 for function_counts in file_counts['functions']}
+    for function in ['shapes::Rectangle::Area', 'shapes::TotalArea', 'main', 'increment', 'get_count']:
+        assert function in functions, function
+    # Mutants in the lambda in 'main' are attributed to 'main'.
+    assert not any('operator()' in function for function in functions), functions
+    assert counts['numMutations'] > 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
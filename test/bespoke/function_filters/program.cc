@@ -0,0 +1,52 @@
+#include <cstdio>
+
+namespace logging {
+
+void Write(const char* message, int level) {
+  if (level > 1) {
+    std::printf("%s\n", message);
+  }
+}
+
+}  // namespace logging
+
+namespace compute {
+
+int Sum(const int* values, int count) {
+  int result = 0;
+  for (int i = 0; i < count; i++) {
+    result += values[i];
+  }
+  return result;
+}
+
+int Apply(int value) {
+  auto twice = [](int x) -> int { return x * 2; };
+  return twice(value) + 1;
+}
+
+[[clang::annotate("dredd_skip")]] int Slow(int value) {
+  return value * value - value;
+}
+
+class [[clang::annotate("dredd_skip")]] Generated {
+ public:
+  static int Serialize(int value) { return value + 42; }
+};
+
+}  // namespace compute
+
+namespace [[clang::annotate("dredd_skip")]] metrics {
+
+int Record(int value) { return value - 1; }
+
+}  // namespace metrics
+
+int main() {
+  const int values[] = {1, 2, 3};
+  logging::Write("starting", 2);
+  const int sum = compute::Sum(values, 3) + compute::Apply(4) +
+                  compute::Slow(2) + compute::Generated::Serialize(1) +
+                  metrics::Record(3);
+  return sum == 62 ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+import filecmp
+import json
+import os
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+DREDD_REPO_ROOT = os.environ['DREDD_REPO_ROOT']
+DREDD_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd')
+
+SOURCE_FILES = ['program.cc']
+
+# The functions that are mutated when no filters are given; functions annotated with dredd_skip, or in a class or
+# namespace annotated with dredd_skip, are never mutated.
+ALL_FUNCTIONS = ['compute::Apply', 'compute::Sum', 'logging::Write', 'main']
+
+
+def count_mutations_per_function(extra_args):
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--count-only'] + extra_args + SOURCE_FILES + ['--'],
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert result.returncode == 0, result.stderr.decode('utf-8')
+    counts = json.loads(result.stdout.decode('utf-8'))
+    return {function_counts['function']: function_counts['actions'] for file_counts in counts['files']
+            for function_counts in file_counts['functions']}
+
+
+def check_filter(full_counts, extra_args, expected_functions):
+    # Filtering must not change the mutants of the functions that are still mutated.
+    counts = count_mutations_per_function(extra_args)
+    assert sorted(counts.keys()) == expected_functions, (extra_args, sorted(counts.keys()))
+    for function, actions in counts.items():
+        assert actions == full_counts[function], function
+
+
+def main():
+    Path('original').mkdir()
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=filename, dst=Path('original', filename))
+
+    full_counts = count_mutations_per_function([])
+    assert sorted(full_counts.keys()) == ALL_FUNCTIONS, sorted(full_counts.keys())
+
+    check_filter(full_counts, ['--skip-functions', 'logging::.*'], ['compute::Apply', 'compute::Sum', 'main'])
+    # The lambda in compute::Apply is mutated because compute::Apply is.
+    check_filter(full_counts, ['--mutate-functions', 'compute::.*'], ['compute::Apply', 'compute::Sum'])
+    check_filter(full_counts, ['--mutate-functions', 'compute::.*', '--mutate-functions', 'main'],
+                 ['compute::Apply', 'compute::Sum', 'main'])
+    check_filter(full_counts, ['--mutate-functions', 'compute::.*', '--skip-functions', '.*::Sum'],
+                 ['compute::Apply'])
+    # Patterns must match whole names.
+    check_filter(full_counts, ['--mutate-functions', 'Sum'], [])
+
+    # Skipped functions are not mutated when mutation is performed.
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--mutate-functions', 'compute::Sum',
+                             '--mutation-info-file', 'info.json'] + SOURCE_FILES + ['--'],
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert result.returncode == 0, result.stderr.decode('utf-8')
+    with open('info.json', 'r') as json_input:
+        info = json.load(json_input)
+    lines = [mutation['start']['line'] for node in info['infoForFiles'][0]['mutationTree']
+             for group in node['mutationGroups'] for kind, mutation in group.items() if 'start' in mutation]
+    lines += [mutation['exprStart']['line'] for node in info['infoForFiles'][0]['mutationTree']
+              for group in node['mutationGroups'] for kind, mutation in group.items() if 'exprStart' in mutation]
+    assert lines, info
+    assert all(15 <= line <= 21 for line in lines), lines
+    assert not filecmp.cmp(Path('original', 'program.cc'), 'program.cc', shallow=False)
+
+    # Invalid patterns are rejected.
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--count-only', '--skip-functions', 'foo('] + SOURCE_FILES +
+                            ['--'], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert result.returncode != 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
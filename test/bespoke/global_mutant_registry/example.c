@@ -0,0 +1,14 @@
+#include <stdbool.h>
+
+static bool IsOdd(int x) { return (x & 1) != 0; }
+
+int main(int argc, char** argv) {
+  (void)argv;
+  int total = 0;
+  if (argc > 1 && !IsOdd(argc)) {
+    total = argc + 4;
+  } else {
+    total = -argc * 2;
+  }
+  return total;
+}
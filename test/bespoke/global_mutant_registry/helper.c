@@ -0,0 +1,5 @@
+#include <stdbool.h>
+
+int Scale(int x, int y) { return x * y + 1; }
+
+bool IsLarge(int x) { return x > 4 && x != 7; }
@@ -0,0 +1,108 @@
+import filecmp
+import os
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+DREDD_REPO_ROOT = os.environ['DREDD_REPO_ROOT']
+DREDD_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd')
+DREDD_MERGE_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd-merge')
+QUERY_MUTANT_INFO_SCRIPT = Path(DREDD_REPO_ROOT, 'scripts', 'query_mutant_info.py')
+CLANG_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'clang')
+CLANGXX_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'clang++')
+
+# Each program is given as a list of source files that are mutated together. The first program mixes C++ and C, so
+# that the registry is shared between mutated C++ and C files.
+PROGRAMS = [['main.cc', 'helper.c'], ['example.c']]
+
+
+def run_successfully(cmd):
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if result.returncode != 0:
+        print(f"Command exited with error code {result.returncode}: {' '.join([str(c) for c in cmd])}")
+        print(result.stdout.decode('utf-8'))
+        print(result.stderr.decode('utf-8'))
+        sys.exit(1)
+    return result
+
+
+def restore_source_files(source_files):
+    for filename in source_files:
+        shutil.copyfile(src=Path('original', filename), dst=filename)
+
+
+def compile_program(source_files, executable):
+    objects = []
+    for filename in source_files:
+        compiler = CLANGXX_INSTALLED_EXECUTABLE if filename.endswith('.cc') else CLANG_INSTALLED_EXECUTABLE
+        objects.append(filename + '.o')
+        run_successfully([compiler, '-c', filename, '-o', objects[-1]])
+    run_successfully([CLANGXX_INSTALLED_EXECUTABLE] + objects + ['-o', executable])
+
+
+def get_exit_codes(executable, enabled_mutations):
+    # The exit code of the program with no mutant enabled, followed by its exit code with each of the given values of
+    # DREDD_ENABLED_MUTATION.
+    result = []
+    for enabled_mutation in [None] + enabled_mutations:
+        dredd_env = os.environ.copy()
+        if enabled_mutation is not None:
+            dredd_env['DREDD_ENABLED_MUTATION'] = enabled_mutation
+        result.append(subprocess.run([executable, '1', '2'], env=dredd_env).returncode)
+    return result
+
+
+def main():
+    Path('original').mkdir()
+    for source_files in PROGRAMS:
+        for filename in source_files:
+            shutil.copyfile(src=filename, dst=Path('original', filename))
+
+    for source_files in PROGRAMS:
+        # Mutate the program in the usual way, with each source file working out which of its mutants are enabled.
+        restore_source_files(source_files)
+        run_successfully([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info.json'] + source_files + ['--'])
+        compile_program(source_files, './per_file.exe')
+        num_mutants = int(run_successfully(
+            ["python", QUERY_MUTANT_INFO_SCRIPT, "--largest-mutant-id", "info.json"]).stdout.decode('utf-8')) + 1
+        assert num_mutants > 1
+
+        # Mutate the program using the global mutant registry. The mutation info should be unaffected.
+        restore_source_files(source_files)
+        run_successfully([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info-registry.json',
+                          '--global-mutant-registry'] + source_files + ['--'])
+        assert filecmp.cmp('info.json', 'info-registry.json', shallow=False)
+        for filename in source_files:
+            contents = open(filename, 'r').read()
+            assert '__dredd_registry_initialize' in contents, filename
+            # Statement removal should not use the masks of a file-local bitset.
+            assert '__dredd_enabled_mutation_with_mask' not in contents, filename
+        compile_program(source_files, './registry.exe')
+
+        # Every mutant, and every pair of adjacent mutants, should have the same effect in both versions of the
+        # program. Ids that do not correspond to mutants, and empty entries, should be ignored.
+        enabled_mutations = [str(mutant) for mutant in range(num_mutants)]
+        enabled_mutations += [f'{mutant},{mutant + 1}' for mutant in range(num_mutants - 1)]
+        enabled_mutations += [f'{num_mutants + 100}', f',0,,{num_mutants + 1000},', '0,0']
+        assert get_exit_codes('./per_file.exe', enabled_mutations) == get_exit_codes('./registry.exe',
+                                                                                       enabled_mutations)
+
+        # Sharding should produce the same mutated files.
+        for filename in source_files:
+            shutil.copyfile(src=filename, dst=filename + '.registry')
+        restore_source_files(source_files)
+        run_successfully([DREDD_INSTALLED_EXECUTABLE, '--shard', '0/1', '--shard-output-file', 'shard.bin',
+                          '--global-mutant-registry'] + source_files + ['--'])
+        run_successfully([DREDD_MERGE_INSTALLED_EXECUTABLE, 'shard.bin'])
+        for filename in source_files:
+            assert filecmp.cmp(filename, filename + '.registry', shallow=False), filename
+
+    # The global mutant registry cannot be combined with a shared runtime.
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--global-mutant-registry', '--runtime-dir', 'runtime',
+                             'example.c', '--'], stderr=subprocess.PIPE)
+    assert result.returncode != 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
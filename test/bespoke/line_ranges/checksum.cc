@@ -0,0 +1,29 @@
+#include <cstdint>
+
+namespace checksum {
+
+uint32_t Adler32(const unsigned char* data, int length) {
+  uint32_t a = 1;
+  uint32_t b = 0;
+  for (int i = 0; i < length; i++) {
+    a = (a + data[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+  return (b << 16) | a;
+}
+
+int Parity(uint32_t value) {
+  int result = 0;
+  while (value != 0) {
+    result ^= static_cast<int>(value & 1);
+    value >>= 1;
+  }
+  return result;
+}
+
+}  // namespace checksum
+
+int main() {
+  const unsigned char data[] = {'d', 'r', 'e', 'd', 'd'};
+  return checksum::Parity(checksum::Adler32(data, 5)) == 0 ? 0 : 1;
+}
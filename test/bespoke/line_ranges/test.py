@@ -0,0 +1,104 @@
+import difflib
+import json
+import os
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+DREDD_REPO_ROOT = os.environ['DREDD_REPO_ROOT']
+DREDD_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd')
+
+SOURCE_FILES = ['checksum.cc', 'unchanged.c']
+
+# Maps each kind of mutation group to the fields giving the start and end of the code it mutates.
+RANGE_FIELDS = {'removeStmt': ('start', 'end'), 'replaceExpr': ('start', 'end'),
+                'replaceBinaryOperator': ('exprStart', 'exprEnd'),
+                'replaceUnaryOperator': ('exprStart', 'exprEnd')}
+
+
+def mutate(extra_args):
+    # Start from pristine copies of the source files, as Dredd mutates them in place.
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=Path('original', filename), dst=filename)
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info.json'] + extra_args +
+                            SOURCE_FILES + ['--'], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert result.returncode == 0, result.stderr.decode('utf-8')
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=Path('original', filename), dst=filename)
+    with open('info.json', 'r') as json_input:
+        return json.load(json_input)
+
+
+def get_mutation_sites(info):
+    # Yields, per source file, the code that is mutated, with the actions applied to it, and checks that mutation ids
+    # are contiguous from zero.
+    result = {}
+    mutation_ids = []
+    for info_for_file in info['infoForFiles']:
+        sites = []
+        for node in info_for_file['mutationTree']:
+            for group in node['mutationGroups']:
+                for kind, mutation in group.items():
+                    start_field, end_field = RANGE_FIELDS[kind]
+                    start = (mutation[start_field]['line'], mutation[start_field]['column'])
+                    end = (mutation[end_field]['line'], mutation[end_field]['column'])
+                    if kind == 'removeStmt':
+                        actions = ['RemoveStmt']
+                        mutation_ids.append(mutation.get('mutationId', 0))
+                    else:
+                        actions = [instance['action'] for instance in mutation['instances']]
+                        mutation_ids += [instance.get('mutationId', 0) for instance in mutation['instances']]
+                    sites.append((kind, start, end, actions))
+        result[Path(info_for_file['filename']).name] = sorted(sites)
+    assert sorted(mutation_ids) == list(range(len(mutation_ids))), mutation_ids
+    return result
+
+
+def check_restricted(full_sites, restricted_sites, filename, lines):
+    # Exactly the mutations of the full run whose code spans one of the given lines must be applied, with all of
+    # their actions.
+    expected = [site for site in full_sites[filename] if any(site[1][0] <= line <= site[2][0] for line in lines)]
+    assert expected, filename
+    assert restricted_sites[filename] == expected, filename
+    for other_filename, sites in restricted_sites.items():
+        if other_filename != filename:
+            assert sites == [], other_filename
+
+
+def main():
+    Path('original').mkdir()
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=filename, dst=Path('original', filename))
+
+    full_sites = get_mutation_sites(mutate([]))
+    for filename in SOURCE_FILES:
+        assert full_sites[filename], filename
+
+    # The loop body of Adler32.
+    restricted_sites = get_mutation_sites(mutate(['--line-ranges', 'checksum.cc:9-10']))
+    check_restricted(full_sites, restricted_sites, 'checksum.cc', [9, 10])
+    assert restricted_sites == get_mutation_sites(mutate(['--line-ranges', 'checksum.cc:9-10', '--jobs', '2']))
+
+    # A diff in which line 9 is changed and a line after line 18 is removed, so that lines 9, 18 and 19 are
+    # considered changed.
+    with open(Path('original', 'checksum.cc'), 'r') as source_input:
+        new_lines = source_input.readlines()
+    old_lines = list(new_lines)
+    old_lines[8] = '    a = (a + data[i]) % 65535;\n'
+    old_lines.insert(18, '    result = -result;\n')
+    with open('changes.diff', 'w') as diff_output:
+        diff_output.writelines(difflib.unified_diff(old_lines, new_lines, fromfile='a/checksum.cc',
+                                                    tofile='b/checksum.cc'))
+    restricted_sites = get_mutation_sites(mutate(['--line-ranges-from-diff', 'changes.diff']))
+    check_restricted(full_sites, restricted_sites, 'checksum.cc', [9, 18, 19])
+    assert restricted_sites == get_mutation_sites(mutate(['--line-ranges', 'checksum.cc:9,18-19']))
+
+    # Invalid line ranges are rejected.
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--line-ranges', 'checksum.cc:10-9'] + SOURCE_FILES +
+                            ['--'], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert result.returncode != 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
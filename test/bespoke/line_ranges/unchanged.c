@@ -0,0 +1,7 @@
+int square(int x) {
+  return x * x;
+}
+
+int sum_of_squares(int a, int b) {
+  return square(a) + square(b);
+}
@@ -0,0 +1,25 @@
+int sum_of_squares(int n) {
+  int result = 0;
+  for (int i = 1; i <= n; i++) {
+    result += i * i;
+  }
+  return result;
+}
+
+int clamp(int x, int low, int high) {
+  if (x < low) {
+    return low;
+  }
+  if (x > high) {
+    return high;
+  }
+  return x;
+}
+
+int main(void) {
+  int total = sum_of_squares(3) + clamp(-5, 0, 10) + clamp(20, 0, 10);
+  if (total != 24) {
+    return 1;
+  }
+  return 0;
+}
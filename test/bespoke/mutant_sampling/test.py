@@ -0,0 +1,82 @@
+import json
+import math
+import os
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+DREDD_REPO_ROOT = os.environ['DREDD_REPO_ROOT']
+DREDD_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd')
+CLANG_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'clang')
+
+
+def run_successfully(cmd):
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert result.returncode == 0, (cmd, result.stderr.decode('utf-8'))
+    return result
+
+
+def count_mutations_per_kind(extra_args):
+    counts = json.loads(run_successfully([DREDD_INSTALLED_EXECUTABLE, '--count-only'] + extra_args +
+                                         ['check.c', '--']).stdout.decode('utf-8'))
+    result = {}
+    for action_count in counts.get('actions', []):
+        result[action_count['kind']] = result.get(action_count['kind'], 0) + action_count['numMutations']
+    return result
+
+
+def mutate(extra_args, info_file):
+    # Mutates a fresh copy of the original source file, yielding the mutation info that is written.
+    shutil.copyfile(src=Path('original', 'check.c'), dst='check.c')
+    run_successfully([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', info_file] + extra_args + ['check.c', '--'])
+    with open(info_file, 'r') as json_input:
+        return json.load(json_input)
+
+
+def main():
+    Path('original').mkdir()
+    shutil.copyfile(src='check.c', dst=Path('original', 'check.c'))
+
+    full_counts = count_mutations_per_kind([])
+    assert len(full_counts) == 4, full_counts
+
+    # Each kind of mutation keeps the sampled proportion of its mutants, rounded up.
+    for rate in [0.01, 0.3, 0.75]:
+        sampled_counts = count_mutations_per_kind(['--sample-rate', str(rate), '--sample-seed', '7'])
+        expected = {kind: math.ceil(rate * count) for kind, count in full_counts.items()}
+        assert sampled_counts == expected, (rate, sampled_counts, expected)
+
+    # The same seed yields the same mutants, and the sampling is recorded.
+    sampled_args = ['--sample-rate', '0.3', '--sample-seed', '7']
+    info = mutate(sampled_args, 'info.json')
+    assert info == mutate(sampled_args, 'info-again.json')
+    assert info['infoForFiles'][0]['mutationSampling'] == {'rate': 0.3, 'seed': '7'}, info
+    assert info != mutate(['--sample-rate', '0.3', '--sample-seed', '8'], 'info-other-seed.json')
+
+    # The sampled mutants are numbered contiguously, and each of them yields a working program.
+    mutate(sampled_args, 'info.json')
+    num_mutants = sum(count_mutations_per_kind(sampled_args).values())
+    run_successfully([CLANG_INSTALLED_EXECUTABLE, 'check.c', '-o', './check.exe'])
+    assert subprocess.run(['./check.exe']).returncode == 0
+    killed = 0
+    for mutant in range(num_mutants):
+        dredd_env = os.environ.copy()
+        dredd_env['DREDD_ENABLED_MUTATION'] = str(mutant)
+        try:
+            if subprocess.run(['./check.exe'], env=dredd_env, timeout=10).returncode != 0:
+                killed += 1
+        except subprocess.TimeoutExpired:
+            killed += 1
+    assert killed > 0, num_mutants
+
+    # A rate of 1 does not sample, and out-of-range rates are rejected.
+    assert 'mutationSampling' not in mutate(['--sample-rate', '1'], 'info-full.json')['infoForFiles'][0]
+    for rate in ['0', '-0.5', '1.5']:
+        result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--count-only', '--sample-rate', rate, 'check.c', '--'],
+                                stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        assert result.returncode != 0, rate
+
+
+if __name__ == '__main__':
+    sys.exit(main())
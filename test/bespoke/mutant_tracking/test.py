@@ -26,6 +26,7 @@ def main():
     # Run Dredd without tracking
     shutil.copyfile(src='example.c', dst='tomutate.c')
     run_successfully([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info-mutate.json', 'tomutate.c', '--'])
+    shutil.copyfile(src='tomutate.c', dst='mutated.c')
 
     # Run Dredd with tracking
     shutil.copyfile(src='example.c', dst='tomutate.c')
@@ -39,6 +40,22 @@ def main():
     # Check that the JSON files produced with vs. without tracking are identical, because tracking should not affect the
     # JSON
     assert filecmp.cmp('info-mutate.json', 'info-track.json')
+    shutil.copyfile(src='tomutate.c', dst='tracked.c')
+
+    # Run Dredd once, producing both the mutated and the tracking version. These, and the JSON, should be identical to
+    # those produced by the separate runs.
+    shutil.copyfile(src='example.c', dst='tomutate.c')
+    run_successfully([DREDD_INSTALLED_EXECUTABLE,
+                      '--mutation-info-file',
+                      'info-both.json',
+                      '--coverage-tracking-output-dir',
+                      'tracking',
+                      'tomutate.c',
+                      '--'])
+    assert filecmp.cmp('info-mutate.json', 'info-both.json')
+    assert filecmp.cmp('mutated.c', 'tomutate.c', shallow=False)
+    assert filecmp.cmp('tracked.c', Path('tracking', 'tomutate.c'), shallow=False)
+    shutil.copyfile(src='tracked.c', dst='tomutate.c')
 
     # The mutant tracking version should compile successfully.
     run_successfully([CLANG_INSTALLED_EXECUTABLE, 'tomutate.c'])
@@ -0,0 +1,12 @@
+#include "header.h"
+
+int scale(int a) {
+  return a * SCALE;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) {
+    return scale(argc);
+  }
+  return 0;
+}
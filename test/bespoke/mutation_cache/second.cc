@@ -0,0 +1,10 @@
+#include <cstddef>
+
+static int counter = 0;
+
+int Next() {
+  counter++;
+  return counter * 3 - 1;
+}
+
+bool IsSmall(std::size_t x) { return x < 10 && x != 5; }
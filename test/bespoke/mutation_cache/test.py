@@ -0,0 +1,77 @@
+import filecmp
+import os
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+DREDD_REPO_ROOT = os.environ['DREDD_REPO_ROOT']
+DREDD_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd')
+
+SOURCE_FILES = ['first.c', 'no_mutations.c', 'second.cc']
+OUTPUT_FILES = SOURCE_FILES + ['info.json']
+
+
+def run_dredd(extra_args, output_dir, source_files=SOURCE_FILES):
+    # Start from pristine copies of the source files, as Dredd mutates them in place.
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=Path('original', filename), dst=filename)
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info.json'] + extra_args +
+                            source_files + ['--'], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert result.returncode == 0, result.stderr.decode('utf-8')
+    Path(output_dir).mkdir()
+    for filename in OUTPUT_FILES:
+        shutil.copyfile(src=filename, dst=Path(output_dir, filename))
+    return result.stderr.decode('utf-8')
+
+
+def check_same_outputs(expected_dir, actual_dir):
+    for filename in OUTPUT_FILES:
+        assert filecmp.cmp(Path(expected_dir, filename), Path(actual_dir, filename), shallow=False), filename
+
+
+def main():
+    Path('original').mkdir()
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=filename, dst=Path('original', filename))
+
+    run_dredd([], 'uncached')
+
+    # The first run populates the cache, and the second is served entirely from it. Both must yield the same
+    # results as a run without a cache.
+    stderr = run_dredd(['--cache-dir', 'cache'], 'cold')
+    assert 'Mutation cache: 0 hit(s), 3 miss(es)' in stderr, stderr
+    check_same_outputs('uncached', 'cold')
+    stderr = run_dredd(['--cache-dir', 'cache'], 'warm')
+    assert 'Mutation cache: 3 hit(s), 0 miss(es)' in stderr, stderr
+    check_same_outputs('uncached', 'warm')
+    stderr = run_dredd(['--cache-dir', 'cache', '--jobs', '2'], 'warm_jobs2')
+    assert 'Mutation cache: 3 hit(s), 0 miss(es)' in stderr, stderr
+    check_same_outputs('uncached', 'warm_jobs2')
+
+    # Different options must not share cache entries.
+    stderr = run_dredd(['--cache-dir', 'cache', '--only-track-mutant-coverage'], 'tracking_cold')
+    assert 'Mutation cache: 0 hit(s), 3 miss(es)' in stderr, stderr
+    run_dredd(['--only-track-mutant-coverage'], 'tracking_uncached')
+    check_same_outputs('tracking_uncached', 'tracking_cold')
+
+    # Changing a header invalidates the entry for the file that includes it, and only that entry.
+    with open('header.h', 'w') as header:
+        header.write('#define SCALE 4\n')
+    run_dredd([], 'changed_header_uncached')
+    stderr = run_dredd(['--cache-dir', 'cache'], 'changed_header')
+    assert 'Mutation cache: 2 hit(s), 1 miss(es)' in stderr, stderr
+    check_same_outputs('changed_header_uncached', 'changed_header')
+    assert not filecmp.cmp(Path('uncached', 'first.c'), Path('changed_header', 'first.c'), shallow=False)
+
+    # Simulate a run that was interrupted after only the first file had been mutated: a further run on the original
+    # source files resumes from the entry that was cached.
+    stderr = run_dredd(['--cache-dir', 'resume_cache'], 'interrupted', ['first.c'])
+    assert 'Mutation cache: 0 hit(s), 1 miss(es)' in stderr, stderr
+    stderr = run_dredd(['--cache-dir', 'resume_cache', '--jobs', '2'], 'resumed')
+    assert 'Mutation cache: 1 hit(s), 2 miss(es)' in stderr, stderr
+    check_same_outputs('changed_header_uncached', 'resumed')
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,13 @@
+int check(int a, int b) {
+  if (a > 0 && b > 0) {
+    return a + b;
+  }
+  if (!(a < 0) || b == -1) {
+    a++;
+  }
+  return a - b;
+}
+
+int main(void) {
+  return check(2, -1);
+}
@@ -0,0 +1,108 @@
+import json
+import os
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+DREDD_REPO_ROOT = os.environ['DREDD_REPO_ROOT']
+DREDD_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd')
+CLANG_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'clang')
+
+SOURCE_FILES = ['check.c', 'values.cc']
+
+
+def run_successfully(cmd):
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert result.returncode == 0, (cmd, result.stderr.decode('utf-8'))
+    return result
+
+
+def count_mutations_per_action(extra_args):
+    # Yields a map from (kind, action) pairs to the number of mutants of that kind and action, for each source file.
+    result = {}
+    for filename in SOURCE_FILES:
+        counts = json.loads(run_successfully([DREDD_INSTALLED_EXECUTABLE, '--count-only'] + extra_args +
+                                             [filename, '--']).stdout.decode('utf-8'))
+        result[filename] = {(action_count['kind'], action_count['action']): action_count['numMutations']
+                            for action_count in counts.get('actions', [])}
+    return result
+
+
+def check_selection(full_counts, extra_args, is_selected):
+    # Restricting the mutations that are applied must yield exactly the selected mutants of an unrestricted run.
+    counts = count_mutations_per_action(extra_args)
+    for filename in SOURCE_FILES:
+        expected = {key: value for key, value in full_counts[filename].items() if is_selected(*key)}
+        assert counts[filename] == expected, (extra_args, filename, counts[filename], expected)
+
+
+def main():
+    Path('original').mkdir()
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=filename, dst=Path('original', filename))
+
+    full_counts = count_mutations_per_action([])
+    for filename in SOURCE_FILES:
+        kinds = {kind for kind, _ in full_counts[filename].keys()}
+        assert kinds == {'remove_stmt', 'replace_expr', 'replace_binary_operator', 'replace_unary_operator'}, kinds
+
+    check_selection(full_counts, ['--disable-mutations', 'replace_expr'], lambda kind, action: kind != 'replace_expr')
+    check_selection(full_counts, ['--enable-mutations', 'remove_stmt,replace_binary_operator:ReplaceWithLHS'],
+                    lambda kind, action: kind == 'remove_stmt' or action == 'ReplaceWithLHS')
+    # Swapping && and || in C is handled specially, and must be possible to disable independently of replacing
+    # such an expression with one of its operands.
+    check_selection(full_counts, ['--disable-mutations', 'replace_binary_operator:ReplaceWithLAnd',
+                                  '--disable-mutations', 'replace_binary_operator:ReplaceWithLOr'],
+                    lambda kind, action: action not in ['ReplaceWithLAnd', 'ReplaceWithLOr'])
+    check_selection(full_counts, ['--enable-mutations', 'replace_unary_operator,replace_expr:InsertLNot',
+                                  '--disable-mutations', 'replace_unary_operator:ReplaceWithOperand'],
+                    lambda kind, action: (kind == 'replace_unary_operator' and action != 'ReplaceWithOperand')
+                    or action == 'InsertLNot')
+
+    # A selection can be kept in a file and passed to Dredd as a response file.
+    with open('selection.txt', 'w') as selection_file:
+        selection_file.write('--enable-mutations=replace_binary_operator:ReplaceWithRHS\n')
+    check_selection(full_counts, ['@selection.txt'], lambda kind, action: action == 'ReplaceWithRHS')
+
+    # Mutate the C program with a selection that only partially covers the special handling of logical operators,
+    # check that the selection is recorded, and that every mutant is as expected.
+    run_successfully([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info.json', '--enable-mutations',
+                      'replace_binary_operator:ReplaceWithLHS,replace_binary_operator:ReplaceWithRHS', 'check.c',
+                      '--'])
+    with open('info.json', 'r') as json_input:
+        info = json.load(json_input)
+    mutation_selection = info['infoForFiles'][0]['mutationSelection']
+    assert not mutation_selection.get('removeStmt', False), mutation_selection
+    assert 'replaceExprActions' not in mutation_selection, mutation_selection
+    assert mutation_selection['replaceBinaryOperatorActions'] == ['ReplaceWithLHS', 'ReplaceWithRHS'], \
+        mutation_selection
+    num_mutants = sum(full_counts['check.c'][('replace_binary_operator', action)]
+                      for action in ['ReplaceWithLHS', 'ReplaceWithRHS'])
+    run_successfully([CLANG_INSTALLED_EXECUTABLE, 'check.c', '-o', './check.exe'])
+    exit_codes = []
+    for mutant in [None] + list(range(num_mutants)):
+        dredd_env = os.environ.copy()
+        if mutant is not None:
+            dredd_env['DREDD_ENABLED_MUTATION'] = str(mutant)
+        exit_codes.append(subprocess.run(['./check.exe'], env=dredd_env).returncode)
+    assert exit_codes[0] == 4, exit_codes
+    # Replacing "a > 0 && b > 0" with "a > 0" leads to "a + b" being returned.
+    assert 1 in exit_codes[1:], exit_codes
+
+    # A run with no restriction does not record a selection.
+    shutil.copyfile(src=Path('original', 'check.c'), dst='check.c')
+    run_successfully([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info-full.json', 'check.c', '--'])
+    with open('info-full.json', 'r') as json_input:
+        assert 'mutationSelection' not in json.load(json_input)['infoForFiles'][0]
+
+    # Invalid selections are rejected.
+    for extra_args in [['--enable-mutations', 'replace_statement'],
+                       ['--disable-mutations', 'replace_expr:ReplaceWithLHS']]:
+        result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--count-only'] + extra_args + ['check.c', '--'],
+                                stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        assert result.returncode != 0, extra_args
+
+
+if __name__ == '__main__':
+    sys.exit(main())
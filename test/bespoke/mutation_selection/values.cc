@@ -0,0 +1,17 @@
+#include <vector>
+
+static int Total(const std::vector<int>& values) {
+  int result = 0;
+  for (int value : values) {
+    if (value > 0 || value < -10) {
+      result += value;
+    }
+  }
+  return result;
+}
+
+int main() {
+  std::vector<int> values = {1, -2, 3, -20};
+  bool negative = Total(values) < 0;
+  return negative ? 1 : -Total(values) + 10;
+}
@@ -0,0 +1,137 @@
+import json
+import os
+import shutil
+import socket
+import stat
+import subprocess
+import sys
+import time
+from pathlib import Path
+
+DREDD_REPO_ROOT = os.environ['DREDD_REPO_ROOT']
+DREDD_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd')
+
+SOURCE_FILES = ['first.c', 'second.cc']
+SOCKET_PATH = 'dredd.sock'
+
+EXTRA_FUNCTION = '\nint sub(int a, int b) {\n  return a - b;\n}\n'
+
+
+def run_dredd():
+    # Mutates pristine copies of the source files in place, and yields the mutated files and mutation info, before
+    # restoring the source files.
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=Path('current', filename), dst=filename)
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info.json'] + SOURCE_FILES + ['--'],
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert result.returncode == 0, result.stderr.decode('utf-8')
+    mutated_texts = [Path(filename).read_text() for filename in SOURCE_FILES]
+    with open('info.json', 'r') as json_input:
+        info_for_files = json.load(json_input)['infoForFiles']
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=Path('current', filename), dst=filename)
+    return mutated_texts, info_for_files
+
+
+def read_response(reader):
+    line = reader.readline()
+    assert line, 'The server closed the connection.'
+    return json.loads(line)
+
+
+def check_response(response, expected_mutated_texts, expected_info_for_files):
+    assert 'error' not in response or not response['error'], response['error']
+    files = response['files']
+    assert [served_file['mutatedText'] for served_file in files] == expected_mutated_texts
+    assert [served_file['mutationInfoForFile'] for served_file in files] == expected_info_for_files
+
+
+def connect():
+    connection = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    # A server that stops responding makes the test fail rather than hang.
+    connection.settimeout(120)
+    connection.connect(SOCKET_PATH)
+    return connection, connection.makefile('r')
+
+
+def main():
+    Path('original').mkdir()
+    Path('current').mkdir()
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=filename, dst=Path('original', filename))
+        shutil.copyfile(src=filename, dst=Path('current', filename))
+    expected_mutated_texts, expected_info_for_files = run_dredd()
+
+    # The expected results for a changed version of the first file are computed up front, as running dredd modifies
+    # the source files, which would be noticed by a server that is watching them.
+    with open(Path('current', 'first.c'), 'a') as current_first:
+        current_first.write(EXTRA_FUNCTION)
+    expected_changed_mutated_texts, expected_changed_info_for_files = run_dredd()
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=Path('original', filename), dst=Path('current', filename))
+        shutil.copyfile(src=Path('original', filename), dst=filename)
+    assert expected_changed_mutated_texts != expected_mutated_texts
+
+    server_log = open('server.log', 'w')
+    server = subprocess.Popen([DREDD_INSTALLED_EXECUTABLE, '--serve', SOCKET_PATH] + SOURCE_FILES + ['--'],
+                              stdout=server_log, stderr=server_log)
+    try:
+        for _ in range(100):
+            if Path(SOCKET_PATH).exists():
+                break
+            time.sleep(0.1)
+
+        # Only the user running the server may connect to it.
+        assert stat.S_IMODE(os.stat(SOCKET_PATH).st_mode) == 0o600
+
+        # A request that lists no source files mutates those given to the server, exactly as dredd would, without
+        # modifying them.
+        connection, reader = connect()
+        connection.sendall(b'{}\n')
+        check_response(read_response(reader), expected_mutated_texts, expected_info_for_files)
+        for filename in SOURCE_FILES:
+            assert Path(filename).read_text() == Path('current', filename).read_text(), filename
+
+        # Several requests can be made on one connection, and malformed requests are reported.
+        connection.sendall(b'not json\n' + json.dumps({'sourcePaths': SOURCE_FILES}).encode('utf-8') + b'\n')
+        assert read_response(reader)['error']
+        check_response(read_response(reader), expected_mutated_texts, expected_info_for_files)
+        connection.close()
+
+        # A client that does not read its responses does not hold up other clients, and receives its responses once
+        # it does read them.
+        idle_connection, idle_reader = connect()
+        idle_connection.sendall(b'{}\n' * 30)
+        connection, reader = connect()
+        connection.sendall(b'{}\n')
+        check_response(read_response(reader), expected_mutated_texts, expected_info_for_files)
+        connection.close()
+        for _ in range(30):
+            check_response(read_response(idle_reader), expected_mutated_texts, expected_info_for_files)
+        idle_connection.close()
+
+        if sys.platform.startswith('linux'):
+            connection, reader = connect()
+            connection.sendall(json.dumps({'sourcePaths': SOURCE_FILES, 'watch': True}).encode('utf-8') + b'\n')
+            check_response(read_response(reader), expected_mutated_texts, expected_info_for_files)
+
+            # Changing the first file leads to a response in which its mutations, and the ids of the mutations in
+            # the second file, are updated, matching what dredd yields for the changed files.
+            with open('first.c', 'a') as first:
+                first.write(EXTRA_FUNCTION)
+            check_response(read_response(reader), expected_changed_mutated_texts, expected_changed_info_for_files)
+            connection.close()
+
+        connection, reader = connect()
+        connection.sendall(b'{"shutdown": true}\n')
+        read_response(reader)
+        connection.close()
+        assert server.wait(timeout=60) == 0
+    finally:
+        if server.poll() is None:
+            server.kill()
+        server_log.close()
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,10 @@
+int add(int a, int b) {
+  return a + b;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) {
+    return add(argc, 2);
+  }
+  return 0;
+}
@@ -0,0 +1,68 @@
+import filecmp
+import json
+import os
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+DREDD_REPO_ROOT = os.environ['DREDD_REPO_ROOT']
+DREDD_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd')
+
+SOURCE_FILES = ['first.c', 'bad.c', 'second.cc', 'no_mutations.c', 'third.cc', 'first.c']
+
+
+def run_dredd(extra_args, output_dir):
+    # Start from pristine copies of the source files.
+    for filename in set(SOURCE_FILES):
+        shutil.copyfile(src=Path('original', filename), dst=filename)
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info.json'] + extra_args +
+                            SOURCE_FILES + ['--'], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    # Dredd should return non-zero, due to 'bad.c'.
+    assert result.returncode != 0
+    assert 'bad.c' in result.stderr.decode('utf-8')
+    Path(output_dir).mkdir()
+    for filename in set(SOURCE_FILES) | {'info.json'}:
+        shutil.copyfile(src=filename, dst=Path(output_dir, filename))
+    return result.stderr.decode('utf-8')
+
+
+def main():
+    Path('original').mkdir()
+    for filename in set(SOURCE_FILES):
+        shutil.copyfile(src=filename, dst=Path('original', filename))
+
+    run_dredd([], 'serial')
+    for num_jobs in ['2', '4', '0']:
+        output_dir = 'jobs' + num_jobs
+        run_dredd(['--jobs', num_jobs], output_dir)
+        # Mutated files and mutation info must be identical to those obtained by mutating files one at a time.
+        for filename in set(SOURCE_FILES) | {'info.json'}:
+            assert filecmp.cmp(Path('serial', filename), Path(output_dir, filename), shallow=False), filename
+
+    # Timing the phases of mutation must not affect the results, whether files are mutated serially or in parallel.
+    for extra_args, output_dir in [([], 'timed_serial'), (['--jobs', '2'], 'timed_jobs2')]:
+        stderr = run_dredd(['--print-phase-timings'] + extra_args, output_dir)
+        assert 'Phase timings' in stderr
+        assert 'apply mutations' in stderr
+        for filename in set(SOURCE_FILES) | {'info.json'}:
+            assert filecmp.cmp(Path('serial', filename), Path(output_dir, filename), shallow=False), filename
+
+    # Mutation info written as JSON Lines must hold the same information, whether files are mutated serially or in
+    # parallel.
+    with open(Path('serial', 'info.json'), 'r') as json_input:
+        expected_info_for_files = json.load(json_input)['infoForFiles']
+    for extra_args, output_dir in [([], 'jsonl_serial'), (['--jobs', '2'], 'jsonl_jobs2')]:
+        run_dredd(['--mutation-info-format=jsonl'] + extra_args, output_dir)
+        for filename in set(SOURCE_FILES):
+            assert filecmp.cmp(Path('serial', filename), Path(output_dir, filename), shallow=False), filename
+        with open(Path(output_dir, 'info.json'), 'r') as jsonl_input:
+            assert [json.loads(line) for line in jsonl_input if line.strip()] == expected_info_for_files
+
+    # Sanity-check that mutation did take place.
+    assert not filecmp.cmp(Path('original', 'first.c'), Path('serial', 'first.c'), shallow=False)
+    assert filecmp.cmp(Path('original', 'no_mutations.c'), Path('serial', 'no_mutations.c'), shallow=False)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
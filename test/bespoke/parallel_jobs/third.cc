@@ -0,0 +1,7 @@
+double Scale(double x, double factor) {
+  double result = x;
+  for (int i = 0; i < 3; i++) {
+    result *= -factor;
+  }
+  return result;
+}
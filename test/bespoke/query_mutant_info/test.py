@@ -1,4 +1,5 @@
 import glob
+import json
 import os
 import shutil
 import subprocess
@@ -113,31 +114,48 @@ def main():
                       '-DDREDD_EXAMPLES_MATH_BUILD_TESTS=OFF',
                       ])
 
-    # Mutate the source files of the math example
-    run_successfully([DREDD_INSTALLED_EXECUTABLE,
-                      '-p',
-                      'build',
-                      '--mutation-info-file',
-                      'mutant-info.json',
-                      'math/math/src/exp.cc'])
-
-    # Get the largest mutant id
-    largest_mutant_id = int(run_successfully(
-        ["python", QUERY_MUTANT_INFO_SCRIPT, "--largest-mutant-id", "mutant-info.json"]).stdout.decode('utf-8'))
+    # Mutate the source files of the math example, once with each of the JSON and binary mutation info formats
+    shutil.copyfile(src=Path('math', 'math', 'src', 'exp.cc'), dst='exp.cc.original')
+    for mutation_info_file, mutation_info_format in [('mutant-info.json', 'json'), ('mutant-info.bin', 'binary')]:
+        shutil.copyfile(src='exp.cc.original', dst=Path('math', 'math', 'src', 'exp.cc'))
+        run_successfully([DREDD_INSTALLED_EXECUTABLE,
+                          '-p',
+                          'build',
+                          '--mutation-info-file',
+                          mutation_info_file,
+                          f'--mutation-info-format={mutation_info_format}',
+                          'math/math/src/exp.cc'])
+
+    # The binary mutation info must hold the same information as the JSON mutation info
+    run_successfully(["python", QUERY_MUTANT_INFO_SCRIPT, "--export-json", "exported.json", "mutant-info.bin"])
+    with open('mutant-info.json', 'r') as json_input, open('exported.json', 'r') as exported_input:
+        if json.load(json_input) != json.load(exported_input):
+            print("Mutation info exported from the binary format differs from the JSON mutation info")
+            sys.exit(1)
 
     all_mutant_info = ""
-    for mutant in range(0, largest_mutant_id + 1):
-        all_mutant_info += str(run_successfully(
-            ["python",
-             QUERY_MUTANT_INFO_SCRIPT,
-             "--show-info-for-mutant",
-             str(mutant),
-             "--path-prefix-replacement",
-             os.path.abspath(os.curdir + os.sep + "math"),
-             str(path_to_original_code),
-             "mutant-info.json"]).stdout.decode('utf-8'))
-
-    all_mutant_info = '\n'.join(all_mutant_info.splitlines())
+    for mutation_info_file in ['mutant-info.json', 'mutant-info.bin']:
+        # Get the largest mutant id
+        largest_mutant_id = int(run_successfully(
+            ["python", QUERY_MUTANT_INFO_SCRIPT, "--largest-mutant-id", mutation_info_file]).stdout.decode('utf-8'))
+
+        mutant_info_for_file = ""
+        for mutant in range(0, largest_mutant_id + 1):
+            mutant_info_for_file += str(run_successfully(
+                ["python",
+                 QUERY_MUTANT_INFO_SCRIPT,
+                 "--show-info-for-mutant",
+                 str(mutant),
+                 "--path-prefix-replacement",
+                 os.path.abspath(os.curdir + os.sep + "math"),
+                 str(path_to_original_code),
+                 mutation_info_file]).stdout.decode('utf-8'))
+
+        mutant_info_for_file = '\n'.join(mutant_info_for_file.splitlines())
+        if all_mutant_info and mutant_info_for_file != all_mutant_info:
+            print(f"Mutant info obtained from {mutation_info_file} differs from that obtained from mutant-info.json")
+            sys.exit(1)
+        all_mutant_info = mutant_info_for_file
 
     for expected_mutation in [EXPECTED_MUTATION_1,
                               EXPECTED_MUTATION_2,
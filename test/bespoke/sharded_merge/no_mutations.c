@@ -0,0 +1 @@
+int declared_only(int x);
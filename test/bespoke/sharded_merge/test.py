@@ -0,0 +1,68 @@
+import filecmp
+import os
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+DREDD_REPO_ROOT = os.environ['DREDD_REPO_ROOT']
+DREDD_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd')
+DREDD_MERGE_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd-merge')
+
+SOURCE_FILES = ['first.c', 'second.cc', 'no_mutations.c', 'third.cc']
+NUM_SHARDS = 3
+
+
+def restore_source_files():
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=Path('original', filename), dst=filename)
+
+
+def save_outputs(output_dir):
+    Path(output_dir).mkdir()
+    for filename in SOURCE_FILES + ['info.json']:
+        shutil.copyfile(src=filename, dst=Path(output_dir, filename))
+
+
+def main():
+    Path('original').mkdir()
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=filename, dst=Path('original', filename))
+
+    restore_source_files()
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info.json'] + SOURCE_FILES + ['--'])
+    assert result.returncode == 0
+    save_outputs('serial')
+
+    restore_source_files()
+    shard_files = []
+    for shard_index in range(NUM_SHARDS):
+        shard_file = 'shard_' + str(shard_index) + '.bin'
+        result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--shard', str(shard_index) + '/' + str(NUM_SHARDS),
+                                 '--shard-output-file', shard_file] + SOURCE_FILES + ['--'])
+        assert result.returncode == 0
+        shard_files.append(shard_file)
+        # Sharded runs must not modify the source files; that is left to dredd-merge.
+        for filename in SOURCE_FILES:
+            assert filecmp.cmp(Path('original', filename), filename, shallow=False), filename
+
+    # Shards may be given to dredd-merge in any order.
+    result = subprocess.run([DREDD_MERGE_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info.json']
+                            + list(reversed(shard_files)))
+    assert result.returncode == 0
+    save_outputs('merged')
+
+    # Merging the shards must produce exactly what a single serial invocation of Dredd produces.
+    for filename in SOURCE_FILES + ['info.json']:
+        assert filecmp.cmp(Path('serial', filename), Path('merged', filename), shallow=False), filename
+
+    # dredd-merge must reject an incomplete set of shards.
+    result = subprocess.run([DREDD_MERGE_INSTALLED_EXECUTABLE] + shard_files[1:], stderr=subprocess.PIPE)
+    assert result.returncode != 0
+
+    # Sanity-check that mutation did take place.
+    assert not filecmp.cmp(Path('original', 'first.c'), Path('serial', 'first.c'), shallow=False)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,3 @@
+int Scale(int x, int y) { return x * y + 1; }
+
+bool IsLarge(int x) { return x > 4 && x != 7; }
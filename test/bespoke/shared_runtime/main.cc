@@ -0,0 +1,12 @@
+int Scale(int x, int y);
+
+bool IsLarge(int x);
+
+int main(int argc, char** argv) {
+  (void)argv;
+  int result = Scale(argc, 3);
+  if (IsLarge(result) && argc < 10) {
+    result = result - 2;
+  }
+  return result;
+}
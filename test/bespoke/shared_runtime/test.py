@@ -0,0 +1,105 @@
+import filecmp
+import os
+import re
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+DREDD_REPO_ROOT = os.environ['DREDD_REPO_ROOT']
+DREDD_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd')
+DREDD_MERGE_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd-merge')
+QUERY_MUTANT_INFO_SCRIPT = Path(DREDD_REPO_ROOT, 'scripts', 'query_mutant_info.py')
+CLANG_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'clang')
+CLANGXX_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'clang++')
+
+# Each program is given as a list of source files that are mutated together.
+PROGRAMS = [['main.cc', 'helper.cc'], ['example.c']]
+
+
+def run_successfully(cmd):
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if result.returncode != 0:
+        print(f"Command exited with error code {result.returncode}: {' '.join([str(c) for c in cmd])}")
+        print(result.stdout.decode('utf-8'))
+        print(result.stderr.decode('utf-8'))
+        sys.exit(1)
+    return result
+
+
+def restore_source_files(source_files):
+    for filename in source_files:
+        shutil.copyfile(src=Path('original', filename), dst=filename)
+
+
+def compile_program(source_files, executable, extra_args):
+    compiler = CLANGXX_INSTALLED_EXECUTABLE if source_files[0].endswith('.cc') else CLANG_INSTALLED_EXECUTABLE
+    run_successfully([compiler] + source_files + extra_args + ['-o', executable])
+
+
+def get_exit_codes(executable, num_mutants):
+    # The exit code of the program with no mutant enabled, followed by its exit code with each mutant enabled.
+    result = []
+    for mutant in [None] + list(range(num_mutants)):
+        dredd_env = os.environ.copy()
+        if mutant is not None:
+            dredd_env['DREDD_ENABLED_MUTATION'] = str(mutant)
+        result.append(subprocess.run([executable, '1', '2'], env=dredd_env).returncode)
+    return result
+
+
+def main():
+    Path('original').mkdir()
+    for source_files in PROGRAMS:
+        for filename in source_files:
+            shutil.copyfile(src=filename, dst=Path('original', filename))
+
+    for source_files in PROGRAMS:
+        # Mutate the program in the usual way, with mutant functions defined in each source file.
+        restore_source_files(source_files)
+        run_successfully([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info.json'] + source_files + ['--'])
+        compile_program(source_files, './per_file.exe', [])
+        num_mutants = int(run_successfully(
+            ["python", QUERY_MUTANT_INFO_SCRIPT, "--largest-mutant-id", "info.json"]).stdout.decode('utf-8')) + 1
+        assert num_mutants > 1
+
+        # Mutate the program using a shared runtime. The mutation info should be unaffected.
+        restore_source_files(source_files)
+        run_successfully([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info-shared.json', '--runtime-dir',
+                          'runtime'] + source_files + ['--'])
+        assert filecmp.cmp('info.json', 'info-shared.json', shallow=False)
+        is_cpp = source_files[0].endswith('.cc')
+        runtime_source = Path('runtime', 'dredd_runtime.cc' if is_cpp else 'dredd_runtime.c')
+        assert Path('runtime', 'dredd_runtime.h').exists()
+        assert runtime_source.exists()
+        # The mutated files should not define any mutant functions themselves.
+        for filename in source_files:
+            assert re.search(r'static [a-z ]+ __dredd_replace_', open(filename, 'r').read()) is None, filename
+        compile_program(source_files + [str(runtime_source)], './shared.exe', ['-Iruntime'])
+
+        # Every mutant should have the same effect in both versions of the program.
+        assert get_exit_codes('./per_file.exe', num_mutants) == get_exit_codes('./shared.exe', num_mutants)
+
+        # Sharding should produce the same mutated files and runtime.
+        for filename in source_files:
+            shutil.copyfile(src=filename, dst=filename + '.shared')
+        shutil.move('runtime', 'runtime-unsharded')
+        restore_source_files(source_files)
+        run_successfully([DREDD_INSTALLED_EXECUTABLE, '--shard', '0/1', '--shard-output-file', 'shard.bin',
+                          '--runtime-dir', 'runtime'] + source_files + ['--'])
+        run_successfully([DREDD_MERGE_INSTALLED_EXECUTABLE, 'shard.bin'])
+        for filename in source_files:
+            assert filecmp.cmp(filename, filename + '.shared', shallow=False), filename
+        for filename in os.listdir('runtime-unsharded'):
+            assert filecmp.cmp(Path('runtime', filename), Path('runtime-unsharded', filename), shallow=False), filename
+        shutil.rmtree('runtime')
+        shutil.rmtree('runtime-unsharded')
+
+    # A shared runtime cannot be combined with producing mutant tracking versions of source files.
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--runtime-dir', 'runtime', '--coverage-tracking-output-dir',
+                             'tracking', 'example.c', '--'], stderr=subprocess.PIPE)
+    assert result.returncode != 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
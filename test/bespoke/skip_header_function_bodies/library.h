@@ -0,0 +1,28 @@
+#include <vector>
+
+inline int Twice(int x) { return x + x; }
+
+template <typename T>
+T Sum(const std::vector<T>& values) {
+  T result = 0;
+  for (const T& value : values) {
+    result += value;
+  }
+  return result;
+}
+
+constexpr int Square(int x) { return x * x; }
+
+inline auto Half(int x) { return x / 2; }
+
+class Counter {
+ public:
+  void Increment() { count_ += 1; }
+  int Get() const { return count_; }
+
+ private:
+  int count_ = 0;
+};
+
+#define DEFINE_GETTER(name, value) \
+  int name() { return value + 1; }
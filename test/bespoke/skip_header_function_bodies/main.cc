@@ -0,0 +1,13 @@
+#include "library.h"
+
+static_assert(Square(3) == 9, "Constexpr function body is needed");
+
+DEFINE_GETTER(GetValue, 41)
+
+int main(int argc, char** argv) {
+  int sizes[Square(2)] = {1, 2, 3, 4};
+  std::vector<int> values = {argc, sizes[1], Half(argc)};
+  Counter counter;
+  counter.Increment();
+  return Sum(values) + Twice(counter.Get()) + GetValue() - sizes[3];
+}
@@ -0,0 +1,5 @@
+#include <stdlib.h>
+
+int scale(int a) {
+  return abs(a) * 3;
+}
@@ -0,0 +1,48 @@
+import filecmp
+import os
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+DREDD_REPO_ROOT = os.environ['DREDD_REPO_ROOT']
+DREDD_INSTALLED_EXECUTABLE = Path(DREDD_REPO_ROOT, 'third_party', 'clang+llvm', 'bin', 'dredd')
+
+SOURCE_FILES = ['main.cc', 'other.c']
+OUTPUT_FILES = SOURCE_FILES + ['info.json']
+
+
+def run_dredd(extra_args, output_dir):
+    # Start from pristine copies of the source files, as Dredd mutates them in place.
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=Path('original', filename), dst=filename)
+    result = subprocess.run([DREDD_INSTALLED_EXECUTABLE, '--mutation-info-file', 'info.json'] + extra_args +
+                            SOURCE_FILES + ['--'], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert result.returncode == 0, result.stderr.decode('utf-8')
+    Path(output_dir).mkdir()
+    for filename in OUTPUT_FILES:
+        shutil.copyfile(src=filename, dst=Path(output_dir, filename))
+
+
+def main():
+    Path('original').mkdir()
+    for filename in SOURCE_FILES:
+        shutil.copyfile(src=filename, dst=Path('original', filename))
+
+    run_dredd([], 'full')
+    # Skipping the bodies of functions declared in headers must not affect the result, including for functions whose
+    # bodies are needed to analyse the source file, and for functions in the source file that are defined via macros
+    # from headers.
+    for extra_args, output_dir in [(['--skip-header-function-bodies'], 'skipped'),
+                                   (['--skip-header-function-bodies', '--jobs', '2'], 'skipped_jobs2')]:
+        run_dredd(extra_args, output_dir)
+        for filename in OUTPUT_FILES:
+            assert filecmp.cmp(Path('full', filename), Path(output_dir, filename), shallow=False), filename
+
+    # Sanity-check that mutation did take place.
+    for filename in SOURCE_FILES:
+        assert not filecmp.cmp(Path('original', filename), Path('full', filename), shallow=False), filename
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,7 @@
+int main() {
+  int x;
+  switch (0) {
+  case 0:
+    x = 2;
+  }
+}